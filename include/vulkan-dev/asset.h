@@ -0,0 +1,140 @@
+#ifndef VULKAN_DEV_ASSET_H
+#define VULKAN_DEV_ASSET_H
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/buffer.h>
+#include <vulkan-dev/image.h>
+#include <vulkan-dev/vertex.h>
+#include <vulkan-dev/staging.h>
+
+#include <stdint.h>
+
+/*
+ *	NOTE:	Baked asset files, written offline by vk_dev_baker (see
+ *			vulkan-dev/baker.h and tools/bake.c) and mapped read only at
+ *			runtime. A file is a header, page aligned sections holding data
+ *			exactly as it is uploaded (optimized and quantized vertices,
+ *			indices, texture mips) and a table of contents sorted by name:
+ *
+ *			header | section | section | ... | entries
+ *
+ *			Opening a file only validates the header and the table, so the
+ *			cost of loading is the cost of reading the pages the staging
+ *			copies touch.
+ */
+
+#define VK_DEV_ASSET_MAGIC 0x41444b56 // "VKDA"
+#define VK_DEV_ASSET_VERSION 1
+#define VK_DEV_ASSET_ALIGNMENT 4096
+#define VK_DEV_ASSET_NAME_SIZE 64
+#define VK_DEV_ASSET_MAX_LEVELS 16
+
+enum vk_dev_asset_kind {
+	VK_DEV_ASSET_MESH = 1,
+	VK_DEV_ASSET_TEXTURE = 2,
+};
+
+struct vk_dev_asset_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entry_count;
+	uint32_t padding;
+	uint64_t entries_offset;
+	uint64_t file_size;
+};
+
+/*
+ *	NOTE:	Offsets are relative to the start of the entry's section. The
+ *			vertex layout is that of struct vk_dev_vertex_format, see
+ *			vk_dev_asset_get_vertex_format.
+ */
+struct vk_dev_asset_mesh {
+	uint32_t vertex_count;
+	uint32_t index_count;
+	uint64_t vertex_offset;
+	uint64_t index_offset;
+
+	uint32_t stride;
+	uint32_t attribute_offsets[VK_DEV_VERTEX_ATTRIBUTE_COUNT];
+	uint32_t attribute_formats[VK_DEV_VERTEX_ATTRIBUTE_COUNT];
+	float position_offset[3];
+	float position_scale[3];
+};
+
+struct vk_dev_asset_texture {
+	uint32_t format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t levels;
+	uint64_t level_offsets[VK_DEV_ASSET_MAX_LEVELS];
+	uint64_t level_sizes[VK_DEV_ASSET_MAX_LEVELS];
+};
+
+struct vk_dev_asset_entry {
+	char name[VK_DEV_ASSET_NAME_SIZE];
+	uint32_t kind;
+	uint32_t padding;
+	uint64_t offset;
+	uint64_t size;
+
+	union {
+		struct vk_dev_asset_mesh mesh;
+		struct vk_dev_asset_texture texture;
+	} info;
+};
+
+struct vk_dev_asset_file;
+
+/*
+ *	NOTE:	Returns NULL when the file cannot be mapped or is not a valid
+ *			asset file of this version.
+ */
+struct vk_dev_asset_file*
+vk_dev_asset_open(const char* path);
+
+void
+vk_dev_asset_close(struct vk_dev_asset_file* file);
+
+uint32_t
+vk_dev_asset_get_entry_count(const struct vk_dev_asset_file* file);
+
+const struct vk_dev_asset_entry*
+vk_dev_asset_get_entry(const struct vk_dev_asset_file* file,
+	const uint32_t index);
+
+/*
+ *	NOTE:	Binary search of the table of contents; NULL if there is no entry
+ *			named name.
+ */
+const struct vk_dev_asset_entry*
+vk_dev_asset_find(const struct vk_dev_asset_file* file, const char* name);
+
+/*
+ *	NOTE:	The entry's section in the mapping, valid until the file is
+ *			closed.
+ */
+const void*
+vk_dev_asset_get_data(const struct vk_dev_asset_file* file,
+	const struct vk_dev_asset_entry* entry);
+
+void
+vk_dev_asset_get_vertex_format(const struct vk_dev_asset_entry* entry,
+	struct vk_dev_vertex_format* format);
+
+/*
+ *	NOTE:	Create device local buffers (or an image) for the entry and queue
+ *			their contents on staging, straight from the mapping. They are
+ *			ready to use after the next vk_dev_staging_flush.
+ */
+void
+vk_dev_asset_upload_mesh(struct vk_dev_context* context,
+	struct vk_dev_staging* staging, const struct vk_dev_asset_file* file,
+	const struct vk_dev_asset_entry* entry, struct vk_dev_buffer* vertices,
+	struct vk_dev_buffer* indices);
+
+void
+vk_dev_asset_upload_texture(struct vk_dev_context* context,
+	struct vk_dev_staging* staging, const struct vk_dev_asset_file* file,
+	const struct vk_dev_asset_entry* entry, struct vk_dev_image* image);
+
+#endif // VULKAN_DEV_ASSET_H
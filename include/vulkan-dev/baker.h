@@ -0,0 +1,49 @@
+#ifndef VULKAN_DEV_BAKER_H
+#define VULKAN_DEV_BAKER_H
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/vertex.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ *	NOTE:	Writes baked asset files (see vulkan-dev/asset.h). Sections are
+ *			streamed to disk as they are added; the table of contents is
+ *			sorted and written by vk_dev_baker_finish. Data is stored as
+ *			given, so meshes should already be optimized and quantized (see
+ *			tools/bake.c for the usual pipeline).
+ */
+
+struct vk_dev_baker;
+
+/*
+ *	NOTE:	Returns NULL when path cannot be opened for writing.
+ */
+struct vk_dev_baker*
+vk_dev_baker_create(const char* path);
+
+void
+vk_dev_baker_add_mesh(struct vk_dev_baker* baker, const char* name,
+	const struct vk_dev_vertex_format* format, const void* vertices,
+	const uint32_t vertex_count, const uint32_t* indices,
+	const uint32_t index_count);
+
+/*
+ *	NOTE:	levels[i] holds level_sizes[i] bytes of tightly packed texels (or
+ *			compressed blocks) of mip level i.
+ */
+void
+vk_dev_baker_add_texture(struct vk_dev_baker* baker, const char* name,
+	const VkFormat format, const uint32_t width, const uint32_t height,
+	const uint32_t level_count, const void* const* levels,
+	const uint64_t* level_sizes);
+
+/*
+ *	NOTE:	Writes the table of contents and closes the file, freeing baker.
+ *			Returns false if anything failed to write.
+ */
+bool
+vk_dev_baker_finish(struct vk_dev_baker* baker);
+
+#endif // VULKAN_DEV_BAKER_H
@@ -0,0 +1,92 @@
+#ifndef VULKAN_DEV_BINDING_H
+#define VULKAN_DEV_BINDING_H
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/descriptor.h>
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ *	NOTE:	Descriptor bindings written straight from a packed C struct.
+ *			The application describes where each binding's descriptor infos
+ *			(VkDescriptorImageInfo, VkDescriptorBufferInfo or VkBufferView)
+ *			live in its struct, and vk_dev builds both the set layout and a
+ *			VkDescriptorUpdateTemplate from that one description. Writing a
+ *			set is then a single call taking a pointer to the struct, with no
+ *			VkWriteDescriptorSet built at all.
+ *
+ *			When VK_KHR_push_descriptor is available (and the layout fits
+ *			its limits) the set is pushed into the command buffer, so per-draw
+ *			data needs no descriptor set allocation either. Otherwise a set is
+ *			taken from the given descriptor allocator.
+ *
+ *			Example:
+ *
+ *				struct draw_bindings {
+ *					VkDescriptorBufferInfo transform;
+ *					VkDescriptorImageInfo textures[4];
+ *				};
+ *
+ *				static const struct vk_dev_binding bindings[] = {
+ *					VK_DEV_BINDING(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1,
+ *						VK_SHADER_STAGE_VERTEX_BIT, struct draw_bindings,
+ *						transform),
+ *					VK_DEV_BINDING(1,
+ *						VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4,
+ *						VK_SHADER_STAGE_FRAGMENT_BIT, struct draw_bindings,
+ *						textures),
+ *				};
+ */
+
+struct vk_dev_binding {
+	uint32_t binding;
+	VkDescriptorType type;
+	uint32_t count;
+	VkShaderStageFlags stages;
+	size_t offset;
+	size_t stride;
+};
+
+#define VK_DEV_BINDING(binding, type, count, stages, struct_type, member) \
+	{(binding), (type), (count), (stages), offsetof(struct_type, member), \
+	sizeof(((struct_type*)0)->member) / (count)}
+
+struct vk_dev_binding_layout;
+
+struct vk_dev_binding_layout*
+vk_dev_binding_layout_create(struct vk_dev_context* context,
+	const struct vk_dev_binding* bindings, const uint32_t binding_count);
+
+void
+vk_dev_binding_layout_destroy(struct vk_dev_binding_layout* layout);
+
+VkDescriptorSetLayout
+vk_dev_binding_layout_get_layout(const struct vk_dev_binding_layout* layout);
+
+bool
+vk_dev_binding_layout_uses_push_descriptors(
+	const struct vk_dev_binding_layout* layout);
+
+/*
+ *	NOTE:	The update template of a push descriptor layout names the
+ *			pipeline layout and set it is pushed to, so this must be called
+ *			once the pipeline layout using get_layout exists and before the
+ *			first write.
+ */
+void
+vk_dev_binding_layout_set_pipeline(struct vk_dev_binding_layout* layout,
+	const VkPipelineBindPoint bind_point, VkPipelineLayout pipeline_layout,
+	const uint32_t set);
+
+/*
+ *	NOTE:	Writes data (a pointer to the application's packed struct) to the
+ *			layout's set and binds it on command_buffer. allocator is only
+ *			used without push descriptors and may be NULL otherwise.
+ */
+void
+vk_dev_binding_layout_write(const struct vk_dev_binding_layout* layout,
+	VkCommandBuffer command_buffer,
+	struct vk_dev_descriptor_allocator* allocator, const void* data);
+
+#endif // VULKAN_DEV_BINDING_H
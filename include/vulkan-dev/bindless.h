@@ -0,0 +1,63 @@
+#ifndef VULKAN_DEV_BINDLESS_H
+#define VULKAN_DEV_BINDLESS_H
+
+#include <vulkan-dev/vulkan-dev.h>
+
+/*
+ *	NOTE:	A bindless resource table. Every texture, storage buffer and
+ *			sampler lives in one large update-after-bind descriptor set which
+ *			is bound once per command buffer; shaders index it with the
+ *			integer handles returned below (see shaders/bindless.glsl).
+ *
+ *			Handles are recycled as soon as they are removed, so a resource
+ *			must only be removed once the GPU has finished with it.
+ */
+
+#define VK_DEV_BINDLESS_INVALID UINT32_MAX
+
+enum vk_dev_bindless_kind {
+	VK_DEV_BINDLESS_TEXTURE,
+	VK_DEV_BINDLESS_BUFFER,
+	VK_DEV_BINDLESS_SAMPLER,
+	VK_DEV_BINDLESS_KIND_COUNT,
+};
+
+struct vk_dev_bindless;
+
+struct vk_dev_bindless*
+vk_dev_bindless_create(struct vk_dev_context* context,
+	const uint32_t texture_capacity, const uint32_t buffer_capacity,
+	const uint32_t sampler_capacity);
+
+void
+vk_dev_bindless_destroy(struct vk_dev_bindless* bindless);
+
+uint32_t
+vk_dev_bindless_add_texture(struct vk_dev_bindless* bindless,
+	VkImageView view, const VkImageLayout layout);
+
+uint32_t
+vk_dev_bindless_add_buffer(struct vk_dev_bindless* bindless,
+	VkBuffer buffer, const VkDeviceSize offset, const VkDeviceSize range);
+
+uint32_t
+vk_dev_bindless_add_sampler(struct vk_dev_bindless* bindless,
+	VkSampler sampler);
+
+/*
+ *	NOTE:	Removing VK_DEV_BINDLESS_INVALID does nothing; removing any other
+ *			handle that is not currently allocated is a fatal error.
+ */
+void
+vk_dev_bindless_remove(struct vk_dev_bindless* bindless,
+	const enum vk_dev_bindless_kind kind, const uint32_t handle);
+
+VkDescriptorSetLayout
+vk_dev_bindless_get_layout(const struct vk_dev_bindless* bindless);
+
+void
+vk_dev_bindless_bind(const struct vk_dev_bindless* bindless,
+	VkCommandBuffer command_buffer, const VkPipelineBindPoint bind_point,
+	VkPipelineLayout pipeline_layout, const uint32_t set);
+
+#endif // VULKAN_DEV_BINDLESS_H
@@ -0,0 +1,42 @@
+#ifndef VULKAN_DEV_BUFFER_H
+#define VULKAN_DEV_BUFFER_H
+
+#include <vulkan-dev/vulkan-dev.h>
+
+#include <stdbool.h>
+
+/*
+ *	NOTE:	A buffer with its own dedicated allocation. Host visible buffers
+ *			are mapped for their whole lifetime and mapped points at the
+ *			start of the buffer; for any other buffer mapped is NULL.
+ */
+struct vk_dev_buffer {
+	VkBuffer buffer;
+	VkDeviceMemory memory;
+	VkDeviceSize size;
+	void* mapped;
+};
+
+uint32_t
+vk_dev_find_memory_type(const struct vk_dev_context* context,
+	const uint32_t type_bits, const VkMemoryPropertyFlags properties);
+
+/*
+ *	NOTE:	Budget and current usage, in bytes, of the device local heap as
+ *			reported by VK_EXT_memory_budget. Returns false when the extension
+ *			is not enabled.
+ */
+bool
+vk_dev_get_memory_budget(const struct vk_dev_context* context,
+	VkDeviceSize* budget, VkDeviceSize* usage);
+
+void
+vk_dev_buffer_create(struct vk_dev_context* context, const VkDeviceSize size,
+	const VkBufferUsageFlags usage, const VkMemoryPropertyFlags properties,
+	struct vk_dev_buffer* buffer);
+
+void
+vk_dev_buffer_destroy(struct vk_dev_context* context,
+	struct vk_dev_buffer* buffer);
+
+#endif // VULKAN_DEV_BUFFER_H
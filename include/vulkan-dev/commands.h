@@ -0,0 +1,161 @@
+#ifndef VULKAN_DEV_COMMANDS_H
+#define VULKAN_DEV_COMMANDS_H
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/parallel.h>
+#include <vulkan-dev/resources.h>
+
+#include <stdint.h>
+
+/*
+ *	NOTE:	A command stream recorded without touching Vulkan. Draws and
+ *			dispatches go into a vk_dev_command_list as packed 64-byte
+ *			packets, each carrying the full state it needs (pipeline and
+ *			buffers as vk_dev_resources handles, see vulkan-dev/resources.h),
+ *			with push constant data behind them in a linear arena. Lists
+ *			touch no shared state, so any thread may record into its own.
+ *
+ *			vk_dev_commands then merges the lists, sorts every packet by its
+ *			64-bit key and translates ranges of the sorted stream into
+ *			vkCmd* calls, binding a pipeline, descriptor set, vertex or index
+ *			buffer, or pushing constants only when they differ from what the
+ *			previous packet left bound. Packets with equal keys keep the
+ *			order they were recorded in, list by list.
+ */
+
+/*
+ *	NOTE:	What a packet binds. Handles that are zero are left unbound:
+ *			a draw needs a graphics pipeline, an indexed draw an index
+ *			buffer, and a dispatch a compute pipeline; a packet without a
+ *			pipeline is a fatal error. push_size is a multiple of 4, at most
+ *			VK_DEV_COMMANDS_MAX_PUSH_SIZE, and index_type of an indexed draw
+ *			is VK_INDEX_TYPE_UINT16 or VK_INDEX_TYPE_UINT32.
+ */
+struct vk_dev_command_state {
+	vk_dev_pipeline_handle pipeline;
+
+	VkDescriptorSet descriptor_set;
+	uint32_t descriptor_set_index;
+
+	vk_dev_buffer_handle vertex_buffer;
+	uint32_t vertex_buffer_offset;
+
+	vk_dev_buffer_handle index_buffer;
+	uint32_t index_buffer_offset;
+	VkIndexType index_type;
+
+	VkShaderStageFlags push_stages;
+	uint32_t push_size;
+	const void* push_constants;
+};
+
+#define VK_DEV_COMMANDS_MAX_PUSH_SIZE 1020
+
+/*
+ *	NOTE:	Counters for the last vk_dev_commands_sort and the translation
+ *			that followed. redundant counts the binds and pushes dropped
+ *			because the state was already current; stale counts packets
+ *			skipped because a handle no longer resolved.
+ */
+struct vk_dev_commands_stats {
+	uint32_t packets;
+	uint32_t draws;
+	uint32_t dispatches;
+	uint32_t pipeline_binds;
+	uint32_t descriptor_binds;
+	uint32_t vertex_binds;
+	uint32_t index_binds;
+	uint32_t pushes;
+	uint32_t redundant;
+	uint32_t stale;
+};
+
+struct vk_dev_command_list;
+
+struct vk_dev_command_list*
+vk_dev_command_list_create(void);
+
+void
+vk_dev_command_list_destroy(struct vk_dev_command_list* list);
+
+/*
+ *	NOTE:	Empties the list, keeping its memory.
+ */
+void
+vk_dev_command_list_reset(struct vk_dev_command_list* list);
+
+uint32_t
+vk_dev_command_list_get_count(const struct vk_dev_command_list* list);
+
+void
+vk_dev_command_list_draw(struct vk_dev_command_list* list,
+	const uint64_t key, const struct vk_dev_command_state* state,
+	const uint32_t vertex_count, const uint32_t instance_count,
+	const uint32_t first_vertex, const uint32_t first_instance);
+
+void
+vk_dev_command_list_draw_indexed(struct vk_dev_command_list* list,
+	const uint64_t key, const struct vk_dev_command_state* state,
+	const uint32_t index_count, const uint32_t instance_count,
+	const uint32_t first_index, const int32_t vertex_offset,
+	const uint32_t first_instance);
+
+void
+vk_dev_command_list_dispatch(struct vk_dev_command_list* list,
+	const uint64_t key, const struct vk_dev_command_state* state,
+	const uint32_t group_count_x, const uint32_t group_count_y,
+	const uint32_t group_count_z);
+
+/*
+ *	NOTE:	A sort key, most significant first: 8 bits of pass, 16 of
+ *			pipeline, 16 of material and 24 of depth, which is a view depth
+ *			of at least 0 so nearer packets sort first. For back to front
+ *			order pass a depth that shrinks with distance instead.
+ */
+uint64_t
+vk_dev_commands_make_key(const uint32_t pass, const uint32_t pipeline,
+	const uint32_t material, const float depth);
+
+struct vk_dev_commands;
+
+struct vk_dev_commands*
+vk_dev_commands_create(struct vk_dev_context* context,
+	struct vk_dev_resources* resources);
+
+void
+vk_dev_commands_destroy(struct vk_dev_commands* commands);
+
+/*
+ *	NOTE:	Merges and sorts the packets of up to 256 lists, and returns how
+ *			many there are. The lists must be left alone until translation
+ *			is done.
+ */
+uint32_t
+vk_dev_commands_sort(struct vk_dev_commands* commands,
+	struct vk_dev_command_list* const* lists, const uint32_t list_count);
+
+/*
+ *	NOTE:	Translates sorted packets [first, first + count) into
+ *			command_buffer, assuming nothing is bound on entry. Ranges may be
+ *			translated concurrently into different command buffers.
+ */
+void
+vk_dev_commands_translate(struct vk_dev_commands* commands,
+	VkCommandBuffer command_buffer, const uint32_t first,
+	const uint32_t count);
+
+/*
+ *	NOTE:	Translates every sorted packet into a render pass, in parallel
+ *			through pass (see vulkan-dev/parallel.h). Packets must be draws;
+ *			a dispatch is a fatal error.
+ */
+void
+vk_dev_commands_record_pass(struct vk_dev_commands* commands,
+	struct vk_dev_parallel_pass* pass, VkCommandBuffer primary,
+	const VkRenderPassBeginInfo* begin_info);
+
+void
+vk_dev_commands_get_stats(const struct vk_dev_commands* commands,
+	struct vk_dev_commands_stats* stats);
+
+#endif // VULKAN_DEV_COMMANDS_H
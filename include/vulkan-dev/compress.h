@@ -0,0 +1,118 @@
+#ifndef VULKAN_DEV_COMPRESS_H
+#define VULKAN_DEV_COMPRESS_H
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/descriptor.h>
+#include <vulkan-dev/jobs.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ *	NOTE:	Block compression of RGBA8 texels. The same encoders run on the
+ *			CPU (SSE2 where available, for offline baking) and in a compute
+ *			shader (for textures made at runtime, such as probes and
+ *			impostors). Both work the same way:
+ *
+ *			BC1	colour endpoints along the principal axis of the block,
+ *				nearest of four colours, one least squares refit.
+ *			BC3	BC1 colour and a BC4 alpha block.
+ *			BC5	BC4 blocks for red and green, for normal maps.
+ *			BC7	mode 6 only: one subset of RGBA endpoints with 16
+ *				interpolated colours, otherwise as BC1.
+ *
+ *			They favour speed over the last decibel; an exhaustive offline
+ *			encoder will do better on hard blocks. Blocks past the edge of
+ *			images whose sides are not multiples of 4 repeat the edge
+ *			texels.
+ */
+
+enum vk_dev_compress_format {
+	VK_DEV_COMPRESS_BC1 = 0,
+	VK_DEV_COMPRESS_BC3 = 1,
+	VK_DEV_COMPRESS_BC5 = 2,
+	VK_DEV_COMPRESS_BC7 = 3,
+};
+
+#define VK_DEV_COMPRESS_FORMAT_COUNT 4
+
+/*
+ *	NOTE:	Peak signal to noise ratio, in dB, over the channels the format
+ *			stores (colour and alpha apart) and the largest error of any
+ *			channel. Identical images score INFINITY.
+ */
+struct vk_dev_compress_quality {
+	double psnr_rgb;
+	double psnr_alpha;
+	uint32_t max_error;
+};
+
+const char*
+vk_dev_compress_get_name(const enum vk_dev_compress_format format);
+
+VkFormat
+vk_dev_compress_get_vk_format(const enum vk_dev_compress_format format,
+	const bool srgb);
+
+uint32_t
+vk_dev_compress_get_block_size(const enum vk_dev_compress_format format);
+
+VkDeviceSize
+vk_dev_compress_get_size(const enum vk_dev_compress_format format,
+	const uint32_t width, const uint32_t height);
+
+/*
+ *	NOTE:	Encodes tightly packed RGBA8 texels into vk_dev_compress_get_size
+ *			bytes of blocks, in rows of blocks as vkCmdCopyBufferToImage
+ *			expects them. Rows of blocks are spread over jobs, which may be
+ *			NULL to encode on the calling thread.
+ */
+void
+vk_dev_compress_encode(const enum vk_dev_compress_format format,
+	const uint8_t* texels, const uint32_t width, const uint32_t height,
+	void* blocks, struct vk_dev_jobs* jobs);
+
+/*
+ *	NOTE:	The inverse, for measuring quality and for devices without
+ *			textureCompressionBC. Only decodes the BC7 modes the encoder
+ *			writes; blocks in other modes come out transparent black.
+ *			Channels a format does not store are 0 (alpha 255).
+ */
+void
+vk_dev_compress_decode(const enum vk_dev_compress_format format,
+	const void* blocks, const uint32_t width, const uint32_t height,
+	uint8_t* texels);
+
+void
+vk_dev_compress_measure(const enum vk_dev_compress_format format,
+	const uint8_t* reference, const uint8_t* texels, const uint32_t width,
+	const uint32_t height, struct vk_dev_compress_quality* quality);
+
+struct vk_dev_compress;
+
+struct vk_dev_compress*
+vk_dev_compress_create(struct vk_dev_context* context);
+
+void
+vk_dev_compress_destroy(struct vk_dev_compress* compress);
+
+/*
+ *	NOTE:	Records encoding a width by height RGBA view, already in
+ *			source_layout with its writes available, into destination at
+ *			offset (a multiple of 16). The view must be UNORM, not sRGB, so
+ *			the shader sees the stored bytes. The destination needs storage
+ *			buffer usage; its blocks are laid out as vk_dev_compress_encode
+ *			lays them out and are visible to transfer and host reads
+ *			afterwards, so vkCmdCopyBufferToImage can move them into a BC
+ *			image. allocator is only used when push descriptors are
+ *			unavailable and may otherwise be NULL.
+ */
+void
+vk_dev_compress_record(struct vk_dev_compress* compress,
+	VkCommandBuffer command_buffer,
+	struct vk_dev_descriptor_allocator* allocator,
+	const enum vk_dev_compress_format format, VkImageView source,
+	const VkImageLayout source_layout, const uint32_t width,
+	const uint32_t height, VkBuffer destination, const VkDeviceSize offset);
+
+#endif // VULKAN_DEV_COMPRESS_H
@@ -0,0 +1,171 @@
+#ifndef VULKAN_DEV_CONTEXT_H
+#define VULKAN_DEV_CONTEXT_H
+
+#include <vulkan-dev/vulkan-dev.h>
+
+#include <stdbool.h>
+
+/*
+ *	NOTE:	Every context owns its own function tables, resolved through
+ *			vkGetInstanceProcAddr and vkGetDeviceProcAddr for its instance
+ *			and device, so several contexts (one per GPU, or per ICD) can be
+ *			driven from independent threads with no shared loader state.
+ *			Device level entry points resolved this way also skip the
+ *			loader's dispatch trampoline.
+ *
+ *			Subsystems call through the table, e.g.
+ *			context->vk.CreateBuffer(context->device, ...). Adding a function
+ *			used by vk_dev means adding it to one of the lists below. Entry
+ *			points of optional extensions are NULL unless the matching flag in
+ *			context->extensions is set.
+ */
+
+#define VK_DEV_GLOBAL_FUNCTIONS(X) \
+	X(CreateInstance) \
+	X(EnumerateInstanceExtensionProperties)
+
+#define VK_DEV_INSTANCE_FUNCTIONS(X) \
+	X(DestroyInstance) \
+	X(EnumeratePhysicalDevices) \
+	X(GetPhysicalDeviceProperties) \
+	X(GetPhysicalDeviceQueueFamilyProperties) \
+	X(GetPhysicalDeviceMemoryProperties) \
+	X(GetPhysicalDeviceMemoryProperties2) \
+	X(GetPhysicalDeviceFeatures2) \
+	X(GetPhysicalDeviceProperties2) \
+	X(GetPhysicalDeviceSparseImageFormatProperties) \
+	X(EnumerateDeviceExtensionProperties) \
+	X(CreateDevice) \
+	X(GetDeviceProcAddr) \
+	X(GetPhysicalDeviceSurfaceSupportKHR) \
+	X(DestroySurfaceKHR)
+
+#define VK_DEV_DEVICE_FUNCTIONS(X) \
+	X(DestroyDevice) \
+	X(GetDeviceQueue) \
+	X(DeviceWaitIdle) \
+	X(CreateDescriptorSetLayout) \
+	X(DestroyDescriptorSetLayout) \
+	X(CreateDescriptorPool) \
+	X(DestroyDescriptorPool) \
+	X(ResetDescriptorPool) \
+	X(AllocateDescriptorSets) \
+	X(FreeDescriptorSets) \
+	X(UpdateDescriptorSets) \
+	X(CmdBindDescriptorSets) \
+	X(CreateDescriptorUpdateTemplate) \
+	X(DestroyDescriptorUpdateTemplate) \
+	X(UpdateDescriptorSetWithTemplate) \
+	X(CmdPushDescriptorSetWithTemplateKHR) \
+	X(CreateBuffer) \
+	X(DestroyBuffer) \
+	X(GetBufferMemoryRequirements) \
+	X(AllocateMemory) \
+	X(FreeMemory) \
+	X(BindBufferMemory) \
+	X(MapMemory) \
+	X(UnmapMemory) \
+	X(CreateImage) \
+	X(DestroyImage) \
+	X(GetImageMemoryRequirements) \
+	X(GetImageSparseMemoryRequirements) \
+	X(BindImageMemory) \
+	X(CreateImageView) \
+	X(DestroyImageView) \
+	X(CreateSampler) \
+	X(DestroySampler) \
+	X(CreateShaderModule) \
+	X(DestroyShaderModule) \
+	X(CreatePipelineLayout) \
+	X(DestroyPipelineLayout) \
+	X(CreateComputePipelines) \
+	X(CreateGraphicsPipelines) \
+	X(DestroyPipeline) \
+	X(CmdBindPipeline) \
+	X(CmdPushConstants) \
+	X(CmdPipelineBarrier) \
+	X(CmdFillBuffer) \
+	X(CmdDispatch) \
+	X(CmdDraw) \
+	X(CmdDrawIndexed) \
+	X(CmdBindVertexBuffers) \
+	X(CmdBindIndexBuffer) \
+	X(CmdDrawIndexedIndirect) \
+	X(CmdDrawIndexedIndirectCountKHR) \
+	X(CreateCommandPool) \
+	X(DestroyCommandPool) \
+	X(ResetCommandPool) \
+	X(AllocateCommandBuffers) \
+	X(BeginCommandBuffer) \
+	X(EndCommandBuffer) \
+	X(QueueSubmit) \
+	X(QueueBindSparse) \
+	X(CreateFence) \
+	X(DestroyFence) \
+	X(WaitForFences) \
+	X(GetFenceStatus) \
+	X(ResetFences) \
+	X(CreateSemaphore) \
+	X(DestroySemaphore) \
+	X(CmdCopyBuffer) \
+	X(CmdCopyBufferToImage) \
+	X(CmdCopyImageToBuffer) \
+	X(CmdBlitImage) \
+	X(CreateRenderPass) \
+	X(DestroyRenderPass) \
+	X(CreateFramebuffer) \
+	X(DestroyFramebuffer) \
+	X(CmdBeginRenderPass) \
+	X(CmdEndRenderPass) \
+	X(CmdExecuteCommands)
+
+#define VK_DEV_DISPATCH_MEMBER(name) PFN_vk##name name;
+
+struct vk_dev_dispatch {
+	PFN_vkGetInstanceProcAddr GetInstanceProcAddr;
+	VK_DEV_GLOBAL_FUNCTIONS(VK_DEV_DISPATCH_MEMBER)
+	VK_DEV_INSTANCE_FUNCTIONS(VK_DEV_DISPATCH_MEMBER)
+	VK_DEV_DEVICE_FUNCTIONS(VK_DEV_DISPATCH_MEMBER)
+};
+
+/*
+ *	NOTE:	Optional device extensions, set when the device reported the
+ *			extension and it was enabled at device creation.
+ */
+struct vk_dev_extensions {
+	bool swapchain;
+	bool maintenance3;
+	bool descriptor_indexing;
+	bool push_descriptor;
+	bool draw_indirect_count;
+	bool memory_budget;
+};
+
+struct vk_dev_context {
+	void* library;
+	VkInstance instance;
+	VkPhysicalDevice physical_device;
+	VkDevice device;
+	VkQueue queue;
+	VkSurfaceKHR surface;
+	uint32_t queue_family;
+	VkQueueFlags queue_flags;
+	uint32_t physical_device_count;
+
+	VkPhysicalDeviceProperties properties;
+	VkPhysicalDeviceMemoryProperties memory_properties;
+
+	struct vk_dev_extensions extensions;
+	VkPhysicalDeviceFeatures features;
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptor_indexing;
+	VkPhysicalDeviceDescriptorIndexingPropertiesEXT
+		descriptor_indexing_properties;
+	VkPhysicalDevicePushDescriptorPropertiesKHR push_descriptor_properties;
+
+	uint64_t phase_start;
+	struct vk_dev_setup_timings timings;
+
+	struct vk_dev_dispatch vk;
+};
+
+#endif // VULKAN_DEV_CONTEXT_H
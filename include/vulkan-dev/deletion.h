@@ -0,0 +1,90 @@
+#ifndef VULKAN_DEV_DELETION_H
+#define VULKAN_DEV_DELETION_H
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/buffer.h>
+#include <vulkan-dev/image.h>
+
+#include <stdint.h>
+
+/*
+ *	NOTE:	Deferred destruction. A resource the GPU may still be using is
+ *			retired with the timeline value of its last use (see
+ *			vulkan-dev/timeline.h) instead of being destroyed, and
+ *			vk_dev_deletion_queue_collect destroys everything whose value
+ *			the GPU has passed, in one batch, typically once a frame. Nothing
+ *			ever waits for the device to go idle.
+ *
+ *			Entries are kept in retirement order and collected from the
+ *			oldest, so values should not decrease: an entry retired with a
+ *			smaller value than one before it is collected with that one.
+ *			Retiring is thread safe; collect from one thread at a time.
+ */
+
+/*
+ *	NOTE:	Counters since creation, except pending. batches counts collect
+ *			calls that destroyed anything.
+ */
+struct vk_dev_deletion_stats {
+	uint64_t retired;
+	uint64_t destroyed;
+	uint64_t batches;
+	uint32_t largest_batch;
+	uint32_t pending;
+};
+
+struct vk_dev_deletion_queue;
+
+struct vk_dev_deletion_queue*
+vk_dev_deletion_queue_create(struct vk_dev_context* context);
+
+/*
+ *	NOTE:	Waits for the device to go idle and destroys everything still
+ *			pending, for shutdown.
+ */
+void
+vk_dev_deletion_queue_destroy(struct vk_dev_deletion_queue* queue);
+
+/*
+ *	NOTE:	The queue takes ownership; the caller's copy is cleared.
+ */
+void
+vk_dev_deletion_queue_retire_buffer(struct vk_dev_deletion_queue* queue,
+	const uint64_t value, struct vk_dev_buffer* buffer);
+
+void
+vk_dev_deletion_queue_retire_image(struct vk_dev_deletion_queue* queue,
+	const uint64_t value, struct vk_dev_image* image);
+
+void
+vk_dev_deletion_queue_retire_image_view(struct vk_dev_deletion_queue* queue,
+	const uint64_t value, VkImageView view);
+
+void
+vk_dev_deletion_queue_retire_sampler(struct vk_dev_deletion_queue* queue,
+	const uint64_t value, VkSampler sampler);
+
+void
+vk_dev_deletion_queue_retire_pipeline(struct vk_dev_deletion_queue* queue,
+	const uint64_t value, VkPipeline pipeline);
+
+void
+vk_dev_deletion_queue_retire_pipeline_layout(
+	struct vk_dev_deletion_queue* queue, const uint64_t value,
+	VkPipelineLayout layout);
+
+/*
+ *	NOTE:	Destroys entries retired with a value up to completed, oldest
+ *			first, at most max_count of them (0 for no limit) so a burst of
+ *			retirements can be spread over several frames. Returns how many
+ *			were destroyed.
+ */
+uint32_t
+vk_dev_deletion_queue_collect(struct vk_dev_deletion_queue* queue,
+	const uint64_t completed, const uint32_t max_count);
+
+void
+vk_dev_deletion_queue_get_stats(struct vk_dev_deletion_queue* queue,
+	struct vk_dev_deletion_stats* stats);
+
+#endif // VULKAN_DEV_DELETION_H
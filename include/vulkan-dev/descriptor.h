@@ -0,0 +1,66 @@
+#ifndef VULKAN_DEV_DESCRIPTOR_H
+#define VULKAN_DEV_DESCRIPTOR_H
+
+#include <vulkan-dev/vulkan-dev.h>
+
+/*
+ *	NOTE:	Descriptor set allocator for the non-bindless paths. Sets are
+ *			carved out of chained descriptor pools; when a pool runs dry a
+ *			new (larger) one is chained on rather than failing. Sets are
+ *			never freed individually: vk_dev_descriptor_allocator_begin_frame
+ *			resets every pool the frame used with one vkResetDescriptorPool
+ *			each, so it must only be called once the GPU is done with that
+ *			frame's sets.
+ *
+ *			An allocator is not thread safe; give each recording thread its
+ *			own.
+ */
+
+/*
+ *	NOTE:	Counters since creation. Compare allocations against cache_hits
+ *			to see how much set churn the cache removed, and pool_creations
+ *			against pool_resets to check the chain has settled.
+ */
+struct vk_dev_descriptor_stats {
+	uint64_t allocations;
+	uint64_t cache_hits;
+	uint64_t cache_misses;
+	uint64_t pool_creations;
+	uint64_t pool_resets;
+};
+
+struct vk_dev_descriptor_allocator;
+
+struct vk_dev_descriptor_allocator*
+vk_dev_descriptor_allocator_create(struct vk_dev_context* context,
+	const uint32_t frame_count);
+
+void
+vk_dev_descriptor_allocator_destroy(
+	struct vk_dev_descriptor_allocator* allocator);
+
+void
+vk_dev_descriptor_allocator_begin_frame(
+	struct vk_dev_descriptor_allocator* allocator, const uint32_t frame);
+
+VkDescriptorSet
+vk_dev_descriptor_allocator_allocate(
+	struct vk_dev_descriptor_allocator* allocator,
+	VkDescriptorSetLayout layout);
+
+/*
+ *	NOTE:	Returns a set of the given layout with the given writes applied,
+ *			reusing an identical set already built this frame. The dstSet
+ *			member of each write is ignored.
+ */
+VkDescriptorSet
+vk_dev_descriptor_allocator_get(struct vk_dev_descriptor_allocator* allocator,
+	VkDescriptorSetLayout layout, const VkWriteDescriptorSet* writes,
+	const uint32_t write_count);
+
+void
+vk_dev_descriptor_allocator_get_stats(
+	const struct vk_dev_descriptor_allocator* allocator,
+	struct vk_dev_descriptor_stats* stats);
+
+#endif // VULKAN_DEV_DESCRIPTOR_H
@@ -0,0 +1,58 @@
+#ifndef VULKAN_DEV_DOWNSAMPLE_H
+#define VULKAN_DEV_DOWNSAMPLE_H
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/descriptor.h>
+#include <vulkan-dev/image.h>
+
+/*
+ *	NOTE:	Single pass mip generation. One dispatch of 256-thread groups
+ *			builds every level of an image: each group reduces a 64x64 tile
+ *			of level 0 down to one texel of level 6 in shared memory, writing
+ *			the levels on the way, and the last group to finish (found with
+ *			an atomic counter) reduces those texels down to level 12. That
+ *			replaces a blit and a barrier per level with one dispatch and
+ *			one barrier.
+ *
+ *			Levels are a 2x2 box filter, exact for power of two extents;
+ *			level 0 is at most 4096 texels across. The image needs sampled
+ *			and storage usage and a format the device can store to without a
+ *			format qualifier.
+ */
+
+#define VK_DEV_DOWNSAMPLE_MAX_LEVELS 13
+
+struct vk_dev_downsample;
+
+struct vk_dev_downsample*
+vk_dev_downsample_create(struct vk_dev_context* context,
+	const struct vk_dev_image* image);
+
+void
+vk_dev_downsample_destroy(struct vk_dev_downsample* downsample);
+
+/*
+ *	NOTE:	Records building levels 1 and up from level 0, which must be in
+ *			layout with its writes available. Every level is left in
+ *			VK_IMAGE_LAYOUT_GENERAL with the writes visible to shader reads.
+ *			allocator is only used when push descriptors are unavailable and
+ *			may otherwise be NULL.
+ */
+void
+vk_dev_downsample_record(struct vk_dev_downsample* downsample,
+	VkCommandBuffer command_buffer,
+	struct vk_dev_descriptor_allocator* allocator, const VkImageLayout layout);
+
+/*
+ *	NOTE:	The reference path: a vkCmdBlitImage chain, one blit and two
+ *			barriers per level, for images the compute path cannot store to.
+ *			The image needs transfer source and destination usage; level 0
+ *			must be in layout with its writes available, and every level is
+ *			left in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+ */
+void
+vk_dev_downsample_blit(struct vk_dev_context* context,
+	VkCommandBuffer command_buffer, const struct vk_dev_image* image,
+	const VkImageLayout layout);
+
+#endif // VULKAN_DEV_DOWNSAMPLE_H
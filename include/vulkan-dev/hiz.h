@@ -0,0 +1,54 @@
+#ifndef VULKAN_DEV_HIZ_H
+#define VULKAN_DEV_HIZ_H
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/descriptor.h>
+
+/*
+ *	NOTE:	Hierarchical-Z pyramid for occlusion culling. Each level holds
+ *			the farthest depth of the texels beneath it, built by a compute
+ *			downsample of a depth buffer (normally the previous frame's).
+ *			Depth is assumed to increase away from the camera (0 near, 1
+ *			far, compare op LESS).
+ *
+ *			Level 0 is the depth buffer's size rounded down to powers of two,
+ *			so every pyramid texel covers a whole number of depth texels at
+ *			every level below it.
+ */
+
+struct vk_dev_hiz;
+
+struct vk_dev_hiz*
+vk_dev_hiz_create(struct vk_dev_context* context, const uint32_t depth_width,
+	const uint32_t depth_height);
+
+void
+vk_dev_hiz_destroy(struct vk_dev_hiz* hiz);
+
+/*
+ *	NOTE:	Records the pyramid build. depth_view must be a depth-aspect view
+ *			of a depth_width by depth_height image, already in depth_layout
+ *			(a read-only depth or shader read-only layout) with its writes
+ *			made visible to compute shaders. allocator is only used when push
+ *			descriptors are unavailable and may otherwise be NULL.
+ */
+void
+vk_dev_hiz_build(struct vk_dev_hiz* hiz, VkCommandBuffer command_buffer,
+	struct vk_dev_descriptor_allocator* allocator, VkImageView depth_view,
+	const VkImageLayout depth_layout);
+
+/*
+ *	NOTE:	The whole pyramid, in VK_IMAGE_LAYOUT_GENERAL once built, with a
+ *			nearest sampler for texelFetch.
+ */
+VkImageView
+vk_dev_hiz_get_view(const struct vk_dev_hiz* hiz);
+
+VkSampler
+vk_dev_hiz_get_sampler(const struct vk_dev_hiz* hiz);
+
+void
+vk_dev_hiz_get_size(const struct vk_dev_hiz* hiz, uint32_t* width,
+	uint32_t* height, uint32_t* levels);
+
+#endif // VULKAN_DEV_HIZ_H
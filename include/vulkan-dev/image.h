@@ -0,0 +1,33 @@
+#ifndef VULKAN_DEV_IMAGE_H
+#define VULKAN_DEV_IMAGE_H
+
+#include <vulkan-dev/vulkan-dev.h>
+
+/*
+ *	NOTE:	A device local 2D color image with its own dedicated allocation,
+ *			created in VK_IMAGE_LAYOUT_UNDEFINED.
+ */
+struct vk_dev_image {
+	VkImage image;
+	VkDeviceMemory memory;
+	VkFormat format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t levels;
+};
+
+void
+vk_dev_image_create(struct vk_dev_context* context, const uint32_t width,
+	const uint32_t height, const uint32_t levels, const VkFormat format,
+	const VkImageUsageFlags usage, struct vk_dev_image* image);
+
+void
+vk_dev_image_destroy(struct vk_dev_context* context,
+	struct vk_dev_image* image);
+
+VkImageView
+vk_dev_image_view_create(struct vk_dev_context* context,
+	const struct vk_dev_image* image, const uint32_t base_level,
+	const uint32_t level_count);
+
+#endif // VULKAN_DEV_IMAGE_H
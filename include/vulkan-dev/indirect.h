@@ -0,0 +1,113 @@
+#ifndef VULKAN_DEV_INDIRECT_H
+#define VULKAN_DEV_INDIRECT_H
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/descriptor.h>
+#include <vulkan-dev/hiz.h>
+
+/*
+ *	NOTE:	GPU-driven drawing. Every object in the scene lives in a storage
+ *			buffer; vk_dev_indirect_cull records a compute pass that culls
+ *			them against the view frustum (and optionally a Hi-Z pyramid,
+ *			see vulkan-dev/hiz.h) and compacts the survivors into an
+ *			indirect draw buffer, and vk_dev_indirect_draw draws all of them
+ *			with a single call. The CPU cost of a frame no longer depends on
+ *			the number of objects.
+ *
+ *			Each surviving object becomes one indexed draw of its mesh with
+ *			firstInstance set to the object's index, so vertex shaders find
+ *			their object with gl_InstanceIndex in the object buffer.
+ *
+ *			The object and mesh tables are host visible and written in place;
+ *			they must not be modified while a frame using them is in flight.
+ */
+
+/*
+ *	NOTE:	cone is a normal cone packed by vk_dev_meshlet_pack_cone, in the
+ *			same space as center, letting the cull drop clusters that face
+ *			away from the camera; 0 disables the test.
+ */
+struct vk_dev_indirect_object {
+	float center[3];
+	float radius;
+	uint32_t mesh;
+	uint32_t cone;
+	uint32_t padding[2];
+};
+
+struct vk_dev_indirect_mesh {
+	uint32_t index_count;
+	uint32_t first_index;
+	int32_t vertex_offset;
+	uint32_t padding;
+};
+
+/*
+ *	NOTE:	What the last cull let through, counted on the GPU. Comparing a
+ *			cull with and without a Hi-Z pyramid shows what occlusion culling
+ *			saves.
+ */
+struct vk_dev_indirect_stats {
+	uint32_t draw_count;
+	uint32_t triangle_count;
+};
+
+struct vk_dev_indirect;
+
+struct vk_dev_indirect*
+vk_dev_indirect_create(struct vk_dev_context* context,
+	const uint32_t object_capacity, const uint32_t mesh_capacity);
+
+void
+vk_dev_indirect_destroy(struct vk_dev_indirect* indirect);
+
+struct vk_dev_indirect_object*
+vk_dev_indirect_get_objects(struct vk_dev_indirect* indirect);
+
+struct vk_dev_indirect_mesh*
+vk_dev_indirect_get_meshes(struct vk_dev_indirect* indirect);
+
+void
+vk_dev_indirect_set_object_count(struct vk_dev_indirect* indirect,
+	const uint32_t object_count);
+
+VkBuffer
+vk_dev_indirect_get_object_buffer(const struct vk_dev_indirect* indirect);
+
+/*
+ *	NOTE:	view_projection is a column-major matrix mapping world space to
+ *			Vulkan clip space and camera_position is the eye in world space,
+ *			used for cone culling. allocator is only used when push descriptors
+ *			are unavailable and may otherwise be NULL.
+ *
+ *			With a built Hi-Z pyramid (normally from the previous frame's
+ *			depth) objects hidden behind it are culled too; with NULL only
+ *			the frustum test runs. Culling this frame's objects against last
+ *			frame's depth can briefly drop objects that are disoccluded by
+ *			fast camera motion.
+ */
+void
+vk_dev_indirect_cull(struct vk_dev_indirect* indirect,
+	VkCommandBuffer command_buffer,
+	struct vk_dev_descriptor_allocator* allocator,
+	const float view_projection[16], const float camera_position[3],
+	const struct vk_dev_hiz* hiz);
+
+/*
+ *	NOTE:	Records the draw of every object that survived the last cull.
+ *			The graphics pipeline, its descriptors and the vertex and index
+ *			buffers holding every mesh must already be bound.
+ */
+void
+vk_dev_indirect_draw(const struct vk_dev_indirect* indirect,
+	VkCommandBuffer command_buffer);
+
+/*
+ *	NOTE:	Only meaningful once the command buffer holding the last cull
+ *			has finished executing.
+ */
+void
+vk_dev_indirect_get_stats(const struct vk_dev_indirect* indirect,
+	struct vk_dev_indirect_stats* stats);
+
+#endif // VULKAN_DEV_INDIRECT_H
@@ -0,0 +1,35 @@
+#ifndef VULKAN_DEV_JOBS_H
+#define VULKAN_DEV_JOBS_H
+
+#include <stdint.h>
+
+/*
+ *	NOTE:	A fixed pool of worker threads running parallel-for batches. The
+ *			thread calling vk_dev_jobs_run works on the batch too and returns
+ *			once every index has been processed. Batches run one at a time:
+ *			a pool must only be driven from one thread at once, and fn must
+ *			not call vk_dev_jobs_run on the same pool.
+ */
+
+typedef void (*vk_dev_job_fn)(void* arg, const uint32_t index);
+
+struct vk_dev_jobs;
+
+/*
+ *	NOTE:	thread_count counts the calling thread; 0 uses one thread per
+ *			online CPU.
+ */
+struct vk_dev_jobs*
+vk_dev_jobs_create(uint32_t thread_count);
+
+void
+vk_dev_jobs_destroy(struct vk_dev_jobs* jobs);
+
+uint32_t
+vk_dev_jobs_get_thread_count(const struct vk_dev_jobs* jobs);
+
+void
+vk_dev_jobs_run(struct vk_dev_jobs* jobs, const uint32_t count,
+	vk_dev_job_fn fn, void* arg);
+
+#endif // VULKAN_DEV_JOBS_H
@@ -0,0 +1,121 @@
+#ifndef VULKAN_DEV_MESHLET_H
+#define VULKAN_DEV_MESHLET_H
+
+#include <vulkan-dev/jobs.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ *	NOTE:	Splits an indexed triangle mesh into meshlets: clusters of at
+ *			most VK_DEV_MESHLET_MAX_VERTICES vertices and
+ *			VK_DEV_MESHLET_MAX_TRIANGLES triangles, each with a bounding
+ *			sphere and a normal cone for per-cluster culling.
+ *
+ *			The mesh is cut into fixed runs of triangles which are built in
+ *			parallel and concatenated, so the output does not depend on the
+ *			number of threads and can be cached (see
+ *			vk_dev_meshlet_build_cached).
+ */
+
+#define VK_DEV_MESHLET_MAX_VERTICES 64
+#define VK_DEV_MESHLET_MAX_TRIANGLES 124
+
+/*
+ *	NOTE:	vertex_offset indexes the mesh's vertices array and
+ *			triangle_offset counts triangles into its triangles array, so a
+ *			meshlet drawn from vk_dev_meshlet_get_indices output starts at
+ *			index triangle_offset * 3.
+ *
+ *			The cone is stored as meshoptimizer does: a meshlet is entirely
+ *			back facing, as seen from eye, when
+ *			dot(center - eye, cone_axis) >=
+ *				cone_cutoff * length(center - eye) + radius.
+ *			A cone_cutoff of 1 disables the test.
+ */
+struct vk_dev_meshlet {
+	uint32_t vertex_offset;
+	uint32_t triangle_offset;
+	uint32_t vertex_count;
+	uint32_t triangle_count;
+
+	float center[3];
+	float radius;
+	float cone_axis[3];
+	float cone_cutoff;
+};
+
+/*
+ *	NOTE:	vertices maps each meshlet-local vertex to a vertex of the source
+ *			mesh; triangles holds three meshlet-local indices per triangle.
+ */
+struct vk_dev_meshlet_mesh {
+	struct vk_dev_meshlet* meshlets;
+	uint32_t meshlet_count;
+
+	uint32_t* vertices;
+	uint32_t vertex_count;
+
+	uint8_t* triangles;
+	uint32_t triangle_count;
+};
+
+/*
+ *	NOTE:	positions points at the first vertex's x, y and z floats, with
+ *			position_stride bytes between vertices. Every index must be below
+ *			vertex_count. jobs may be NULL to build on the calling thread.
+ */
+void
+vk_dev_meshlet_build(struct vk_dev_jobs* jobs, const uint32_t* indices,
+	const uint32_t index_count, const float* positions,
+	const size_t position_stride, const uint32_t vertex_count,
+	struct vk_dev_meshlet_mesh* mesh);
+
+void
+vk_dev_meshlet_mesh_free(struct vk_dev_meshlet_mesh* mesh);
+
+/*
+ *	NOTE:	Identifies a build: a hash of the indices, positions, meshlet
+ *			limits and cache format version.
+ */
+uint64_t
+vk_dev_meshlet_key(const uint32_t* indices, const uint32_t index_count,
+	const float* positions, const size_t position_stride,
+	const uint32_t vertex_count);
+
+bool
+vk_dev_meshlet_cache_load(const char* path, const uint64_t key,
+	struct vk_dev_meshlet_mesh* mesh);
+
+bool
+vk_dev_meshlet_cache_save(const char* path, const uint64_t key,
+	const struct vk_dev_meshlet_mesh* mesh);
+
+/*
+ *	NOTE:	Loads the meshlets from the cache file at path when it holds this
+ *			exact build, otherwise builds them and rewrites the cache.
+ */
+void
+vk_dev_meshlet_build_cached(struct vk_dev_jobs* jobs, const char* path,
+	const uint32_t* indices, const uint32_t index_count,
+	const float* positions, const size_t position_stride,
+	const uint32_t vertex_count, struct vk_dev_meshlet_mesh* mesh);
+
+/*
+ *	NOTE:	Writes triangle_count * 3 source vertex indices, meshlet by
+ *			meshlet, for drawing the meshlets as ordinary indexed ranges.
+ */
+void
+vk_dev_meshlet_get_indices(const struct vk_dev_meshlet_mesh* mesh,
+	uint32_t* indices);
+
+/*
+ *	NOTE:	The cone quantized to signed 8-bit axis and cutoff for
+ *			vk_dev_indirect_object.cone, rounded so the quantized test stays
+ *			conservative; 0 when the cone cannot cull anything.
+ */
+uint32_t
+vk_dev_meshlet_pack_cone(const struct vk_dev_meshlet* meshlet);
+
+#endif // VULKAN_DEV_MESHLET_H
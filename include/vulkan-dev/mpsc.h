@@ -0,0 +1,46 @@
+#ifndef VULKAN_DEV_MPSC_H
+#define VULKAN_DEV_MPSC_H
+
+#include <stdint.h>
+
+/*
+ *	NOTE:	An intrusive multi-producer single-consumer queue (Vyukov's
+ *			node based design). Any number of threads push without locks,
+ *			each push one atomic exchange, and one thread at a time pops in
+ *			push order. Nodes are owned by the caller and embedded in
+ *			whatever is being queued.
+ *
+ *			A push is two steps, so a producer preempted between them hides
+ *			its node and everything pushed after it until it resumes: pop
+ *			then returns NULL as if the queue were empty. Nothing is lost,
+ *			the consumer just sees it on a later pop.
+ */
+
+#define VK_DEV_MPSC_CACHE_LINE 64
+
+struct vk_dev_mpsc_node {
+	struct vk_dev_mpsc_node* next;
+};
+
+/*
+ *	NOTE:	head is written by producers and tail by the consumer, so they
+ *			are kept a cache line apart.
+ */
+struct vk_dev_mpsc {
+	struct vk_dev_mpsc_node* head;
+	uint8_t padding[VK_DEV_MPSC_CACHE_LINE - sizeof(void*)];
+
+	struct vk_dev_mpsc_node* tail;
+	struct vk_dev_mpsc_node stub;
+};
+
+void
+vk_dev_mpsc_init(struct vk_dev_mpsc* queue);
+
+void
+vk_dev_mpsc_push(struct vk_dev_mpsc* queue, struct vk_dev_mpsc_node* node);
+
+struct vk_dev_mpsc_node*
+vk_dev_mpsc_pop(struct vk_dev_mpsc* queue);
+
+#endif // VULKAN_DEV_MPSC_H
@@ -0,0 +1,90 @@
+#ifndef VULKAN_DEV_OPTIMIZE_H
+#define VULKAN_DEV_OPTIMIZE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ *	NOTE:	CPU index and vertex buffer optimization, run on meshes before
+ *			they are uploaded (or baked). The usual order is vertex cache,
+ *			then optionally overdraw, then vertex fetch, which renumbers the
+ *			vertices in the order the final index buffer first uses them.
+ *
+ *			Indices are triangle lists: index_count must be a multiple of 3
+ *			and every index less than vertex_count, or the functions below
+ *			fail with a fatal error.
+ */
+
+/*
+ *	NOTE:	Post-transform cache size the optimizer targets. Modern GPUs do
+ *			not have a true FIFO vertex cache, but ordering for a small one
+ *			still models their batch-local vertex reuse well.
+ */
+#define VK_DEV_OPTIMIZE_CACHE_SIZE 16
+
+/*
+ *	NOTE:	acmr is vertices transformed per triangle (0.5 is the ideal for
+ *			a regular grid, 3 the worst); atvr is vertices transformed per
+ *			vertex used (1 is ideal), both under a FIFO cache of cache_size.
+ */
+struct vk_dev_vertex_cache_stats {
+	uint32_t vertices_transformed;
+	float acmr;
+	float atvr;
+};
+
+struct vk_dev_optimize_report {
+	struct vk_dev_vertex_cache_stats before;
+	struct vk_dev_vertex_cache_stats after;
+};
+
+void
+vk_dev_optimize_analyze_vertex_cache(const uint32_t* indices,
+	const uint32_t index_count, const uint32_t vertex_count,
+	const uint32_t cache_size, struct vk_dev_vertex_cache_stats* stats);
+
+/*
+ *	NOTE:	Reorders triangles for vertex cache locality with Tipsify (Sander,
+ *			Nehab and Barczak, 2007), which runs in linear time. destination
+ *			and indices may be the same array.
+ */
+void
+vk_dev_optimize_vertex_cache(uint32_t* destination, const uint32_t* indices,
+	const uint32_t index_count, const uint32_t vertex_count);
+
+/*
+ *	NOTE:	Reorders clusters of a cache optimized index buffer so triangles
+ *			facing out from the mesh center are drawn first, which lets early
+ *			depth testing reject more of what is drawn behind them. Clusters
+ *			break where the cache restarts, so vertex reuse is kept.
+ *			destination and indices must not overlap.
+ */
+void
+vk_dev_optimize_overdraw(uint32_t* destination, const uint32_t* indices,
+	const uint32_t index_count, const float* positions,
+	const size_t position_stride, const uint32_t vertex_count);
+
+/*
+ *	NOTE:	Renumbers vertices in the order indices first reference them,
+ *			copying them to destination (which must not overlap vertices) and
+ *			rewriting indices in place. Unreferenced vertices are dropped;
+ *			returns the number of vertices written.
+ */
+uint32_t
+vk_dev_optimize_vertex_fetch(void* destination, const void* vertices,
+	uint32_t* indices, const uint32_t index_count,
+	const uint32_t vertex_count, const size_t vertex_size);
+
+/*
+ *	NOTE:	Runs the whole pipeline above in place, with overdraw ordering
+ *			when positions is not NULL (positions must then point into
+ *			vertices), and returns the new vertex count. report, if not NULL,
+ *			receives the cache statistics before and after.
+ */
+uint32_t
+vk_dev_optimize_mesh(void* vertices, uint32_t* indices,
+	const uint32_t index_count, const uint32_t vertex_count,
+	const size_t vertex_size, const float* positions,
+	struct vk_dev_optimize_report* report);
+
+#endif // VULKAN_DEV_OPTIMIZE_H
@@ -0,0 +1,77 @@
+#ifndef VULKAN_DEV_PARALLEL_H
+#define VULKAN_DEV_PARALLEL_H
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/jobs.h>
+
+#include <stdint.h>
+
+/*
+ *	NOTE:	Parallel render pass recording. The draw list of a single
+ *			subpass render pass is cut into chunks, the chunks are recorded
+ *			into secondary command buffers on a vk_dev_jobs pool (see
+ *			vulkan-dev/jobs.h), and the primary runs them in order with one
+ *			vkCmdExecuteCommands.
+ *
+ *			The split follows the draw count: a pass with few draws is
+ *			recorded inline in the primary, since a secondary buffer costs
+ *			more to begin and end than a handful of draws, and larger ones
+ *			get chunks of at least VK_DEV_PARALLEL_MIN_DRAWS draws, several
+ *			per thread so uneven draws still balance, up to
+ *			VK_DEV_PARALLEL_MAX_CHUNKS.
+ *
+ *			Each chunk slot owns its command pool, which is reset by every
+ *			record, so a parallel pass serves one frame in flight: create
+ *			one per frame and record into a pass only once the GPU is done
+ *			with its previous recording.
+ */
+
+#define VK_DEV_PARALLEL_MIN_DRAWS 128
+#define VK_DEV_PARALLEL_MAX_CHUNKS 64
+
+/*
+ *	NOTE:	Records draws [first, first + count) into command_buffer, which
+ *			is already inside the render pass. Called from worker threads,
+ *			at most once per draw, in no particular order across chunks.
+ *			Nothing bound before the call is inherited, so every chunk binds
+ *			its own pipeline and descriptors.
+ */
+typedef void (*vk_dev_parallel_record_fn)(void* arg,
+	VkCommandBuffer command_buffer, const uint32_t first,
+	const uint32_t count);
+
+/*
+ *	NOTE:	The split of the last record; chunk_count is 0 when it was
+ *			recorded inline. record_ns covers the whole call: resetting,
+ *			recording and joining the chunks.
+ */
+struct vk_dev_parallel_stats {
+	uint32_t draw_count;
+	uint32_t chunk_count;
+	uint32_t chunk_size;
+	uint64_t record_ns;
+};
+
+struct vk_dev_parallel_pass;
+
+struct vk_dev_parallel_pass*
+vk_dev_parallel_pass_create(struct vk_dev_context* context,
+	struct vk_dev_jobs* jobs);
+
+void
+vk_dev_parallel_pass_destroy(struct vk_dev_parallel_pass* pass);
+
+/*
+ *	NOTE:	Records the whole render pass described by begin_info into
+ *			primary, which must be recording outside a render pass.
+ */
+void
+vk_dev_parallel_pass_record(struct vk_dev_parallel_pass* pass,
+	VkCommandBuffer primary, const VkRenderPassBeginInfo* begin_info,
+	const uint32_t draw_count, vk_dev_parallel_record_fn fn, void* arg);
+
+void
+vk_dev_parallel_pass_get_stats(const struct vk_dev_parallel_pass* pass,
+	struct vk_dev_parallel_stats* stats);
+
+#endif // VULKAN_DEV_PARALLEL_H
@@ -0,0 +1,98 @@
+#ifndef VULKAN_DEV_REPLAY_H
+#define VULKAN_DEV_REPLAY_H
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/timeline.h>
+
+#include <stdint.h>
+
+/*
+ *	NOTE:	Pre-recorded command buffers for passes that record the same
+ *			commands every frame, such as shadow maps of static geometry.
+ *			Each entry is recorded once and handed back as is until the key
+ *			passed with it changes, so static content costs no recording
+ *			time. Command buffers are recorded with SIMULTANEOUS_USE, so the
+ *			same one may be in flight for several frames at once.
+ *
+ *			Recording anew never touches a buffer the GPU may still be
+ *			running: every entry has two, and uses are tracked on the
+ *			timeline (see vulkan-dev/timeline.h), which is only waited on if
+ *			an entry is recorded twice within the frames in flight.
+ *
+ *			A replay cache is externally synchronized, like the command pool
+ *			behind it.
+ */
+
+/*
+ *	NOTE:	Records the entry's commands into command_buffer, which has been
+ *			begun; for a secondary entry it continues the render pass.
+ */
+typedef void (*vk_dev_replay_record_fn)(void* arg,
+	VkCommandBuffer command_buffer);
+
+/*
+ *	NOTE:	A primary entry is submitted directly, a secondary one executed
+ *			inside render_pass with vkCmdExecuteCommands. framebuffer may be
+ *			VK_NULL_HANDLE, so one recording serves every swapchain image.
+ */
+struct vk_dev_replay_info {
+	VkCommandBufferLevel level;
+	VkRenderPass render_pass;
+	uint32_t subpass;
+	VkFramebuffer framebuffer;
+
+	vk_dev_replay_record_fn fn;
+	void* arg;
+};
+
+/*
+ *	NOTE:	Counters since creation. saved_ns charges every replay the time
+ *			its entry took to record last.
+ */
+struct vk_dev_replay_stats {
+	uint64_t records;
+	uint64_t replays;
+	uint64_t record_ns;
+	uint64_t saved_ns;
+};
+
+struct vk_dev_replay;
+
+struct vk_dev_replay*
+vk_dev_replay_create(struct vk_dev_context* context,
+	struct vk_dev_timeline* timeline);
+
+/*
+ *	NOTE:	Waits for every submission that may still use an entry.
+ */
+void
+vk_dev_replay_destroy(struct vk_dev_replay* replay);
+
+/*
+ *	NOTE:	Returns the entry's index; nothing is recorded until it is first
+ *			used.
+ */
+uint32_t
+vk_dev_replay_add(struct vk_dev_replay* replay,
+	const struct vk_dev_replay_info* info);
+
+/*
+ *	NOTE:	The entry's command buffer for the next submission, recorded
+ *			again first if key differs from the last call's. The buffer must
+ *			go out with the next timeline signal, not a later one.
+ */
+VkCommandBuffer
+vk_dev_replay_get(struct vk_dev_replay* replay, const uint32_t entry,
+	const uint64_t key);
+
+/*
+ *	NOTE:	Forces the next vk_dev_replay_get to record, whatever its key.
+ */
+void
+vk_dev_replay_invalidate(struct vk_dev_replay* replay, const uint32_t entry);
+
+void
+vk_dev_replay_get_stats(const struct vk_dev_replay* replay,
+	struct vk_dev_replay_stats* stats);
+
+#endif // VULKAN_DEV_REPLAY_H
@@ -0,0 +1,164 @@
+#ifndef VULKAN_DEV_RESOURCES_H
+#define VULKAN_DEV_RESOURCES_H
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/buffer.h>
+#include <vulkan-dev/deletion.h>
+#include <vulkan-dev/image.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ *	NOTE:	Buffers, images, pipelines and samplers behind 32-bit handles:
+ *			the low 20 bits index a slot and the high 12 bits are the slot's
+ *			generation, bumped whenever its resource is removed, so a stale
+ *			handle fails the lookup instead of reaching a destroyed object.
+ *			Handle 0 is never issued. Generations wrap after 4096 reuses of
+ *			a slot, so the check is a strong guard, not a proof.
+ *
+ *			Each kind lives in a pool of fixed capacity split in two arrays:
+ *			hot fields (the generation and the handles command recording
+ *			needs) in cache line aligned records of 16 or 32 bytes, and
+ *			everything else (memory, extents, format) apart. A lookup reads
+ *			one hot record, so it touches a single cache line.
+ *
+ *			Pools never reallocate, so lookups take no lock and may run on
+ *			any thread alongside adds and removes. Adds and removes take a
+ *			per-pool lock. Removing a resource while another thread is still
+ *			using its handle is a race like any use after free; generations
+ *			catch handles used after removal.
+ */
+
+typedef struct { uint32_t bits; } vk_dev_buffer_handle;
+typedef struct { uint32_t bits; } vk_dev_image_handle;
+typedef struct { uint32_t bits; } vk_dev_pipeline_handle;
+typedef struct { uint32_t bits; } vk_dev_sampler_handle;
+
+#define VK_DEV_RESOURCES_MAX_CAPACITY ((1u << 20) - 1)
+
+/*
+ *	NOTE:	Slots per kind; each at most VK_DEV_RESOURCES_MAX_CAPACITY.
+ */
+struct vk_dev_resources_capacity {
+	uint32_t buffers;
+	uint32_t images;
+	uint32_t pipelines;
+	uint32_t samplers;
+};
+
+struct vk_dev_resources_stats {
+	uint32_t live_buffers;
+	uint32_t live_images;
+	uint32_t live_pipelines;
+	uint32_t live_samplers;
+	uint64_t stale_lookups;
+};
+
+struct vk_dev_resources;
+
+struct vk_dev_resources*
+vk_dev_resources_create(struct vk_dev_context* context,
+	const struct vk_dev_resources_capacity* capacity);
+
+/*
+ *	NOTE:	Destroys every resource still registered; the device must be
+ *			done with them.
+ */
+void
+vk_dev_resources_destroy(struct vk_dev_resources* resources);
+
+/*
+ *	NOTE:	Adding takes ownership of the objects. Removing hands them to
+ *			queue to be destroyed once the GPU passes value (see
+ *			vulkan-dev/deletion.h) and invalidates the handle at once; with
+ *			a NULL queue they are destroyed immediately, for when the device
+ *			is known to be done with them. A full pool is a fatal error;
+ *			removing through a stale handle does nothing and returns false.
+ */
+vk_dev_buffer_handle
+vk_dev_resources_add_buffer(struct vk_dev_resources* resources,
+	const struct vk_dev_buffer* buffer);
+
+bool
+vk_dev_resources_remove_buffer(struct vk_dev_resources* resources,
+	const vk_dev_buffer_handle handle, struct vk_dev_deletion_queue* queue,
+	const uint64_t value);
+
+/*
+ *	NOTE:	view may be VK_NULL_HANDLE; it is destroyed along with the image.
+ */
+vk_dev_image_handle
+vk_dev_resources_add_image(struct vk_dev_resources* resources,
+	const struct vk_dev_image* image, VkImageView view);
+
+bool
+vk_dev_resources_remove_image(struct vk_dev_resources* resources,
+	const vk_dev_image_handle handle, struct vk_dev_deletion_queue* queue,
+	const uint64_t value);
+
+/*
+ *	NOTE:	The layout is shared and stays owned by the caller.
+ */
+vk_dev_pipeline_handle
+vk_dev_resources_add_pipeline(struct vk_dev_resources* resources,
+	VkPipeline pipeline, VkPipelineLayout layout,
+	const VkPipelineBindPoint bind_point);
+
+bool
+vk_dev_resources_remove_pipeline(struct vk_dev_resources* resources,
+	const vk_dev_pipeline_handle handle, struct vk_dev_deletion_queue* queue,
+	const uint64_t value);
+
+vk_dev_sampler_handle
+vk_dev_resources_add_sampler(struct vk_dev_resources* resources,
+	VkSampler sampler);
+
+bool
+vk_dev_resources_remove_sampler(struct vk_dev_resources* resources,
+	const vk_dev_sampler_handle handle, struct vk_dev_deletion_queue* queue,
+	const uint64_t value);
+
+/*
+ *	NOTE:	Hot lookups, for command recording. A stale or null handle gives
+ *			VK_NULL_HANDLE (false for the pipeline) and counts in
+ *			stale_lookups.
+ */
+VkBuffer
+vk_dev_resources_get_buffer(struct vk_dev_resources* resources,
+	const vk_dev_buffer_handle handle);
+
+VkImageView
+vk_dev_resources_get_image_view(struct vk_dev_resources* resources,
+	const vk_dev_image_handle handle);
+
+VkImage
+vk_dev_resources_get_image(struct vk_dev_resources* resources,
+	const vk_dev_image_handle handle);
+
+bool
+vk_dev_resources_get_pipeline(struct vk_dev_resources* resources,
+	const vk_dev_pipeline_handle handle, VkPipeline* pipeline,
+	VkPipelineLayout* layout, VkPipelineBindPoint* bind_point);
+
+VkSampler
+vk_dev_resources_get_sampler(struct vk_dev_resources* resources,
+	const vk_dev_sampler_handle handle);
+
+/*
+ *	NOTE:	Cold lookups: the full description. Return false for a stale
+ *			handle.
+ */
+bool
+vk_dev_resources_get_buffer_info(struct vk_dev_resources* resources,
+	const vk_dev_buffer_handle handle, struct vk_dev_buffer* buffer);
+
+bool
+vk_dev_resources_get_image_info(struct vk_dev_resources* resources,
+	const vk_dev_image_handle handle, struct vk_dev_image* image);
+
+void
+vk_dev_resources_get_stats(struct vk_dev_resources* resources,
+	struct vk_dev_resources_stats* stats);
+
+#endif // VULKAN_DEV_RESOURCES_H
@@ -0,0 +1,22 @@
+#ifndef VULKAN_DEV_SHADER_H
+#define VULKAN_DEV_SHADER_H
+
+#include <vulkan-dev/vulkan-dev.h>
+
+/*
+ *	NOTE:	Shaders under shaders/ are compiled to SPIR-V by the Makefile
+ *			into this directory, named after their source (cull.comp becomes
+ *			cull.comp.spv).
+ */
+#ifndef VK_DEV_SHADER_DIR
+#define VK_DEV_SHADER_DIR "bin/shaders"
+#endif
+
+VkShaderModule
+vk_dev_shader_module_load(struct vk_dev_context* context, const char* path);
+
+VkPipeline
+vk_dev_compute_pipeline_create(struct vk_dev_context* context,
+	const char* path, VkPipelineLayout layout);
+
+#endif // VULKAN_DEV_SHADER_H
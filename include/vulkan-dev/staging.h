@@ -0,0 +1,83 @@
+#ifndef VULKAN_DEV_STAGING_H
+#define VULKAN_DEV_STAGING_H
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/image.h>
+
+/*
+ *	NOTE:	Uploads to device local memory through one persistently mapped
+ *			host visible buffer. Uploads are copied into the buffer and
+ *			recorded into a transfer command buffer; when the buffer fills up,
+ *			or on vk_dev_staging_flush, the copies are submitted on the
+ *			context's queue and waited for, and the buffer is reused.
+ *
+ *			Nothing uploaded may be used by the GPU before the next flush.
+ *			The context's queue is used without locking, so uploads must not
+ *			run concurrently with other submissions on it.
+ */
+
+struct vk_dev_staging;
+
+struct vk_dev_staging*
+vk_dev_staging_create(struct vk_dev_context* context,
+	const VkDeviceSize capacity);
+
+void
+vk_dev_staging_destroy(struct vk_dev_staging* staging);
+
+/*
+ *	NOTE:	Uploads larger than the staging buffer are split across several
+ *			submissions.
+ */
+void
+vk_dev_staging_upload_buffer(struct vk_dev_staging* staging,
+	VkBuffer buffer, const VkDeviceSize offset, const void* data,
+	const VkDeviceSize size);
+
+/*
+ *	NOTE:	Replaces the contents of one mip level with tightly packed texels
+ *			(or compressed blocks) and leaves it in
+ *			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL. The whole level has to
+ *			fit in the staging buffer.
+ */
+void
+vk_dev_staging_upload_image(struct vk_dev_staging* staging,
+	const struct vk_dev_image* image, const uint32_t level, const void* data,
+	const VkDeviceSize size);
+
+/*
+ *	NOTE:	For images updated in place while in use: moves every level of
+ *			image from VK_IMAGE_LAYOUT_UNDEFINED to VK_IMAGE_LAYOUT_GENERAL,
+ *			discarding its contents. The image then stays in GENERAL, so
+ *			region uploads need no layout transitions that would disturb
+ *			frames still sampling other parts of it.
+ */
+void
+vk_dev_staging_prepare_image(struct vk_dev_staging* staging,
+	const struct vk_dev_image* image);
+
+/*
+ *	NOTE:	Copies tightly packed texels into a region of one level of an
+ *			image prepared with vk_dev_staging_prepare_image. The caller
+ *			makes sure no frame in flight samples the region.
+ */
+void
+vk_dev_staging_upload_image_region(struct vk_dev_staging* staging,
+	const struct vk_dev_image* image, const uint32_t level,
+	const VkOffset2D offset, const VkExtent2D extent, const void* data,
+	const VkDeviceSize size);
+
+/*
+ *	NOTE:	Makes the next submission of uploads wait for semaphore at stages,
+ *			for instance on a vkQueueBindSparse binding the memory they write.
+ *			The next flush submits even when nothing was uploaded, so the
+ *			semaphore is always waited on.
+ */
+void
+vk_dev_staging_wait(struct vk_dev_staging* staging, VkSemaphore semaphore,
+	const VkPipelineStageFlags stages);
+
+void
+vk_dev_staging_flush(struct vk_dev_staging* staging);
+
+#endif // VULKAN_DEV_STAGING_H
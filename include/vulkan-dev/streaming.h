@@ -0,0 +1,89 @@
+#ifndef VULKAN_DEV_STREAMING_H
+#define VULKAN_DEV_STREAMING_H
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/asset.h>
+#include <vulkan-dev/bindless.h>
+#include <vulkan-dev/staging.h>
+
+#include <stdint.h>
+
+/*
+ *	NOTE:	Texture streaming from baked asset files. Every texture starts
+ *			with only its mip tail (the levels at most
+ *			VK_DEV_STREAMING_TAIL_SIZE texels across) resident. Shaders
+ *			sample streamed textures through shaders/streaming.glsl, which
+ *			records the finest level each texture was sampled at in a
+ *			per-frame feedback table. vk_dev_streaming_begin_frame reads the
+ *			table back and loads finer levels, evicting the levels that
+ *			were used least recently whenever the resident textures would
+ *			exceed the memory budget.
+ *
+ *			Pages of the asset file are faulted in on a background thread,
+ *			so the frame only pays for the staging copies. A texture whose
+ *			residency changes gets a new image and bindless handle; the old
+ *			ones are released frame_count frames later. They stay in the
+ *			resident byte count until then, which keeps peak memory within
+ *			the budget. Mip tails are always resident and are not subject to
+ *			the budget.
+ */
+
+#define VK_DEV_STREAMING_TAIL_SIZE 64
+
+struct vk_dev_streaming_stats {
+	uint32_t texture_count;
+	uint32_t pending;
+	uint64_t loads;
+	uint64_t evictions;
+	VkDeviceSize resident_bytes;
+	VkDeviceSize budget_bytes;
+};
+
+struct vk_dev_streaming;
+
+/*
+ *	NOTE:	budget caps the bytes of texture data resident at once; with
+ *			VK_EXT_memory_budget it is further capped by what the device
+ *			local heap has left. frame_count is the number of frames in
+ *			flight, as for vk_dev_descriptor_allocator_create.
+ */
+struct vk_dev_streaming*
+vk_dev_streaming_create(struct vk_dev_context* context,
+	struct vk_dev_bindless* bindless, struct vk_dev_staging* staging,
+	const uint32_t texture_capacity, const uint32_t frame_count,
+	const VkDeviceSize budget);
+
+void
+vk_dev_streaming_destroy(struct vk_dev_streaming* streaming);
+
+/*
+ *	NOTE:	Uploads the texture's mip tail and returns the index shaders use
+ *			to sample it. file must stay open as long as streaming does.
+ */
+uint32_t
+vk_dev_streaming_add_texture(struct vk_dev_streaming* streaming,
+	const struct vk_dev_asset_file* file,
+	const struct vk_dev_asset_entry* entry);
+
+/*
+ *	NOTE:	Call once the GPU has finished the frame that last used frame,
+ *			before recording anything that samples streamed textures. Uploads
+ *			are flushed through staging before returning.
+ */
+void
+vk_dev_streaming_begin_frame(struct vk_dev_streaming* streaming,
+	const uint32_t frame);
+
+/*
+ *	NOTE:	Bindless buffer handle of frame's texture table, to be passed to
+ *			shaders (see shaders/streaming.glsl).
+ */
+uint32_t
+vk_dev_streaming_get_table(const struct vk_dev_streaming* streaming,
+	const uint32_t frame);
+
+void
+vk_dev_streaming_get_stats(const struct vk_dev_streaming* streaming,
+	struct vk_dev_streaming_stats* stats);
+
+#endif // VULKAN_DEV_STREAMING_H
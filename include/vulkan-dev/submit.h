@@ -0,0 +1,101 @@
+#ifndef VULKAN_DEV_SUBMIT_H
+#define VULKAN_DEV_SUBMIT_H
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/timeline.h>
+
+#include <stdint.h>
+
+/*
+ *	NOTE:	Coalesced queue submission. Producers on any thread add command
+ *			buffers with the semaphores they wait on and signal, and the
+ *			thread that owns the queue flushes everything added since the
+ *			last flush with a single vkQueueSubmit, which costs a trip into
+ *			the kernel driver however many batches it carries.
+ *
+ *			Adding is lock free: producers push onto a multi-producer
+ *			single-consumer queue (see vulkan-dev/mpsc.h) that the flushing
+ *			thread drains, so worker threads never contend on a mutex for
+ *			the externally synchronized VkQueue.
+ *
+ *			Submissions are kept in the order they were added. One that
+ *			waits on nothing joins the batch before it unless that batch
+ *			signals, so only semaphores split batches: a wait applies to a
+ *			whole batch and a signal fires once all of it completes.
+ */
+
+struct vk_dev_submission {
+	uint32_t wait_semaphore_count;
+	const VkSemaphore* wait_semaphores;
+	const VkPipelineStageFlags* wait_stages;
+
+	uint32_t command_buffer_count;
+	const VkCommandBuffer* command_buffers;
+
+	uint32_t signal_semaphore_count;
+	const VkSemaphore* signal_semaphores;
+};
+
+/*
+ *	NOTE:	Counters since creation, and the totals for the last frame ended
+ *			with vk_dev_submitter_end_frame. Submits per frame is submits
+ *			over frames; command buffers per submit is command_buffers over
+ *			submits.
+ */
+struct vk_dev_submit_stats {
+	uint64_t frames;
+	uint64_t submissions;
+	uint64_t submits;
+	uint64_t batches;
+	uint64_t command_buffers;
+	uint32_t largest_submit;
+
+	uint32_t frame_submits;
+	uint32_t frame_batches;
+	uint32_t frame_command_buffers;
+};
+
+struct vk_dev_submitter;
+
+/*
+ *	NOTE:	timeline may be NULL; otherwise every flush that submits signals
+ *			it (see vulkan-dev/timeline.h) and belongs to queue's owner.
+ */
+struct vk_dev_submitter*
+vk_dev_submitter_create(struct vk_dev_context* context, VkQueue queue,
+	struct vk_dev_timeline* timeline);
+
+/*
+ *	NOTE:	Anything added and not flushed is dropped.
+ */
+void
+vk_dev_submitter_destroy(struct vk_dev_submitter* submitter);
+
+/*
+ *	NOTE:	Thread safe and lock free. The arrays are copied, so they need
+ *			not outlive the call.
+ */
+void
+vk_dev_submitter_add(struct vk_dev_submitter* submitter,
+	const struct vk_dev_submission* submission);
+
+/*
+ *	NOTE:	Submits everything added so far and returns the timeline value
+ *			it completes at, or the last value signalled if there was
+ *			nothing to submit (0 without a timeline). Call from one thread
+ *			at a time. Adds racing with it go to this flush or the next.
+ */
+uint64_t
+vk_dev_submitter_flush(struct vk_dev_submitter* submitter);
+
+/*
+ *	NOTE:	Flushes and closes the frame's counters.
+ */
+uint64_t
+vk_dev_submitter_end_frame(struct vk_dev_submitter* submitter);
+
+void
+vk_dev_submitter_get_stats(struct vk_dev_submitter* submitter,
+	struct vk_dev_submit_stats* stats);
+
+#endif // VULKAN_DEV_SUBMIT_H
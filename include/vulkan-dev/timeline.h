@@ -0,0 +1,60 @@
+#ifndef VULKAN_DEV_TIMELINE_H
+#define VULKAN_DEV_TIMELINE_H
+
+#include <vulkan-dev/vulkan-dev.h>
+
+#include <stdint.h>
+
+/*
+ *	NOTE:	GPU progress as a count that only goes up. Every submission that
+ *			should advance it passes the fence from vk_dev_timeline_signal
+ *			to vkQueueSubmit; the value handed out with that fence is
+ *			reached once the fence and every earlier one have signalled.
+ *			Resources tagged with the value of their last use can then be
+ *			released once it is reached (see vulkan-dev/deletion.h).
+ *
+ *			The loader is Vulkan 1.1 without VK_KHR_timeline_semaphore, so
+ *			this is a ring of fences polled with vkGetFenceStatus. capacity
+ *			bounds the submissions in flight: signalling with the ring full
+ *			first waits for the oldest. A fence must be submitted before the
+ *			timeline is next polled or waited on. Like the queue it tracks,
+ *			a timeline is externally synchronized.
+ */
+
+struct vk_dev_timeline;
+
+struct vk_dev_timeline*
+vk_dev_timeline_create(struct vk_dev_context* context,
+	const uint32_t capacity);
+
+/*
+ *	NOTE:	Waits for every submission still in flight.
+ */
+void
+vk_dev_timeline_destroy(struct vk_dev_timeline* timeline);
+
+VkFence
+vk_dev_timeline_signal(struct vk_dev_timeline* timeline, uint64_t* value);
+
+/*
+ *	NOTE:	The last value reached, without blocking.
+ */
+uint64_t
+vk_dev_timeline_poll(struct vk_dev_timeline* timeline);
+
+/*
+ *	NOTE:	Blocks until value is reached, or until everything signalled so
+ *			far is if value has not been handed out yet.
+ */
+void
+vk_dev_timeline_wait(struct vk_dev_timeline* timeline, const uint64_t value);
+
+/*
+ *	NOTE:	The value handed out by the last vk_dev_timeline_signal. Work
+ *			not submitted yet is covered by the next one, so resources it
+ *			uses are retired with this plus one.
+ */
+uint64_t
+vk_dev_timeline_get_signalled(const struct vk_dev_timeline* timeline);
+
+#endif // VULKAN_DEV_TIMELINE_H
@@ -0,0 +1,51 @@
+#ifndef VULKAN_DEV_TRACE_H
+#define VULKAN_DEV_TRACE_H
+
+#include <stdint.h>
+
+/*
+ *	NOTE:	CPU tracing. Each thread owns a lock-free ring buffer of fixed
+ *			size events which a background thread drains into a compact
+ *			binary file. Event names must be string literals (or otherwise
+ *			outlive the trace) as only the pointer is recorded on the hot path.
+ *
+ *			Building with VK_DEV_TRACE_DISABLE (the release target) compiles
+ *			every macro below out entirely.
+ */
+
+enum vk_dev_trace_phase {
+	VK_DEV_TRACE_PHASE_BEGIN = 0,
+	VK_DEV_TRACE_PHASE_END = 1,
+	VK_DEV_TRACE_PHASE_INSTANT = 2,
+};
+
+void
+vk_dev_trace_start(const char* path);
+
+void
+vk_dev_trace_stop(void);
+
+void
+vk_dev_trace_emit(const char* name, const uint32_t phase);
+
+int
+vk_dev_trace_export_chrome(const char* trace_path, const char* json_path);
+
+#if defined(VK_DEV_TRACE_DISABLE)
+#define VK_DEV_TRACE_START(path) ((void)0)
+#define VK_DEV_TRACE_STOP() ((void)0)
+#define VK_DEV_TRACE_BEGIN(name) ((void)0)
+#define VK_DEV_TRACE_END(name) ((void)0)
+#define VK_DEV_TRACE_INSTANT(name) ((void)0)
+#else
+#define VK_DEV_TRACE_START(path) vk_dev_trace_start(path)
+#define VK_DEV_TRACE_STOP() vk_dev_trace_stop()
+#define VK_DEV_TRACE_BEGIN(name) \
+	vk_dev_trace_emit((name), VK_DEV_TRACE_PHASE_BEGIN)
+#define VK_DEV_TRACE_END(name) \
+	vk_dev_trace_emit((name), VK_DEV_TRACE_PHASE_END)
+#define VK_DEV_TRACE_INSTANT(name) \
+	vk_dev_trace_emit((name), VK_DEV_TRACE_PHASE_INSTANT)
+#endif
+
+#endif // VULKAN_DEV_TRACE_H
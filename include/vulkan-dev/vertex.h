@@ -0,0 +1,92 @@
+#ifndef VULKAN_DEV_VERTEX_H
+#define VULKAN_DEV_VERTEX_H
+
+#include <vulkan-dev/vulkan-dev.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ *	NOTE:	Compact vertex formats. Float vertices are quantized once on the
+ *			CPU and decoded by the vertex shader (see shaders/vertex.glsl):
+ *
+ *			position	R16G16B16A16_UNORM, relative to the mesh's bounding
+ *						box; w holds the tangent's bitangent sign.
+ *			uv			R16G16_SFLOAT.
+ *			normal		octahedral R8G8_SNORM, or R16G16_SNORM when
+ *						high_precision is set.
+ *			tangent		octahedral, as normal.
+ *
+ *			A position, normal, tangent and uv vertex shrinks from 48 bytes
+ *			to 16 (20 with high precision).
+ */
+
+enum vk_dev_vertex_attribute {
+	VK_DEV_VERTEX_POSITION,
+	VK_DEV_VERTEX_UV,
+	VK_DEV_VERTEX_NORMAL,
+	VK_DEV_VERTEX_TANGENT,
+	VK_DEV_VERTEX_ATTRIBUTE_COUNT,
+};
+
+#define VK_DEV_VERTEX_ABSENT SIZE_MAX
+
+/*
+ *	NOTE:	Float input vertices. offsets are byte offsets of each attribute
+ *			within a vertex, or VK_DEV_VERTEX_ABSENT; positions are required.
+ *			Positions and normals are 3 floats, uvs 2 and tangents 4, with w
+ *			the bitangent sign.
+ */
+struct vk_dev_vertex_source {
+	const void* data;
+	size_t stride;
+	uint32_t count;
+	size_t offsets[VK_DEV_VERTEX_ATTRIBUTE_COUNT];
+};
+
+/*
+ *	NOTE:	offsets are UINT32_MAX for attributes the source did not have.
+ *			The shader rebuilds positions as
+ *			position_offset + position.xyz * position_scale.
+ */
+struct vk_dev_vertex_format {
+	uint32_t stride;
+	uint32_t offsets[VK_DEV_VERTEX_ATTRIBUTE_COUNT];
+	VkFormat formats[VK_DEV_VERTEX_ATTRIBUTE_COUNT];
+
+	float position_offset[3];
+	float position_scale[3];
+};
+
+/*
+ *	NOTE:	Lays out the compact format for source and fits the position
+ *			range to its bounding box.
+ */
+void
+vk_dev_vertex_format_init(const struct vk_dev_vertex_source* source,
+	const bool high_precision, struct vk_dev_vertex_format* format);
+
+/*
+ *	NOTE:	Writes source->count vertices of format->stride bytes each to
+ *			destination.
+ */
+void
+vk_dev_vertex_quantize(const struct vk_dev_vertex_format* format,
+	const struct vk_dev_vertex_source* source, void* destination);
+
+VkVertexInputBindingDescription
+vk_dev_vertex_get_binding(const struct vk_dev_vertex_format* format,
+	const uint32_t binding);
+
+/*
+ *	NOTE:	Fills attributes with one description per attribute present,
+ *			using the vk_dev_vertex_attribute value as the shader location,
+ *			and returns how many were written.
+ */
+uint32_t
+vk_dev_vertex_get_attributes(const struct vk_dev_vertex_format* format,
+	const uint32_t binding,
+	VkVertexInputAttributeDescription attributes[VK_DEV_VERTEX_ATTRIBUTE_COUNT]);
+
+#endif // VULKAN_DEV_VERTEX_H
@@ -0,0 +1,94 @@
+#ifndef VULKAN_DEV_VIRTUAL_H
+#define VULKAN_DEV_VIRTUAL_H
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/asset.h>
+#include <vulkan-dev/bindless.h>
+#include <vulkan-dev/staging.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ *	NOTE:	Virtual textures: a texture from a baked asset file, split into
+ *			pages of which only the ones shaders sample are resident. A page
+ *			table holds, for every page of every level, the physical page
+ *			backing it, and shaders sample through shaders/virtual.glsl,
+ *			which falls back to the finest resident ancestor of a missing
+ *			page and records the page it wanted in a per-frame feedback
+ *			table. vk_dev_virtual_texture_begin_frame reads the feedback
+ *			back, makes the wanted pages resident and evicts the least
+ *			recently used ones once page_capacity pages are resident.
+ *
+ *			When the device supports sparse residency for the format, the
+ *			texture is a sparse image and physical pages are memory pages
+ *			from a pool of device memory blocks, bound with one batched
+ *			vkQueueBindSparse per frame on the context's queue that the
+ *			uploads into them wait for with a semaphore. Otherwise
+ *			(lavapipe, for one) physical pages are tiles of an atlas image,
+ *			stored with a border so filtering stays inside the tile, and the
+ *			page table is the only indirection. Either way the levels that
+ *			fit in one page (the mip tail) are always resident.
+ *
+ *			Evicted pages keep their physical page for frame_count frames,
+ *			since frames in flight may still sample them, and a sparse page
+ *			is not loaded again until its old binding has been released.
+ *			Shaders store feedback from the fragment stage, which needs
+ *			fragmentStoresAndAtomics. Only uncompressed formats are
+ *			supported.
+ */
+
+#define VK_DEV_VIRTUAL_PAGE_NONE UINT32_MAX
+
+struct vk_dev_virtual_texture_stats {
+	bool sparse;
+	uint32_t page_width;
+	uint32_t page_height;
+	uint32_t page_capacity;
+	uint32_t resident_pages;
+	uint64_t loads;
+	uint64_t evictions;
+	uint64_t bind_batches;
+	VkDeviceSize committed_bytes;
+};
+
+struct vk_dev_virtual_texture;
+
+/*
+ *	NOTE:	page_capacity is the number of pages, mip tail excluded, that
+ *			may be resident at once. file must stay open as long as the
+ *			texture exists.
+ */
+struct vk_dev_virtual_texture*
+vk_dev_virtual_texture_create(struct vk_dev_context* context,
+	struct vk_dev_bindless* bindless, struct vk_dev_staging* staging,
+	const struct vk_dev_asset_file* file,
+	const struct vk_dev_asset_entry* entry, const uint32_t page_capacity,
+	const uint32_t frame_count);
+
+void
+vk_dev_virtual_texture_destroy(struct vk_dev_virtual_texture* texture);
+
+/*
+ *	NOTE:	Call once the GPU has finished the frame that last used frame,
+ *			before recording anything that samples the texture. Binds and
+ *			uploads are complete when this returns.
+ */
+void
+vk_dev_virtual_texture_begin_frame(struct vk_dev_virtual_texture* texture,
+	const uint32_t frame);
+
+/*
+ *	NOTE:	Bindless buffer handle of frame's page table, to be passed to
+ *			shaders (see shaders/virtual.glsl).
+ */
+uint32_t
+vk_dev_virtual_texture_get_table(const struct vk_dev_virtual_texture* texture,
+	const uint32_t frame);
+
+void
+vk_dev_virtual_texture_get_stats(
+	const struct vk_dev_virtual_texture* texture,
+	struct vk_dev_virtual_texture_stats* stats);
+
+#endif // VULKAN_DEV_VIRTUAL_H
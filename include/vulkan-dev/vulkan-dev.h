@@ -1,12 +1,84 @@
 #ifndef VULKAN_DEV_H
 #define VULKAN_DEV_H
 
+#include <stdio.h>
+#include <stdint.h>
+
+#include <glad/vulkan.h>
+
+enum vk_dev_setup_phase {
+	VK_DEV_SETUP_PHASE_DLOPEN,
+	VK_DEV_SETUP_PHASE_SYMBOL_RESOLUTION,
+	VK_DEV_SETUP_PHASE_EXTENSION_ENUMERATION,
+	VK_DEV_SETUP_PHASE_INSTANCE_CREATION,
+	VK_DEV_SETUP_PHASE_DEVICE_ENUMERATION,
+	VK_DEV_SETUP_PHASE_DEVICE_CREATION,
+	VK_DEV_SETUP_PHASE_COUNT,
+};
+
+/*
+ *	NOTE:	Wall-clock cost of each stage of the last vk_dev_setup call.
+ *			Setting VK_DEV_SETUP_TIMINGS in the environment prints them to
+ *			stderr once setup completes.
+ */
+struct vk_dev_setup_timings {
+	uint64_t phase_ns[VK_DEV_SETUP_PHASE_COUNT];
+	uint64_t total_ns;
+};
+
+struct vk_dev_context;
+
+struct vk_dev_context*
+vk_dev_context_create(const int32_t device_index);
+
+void
+vk_dev_context_destroy(struct vk_dev_context* context);
+
+uint32_t
+vk_dev_context_get_physical_device_count(const struct vk_dev_context* context);
+
+void
+vk_dev_context_get_setup_timings(const struct vk_dev_context* context,
+	struct vk_dev_setup_timings* timings);
+
+void
+vk_dev_context_set_surface(struct vk_dev_context* context,
+	VkSurfaceKHR surface);
+
+/*
+ *	NOTE:	vk_dev_setup and friends drive a single default context and also
+ *			load glad's global vk* entry points for application code.
+ */
 void
 vk_dev_setup(void);
 
+void
+vk_dev_setup_begin(void);
+
+void
+vk_dev_setup_end(void);
+
 void
 vk_dev_terminate(void);
 
+struct vk_dev_context*
+vk_dev_get_context(void);
+
+VkInstance
+vk_dev_get_instance(void);
+
+void
+vk_dev_set_surface(VkSurfaceKHR surface);
+
+void
+vk_dev_get_setup_timings(struct vk_dev_setup_timings* timings);
+
+const char*
+vk_dev_setup_phase_name(const enum vk_dev_setup_phase phase);
+
+void
+vk_dev_print_setup_timings(FILE* stream);
+
 void
 vk_dev_fatal_error(const char* msg);
 
@@ -0,0 +1,23 @@
+#version 450
+
+/*
+ *	NOTE:	One small triangle per draw for tools/parallel-bench.c, placed
+ *			and coloured by push constants so every draw records its own.
+ */
+
+layout(push_constant) uniform vk_dev_bench_constants {
+	vec4 placement;
+	vec4 colour;
+};
+
+layout(location = 0) out vec4 out_colour;
+
+void
+main()
+{
+	vec2 corner;
+
+	corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1);
+	gl_Position = vec4(placement.xy + corner * placement.z, 0.0, 1.0);
+	out_colour = colour;
+}
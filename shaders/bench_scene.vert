@@ -0,0 +1,37 @@
+#version 450
+
+/*
+ *	NOTE:	Scene objects for tools/indirect-bench.c: a unit sphere mesh
+ *			scaled and placed by each object's bounding sphere, found with
+ *			gl_InstanceIndex as vulkan-dev/indirect.h lays its draws out.
+ */
+
+struct vk_dev_object {
+	vec4 sphere;
+	uint mesh;
+	uint cone;
+	uint padding[2];
+};
+
+layout(std430, binding = 0) readonly buffer vk_dev_objects {
+	vk_dev_object objects[];
+};
+
+layout(push_constant) uniform vk_dev_bench_scene {
+	mat4 view_projection;
+};
+
+layout(location = 0) in vec3 position;
+
+layout(location = 0) out vec3 out_colour;
+
+void
+main()
+{
+	vec4 sphere;
+
+	sphere = objects[gl_InstanceIndex].sphere;
+	gl_Position = view_projection * vec4(sphere.xyz + position * sphere.w,
+		1.0);
+	out_colour = position * 0.5 + 0.5;
+}
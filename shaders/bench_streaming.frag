@@ -0,0 +1,22 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "bindless.glsl"
+#include "streaming.glsl"
+
+layout(push_constant) uniform vk_dev_bench_constants {
+	uint table;
+	uint texture_index;
+	uint sampler_handle;
+};
+
+layout(location = 0) in vec2 uv;
+
+layout(location = 0) out vec4 out_colour;
+
+void
+main()
+{
+	out_colour = vk_dev_streaming_sample(table, texture_index, sampler_handle,
+		uv);
+}
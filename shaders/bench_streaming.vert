@@ -0,0 +1,15 @@
+#version 450
+
+/*
+ *	NOTE:	A full-screen triangle for tools/streaming-bench.c, with UVs
+ *			covering [0, 1] across the screen.
+ */
+
+layout(location = 0) out vec2 out_uv;
+
+void
+main()
+{
+	out_uv = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+	gl_Position = vec4(out_uv * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,30 @@
+/*
+ *	NOTE:	Shader side of the bindless resource table (vulkan-dev/bindless.h).
+ *			Include from a shader compiled with GL_EXT_nonuniform_qualifier
+ *			and declare VK_DEV_BINDLESS_SET first if the table is not bound
+ *			at set 0. Handles that vary within a draw or dispatch must be
+ *			wrapped in nonuniformEXT().
+ */
+
+#extension GL_EXT_nonuniform_qualifier : require
+
+#ifndef VK_DEV_BINDLESS_SET
+#define VK_DEV_BINDLESS_SET 0
+#endif
+
+layout(set = VK_DEV_BINDLESS_SET, binding = 0)
+	uniform texture2D vk_dev_textures[];
+
+layout(set = VK_DEV_BINDLESS_SET, binding = 1) buffer vk_dev_buffer {
+	uint data[];
+} vk_dev_buffers[];
+
+layout(set = VK_DEV_BINDLESS_SET, binding = 2)
+	uniform sampler vk_dev_samplers[];
+
+vec4
+vk_dev_bindless_sample(uint texture_handle, uint sampler_handle, vec2 uv)
+{
+	return texture(sampler2D(vk_dev_textures[nonuniformEXT(texture_handle)],
+		vk_dev_samplers[nonuniformEXT(sampler_handle)]), uv);
+}
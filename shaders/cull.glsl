@@ -0,0 +1,184 @@
+/*
+ *	NOTE:	Culling for vulkan-dev/indirect.h, included by cull.comp
+ *			(frustum and normal cone) and cull_occlusion.comp (adding Hi-Z). One
+ *			invocation per object; survivors are appended to the draw buffer
+ *			and counted along with their triangles.
+ */
+
+layout(local_size_x = 64) in;
+
+struct vk_dev_object {
+	vec4 sphere;
+	uint mesh;
+	uint cone;
+	uint padding[2];
+};
+
+struct vk_dev_mesh {
+	uint index_count;
+	uint first_index;
+	int vertex_offset;
+	uint padding;
+};
+
+struct vk_dev_draw {
+	uint index_count;
+	uint instance_count;
+	uint first_index;
+	int vertex_offset;
+	uint first_instance;
+};
+
+layout(std430, binding = 0) readonly buffer vk_dev_objects {
+	vk_dev_object objects[];
+};
+
+layout(std430, binding = 1) readonly buffer vk_dev_meshes {
+	vk_dev_mesh meshes[];
+};
+
+layout(std430, binding = 2) writeonly buffer vk_dev_draws {
+	vk_dev_draw draws[];
+};
+
+layout(std430, binding = 3) buffer vk_dev_draw_stats {
+	uint draw_count;
+	uint triangle_count;
+};
+
+#ifdef VK_DEV_CULL_OCCLUSION
+layout(binding = 4) uniform sampler2D pyramid;
+#endif
+
+layout(push_constant) uniform vk_dev_cull {
+	mat4 view_projection;
+	vec4 camera_position;
+	vec2 pyramid_size;
+	uint pyramid_levels;
+	uint object_count;
+} cull;
+
+/*
+ *	NOTE:	Gribb-Hartmann: each frustum plane is a sum of rows of the
+ *			view-projection matrix. Vulkan clip space has 0 <= z <= w, so the
+ *			near plane is the third row alone.
+ */
+bool
+vk_dev_cull_frustum(vec4 sphere)
+{
+	mat4 m = transpose(cull.view_projection);
+	vec4 planes[6] = vec4[6](m[3] + m[0], m[3] - m[0], m[3] + m[1],
+		m[3] - m[1], m[2], m[3] - m[2]);
+
+	for (int i = 0; i < 6; i++) {
+		vec4 plane = planes[i] / length(planes[i].xyz);
+		if (dot(plane.xyz, sphere.xyz) + plane.w < -sphere.w) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ *	NOTE:	Cone test from meshoptimizer: a cluster whose normals all lie
+ *			within the cone faces away from every point of its bounding
+ *			sphere when this holds. The packed cutoff is pre-rounded up so
+ *			the snorm axis error cannot cull a visible cluster.
+ */
+bool
+vk_dev_cull_cone(vec4 sphere, uint cone)
+{
+	if (cone == 0) {
+		return true;
+	}
+
+	vec4 unpacked = unpackSnorm4x8(cone);
+	vec3 direction = sphere.xyz - cull.camera_position.xyz;
+
+	return dot(direction, unpacked.xyz) <
+		unpacked.w * length(direction) + sphere.w;
+}
+
+#ifdef VK_DEV_CULL_OCCLUSION
+/*
+ *	NOTE:	Projects the sphere's bounding box to a screen rectangle and
+ *			nearest depth, then compares against the pyramid level where the
+ *			rectangle spans at most 2x2 texels. The object is hidden only if
+ *			its nearest point lies behind the farthest depth of all four.
+ */
+bool
+vk_dev_cull_occlusion(vec4 sphere)
+{
+	vec3 low = vec3(1.0);
+	vec3 high = vec3(0.0);
+
+	for (int i = 0; i < 8; i++) {
+		vec3 corner = sphere.xyz + sphere.w * vec3(
+			(i & 1) != 0 ? 1.0 : -1.0,
+			(i & 2) != 0 ? 1.0 : -1.0,
+			(i & 4) != 0 ? 1.0 : -1.0);
+		vec4 clip = cull.view_projection * vec4(corner, 1.0);
+
+		// NOTE: Boxes crossing the near plane cannot be projected safely.
+		if (clip.w <= 0.0) {
+			return true;
+		}
+
+		vec3 ndc = clip.xyz / clip.w;
+		vec3 point = vec3(ndc.xy * 0.5 + 0.5, ndc.z);
+		low = min(low, point);
+		high = max(high, point);
+	}
+
+	low.xy = clamp(low.xy, 0.0, 1.0);
+	high.xy = clamp(high.xy, 0.0, 1.0);
+
+	vec2 extent = (high.xy - low.xy) * cull.pyramid_size;
+	int level = int(ceil(log2(max(max(extent.x, extent.y), 1.0))));
+	level = min(level, int(cull.pyramid_levels) - 1);
+
+	ivec2 size = textureSize(pyramid, level);
+	ivec2 first = min(ivec2(low.xy * vec2(size)), size - 1);
+	ivec2 last = min(ivec2(high.xy * vec2(size)), size - 1);
+
+	float depth = max(
+		max(texelFetch(pyramid, first, level).r,
+			texelFetch(pyramid, ivec2(last.x, first.y), level).r),
+		max(texelFetch(pyramid, ivec2(first.x, last.y), level).r,
+			texelFetch(pyramid, last, level).r));
+
+	return low.z <= depth;
+}
+#endif
+
+void
+main()
+{
+	uint index = gl_GlobalInvocationID.x;
+	if (index >= cull.object_count) {
+		return;
+	}
+
+	vec4 sphere = objects[index].sphere;
+	if (!vk_dev_cull_frustum(sphere) ||
+		!vk_dev_cull_cone(sphere, objects[index].cone)) {
+		return;
+	}
+
+#ifdef VK_DEV_CULL_OCCLUSION
+	if (!vk_dev_cull_occlusion(sphere)) {
+		return;
+	}
+#endif
+
+	vk_dev_mesh mesh = meshes[objects[index].mesh];
+	uint slot = atomicAdd(draw_count, 1);
+	atomicAdd(triangle_count, mesh.index_count / 3);
+
+	draws[slot].index_count = mesh.index_count;
+	draws[slot].instance_count = 1;
+	draws[slot].first_index = mesh.first_index;
+	draws[slot].vertex_offset = mesh.vertex_offset;
+	draws[slot].first_instance = index;
+}
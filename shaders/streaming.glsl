@@ -0,0 +1,34 @@
+/*
+ *	NOTE:	Shader side of texture streaming (vulkan-dev/streaming.h).
+ *			Include after bindless.glsl. table is the handle returned by
+ *			vk_dev_streaming_get_table for the frame and texture the index
+ *			returned by vk_dev_streaming_add_texture. Sampling records the
+ *			finest mip level the texture is needed at, so it is only valid in
+ *			fragment shaders.
+ */
+
+#define VK_DEV_STREAMING_ENTRY_WORDS 4
+
+vec4
+vk_dev_streaming_sample(uint table, uint texture_index, uint sampler_handle,
+	vec2 uv)
+{
+	uint entry = texture_index * VK_DEV_STREAMING_ENTRY_WORDS;
+	uint handle = vk_dev_buffers[nonuniformEXT(table)].data[entry];
+	uint level = vk_dev_buffers[nonuniformEXT(table)].data[entry + 1];
+
+	sampler2D resident = sampler2D(vk_dev_textures[nonuniformEXT(handle)],
+		vk_dev_samplers[nonuniformEXT(sampler_handle)]);
+
+	/*
+	 *	NOTE:	The resident image starts at level, so its LOD is offset by
+	 *			that many levels from the full texture's. It is negative when
+	 *			the resident image is magnified, which asks for a finer level
+	 *			than the resident one.
+	 */
+	int wanted = int(level) + int(floor(textureQueryLod(resident, uv).y));
+	atomicMin(vk_dev_buffers[nonuniformEXT(table)].data[entry + 2],
+		uint(max(wanted, 0)));
+
+	return texture(resident, uv);
+}
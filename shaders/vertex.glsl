@@ -0,0 +1,35 @@
+/*
+ *	NOTE:	Shader side of the compact vertex formats (vulkan-dev/vertex.h).
+ *			Attributes arrive at the locations of vk_dev_vertex_attribute and
+ *			the UNORM/SNORM formats are already normalized by the input
+ *			assembler, so only the position range and the octahedral folding
+ *			are left to undo here.
+ */
+
+vec3
+vk_dev_vertex_position(vec4 position, vec3 offset, vec3 scale)
+{
+	return offset + position.xyz * scale;
+}
+
+vec3
+vk_dev_vertex_octahedral(vec2 encoded)
+{
+	vec3 vector = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float fold = max(-vector.z, 0.0);
+
+	vector.x += vector.x >= 0.0 ? -fold : fold;
+	vector.y += vector.y >= 0.0 ? -fold : fold;
+
+	return normalize(vector);
+}
+
+/*
+ *	NOTE:	The bitangent sign rides in the position's w: 0 for -1 and 1 for
+ *			+1.
+ */
+vec4
+vk_dev_vertex_tangent(vec2 encoded, vec4 position)
+{
+	return vec4(vk_dev_vertex_octahedral(encoded), position.w * 2.0 - 1.0);
+}
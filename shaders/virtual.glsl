@@ -0,0 +1,104 @@
+/*
+ *	NOTE:	Shader side of virtual textures (vulkan-dev/virtual.h). Include
+ *			after bindless.glsl. table is the handle returned by
+ *			vk_dev_virtual_texture_get_table for the frame. The level is
+ *			picked from screen space derivatives, so sampling is only valid
+ *			in fragment shaders; a missing page is stood in for by the finest
+ *			resident page covering it, and recorded as wanted.
+ *
+ *			In the atlas fallback the sampler should clamp to edge; pages
+ *			are filtered bilinearly within a level.
+ */
+
+#define VK_DEV_VIRTUAL_PAGE_NONE 0xffffffffu
+
+#define VK_DEV_VIRTUAL_HEADER_SPARSE 0
+#define VK_DEV_VIRTUAL_HEADER_HANDLE 1
+#define VK_DEV_VIRTUAL_HEADER_WIDTH 2
+#define VK_DEV_VIRTUAL_HEADER_HEIGHT 3
+#define VK_DEV_VIRTUAL_HEADER_LEVELS 4
+#define VK_DEV_VIRTUAL_HEADER_PAGE_WIDTH 5
+#define VK_DEV_VIRTUAL_HEADER_PAGE_HEIGHT 6
+#define VK_DEV_VIRTUAL_HEADER_BORDER 7
+#define VK_DEV_VIRTUAL_HEADER_TILE_SIZE 8
+#define VK_DEV_VIRTUAL_HEADER_TILES_PER_ROW 9
+#define VK_DEV_VIRTUAL_HEADER_ATLAS_SIZE 10
+#define VK_DEV_VIRTUAL_HEADER_FEEDBACK 11
+#define VK_DEV_VIRTUAL_HEADER_LEVEL_OFFSETS 16
+#define VK_DEV_VIRTUAL_HEADER_PAGES_X 32
+#define VK_DEV_VIRTUAL_HEADER_PAGES_Y 48
+
+#define VK_DEV_VIRTUAL_WORD(t, w) vk_dev_buffers[nonuniformEXT(t)].data[w]
+
+vec4
+vk_dev_virtual_sample(uint table, uint sampler_handle, vec2 uv)
+{
+	uvec2 size = uvec2(VK_DEV_VIRTUAL_WORD(table, VK_DEV_VIRTUAL_HEADER_WIDTH),
+		VK_DEV_VIRTUAL_WORD(table, VK_DEV_VIRTUAL_HEADER_HEIGHT));
+	uvec2 page_size = uvec2(
+		VK_DEV_VIRTUAL_WORD(table, VK_DEV_VIRTUAL_HEADER_PAGE_WIDTH),
+		VK_DEV_VIRTUAL_WORD(table, VK_DEV_VIRTUAL_HEADER_PAGE_HEIGHT));
+	uint levels = VK_DEV_VIRTUAL_WORD(table, VK_DEV_VIRTUAL_HEADER_LEVELS);
+	uint handle = VK_DEV_VIRTUAL_WORD(table, VK_DEV_VIRTUAL_HEADER_HANDLE);
+
+	uv = clamp(uv, 0.0, 1.0);
+
+	vec2 dx = dFdx(uv * vec2(size));
+	vec2 dy = dFdy(uv * vec2(size));
+	float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1.0));
+	uint level = min(uint(lod), levels - 1u);
+
+	uint entry = VK_DEV_VIRTUAL_PAGE_NONE;
+	vec2 texel;
+	uvec2 page;
+
+	/*
+	 *	NOTE:	The mip tail is always resident, so the walk towards coarser
+	 *			levels ends at the latest there.
+	 */
+	for (uint i = level; i < levels; i++) {
+		uvec2 pages = uvec2(
+			VK_DEV_VIRTUAL_WORD(table, VK_DEV_VIRTUAL_HEADER_PAGES_X + i),
+			VK_DEV_VIRTUAL_WORD(table, VK_DEV_VIRTUAL_HEADER_PAGES_Y + i));
+
+		texel = uv * vec2(max(size >> i, uvec2(1u)));
+		page = min(uvec2(texel) / page_size, pages - 1u);
+
+		uint word = VK_DEV_VIRTUAL_WORD(table,
+			VK_DEV_VIRTUAL_HEADER_LEVEL_OFFSETS + i) + page.y * pages.x + page.x;
+
+		if (i == level) {
+			VK_DEV_VIRTUAL_WORD(table, word + VK_DEV_VIRTUAL_WORD(table,
+				VK_DEV_VIRTUAL_HEADER_FEEDBACK)) = 1u;
+		}
+
+		entry = VK_DEV_VIRTUAL_WORD(table, word);
+		if (entry != VK_DEV_VIRTUAL_PAGE_NONE) {
+			level = i;
+			break;
+		}
+	}
+
+	sampler2D image = sampler2D(vk_dev_textures[nonuniformEXT(handle)],
+		vk_dev_samplers[nonuniformEXT(sampler_handle)]);
+
+	if (VK_DEV_VIRTUAL_WORD(table, VK_DEV_VIRTUAL_HEADER_SPARSE) != 0u) {
+		return textureLod(image, uv, float(level));
+	}
+
+	uint tiles_per_row = VK_DEV_VIRTUAL_WORD(table,
+		VK_DEV_VIRTUAL_HEADER_TILES_PER_ROW);
+	uint tile_size = VK_DEV_VIRTUAL_WORD(table,
+		VK_DEV_VIRTUAL_HEADER_TILE_SIZE);
+	uint border = VK_DEV_VIRTUAL_WORD(table, VK_DEV_VIRTUAL_HEADER_BORDER);
+	float atlas_size = float(VK_DEV_VIRTUAL_WORD(table,
+		VK_DEV_VIRTUAL_HEADER_ATLAS_SIZE));
+
+	uvec2 tile = uvec2(entry % tiles_per_row, entry / tiles_per_row);
+	vec2 atlas_texel = vec2(tile * tile_size + border) + texel -
+		vec2(page * page_size);
+
+	return textureLod(image, atlas_texel / atlas_size, 0.0);
+}
+
+#undef VK_DEV_VIRTUAL_WORD
@@ -0,0 +1,290 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <vulkan-dev/asset.h>
+#include <vulkan-dev/trace.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+struct vk_dev_asset_file {
+	const char* data;
+	size_t size;
+
+	const struct vk_dev_asset_header* header;
+	const struct vk_dev_asset_entry* entries;
+};
+
+static bool
+_vk_dev_asset_range_valid(const uint64_t offset, const uint64_t size,
+	const uint64_t limit)
+{
+	return offset <= limit && size <= limit - offset;
+}
+
+static bool
+_vk_dev_asset_entry_valid(const struct vk_dev_asset_entry* entry,
+	const uint64_t file_size)
+{
+	const struct vk_dev_asset_mesh* mesh;
+	const struct vk_dev_asset_texture* texture;
+
+	if (!_vk_dev_asset_range_valid(entry->offset, entry->size, file_size) ||
+		memchr(entry->name, '\0', sizeof(entry->name)) == NULL) {
+		return false;
+	}
+
+	switch (entry->kind) {
+	case VK_DEV_ASSET_MESH:
+		mesh = &entry->info.mesh;
+		return _vk_dev_asset_range_valid(mesh->vertex_offset,
+			(uint64_t)mesh->vertex_count * mesh->stride, entry->size) &&
+			_vk_dev_asset_range_valid(mesh->index_offset,
+			(uint64_t)mesh->index_count * sizeof(uint32_t), entry->size);
+	case VK_DEV_ASSET_TEXTURE:
+		texture = &entry->info.texture;
+		if (texture->levels == 0 ||
+			texture->levels > VK_DEV_ASSET_MAX_LEVELS) {
+			return false;
+		}
+
+		for (uint32_t i = 0; i < texture->levels; i++) {
+			if (!_vk_dev_asset_range_valid(texture->level_offsets[i],
+				texture->level_sizes[i], entry->size)) {
+				return false;
+			}
+		}
+
+		return true;
+	default:
+		return false;
+	}
+}
+
+struct vk_dev_asset_file*
+vk_dev_asset_open(const char* path)
+{
+	int fd;
+	void* data;
+	struct stat status;
+	struct vk_dev_asset_file* file;
+	const struct vk_dev_asset_header* header;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_asset_open");
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		VK_DEV_TRACE_END("vk_dev_asset_open");
+		return NULL;
+	}
+
+	if (fstat(fd, &status) != 0 ||
+		(size_t)status.st_size < sizeof(struct vk_dev_asset_header)) {
+		close(fd);
+		VK_DEV_TRACE_END("vk_dev_asset_open");
+		return NULL;
+	}
+
+	data = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (data == MAP_FAILED) {
+		VK_DEV_TRACE_END("vk_dev_asset_open");
+		return NULL;
+	}
+
+	file = malloc(sizeof(*file));
+	if (file == NULL) {
+		vk_dev_fatal_error("[ASSET] Failed to allocate asset file.");
+	}
+
+	file->data = data;
+	file->size = status.st_size;
+
+	header = data;
+	file->header = header;
+	file->entries = NULL;
+
+	if (header->magic != VK_DEV_ASSET_MAGIC ||
+		header->version != VK_DEV_ASSET_VERSION ||
+		header->file_size != file->size ||
+		header->entries_offset % sizeof(uint64_t) != 0 ||
+		!_vk_dev_asset_range_valid(header->entries_offset,
+		(uint64_t)header->entry_count * sizeof(struct vk_dev_asset_entry),
+		file->size)) {
+		vk_dev_asset_close(file);
+		VK_DEV_TRACE_END("vk_dev_asset_open");
+		return NULL;
+	}
+
+	file->entries = (const struct vk_dev_asset_entry*)(file->data +
+		header->entries_offset);
+
+	for (uint32_t i = 0; i < header->entry_count; i++) {
+		if (!_vk_dev_asset_entry_valid(&file->entries[i], file->size)) {
+			vk_dev_asset_close(file);
+			VK_DEV_TRACE_END("vk_dev_asset_open");
+			return NULL;
+		}
+	}
+
+	/*
+	 *	NOTE:	Uploads read every section front to back exactly once, so let
+	 *			the kernel read ahead aggressively.
+	 */
+	posix_madvise(data, file->size, POSIX_MADV_SEQUENTIAL);
+
+	VK_DEV_TRACE_END("vk_dev_asset_open");
+
+	return file;
+}
+
+void
+vk_dev_asset_close(struct vk_dev_asset_file* file)
+{
+	if (file == NULL) {
+		return;
+	}
+
+	munmap((void*)file->data, file->size);
+	free(file);
+}
+
+uint32_t
+vk_dev_asset_get_entry_count(const struct vk_dev_asset_file* file)
+{
+	return file->header->entry_count;
+}
+
+const struct vk_dev_asset_entry*
+vk_dev_asset_get_entry(const struct vk_dev_asset_file* file,
+	const uint32_t index)
+{
+	return &file->entries[index];
+}
+
+const struct vk_dev_asset_entry*
+vk_dev_asset_find(const struct vk_dev_asset_file* file, const char* name)
+{
+	int order;
+	uint32_t low, high, middle;
+
+	low = 0;
+	high = file->header->entry_count;
+
+	while (low < high) {
+		middle = low + (high - low) / 2;
+
+		order = strncmp(name, file->entries[middle].name,
+			VK_DEV_ASSET_NAME_SIZE);
+		if (order == 0) {
+			return &file->entries[middle];
+		}
+
+		if (order < 0) {
+			high = middle;
+		} else {
+			low = middle + 1;
+		}
+	}
+
+	return NULL;
+}
+
+const void*
+vk_dev_asset_get_data(const struct vk_dev_asset_file* file,
+	const struct vk_dev_asset_entry* entry)
+{
+	return file->data + entry->offset;
+}
+
+void
+vk_dev_asset_get_vertex_format(const struct vk_dev_asset_entry* entry,
+	struct vk_dev_vertex_format* format)
+{
+	const struct vk_dev_asset_mesh* mesh;
+
+	mesh = &entry->info.mesh;
+
+	format->stride = mesh->stride;
+	for (int i = 0; i < VK_DEV_VERTEX_ATTRIBUTE_COUNT; i++) {
+		format->offsets[i] = mesh->attribute_offsets[i];
+		format->formats[i] = (VkFormat)mesh->attribute_formats[i];
+	}
+
+	for (int i = 0; i < 3; i++) {
+		format->position_offset[i] = mesh->position_offset[i];
+		format->position_scale[i] = mesh->position_scale[i];
+	}
+}
+
+void
+vk_dev_asset_upload_mesh(struct vk_dev_context* context,
+	struct vk_dev_staging* staging, const struct vk_dev_asset_file* file,
+	const struct vk_dev_asset_entry* entry, struct vk_dev_buffer* vertices,
+	struct vk_dev_buffer* indices)
+{
+	const char* data;
+	VkDeviceSize vertex_size, index_size;
+	const struct vk_dev_asset_mesh* mesh;
+
+	if (entry->kind != VK_DEV_ASSET_MESH) {
+		vk_dev_fatal_error("[ASSET] Entry is not a mesh.");
+	}
+
+	VK_DEV_TRACE_BEGIN("vk_dev_asset_upload_mesh");
+
+	mesh = &entry->info.mesh;
+	data = vk_dev_asset_get_data(file, entry);
+
+	vertex_size = (VkDeviceSize)mesh->vertex_count * mesh->stride;
+	index_size = (VkDeviceSize)mesh->index_count * sizeof(uint32_t);
+
+	vk_dev_buffer_create(context, vertex_size,
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertices);
+	vk_dev_buffer_create(context, index_size,
+		VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indices);
+
+	vk_dev_staging_upload_buffer(staging, vertices->buffer, 0,
+		data + mesh->vertex_offset, vertex_size);
+	vk_dev_staging_upload_buffer(staging, indices->buffer, 0,
+		data + mesh->index_offset, index_size);
+
+	VK_DEV_TRACE_END("vk_dev_asset_upload_mesh");
+}
+
+void
+vk_dev_asset_upload_texture(struct vk_dev_context* context,
+	struct vk_dev_staging* staging, const struct vk_dev_asset_file* file,
+	const struct vk_dev_asset_entry* entry, struct vk_dev_image* image)
+{
+	const char* data;
+	const struct vk_dev_asset_texture* texture;
+
+	if (entry->kind != VK_DEV_ASSET_TEXTURE) {
+		vk_dev_fatal_error("[ASSET] Entry is not a texture.");
+	}
+
+	VK_DEV_TRACE_BEGIN("vk_dev_asset_upload_texture");
+
+	texture = &entry->info.texture;
+	data = vk_dev_asset_get_data(file, entry);
+
+	vk_dev_image_create(context, texture->width, texture->height,
+		texture->levels, (VkFormat)texture->format,
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, image);
+
+	for (uint32_t i = 0; i < texture->levels; i++) {
+		vk_dev_staging_upload_image(staging, image, i,
+			data + texture->level_offsets[i], texture->level_sizes[i]);
+	}
+
+	VK_DEV_TRACE_END("vk_dev_asset_upload_texture");
+}
@@ -0,0 +1,231 @@
+#include <vulkan-dev/baker.h>
+#include <vulkan-dev/asset.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VK_DEV_BAKER_LEVEL_ALIGNMENT 256
+
+struct vk_dev_baker {
+	FILE* file;
+	uint64_t offset;
+	bool failed;
+
+	struct vk_dev_asset_entry* entries;
+	uint32_t entry_count;
+	uint32_t entry_capacity;
+};
+
+static uint64_t
+_vk_dev_baker_align(const uint64_t value, const uint64_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+static void
+_vk_dev_baker_write(struct vk_dev_baker* baker, const void* data,
+	const uint64_t size)
+{
+	if (size > 0 && fwrite(data, 1, size, baker->file) != size) {
+		baker->failed = true;
+	}
+
+	baker->offset += size;
+}
+
+static void
+_vk_dev_baker_pad(struct vk_dev_baker* baker, const uint64_t alignment)
+{
+	static const char zeros[VK_DEV_ASSET_ALIGNMENT];
+	uint64_t padding;
+
+	padding = _vk_dev_baker_align(baker->offset, alignment) - baker->offset;
+	_vk_dev_baker_write(baker, zeros, padding);
+}
+
+static struct vk_dev_asset_entry*
+_vk_dev_baker_begin_entry(struct vk_dev_baker* baker, const char* name,
+	const enum vk_dev_asset_kind kind)
+{
+	struct vk_dev_asset_entry* entry;
+
+	if (strlen(name) >= VK_DEV_ASSET_NAME_SIZE) {
+		vk_dev_fatal_error("[BAKER] Asset name too long.");
+	}
+
+	if (baker->entry_count == baker->entry_capacity) {
+		baker->entry_capacity = baker->entry_capacity > 0 ?
+			baker->entry_capacity * 2 : 16;
+		baker->entries = realloc(baker->entries,
+			sizeof(*baker->entries) * baker->entry_capacity);
+		if (baker->entries == NULL) {
+			vk_dev_fatal_error("[BAKER] Failed to allocate entries.");
+		}
+	}
+
+	_vk_dev_baker_pad(baker, VK_DEV_ASSET_ALIGNMENT);
+
+	entry = &baker->entries[baker->entry_count++];
+	memset(entry, 0, sizeof(*entry));
+	strcpy(entry->name, name);
+	entry->kind = kind;
+	entry->offset = baker->offset;
+
+	return entry;
+}
+
+struct vk_dev_baker*
+vk_dev_baker_create(const char* path)
+{
+	struct vk_dev_baker* baker;
+	struct vk_dev_asset_header header;
+
+	baker = malloc(sizeof(*baker));
+	if (baker == NULL) {
+		vk_dev_fatal_error("[BAKER] Failed to allocate baker.");
+	}
+
+	baker->file = fopen(path, "wb");
+	if (baker->file == NULL) {
+		free(baker);
+		return NULL;
+	}
+
+	baker->offset = 0;
+	baker->failed = false;
+	baker->entries = NULL;
+	baker->entry_count = 0;
+	baker->entry_capacity = 0;
+
+	// NOTE: Reserve the header; it is rewritten by vk_dev_baker_finish.
+	memset(&header, 0, sizeof(header));
+	_vk_dev_baker_write(baker, &header, sizeof(header));
+
+	return baker;
+}
+
+void
+vk_dev_baker_add_mesh(struct vk_dev_baker* baker, const char* name,
+	const struct vk_dev_vertex_format* format, const void* vertices,
+	const uint32_t vertex_count, const uint32_t* indices,
+	const uint32_t index_count)
+{
+	struct vk_dev_asset_mesh* mesh;
+	struct vk_dev_asset_entry* entry;
+
+	entry = _vk_dev_baker_begin_entry(baker, name, VK_DEV_ASSET_MESH);
+	mesh = &entry->info.mesh;
+
+	mesh->vertex_count = vertex_count;
+	mesh->index_count = index_count;
+	mesh->stride = format->stride;
+
+	for (int i = 0; i < VK_DEV_VERTEX_ATTRIBUTE_COUNT; i++) {
+		mesh->attribute_offsets[i] = format->offsets[i];
+		mesh->attribute_formats[i] = format->formats[i];
+	}
+
+	for (int i = 0; i < 3; i++) {
+		mesh->position_offset[i] = format->position_offset[i];
+		mesh->position_scale[i] = format->position_scale[i];
+	}
+
+	mesh->vertex_offset = 0;
+	_vk_dev_baker_write(baker, vertices,
+		(uint64_t)vertex_count * format->stride);
+
+	_vk_dev_baker_pad(baker, sizeof(uint32_t));
+	mesh->index_offset = baker->offset - entry->offset;
+	_vk_dev_baker_write(baker, indices,
+		(uint64_t)index_count * sizeof(*indices));
+
+	entry->size = baker->offset - entry->offset;
+}
+
+void
+vk_dev_baker_add_texture(struct vk_dev_baker* baker, const char* name,
+	const VkFormat format, const uint32_t width, const uint32_t height,
+	const uint32_t level_count, const void* const* levels,
+	const uint64_t* level_sizes)
+{
+	struct vk_dev_asset_entry* entry;
+	struct vk_dev_asset_texture* texture;
+
+	if (level_count == 0 || level_count > VK_DEV_ASSET_MAX_LEVELS) {
+		vk_dev_fatal_error("[BAKER] Unsupported texture level count.");
+	}
+
+	entry = _vk_dev_baker_begin_entry(baker, name, VK_DEV_ASSET_TEXTURE);
+	texture = &entry->info.texture;
+
+	texture->format = format;
+	texture->width = width;
+	texture->height = height;
+	texture->levels = level_count;
+
+	for (uint32_t i = 0; i < level_count; i++) {
+		_vk_dev_baker_pad(baker, VK_DEV_BAKER_LEVEL_ALIGNMENT);
+
+		texture->level_offsets[i] = baker->offset - entry->offset;
+		texture->level_sizes[i] = level_sizes[i];
+		_vk_dev_baker_write(baker, levels[i], level_sizes[i]);
+	}
+
+	entry->size = baker->offset - entry->offset;
+}
+
+static int
+_vk_dev_baker_entry_compare(const void* a, const void* b)
+{
+	const struct vk_dev_asset_entry* lhs = a;
+	const struct vk_dev_asset_entry* rhs = b;
+
+	return strncmp(lhs->name, rhs->name, VK_DEV_ASSET_NAME_SIZE);
+}
+
+bool
+vk_dev_baker_finish(struct vk_dev_baker* baker)
+{
+	bool result;
+	struct vk_dev_asset_header header;
+
+	qsort(baker->entries, baker->entry_count, sizeof(*baker->entries),
+		_vk_dev_baker_entry_compare);
+
+	for (uint32_t i = 1; i < baker->entry_count; i++) {
+		if (_vk_dev_baker_entry_compare(&baker->entries[i - 1],
+			&baker->entries[i]) == 0) {
+			vk_dev_fatal_error("[BAKER] Duplicate asset name.");
+		}
+	}
+
+	_vk_dev_baker_pad(baker, sizeof(uint64_t));
+
+	header.magic = VK_DEV_ASSET_MAGIC;
+	header.version = VK_DEV_ASSET_VERSION;
+	header.entry_count = baker->entry_count;
+	header.padding = 0;
+	header.entries_offset = baker->offset;
+
+	_vk_dev_baker_write(baker, baker->entries,
+		(uint64_t)baker->entry_count * sizeof(*baker->entries));
+
+	header.file_size = baker->offset;
+
+	if (fseek(baker->file, 0, SEEK_SET) != 0 ||
+		fwrite(&header, sizeof(header), 1, baker->file) != 1) {
+		baker->failed = true;
+	}
+
+	if (fclose(baker->file) != 0) {
+		baker->failed = true;
+	}
+
+	result = !baker->failed;
+
+	free(baker->entries);
+	free(baker);
+
+	return result;
+}
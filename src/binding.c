@@ -0,0 +1,212 @@
+#include <vulkan-dev/binding.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/trace.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+struct vk_dev_binding_layout {
+	struct vk_dev_context* context;
+
+	VkDescriptorSetLayout layout;
+	VkDescriptorUpdateTemplate update_template;
+	bool push;
+
+	VkPipelineBindPoint bind_point;
+	VkPipelineLayout pipeline_layout;
+	uint32_t set;
+
+	struct vk_dev_binding* bindings;
+	uint32_t binding_count;
+};
+
+/*
+ *	NOTE:	Push descriptor layouts may not contain dynamic buffers and are
+ *			capped at maxPushDescriptors descriptors in total.
+ */
+static bool
+_vk_dev_binding_can_push(const struct vk_dev_context* context,
+	const struct vk_dev_binding* bindings, const uint32_t binding_count)
+{
+	uint32_t descriptor_count;
+
+	if (context->extensions.push_descriptor == false) {
+		return false;
+	}
+
+	descriptor_count = 0;
+	for (uint32_t i = 0; i < binding_count; i++) {
+		if (bindings[i].type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ||
+			bindings[i].type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC) {
+			return false;
+		}
+
+		descriptor_count += bindings[i].count;
+	}
+
+	return descriptor_count <=
+		context->push_descriptor_properties.maxPushDescriptors;
+}
+
+struct vk_dev_binding_layout*
+vk_dev_binding_layout_create(struct vk_dev_context* context,
+	const struct vk_dev_binding* bindings, const uint32_t binding_count)
+{
+	VkResult result;
+	VkDescriptorSetLayoutBinding* layout_bindings;
+	VkDescriptorSetLayoutCreateInfo create_info;
+	struct vk_dev_binding_layout* layout;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_binding_layout_create");
+
+	layout = calloc(1, sizeof(*layout));
+	if (layout == NULL) {
+		vk_dev_fatal_error("[BINDING] Failed to allocate binding layout.");
+	}
+
+	layout_bindings = malloc(sizeof(*layout_bindings) * binding_count);
+	layout->bindings = malloc(sizeof(*layout->bindings) * binding_count);
+	if (layout_bindings == NULL || layout->bindings == NULL) {
+		vk_dev_fatal_error("[BINDING] Failed to allocate bindings.");
+	}
+
+	layout->context = context;
+	layout->push = _vk_dev_binding_can_push(context, bindings, binding_count);
+	layout->binding_count = binding_count;
+
+	for (uint32_t i = 0; i < binding_count; i++) {
+		layout->bindings[i] = bindings[i];
+
+		layout_bindings[i].binding = bindings[i].binding;
+		layout_bindings[i].descriptorType = bindings[i].type;
+		layout_bindings[i].descriptorCount = bindings[i].count;
+		layout_bindings[i].stageFlags = bindings[i].stages;
+		layout_bindings[i].pImmutableSamplers = NULL;
+	}
+
+	create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	create_info.pNext = NULL;
+	create_info.flags = layout->push ?
+		VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0;
+	create_info.bindingCount = binding_count;
+	create_info.pBindings = layout_bindings;
+
+	result = context->vk.CreateDescriptorSetLayout(context->device,
+		&create_info, NULL, &layout->layout);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[BINDING] Failed to create descriptor set layout.");
+	}
+
+	free(layout_bindings);
+
+	VK_DEV_TRACE_END("vk_dev_binding_layout_create");
+
+	return layout;
+}
+
+void
+vk_dev_binding_layout_destroy(struct vk_dev_binding_layout* layout)
+{
+	if (layout->update_template != VK_NULL_HANDLE) {
+		layout->context->vk.DestroyDescriptorUpdateTemplate(
+			layout->context->device, layout->update_template, NULL);
+	}
+
+	layout->context->vk.DestroyDescriptorSetLayout(layout->context->device,
+		layout->layout, NULL);
+
+	free(layout->bindings);
+	free(layout);
+}
+
+VkDescriptorSetLayout
+vk_dev_binding_layout_get_layout(const struct vk_dev_binding_layout* layout)
+{
+	return layout->layout;
+}
+
+bool
+vk_dev_binding_layout_uses_push_descriptors(
+	const struct vk_dev_binding_layout* layout)
+{
+	return layout->push;
+}
+
+void
+vk_dev_binding_layout_set_pipeline(struct vk_dev_binding_layout* layout,
+	const VkPipelineBindPoint bind_point, VkPipelineLayout pipeline_layout,
+	const uint32_t set)
+{
+	VkResult result;
+	VkDescriptorUpdateTemplateEntry* entries;
+	VkDescriptorUpdateTemplateCreateInfo create_info;
+
+	if (layout->update_template != VK_NULL_HANDLE) {
+		layout->context->vk.DestroyDescriptorUpdateTemplate(
+			layout->context->device, layout->update_template, NULL);
+	}
+
+	entries = malloc(sizeof(*entries) * layout->binding_count);
+	if (entries == NULL) {
+		vk_dev_fatal_error("[BINDING] Failed to allocate template entries.");
+	}
+
+	for (uint32_t i = 0; i < layout->binding_count; i++) {
+		entries[i].dstBinding = layout->bindings[i].binding;
+		entries[i].dstArrayElement = 0;
+		entries[i].descriptorCount = layout->bindings[i].count;
+		entries[i].descriptorType = layout->bindings[i].type;
+		entries[i].offset = layout->bindings[i].offset;
+		entries[i].stride = layout->bindings[i].stride;
+	}
+
+	create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+	create_info.pNext = NULL;
+	create_info.flags = 0;
+	create_info.descriptorUpdateEntryCount = layout->binding_count;
+	create_info.pDescriptorUpdateEntries = entries;
+	create_info.templateType = layout->push ?
+		VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR :
+		VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+	create_info.descriptorSetLayout = layout->layout;
+	create_info.pipelineBindPoint = bind_point;
+	create_info.pipelineLayout = pipeline_layout;
+	create_info.set = set;
+
+	result = layout->context->vk.CreateDescriptorUpdateTemplate(
+		layout->context->device, &create_info, NULL,
+		&layout->update_template);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[BINDING] Failed to create update template.");
+	}
+
+	free(entries);
+
+	layout->bind_point = bind_point;
+	layout->pipeline_layout = pipeline_layout;
+	layout->set = set;
+}
+
+void
+vk_dev_binding_layout_write(const struct vk_dev_binding_layout* layout,
+	VkCommandBuffer command_buffer,
+	struct vk_dev_descriptor_allocator* allocator, const void* data)
+{
+	VkDescriptorSet set;
+
+	if (layout->push) {
+		layout->context->vk.CmdPushDescriptorSetWithTemplateKHR(
+			command_buffer, layout->update_template, layout->pipeline_layout,
+			layout->set, data);
+		return;
+	}
+
+	set = vk_dev_descriptor_allocator_allocate(allocator, layout->layout);
+
+	layout->context->vk.UpdateDescriptorSetWithTemplate(
+		layout->context->device, set, layout->update_template, data);
+	layout->context->vk.CmdBindDescriptorSets(command_buffer,
+		layout->bind_point, layout->pipeline_layout, layout->set, 1, &set, 0,
+		NULL);
+}
@@ -0,0 +1,367 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <vulkan-dev/bindless.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/trace.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#define VK_DEV_BINDLESS_LIVE (VK_DEV_BINDLESS_INVALID - 1)
+
+/*
+ *	NOTE:	Free-list index allocator. Free slots form a singly linked list
+ *			threaded through next[], so allocation and release are O(1)
+ *			and a released handle is the first to be handed out again.
+ *			Allocated slots hold VK_DEV_BINDLESS_LIVE instead, so a handle
+ *			that is already free cannot be linked into the list twice.
+ */
+struct _vk_dev_bindless_slots {
+	uint32_t* next;
+	uint32_t head;
+	uint32_t capacity;
+};
+
+struct vk_dev_bindless {
+	struct vk_dev_context* context;
+
+	VkDescriptorSetLayout layout;
+	VkDescriptorPool pool;
+	VkDescriptorSet set;
+
+	pthread_mutex_t lock;
+	struct _vk_dev_bindless_slots slots[VK_DEV_BINDLESS_KIND_COUNT];
+};
+
+static const VkDescriptorType _descriptor_types[VK_DEV_BINDLESS_KIND_COUNT] = {
+	VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+	VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	VK_DESCRIPTOR_TYPE_SAMPLER,
+};
+
+static void
+_vk_dev_bindless_slots_create(struct _vk_dev_bindless_slots* slots,
+	const uint32_t capacity)
+{
+	slots->next = malloc(sizeof(*slots->next) * capacity);
+	if (slots->next == NULL) {
+		vk_dev_fatal_error("[BINDLESS] Failed to allocate handle table.");
+	}
+
+	for (uint32_t i = 0; i < capacity; i++) {
+		slots->next[i] = i + 1 < capacity ? i + 1 : VK_DEV_BINDLESS_INVALID;
+	}
+
+	slots->head = capacity > 0 ? 0 : VK_DEV_BINDLESS_INVALID;
+	slots->capacity = capacity;
+}
+
+static uint32_t
+_vk_dev_bindless_slots_alloc(struct _vk_dev_bindless_slots* slots)
+{
+	uint32_t handle;
+
+	handle = slots->head;
+	if (handle == VK_DEV_BINDLESS_INVALID) {
+		vk_dev_fatal_error("[BINDLESS] Resource table is full.");
+	}
+
+	slots->head = slots->next[handle];
+	slots->next[handle] = VK_DEV_BINDLESS_LIVE;
+
+	return handle;
+}
+
+static void
+_vk_dev_bindless_slots_free(struct _vk_dev_bindless_slots* slots,
+	const uint32_t handle)
+{
+	if (handle >= slots->capacity ||
+		slots->next[handle] != VK_DEV_BINDLESS_LIVE) {
+		vk_dev_fatal_error("[BINDLESS] Removed a handle that is not "
+			"allocated.");
+	}
+
+	slots->next[handle] = slots->head;
+	slots->head = handle;
+}
+
+/*
+ *	NOTE:	Every binding is visible to all stages, so a capacity must fit
+ *			both the per-set and the per-stage update-after-bind limit.
+ */
+static uint32_t
+_vk_dev_bindless_clamp(const uint32_t requested, const uint32_t set_limit,
+	const uint32_t stage_limit)
+{
+	uint32_t limit;
+
+	limit = set_limit < stage_limit ? set_limit : stage_limit;
+
+	return requested < limit ? requested : limit;
+}
+
+static void
+_vk_dev_bindless_layout_create(struct vk_dev_bindless* bindless)
+{
+	VkResult result;
+	VkDescriptorSetLayoutBinding bindings[VK_DEV_BINDLESS_KIND_COUNT];
+	VkDescriptorBindingFlagsEXT binding_flags[VK_DEV_BINDLESS_KIND_COUNT];
+	VkDescriptorSetLayoutBindingFlagsCreateInfoEXT flags_info;
+	VkDescriptorSetLayoutCreateInfo create_info;
+
+	/*
+	 *	NOTE:	Update-after-bind lets handles be added while the set is bound
+	 *			in command buffers that are still executing; partially bound
+	 *			means unused slots need no valid descriptor.
+	 */
+	for (int i = 0; i < VK_DEV_BINDLESS_KIND_COUNT; i++) {
+		bindings[i].binding = i;
+		bindings[i].descriptorType = _descriptor_types[i];
+		bindings[i].descriptorCount = bindless->slots[i].capacity;
+		bindings[i].stageFlags = VK_SHADER_STAGE_ALL;
+		bindings[i].pImmutableSamplers = NULL;
+
+		binding_flags[i] = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+			VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT |
+			VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+	}
+
+	flags_info.sType =
+		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+	flags_info.pNext = NULL;
+	flags_info.bindingCount = VK_DEV_BINDLESS_KIND_COUNT;
+	flags_info.pBindingFlags = binding_flags;
+
+	create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	create_info.pNext = &flags_info;
+	create_info.flags =
+		VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+	create_info.bindingCount = VK_DEV_BINDLESS_KIND_COUNT;
+	create_info.pBindings = bindings;
+
+	result = bindless->context->vk.CreateDescriptorSetLayout(
+		bindless->context->device, &create_info, NULL, &bindless->layout);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[BINDLESS] Failed to create descriptor set layout.");
+	}
+}
+
+static void
+_vk_dev_bindless_set_create(struct vk_dev_bindless* bindless)
+{
+	VkResult result;
+	VkDescriptorPoolSize pool_sizes[VK_DEV_BINDLESS_KIND_COUNT];
+	VkDescriptorPoolCreateInfo pool_info;
+	VkDescriptorSetAllocateInfo allocate_info;
+
+	for (int i = 0; i < VK_DEV_BINDLESS_KIND_COUNT; i++) {
+		pool_sizes[i].type = _descriptor_types[i];
+		pool_sizes[i].descriptorCount = bindless->slots[i].capacity;
+	}
+
+	pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.pNext = NULL;
+	pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+	pool_info.maxSets = 1;
+	pool_info.poolSizeCount = VK_DEV_BINDLESS_KIND_COUNT;
+	pool_info.pPoolSizes = pool_sizes;
+
+	result = bindless->context->vk.CreateDescriptorPool(
+		bindless->context->device, &pool_info, NULL, &bindless->pool);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[BINDLESS] Failed to create descriptor pool.");
+	}
+
+	allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocate_info.pNext = NULL;
+	allocate_info.descriptorPool = bindless->pool;
+	allocate_info.descriptorSetCount = 1;
+	allocate_info.pSetLayouts = &bindless->layout;
+
+	result = bindless->context->vk.AllocateDescriptorSets(
+		bindless->context->device, &allocate_info, &bindless->set);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[BINDLESS] Failed to allocate descriptor set.");
+	}
+}
+
+struct vk_dev_bindless*
+vk_dev_bindless_create(struct vk_dev_context* context,
+	const uint32_t texture_capacity, const uint32_t buffer_capacity,
+	const uint32_t sampler_capacity)
+{
+	struct vk_dev_bindless* bindless;
+	const VkPhysicalDeviceDescriptorIndexingFeaturesEXT* features;
+	const VkPhysicalDeviceDescriptorIndexingPropertiesEXT* limits;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_bindless_create");
+
+	features = &context->descriptor_indexing;
+	if (context->extensions.descriptor_indexing == false ||
+		features->runtimeDescriptorArray == VK_FALSE ||
+		features->shaderSampledImageArrayNonUniformIndexing == VK_FALSE ||
+		features->shaderStorageBufferArrayNonUniformIndexing == VK_FALSE ||
+		features->descriptorBindingPartiallyBound == VK_FALSE ||
+		features->descriptorBindingSampledImageUpdateAfterBind == VK_FALSE ||
+		features->descriptorBindingStorageBufferUpdateAfterBind == VK_FALSE ||
+		features->descriptorBindingUpdateUnusedWhilePending == VK_FALSE) {
+		vk_dev_fatal_error("[BINDLESS] Descriptor indexing not supported.");
+	}
+
+	bindless = calloc(1, sizeof(*bindless));
+	if (bindless == NULL) {
+		vk_dev_fatal_error("[BINDLESS] Failed to allocate resource table.");
+	}
+
+	bindless->context = context;
+	pthread_mutex_init(&bindless->lock, NULL);
+
+	limits = &context->descriptor_indexing_properties;
+	_vk_dev_bindless_slots_create(&bindless->slots[VK_DEV_BINDLESS_TEXTURE],
+		_vk_dev_bindless_clamp(texture_capacity,
+		limits->maxDescriptorSetUpdateAfterBindSampledImages,
+		limits->maxPerStageDescriptorUpdateAfterBindSampledImages));
+	_vk_dev_bindless_slots_create(&bindless->slots[VK_DEV_BINDLESS_BUFFER],
+		_vk_dev_bindless_clamp(buffer_capacity,
+		limits->maxDescriptorSetUpdateAfterBindStorageBuffers,
+		limits->maxPerStageDescriptorUpdateAfterBindStorageBuffers));
+	_vk_dev_bindless_slots_create(&bindless->slots[VK_DEV_BINDLESS_SAMPLER],
+		_vk_dev_bindless_clamp(sampler_capacity,
+		limits->maxDescriptorSetUpdateAfterBindSamplers,
+		limits->maxPerStageDescriptorUpdateAfterBindSamplers));
+
+	_vk_dev_bindless_layout_create(bindless);
+	_vk_dev_bindless_set_create(bindless);
+
+	VK_DEV_TRACE_END("vk_dev_bindless_create");
+
+	return bindless;
+}
+
+void
+vk_dev_bindless_destroy(struct vk_dev_bindless* bindless)
+{
+	bindless->context->vk.DestroyDescriptorPool(bindless->context->device,
+		bindless->pool, NULL);
+	bindless->context->vk.DestroyDescriptorSetLayout(bindless->context->device,
+		bindless->layout, NULL);
+
+	for (int i = 0; i < VK_DEV_BINDLESS_KIND_COUNT; i++) {
+		free(bindless->slots[i].next);
+	}
+
+	pthread_mutex_destroy(&bindless->lock);
+	free(bindless);
+}
+
+static uint32_t
+_vk_dev_bindless_write(struct vk_dev_bindless* bindless,
+	const enum vk_dev_bindless_kind kind,
+	const VkDescriptorImageInfo* image_info,
+	const VkDescriptorBufferInfo* buffer_info)
+{
+	uint32_t handle;
+	VkWriteDescriptorSet write;
+
+	pthread_mutex_lock(&bindless->lock);
+	handle = _vk_dev_bindless_slots_alloc(&bindless->slots[kind]);
+	pthread_mutex_unlock(&bindless->lock);
+
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.pNext = NULL;
+	write.dstSet = bindless->set;
+	write.dstBinding = kind;
+	write.dstArrayElement = handle;
+	write.descriptorCount = 1;
+	write.descriptorType = _descriptor_types[kind];
+	write.pImageInfo = image_info;
+	write.pBufferInfo = buffer_info;
+	write.pTexelBufferView = NULL;
+
+	/*
+	 *	NOTE:	Different array elements of an update-after-bind binding may be
+	 *			written concurrently, so the update happens outside the lock.
+	 */
+	bindless->context->vk.UpdateDescriptorSets(bindless->context->device, 1,
+		&write, 0, NULL);
+
+	return handle;
+}
+
+uint32_t
+vk_dev_bindless_add_texture(struct vk_dev_bindless* bindless,
+	VkImageView view, const VkImageLayout layout)
+{
+	VkDescriptorImageInfo image_info;
+
+	image_info.sampler = VK_NULL_HANDLE;
+	image_info.imageView = view;
+	image_info.imageLayout = layout;
+
+	return _vk_dev_bindless_write(bindless, VK_DEV_BINDLESS_TEXTURE,
+		&image_info, NULL);
+}
+
+uint32_t
+vk_dev_bindless_add_buffer(struct vk_dev_bindless* bindless,
+	VkBuffer buffer, const VkDeviceSize offset, const VkDeviceSize range)
+{
+	VkDescriptorBufferInfo buffer_info;
+
+	buffer_info.buffer = buffer;
+	buffer_info.offset = offset;
+	buffer_info.range = range;
+
+	return _vk_dev_bindless_write(bindless, VK_DEV_BINDLESS_BUFFER, NULL,
+		&buffer_info);
+}
+
+uint32_t
+vk_dev_bindless_add_sampler(struct vk_dev_bindless* bindless,
+	VkSampler sampler)
+{
+	VkDescriptorImageInfo image_info;
+
+	image_info.sampler = sampler;
+	image_info.imageView = VK_NULL_HANDLE;
+	image_info.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	return _vk_dev_bindless_write(bindless, VK_DEV_BINDLESS_SAMPLER,
+		&image_info, NULL);
+}
+
+void
+vk_dev_bindless_remove(struct vk_dev_bindless* bindless,
+	const enum vk_dev_bindless_kind kind, const uint32_t handle)
+{
+	if (handle == VK_DEV_BINDLESS_INVALID) {
+		return;
+	}
+
+	pthread_mutex_lock(&bindless->lock);
+	_vk_dev_bindless_slots_free(&bindless->slots[kind], handle);
+	pthread_mutex_unlock(&bindless->lock);
+}
+
+VkDescriptorSetLayout
+vk_dev_bindless_get_layout(const struct vk_dev_bindless* bindless)
+{
+	return bindless->layout;
+}
+
+/*
+ *	NOTE:	This is the only descriptor bind a draw-heavy pass needs; every
+ *			draw after it selects its resources through push constants or
+ *			instance data holding bindless handles.
+ */
+void
+vk_dev_bindless_bind(const struct vk_dev_bindless* bindless,
+	VkCommandBuffer command_buffer, const VkPipelineBindPoint bind_point,
+	VkPipelineLayout pipeline_layout, const uint32_t set)
+{
+	bindless->context->vk.CmdBindDescriptorSets(command_buffer, bind_point,
+		pipeline_layout, set, 1, &bindless->set, 0, NULL);
+}
@@ -0,0 +1,134 @@
+#include <vulkan-dev/buffer.h>
+#include <vulkan-dev/context.h>
+
+#include <stdint.h>
+
+uint32_t
+vk_dev_find_memory_type(const struct vk_dev_context* context,
+	const uint32_t type_bits, const VkMemoryPropertyFlags properties)
+{
+	const VkPhysicalDeviceMemoryProperties* memory_properties;
+
+	memory_properties = &context->memory_properties;
+	for (uint32_t i = 0; i < memory_properties->memoryTypeCount; i++) {
+		if ((type_bits & (1u << i)) &&
+			(memory_properties->memoryTypes[i].propertyFlags & properties) ==
+			properties) {
+			return i;
+		}
+	}
+
+	vk_dev_fatal_error("[BUFFER] No suitable memory type found.");
+
+	return UINT32_MAX;
+}
+
+bool
+vk_dev_get_memory_budget(const struct vk_dev_context* context,
+	VkDeviceSize* budget, VkDeviceSize* usage)
+{
+	VkPhysicalDeviceMemoryProperties2 properties;
+	VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_properties;
+
+	if (!context->extensions.memory_budget) {
+		return false;
+	}
+
+	budget_properties.sType =
+		VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+	budget_properties.pNext = NULL;
+
+	properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+	properties.pNext = &budget_properties;
+
+	context->vk.GetPhysicalDeviceMemoryProperties2(context->physical_device,
+		&properties);
+
+	*budget = 0;
+	*usage = 0;
+
+	for (uint32_t i = 0; i < properties.memoryProperties.memoryHeapCount;
+		i++) {
+		if (properties.memoryProperties.memoryHeaps[i].flags &
+			VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+			*budget += budget_properties.heapBudget[i];
+			*usage += budget_properties.heapUsage[i];
+		}
+	}
+
+	return true;
+}
+
+void
+vk_dev_buffer_create(struct vk_dev_context* context, const VkDeviceSize size,
+	const VkBufferUsageFlags usage, const VkMemoryPropertyFlags properties,
+	struct vk_dev_buffer* buffer)
+{
+	VkResult result;
+	VkMemoryRequirements requirements;
+	VkBufferCreateInfo create_info;
+	VkMemoryAllocateInfo allocate_info;
+
+	create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	create_info.pNext = NULL;
+	create_info.flags = 0;
+	create_info.size = size;
+	create_info.usage = usage;
+	create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	create_info.queueFamilyIndexCount = 0;
+	create_info.pQueueFamilyIndices = NULL;
+
+	result = context->vk.CreateBuffer(context->device, &create_info, NULL,
+		&buffer->buffer);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[BUFFER] Failed to create buffer.");
+	}
+
+	context->vk.GetBufferMemoryRequirements(context->device, buffer->buffer,
+		&requirements);
+
+	allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocate_info.pNext = NULL;
+	allocate_info.allocationSize = requirements.size;
+	allocate_info.memoryTypeIndex = vk_dev_find_memory_type(context,
+		requirements.memoryTypeBits, properties);
+
+	result = context->vk.AllocateMemory(context->device, &allocate_info, NULL,
+		&buffer->memory);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[BUFFER] Failed to allocate buffer memory.");
+	}
+
+	result = context->vk.BindBufferMemory(context->device, buffer->buffer,
+		buffer->memory, 0);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[BUFFER] Failed to bind buffer memory.");
+	}
+
+	buffer->size = size;
+	buffer->mapped = NULL;
+
+	if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+		result = context->vk.MapMemory(context->device, buffer->memory, 0,
+			VK_WHOLE_SIZE, 0, &buffer->mapped);
+		if (result != VK_SUCCESS) {
+			vk_dev_fatal_error("[BUFFER] Failed to map buffer memory.");
+		}
+	}
+}
+
+void
+vk_dev_buffer_destroy(struct vk_dev_context* context,
+	struct vk_dev_buffer* buffer)
+{
+	if (buffer->mapped != NULL) {
+		context->vk.UnmapMemory(context->device, buffer->memory);
+	}
+
+	context->vk.DestroyBuffer(context->device, buffer->buffer, NULL);
+	context->vk.FreeMemory(context->device, buffer->memory, NULL);
+
+	buffer->buffer = VK_NULL_HANDLE;
+	buffer->memory = VK_NULL_HANDLE;
+	buffer->mapped = NULL;
+}
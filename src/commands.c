@@ -0,0 +1,701 @@
+#include <vulkan-dev/commands.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/trace.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define VK_DEV_COMMANDS_MIN_CAPACITY 256
+#define VK_DEV_COMMANDS_MAX_LISTS 256
+
+enum _vk_dev_packet_type {
+	_VK_DEV_PACKET_DRAW,
+	_VK_DEV_PACKET_DRAW_INDEXED_16,
+	_VK_DEV_PACKET_DRAW_INDEXED_32,
+	_VK_DEV_PACKET_DISPATCH,
+};
+
+/*
+ *	NOTE:	One cache line. Handles are vk_dev_resources handle bits, zero
+ *			for none; args are the vkCmdDraw*, vkCmdDispatch parameters in
+ *			order, with vertexOffset stored as its bit pattern.
+ */
+struct _vk_dev_packet {
+	uint64_t key;
+	VkDescriptorSet descriptor_set;
+	uint32_t pipeline;
+	uint32_t vertex_buffer;
+	uint32_t index_buffer;
+	uint32_t vertex_buffer_offset;
+	uint32_t index_buffer_offset;
+	uint32_t push_offset;
+	uint8_t type;
+	uint8_t descriptor_set_index;
+	uint8_t push_words;
+	uint8_t push_stages;
+	uint32_t args[5];
+};
+
+struct vk_dev_command_list {
+	struct _vk_dev_packet* packets;
+	uint32_t count;
+	uint32_t capacity;
+
+	// NOTE: Push constant data, packets refer to it by offset.
+	uint8_t* arena;
+	uint32_t arena_size;
+	uint32_t arena_capacity;
+};
+
+struct _vk_dev_commands_entry {
+	uint64_t key;
+	uint32_t list;
+	uint32_t packet;
+};
+
+struct vk_dev_commands {
+	struct vk_dev_context* context;
+	struct vk_dev_resources* resources;
+
+	// NOTE: The lists of the last sort and its order, as indices into them.
+	struct vk_dev_command_list* lists[VK_DEV_COMMANDS_MAX_LISTS];
+	struct _vk_dev_commands_entry* entries;
+	struct _vk_dev_commands_entry* scratch;
+	uint32_t count;
+	uint32_t capacity;
+
+	struct vk_dev_commands_stats stats;
+};
+
+/*
+ *	NOTE:	What a translated range has left bound. Zero handles never
+ *			resolve, so the first packet binds everything it names.
+ */
+struct _vk_dev_commands_bound {
+	uint32_t pipeline;
+	VkPipelineLayout layout;
+	VkPipelineBindPoint bind_point;
+
+	VkDescriptorSet descriptor_set;
+	uint32_t descriptor_set_index;
+
+	uint32_t vertex_buffer;
+	uint32_t vertex_buffer_offset;
+
+	uint32_t index_buffer;
+	uint32_t index_buffer_offset;
+	uint8_t index_type;
+
+	const uint8_t* push;
+	uint32_t push_words;
+	uint32_t push_stages;
+};
+
+struct vk_dev_command_list*
+vk_dev_command_list_create(void)
+{
+	struct vk_dev_command_list* list;
+
+	list = calloc(1, sizeof(*list));
+	if (list == NULL) {
+		vk_dev_fatal_error("[COMMANDS] Failed to allocate command list.");
+	}
+
+	return list;
+}
+
+void
+vk_dev_command_list_destroy(struct vk_dev_command_list* list)
+{
+	if (list == NULL) {
+		return;
+	}
+
+	free(list->arena);
+	free(list->packets);
+	free(list);
+}
+
+void
+vk_dev_command_list_reset(struct vk_dev_command_list* list)
+{
+	list->count = 0;
+	list->arena_size = 0;
+}
+
+uint32_t
+vk_dev_command_list_get_count(const struct vk_dev_command_list* list)
+{
+	return list->count;
+}
+
+static struct _vk_dev_packet*
+_vk_dev_command_list_push(struct vk_dev_command_list* list,
+	const uint64_t key, const struct vk_dev_command_state* state,
+	const enum _vk_dev_packet_type type)
+{
+	void* grown;
+	uint32_t capacity;
+	struct _vk_dev_packet* packet;
+
+	if (state->push_size % 4 != 0 ||
+		state->push_size > VK_DEV_COMMANDS_MAX_PUSH_SIZE ||
+		state->push_stages > UINT8_MAX ||
+		state->descriptor_set_index > UINT8_MAX ||
+		((type == _VK_DEV_PACKET_DRAW_INDEXED_16 ||
+		type == _VK_DEV_PACKET_DRAW_INDEXED_32) &&
+		state->index_type != VK_INDEX_TYPE_UINT16 &&
+		state->index_type != VK_INDEX_TYPE_UINT32)) {
+		vk_dev_fatal_error("[COMMANDS] Packet state out of range.");
+	}
+
+	/*
+	 *	NOTE:	Handle 0 is never issued, and translation would take it for
+	 *			the nothing bound before the first packet.
+	 */
+	if (state->pipeline.bits == 0) {
+		vk_dev_fatal_error("[COMMANDS] Packet has no pipeline.");
+	}
+
+	if (list->count == list->capacity) {
+		capacity = list->capacity > 0 ? list->capacity * 2 :
+			VK_DEV_COMMANDS_MIN_CAPACITY;
+
+		grown = realloc(list->packets, sizeof(*list->packets) * capacity);
+		if (grown == NULL) {
+			vk_dev_fatal_error("[COMMANDS] Failed to grow command list.");
+		}
+
+		list->packets = grown;
+		list->capacity = capacity;
+	}
+
+	if (list->arena_size + state->push_size > list->arena_capacity) {
+		capacity = list->arena_capacity > 0 ? list->arena_capacity :
+			VK_DEV_COMMANDS_MIN_CAPACITY * 16;
+		while (capacity < list->arena_size + state->push_size) {
+			capacity *= 2;
+		}
+
+		grown = realloc(list->arena, capacity);
+		if (grown == NULL) {
+			vk_dev_fatal_error("[COMMANDS] Failed to grow command arena.");
+		}
+
+		list->arena = grown;
+		list->arena_capacity = capacity;
+	}
+
+	packet = &list->packets[list->count++];
+
+	packet->key = key;
+	packet->descriptor_set = state->descriptor_set;
+	packet->pipeline = state->pipeline.bits;
+	packet->vertex_buffer = state->vertex_buffer.bits;
+	packet->index_buffer = state->index_buffer.bits;
+	packet->vertex_buffer_offset = state->vertex_buffer_offset;
+	packet->index_buffer_offset = state->index_buffer_offset;
+	packet->push_offset = list->arena_size;
+	packet->type = (uint8_t)type;
+	packet->descriptor_set_index = (uint8_t)state->descriptor_set_index;
+	packet->push_words = (uint8_t)(state->push_size / 4);
+	packet->push_stages = (uint8_t)state->push_stages;
+
+	if (state->push_size > 0) {
+		memcpy(list->arena + list->arena_size, state->push_constants,
+			state->push_size);
+		list->arena_size += state->push_size;
+	}
+
+	return packet;
+}
+
+void
+vk_dev_command_list_draw(struct vk_dev_command_list* list,
+	const uint64_t key, const struct vk_dev_command_state* state,
+	const uint32_t vertex_count, const uint32_t instance_count,
+	const uint32_t first_vertex, const uint32_t first_instance)
+{
+	struct _vk_dev_packet* packet;
+
+	packet = _vk_dev_command_list_push(list, key, state,
+		_VK_DEV_PACKET_DRAW);
+
+	packet->index_buffer = 0;
+	packet->args[0] = vertex_count;
+	packet->args[1] = instance_count;
+	packet->args[2] = first_vertex;
+	packet->args[3] = first_instance;
+	packet->args[4] = 0;
+}
+
+void
+vk_dev_command_list_draw_indexed(struct vk_dev_command_list* list,
+	const uint64_t key, const struct vk_dev_command_state* state,
+	const uint32_t index_count, const uint32_t instance_count,
+	const uint32_t first_index, const int32_t vertex_offset,
+	const uint32_t first_instance)
+{
+	struct _vk_dev_packet* packet;
+
+	packet = _vk_dev_command_list_push(list, key, state,
+		state->index_type == VK_INDEX_TYPE_UINT16 ?
+		_VK_DEV_PACKET_DRAW_INDEXED_16 : _VK_DEV_PACKET_DRAW_INDEXED_32);
+
+	packet->args[0] = index_count;
+	packet->args[1] = instance_count;
+	packet->args[2] = first_index;
+	packet->args[3] = (uint32_t)vertex_offset;
+	packet->args[4] = first_instance;
+}
+
+void
+vk_dev_command_list_dispatch(struct vk_dev_command_list* list,
+	const uint64_t key, const struct vk_dev_command_state* state,
+	const uint32_t group_count_x, const uint32_t group_count_y,
+	const uint32_t group_count_z)
+{
+	struct _vk_dev_packet* packet;
+
+	packet = _vk_dev_command_list_push(list, key, state,
+		_VK_DEV_PACKET_DISPATCH);
+
+	packet->vertex_buffer = 0;
+	packet->index_buffer = 0;
+	packet->args[0] = group_count_x;
+	packet->args[1] = group_count_y;
+	packet->args[2] = group_count_z;
+	packet->args[3] = 0;
+	packet->args[4] = 0;
+}
+
+uint64_t
+vk_dev_commands_make_key(const uint32_t pass, const uint32_t pipeline,
+	const uint32_t material, const float depth)
+{
+	float clamped;
+	uint32_t bits;
+
+	// NOTE: Non-negative floats order like their bit patterns.
+	clamped = depth > 0.0f ? depth : 0.0f;
+	memcpy(&bits, &clamped, sizeof(bits));
+
+	return (uint64_t)(pass & 0xff) << 56 |
+		(uint64_t)(pipeline & 0xffff) << 40 |
+		(uint64_t)(material & 0xffff) << 24 |
+		(uint64_t)(bits >> 7);
+}
+
+struct vk_dev_commands*
+vk_dev_commands_create(struct vk_dev_context* context,
+	struct vk_dev_resources* resources)
+{
+	struct vk_dev_commands* commands;
+
+	commands = calloc(1, sizeof(*commands));
+	if (commands == NULL) {
+		vk_dev_fatal_error("[COMMANDS] Failed to allocate commands.");
+	}
+
+	commands->context = context;
+	commands->resources = resources;
+
+	return commands;
+}
+
+void
+vk_dev_commands_destroy(struct vk_dev_commands* commands)
+{
+	if (commands == NULL) {
+		return;
+	}
+
+	free(commands->scratch);
+	free(commands->entries);
+	free(commands);
+}
+
+/*
+ *	NOTE:	Least significant digit first radix sort, 8 bits a pass; a pass
+ *			where every key has the same digit is skipped. Each pass is
+ *			stable, so equal keys keep the order they were gathered in.
+ */
+static void
+_vk_dev_commands_radix_sort(struct vk_dev_commands* commands)
+{
+	uint32_t counts[256], offset, digit, shift;
+	struct _vk_dev_commands_entry* swap;
+
+	for (shift = 0; shift < 64; shift += 8) {
+		memset(counts, 0, sizeof(counts));
+
+		for (uint32_t i = 0; i < commands->count; i++) {
+			counts[(commands->entries[i].key >> shift) & 0xff]++;
+		}
+
+		digit = (commands->entries[0].key >> shift) & 0xff;
+		if (counts[digit] == commands->count) {
+			continue;
+		}
+
+		offset = 0;
+		for (uint32_t i = 0; i < 256; i++) {
+			digit = counts[i];
+			counts[i] = offset;
+			offset += digit;
+		}
+
+		for (uint32_t i = 0; i < commands->count; i++) {
+			digit = (commands->entries[i].key >> shift) & 0xff;
+			commands->scratch[counts[digit]++] = commands->entries[i];
+		}
+
+		swap = commands->entries;
+		commands->entries = commands->scratch;
+		commands->scratch = swap;
+	}
+}
+
+uint32_t
+vk_dev_commands_sort(struct vk_dev_commands* commands,
+	struct vk_dev_command_list* const* lists, const uint32_t list_count)
+{
+	uint32_t count, capacity;
+	struct _vk_dev_commands_entry* entry;
+
+	if (list_count > VK_DEV_COMMANDS_MAX_LISTS) {
+		vk_dev_fatal_error("[COMMANDS] Too many command lists.");
+	}
+
+	VK_DEV_TRACE_BEGIN("vk_dev_commands_sort");
+
+	count = 0;
+	for (uint32_t i = 0; i < list_count; i++) {
+		commands->lists[i] = lists[i];
+		count += lists[i]->count;
+	}
+
+	if (count > commands->capacity) {
+		capacity = commands->capacity > 0 ? commands->capacity :
+			VK_DEV_COMMANDS_MIN_CAPACITY;
+		while (capacity < count) {
+			capacity *= 2;
+		}
+
+		free(commands->scratch);
+		free(commands->entries);
+
+		commands->entries = malloc(sizeof(*commands->entries) * capacity);
+		commands->scratch = malloc(sizeof(*commands->scratch) * capacity);
+		if (commands->entries == NULL || commands->scratch == NULL) {
+			vk_dev_fatal_error("[COMMANDS] Failed to allocate sort keys.");
+		}
+
+		commands->capacity = capacity;
+	}
+
+	entry = commands->entries;
+	for (uint32_t i = 0; i < list_count; i++) {
+		for (uint32_t j = 0; j < lists[i]->count; j++) {
+			entry->key = lists[i]->packets[j].key;
+			entry->list = i;
+			entry->packet = j;
+			entry++;
+		}
+	}
+
+	commands->count = count;
+	if (count > 1) {
+		_vk_dev_commands_radix_sort(commands);
+	}
+
+	memset(&commands->stats, 0, sizeof(commands->stats));
+	commands->stats.packets = count;
+
+	VK_DEV_TRACE_END("vk_dev_commands_sort");
+
+	return count;
+}
+
+/*
+ *	NOTE:	Binds the packet's pipeline if it is not bound yet. Returns
+ *			false if its handle is stale. A new layout or bind point
+ *			forgets the descriptor set and push constants, which it may
+ *			have disturbed.
+ */
+static bool
+_vk_dev_commands_bind_pipeline(struct vk_dev_commands* commands,
+	VkCommandBuffer command_buffer, const struct _vk_dev_packet* packet,
+	struct _vk_dev_commands_bound* bound,
+	struct vk_dev_commands_stats* stats)
+{
+	VkPipeline pipeline;
+	VkPipelineLayout layout;
+	VkPipelineBindPoint bind_point;
+
+	if (packet->pipeline == bound->pipeline) {
+		stats->redundant++;
+		return true;
+	}
+
+	if (!vk_dev_resources_get_pipeline(commands->resources,
+		(vk_dev_pipeline_handle){packet->pipeline}, &pipeline, &layout,
+		&bind_point)) {
+		return false;
+	}
+
+	if ((bind_point == VK_PIPELINE_BIND_POINT_COMPUTE) !=
+		(packet->type == _VK_DEV_PACKET_DISPATCH)) {
+		vk_dev_fatal_error("[COMMANDS] Pipeline does not suit its packet.");
+	}
+
+	commands->context->vk.CmdBindPipeline(command_buffer, bind_point,
+		pipeline);
+	stats->pipeline_binds++;
+
+	if (layout != bound->layout || bind_point != bound->bind_point) {
+		bound->descriptor_set = VK_NULL_HANDLE;
+		bound->push = NULL;
+	}
+
+	bound->pipeline = packet->pipeline;
+	bound->layout = layout;
+	bound->bind_point = bind_point;
+
+	return true;
+}
+
+/*
+ *	NOTE:	Binds the packet's vertex and index buffers if they differ from
+ *			the bound ones. Returns false if a handle is stale.
+ */
+static bool
+_vk_dev_commands_bind_buffers(struct vk_dev_commands* commands,
+	VkCommandBuffer command_buffer, const struct _vk_dev_packet* packet,
+	struct _vk_dev_commands_bound* bound,
+	struct vk_dev_commands_stats* stats)
+{
+	VkBuffer buffer;
+	VkDeviceSize offset;
+	uint8_t index_type;
+	struct vk_dev_context* context;
+
+	context = commands->context;
+
+	if (packet->vertex_buffer != 0) {
+		if (packet->vertex_buffer == bound->vertex_buffer &&
+			packet->vertex_buffer_offset == bound->vertex_buffer_offset) {
+			stats->redundant++;
+		} else {
+			buffer = vk_dev_resources_get_buffer(commands->resources,
+				(vk_dev_buffer_handle){packet->vertex_buffer});
+			if (buffer == VK_NULL_HANDLE) {
+				return false;
+			}
+
+			offset = packet->vertex_buffer_offset;
+			context->vk.CmdBindVertexBuffers(command_buffer, 0, 1, &buffer,
+				&offset);
+			stats->vertex_binds++;
+
+			bound->vertex_buffer = packet->vertex_buffer;
+			bound->vertex_buffer_offset = packet->vertex_buffer_offset;
+		}
+	}
+
+	if (packet->type == _VK_DEV_PACKET_DRAW_INDEXED_16 ||
+		packet->type == _VK_DEV_PACKET_DRAW_INDEXED_32) {
+		index_type = packet->type;
+
+		if (packet->index_buffer == bound->index_buffer &&
+			packet->index_buffer_offset == bound->index_buffer_offset &&
+			index_type == bound->index_type) {
+			stats->redundant++;
+		} else {
+			buffer = vk_dev_resources_get_buffer(commands->resources,
+				(vk_dev_buffer_handle){packet->index_buffer});
+			if (buffer == VK_NULL_HANDLE) {
+				return false;
+			}
+
+			context->vk.CmdBindIndexBuffer(command_buffer, buffer,
+				packet->index_buffer_offset,
+				index_type == _VK_DEV_PACKET_DRAW_INDEXED_16 ?
+				VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32);
+			stats->index_binds++;
+
+			bound->index_buffer = packet->index_buffer;
+			bound->index_buffer_offset = packet->index_buffer_offset;
+			bound->index_type = index_type;
+		}
+	}
+
+	return true;
+}
+
+static void
+_vk_dev_commands_bind_state(struct vk_dev_commands* commands,
+	VkCommandBuffer command_buffer, const struct _vk_dev_packet* packet,
+	const uint8_t* push, struct _vk_dev_commands_bound* bound,
+	struct vk_dev_commands_stats* stats)
+{
+	struct vk_dev_context* context;
+
+	context = commands->context;
+
+	if (packet->descriptor_set != VK_NULL_HANDLE) {
+		if (packet->descriptor_set == bound->descriptor_set &&
+			packet->descriptor_set_index == bound->descriptor_set_index) {
+			stats->redundant++;
+		} else {
+			context->vk.CmdBindDescriptorSets(command_buffer,
+				bound->bind_point, bound->layout,
+				packet->descriptor_set_index, 1, &packet->descriptor_set, 0,
+				NULL);
+			stats->descriptor_binds++;
+
+			bound->descriptor_set = packet->descriptor_set;
+			bound->descriptor_set_index = packet->descriptor_set_index;
+		}
+	}
+
+	if (packet->push_words > 0) {
+		if (bound->push != NULL && packet->push_words == bound->push_words &&
+			packet->push_stages == bound->push_stages &&
+			memcmp(push, bound->push, packet->push_words * 4) == 0) {
+			stats->redundant++;
+		} else {
+			context->vk.CmdPushConstants(command_buffer, bound->layout,
+				packet->push_stages, 0, packet->push_words * 4, push);
+			stats->pushes++;
+
+			bound->push = push;
+			bound->push_words = packet->push_words;
+			bound->push_stages = packet->push_stages;
+		}
+	}
+}
+
+static void
+_vk_dev_commands_add_stats(struct vk_dev_commands_stats* total,
+	const struct vk_dev_commands_stats* stats)
+{
+	__atomic_fetch_add(&total->draws, stats->draws, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&total->dispatches, stats->dispatches,
+		__ATOMIC_RELAXED);
+	__atomic_fetch_add(&total->pipeline_binds, stats->pipeline_binds,
+		__ATOMIC_RELAXED);
+	__atomic_fetch_add(&total->descriptor_binds, stats->descriptor_binds,
+		__ATOMIC_RELAXED);
+	__atomic_fetch_add(&total->vertex_binds, stats->vertex_binds,
+		__ATOMIC_RELAXED);
+	__atomic_fetch_add(&total->index_binds, stats->index_binds,
+		__ATOMIC_RELAXED);
+	__atomic_fetch_add(&total->pushes, stats->pushes, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&total->redundant, stats->redundant,
+		__ATOMIC_RELAXED);
+	__atomic_fetch_add(&total->stale, stats->stale, __ATOMIC_RELAXED);
+}
+
+void
+vk_dev_commands_translate(struct vk_dev_commands* commands,
+	VkCommandBuffer command_buffer, const uint32_t first,
+	const uint32_t count)
+{
+	const uint8_t* push;
+	const uint32_t* args;
+	const struct _vk_dev_packet* packet;
+	const struct _vk_dev_commands_entry* entry;
+	struct vk_dev_command_list* list;
+	struct vk_dev_context* context;
+	struct _vk_dev_commands_bound bound;
+	struct vk_dev_commands_stats stats;
+
+	if (first > commands->count || count > commands->count - first) {
+		vk_dev_fatal_error("[COMMANDS] Range out of bounds.");
+	}
+
+	VK_DEV_TRACE_BEGIN("vk_dev_commands_translate");
+
+	context = commands->context;
+
+	memset(&bound, 0, sizeof(bound));
+	memset(&stats, 0, sizeof(stats));
+
+	for (uint32_t i = first; i < first + count; i++) {
+		entry = &commands->entries[i];
+		list = commands->lists[entry->list];
+		packet = &list->packets[entry->packet];
+		push = list->arena + packet->push_offset;
+		args = packet->args;
+
+		if (!_vk_dev_commands_bind_pipeline(commands, command_buffer, packet,
+			&bound, &stats) || !_vk_dev_commands_bind_buffers(commands,
+			command_buffer, packet, &bound, &stats)) {
+			stats.stale++;
+			continue;
+		}
+
+		_vk_dev_commands_bind_state(commands, command_buffer, packet, push,
+			&bound, &stats);
+
+		switch (packet->type) {
+		case _VK_DEV_PACKET_DRAW:
+			context->vk.CmdDraw(command_buffer, args[0], args[1], args[2],
+				args[3]);
+			stats.draws++;
+			break;
+		case _VK_DEV_PACKET_DRAW_INDEXED_16:
+		case _VK_DEV_PACKET_DRAW_INDEXED_32:
+			context->vk.CmdDrawIndexed(command_buffer, args[0], args[1],
+				args[2], (int32_t)args[3], args[4]);
+			stats.draws++;
+			break;
+		case _VK_DEV_PACKET_DISPATCH:
+			context->vk.CmdDispatch(command_buffer, args[0], args[1],
+				args[2]);
+			stats.dispatches++;
+			break;
+		}
+	}
+
+	_vk_dev_commands_add_stats(&commands->stats, &stats);
+
+	VK_DEV_TRACE_END("vk_dev_commands_translate");
+}
+
+static void
+_vk_dev_commands_translate_chunk(void* arg, VkCommandBuffer command_buffer,
+	const uint32_t first, const uint32_t count)
+{
+	vk_dev_commands_translate(arg, command_buffer, first, count);
+}
+
+void
+vk_dev_commands_record_pass(struct vk_dev_commands* commands,
+	struct vk_dev_parallel_pass* pass, VkCommandBuffer primary,
+	const VkRenderPassBeginInfo* begin_info)
+{
+	const struct _vk_dev_commands_entry* entry;
+
+	// NOTE: vkCmdDispatch is not allowed inside a render pass.
+	for (uint32_t i = 0; i < commands->count; i++) {
+		entry = &commands->entries[i];
+		if (commands->lists[entry->list]->packets[entry->packet].type ==
+			_VK_DEV_PACKET_DISPATCH) {
+			vk_dev_fatal_error("[COMMANDS] Dispatch in a render pass.");
+		}
+	}
+
+	vk_dev_parallel_pass_record(pass, primary, begin_info, commands->count,
+		_vk_dev_commands_translate_chunk, commands);
+}
+
+void
+vk_dev_commands_get_stats(const struct vk_dev_commands* commands,
+	struct vk_dev_commands_stats* stats)
+{
+	*stats = commands->stats;
+}
@@ -0,0 +1,1103 @@
+#include <vulkan-dev/compress.h>
+#include <vulkan-dev/binding.h>
+#include <vulkan-dev/shader.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/trace.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define ARRAY_SIZE(x) (sizeof(x)/sizeof(*x))
+
+#define VK_DEV_COMPRESS_GROUP_SIZE 8
+#define VK_DEV_COMPRESS_POWER_ITERATIONS 8
+
+/*
+ *	NOTE:	A block's texels, channel by channel, as 0 to 255 floats: the
+ *			layout the SSE2 palette search wants.
+ */
+struct _vk_dev_compress_block {
+	float c[4][16];
+};
+
+struct _vk_dev_compress_job {
+	enum vk_dev_compress_format format;
+	const uint8_t* texels;
+	uint32_t width;
+	uint32_t height;
+	uint32_t blocks_x;
+	uint8_t* blocks;
+};
+
+struct _vk_dev_compress_bindings {
+	VkDescriptorImageInfo source;
+	VkDescriptorBufferInfo destination;
+};
+
+// NOTE: Matches the push constant block in shaders/compress.comp.
+struct _vk_dev_compress_constants {
+	uint32_t size[2];
+	uint32_t format;
+	uint32_t offset;
+};
+
+static const struct vk_dev_binding _bindings[] = {
+	VK_DEV_BINDING(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+		VK_SHADER_STAGE_COMPUTE_BIT, struct _vk_dev_compress_bindings,
+		source),
+	VK_DEV_BINDING(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+		VK_SHADER_STAGE_COMPUTE_BIT, struct _vk_dev_compress_bindings,
+		destination),
+};
+
+// NOTE: BC7 interpolation weights for 4 bit indices, out of 64.
+static const uint32_t _bc7_weights[16] = {
+	0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64,
+};
+
+struct vk_dev_compress {
+	struct vk_dev_context* context;
+
+	VkSampler sampler;
+
+	struct vk_dev_binding_layout* binding_layout;
+	VkPipelineLayout pipeline_layout;
+	VkPipeline pipeline;
+};
+
+const char*
+vk_dev_compress_get_name(const enum vk_dev_compress_format format)
+{
+	static const char* names[VK_DEV_COMPRESS_FORMAT_COUNT] = {
+		"BC1", "BC3", "BC5", "BC7",
+	};
+
+	return names[format];
+}
+
+VkFormat
+vk_dev_compress_get_vk_format(const enum vk_dev_compress_format format,
+	const bool srgb)
+{
+	switch (format) {
+	case VK_DEV_COMPRESS_BC1:
+		return srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK :
+			VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+	case VK_DEV_COMPRESS_BC3:
+		return srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+	case VK_DEV_COMPRESS_BC5:
+		return VK_FORMAT_BC5_UNORM_BLOCK;
+	case VK_DEV_COMPRESS_BC7:
+		return srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+	}
+
+	return VK_FORMAT_UNDEFINED;
+}
+
+uint32_t
+vk_dev_compress_get_block_size(const enum vk_dev_compress_format format)
+{
+	return format == VK_DEV_COMPRESS_BC1 ? 8 : 16;
+}
+
+VkDeviceSize
+vk_dev_compress_get_size(const enum vk_dev_compress_format format,
+	const uint32_t width, const uint32_t height)
+{
+	return (VkDeviceSize)((width + 3) / 4) * ((height + 3) / 4) *
+		vk_dev_compress_get_block_size(format);
+}
+
+static float
+_vk_dev_compress_round(const float value)
+{
+	return floorf(value + 0.5f);
+}
+
+static void
+_vk_dev_compress_load(const struct _vk_dev_compress_job* job,
+	const uint32_t block_x, const uint32_t block_y,
+	struct _vk_dev_compress_block* block)
+{
+	uint32_t x, y;
+	const uint8_t* texel;
+
+	for (uint32_t i = 0; i < 16; i++) {
+		x = block_x * 4 + (i & 3);
+		y = block_y * 4 + (i >> 2);
+		x = x < job->width ? x : job->width - 1;
+		y = y < job->height ? y : job->height - 1;
+
+		texel = job->texels + ((size_t)y * job->width + x) * 4;
+		for (uint32_t c = 0; c < 4; c++) {
+			block->c[c][i] = texel[c];
+		}
+	}
+}
+
+/*
+ *	NOTE:	Picks the nearest of count palette colours for every texel and
+ *			returns the summed squared error. Ties go to the lower index.
+ */
+static float
+_vk_dev_compress_select(const struct _vk_dev_compress_block* block,
+	const float palette[][4], const uint32_t count, uint8_t indices[16])
+{
+	float error;
+
+#if defined(__SSE2__)
+	__m128 texels[4], best, distance, difference, mask, sum;
+	__m128i best_index, index;
+	int32_t lanes[4];
+
+	sum = _mm_setzero_ps();
+
+	for (uint32_t i = 0; i < 16; i += 4) {
+		for (uint32_t c = 0; c < 4; c++) {
+			texels[c] = _mm_loadu_ps(&block->c[c][i]);
+		}
+
+		best = _mm_set1_ps(INFINITY);
+		best_index = _mm_setzero_si128();
+
+		for (uint32_t j = 0; j < count; j++) {
+			distance = _mm_setzero_ps();
+			for (uint32_t c = 0; c < 4; c++) {
+				difference = _mm_sub_ps(texels[c],
+					_mm_set1_ps(palette[j][c]));
+				distance = _mm_add_ps(distance,
+					_mm_mul_ps(difference, difference));
+			}
+
+			mask = _mm_cmplt_ps(distance, best);
+			index = _mm_set1_epi32((int32_t)j);
+			best = _mm_min_ps(distance, best);
+			best_index = _mm_or_si128(
+				_mm_and_si128(_mm_castps_si128(mask), index),
+				_mm_andnot_si128(_mm_castps_si128(mask), best_index));
+		}
+
+		sum = _mm_add_ps(sum, best);
+		_mm_storeu_si128((__m128i*)lanes, best_index);
+		for (uint32_t k = 0; k < 4; k++) {
+			indices[i + k] = (uint8_t)lanes[k];
+		}
+	}
+
+	float sums[4];
+
+	_mm_storeu_ps(sums, sum);
+	error = sums[0] + sums[1] + sums[2] + sums[3];
+#else
+	float best, distance, difference;
+
+	error = 0.0f;
+
+	for (uint32_t i = 0; i < 16; i++) {
+		best = INFINITY;
+		indices[i] = 0;
+
+		for (uint32_t j = 0; j < count; j++) {
+			distance = 0.0f;
+			for (uint32_t c = 0; c < 4; c++) {
+				difference = block->c[c][i] - palette[j][c];
+				distance += difference * difference;
+			}
+
+			if (distance < best) {
+				best = distance;
+				indices[i] = (uint8_t)j;
+			}
+		}
+
+		error += best;
+	}
+#endif
+
+	return error;
+}
+
+/*
+ *	NOTE:	Endpoints spanning the block along the principal axis of its
+ *			first channels channels, found by power iteration on their
+ *			covariance.
+ */
+static void
+_vk_dev_compress_fit(const struct _vk_dev_compress_block* block,
+	const uint32_t channels, float endpoints[2][4])
+{
+	float mean[4], covariance[4][4], axis[4], next[4], low, high, t, scale;
+
+	for (uint32_t c = 0; c < 4; c++) {
+		mean[c] = 0.0f;
+		low = INFINITY;
+		high = -INFINITY;
+
+		for (uint32_t i = 0; i < 16; i++) {
+			mean[c] += block->c[c][i];
+			low = fminf(low, block->c[c][i]);
+			high = fmaxf(high, block->c[c][i]);
+		}
+
+		mean[c] /= 16.0f;
+		axis[c] = c < channels ? high - low : 0.0f;
+	}
+
+	for (uint32_t a = 0; a < 4; a++) {
+		for (uint32_t b = 0; b < 4; b++) {
+			covariance[a][b] = 0.0f;
+			if (a >= channels || b >= channels) {
+				continue;
+			}
+
+			for (uint32_t i = 0; i < 16; i++) {
+				covariance[a][b] += (block->c[a][i] - mean[a]) *
+					(block->c[b][i] - mean[b]);
+			}
+		}
+	}
+
+	for (uint32_t n = 0; n < VK_DEV_COMPRESS_POWER_ITERATIONS; n++) {
+		scale = 0.0f;
+		for (uint32_t a = 0; a < 4; a++) {
+			next[a] = 0.0f;
+			for (uint32_t b = 0; b < 4; b++) {
+				next[a] += covariance[a][b] * axis[b];
+			}
+			scale = fmaxf(scale, fabsf(next[a]));
+		}
+
+		if (scale <= 0.0f) {
+			break;
+		}
+
+		for (uint32_t a = 0; a < 4; a++) {
+			axis[a] = next[a] / scale;
+		}
+	}
+
+	scale = 0.0f;
+	for (uint32_t c = 0; c < 4; c++) {
+		scale += axis[c] * axis[c];
+	}
+
+	low = 0.0f;
+	high = 0.0f;
+
+	if (scale > 0.0f) {
+		low = INFINITY;
+		high = -INFINITY;
+
+		for (uint32_t i = 0; i < 16; i++) {
+			t = 0.0f;
+			for (uint32_t c = 0; c < 4; c++) {
+				t += (block->c[c][i] - mean[c]) * axis[c];
+			}
+
+			low = fminf(low, t / scale);
+			high = fmaxf(high, t / scale);
+		}
+	}
+
+	for (uint32_t c = 0; c < 4; c++) {
+		endpoints[0][c] = fminf(fmaxf(mean[c] + axis[c] * low, 0.0f),
+			255.0f);
+		endpoints[1][c] = fminf(fmaxf(mean[c] + axis[c] * high, 0.0f),
+			255.0f);
+	}
+}
+
+/*
+ *	NOTE:	Least squares endpoints for fixed indices, each texel being
+ *			weights[i] of the way from the first endpoint to the second.
+ *			Returns false when the weights do not determine them.
+ */
+static bool
+_vk_dev_compress_refit(const struct _vk_dev_compress_block* block,
+	const float weights[16], float endpoints[2][4])
+{
+	float aa, bb, ab, ax[4], bx[4], determinant;
+
+	aa = bb = ab = 0.0f;
+	for (uint32_t c = 0; c < 4; c++) {
+		ax[c] = bx[c] = 0.0f;
+	}
+
+	for (uint32_t i = 0; i < 16; i++) {
+		aa += (1.0f - weights[i]) * (1.0f - weights[i]);
+		bb += weights[i] * weights[i];
+		ab += (1.0f - weights[i]) * weights[i];
+
+		for (uint32_t c = 0; c < 4; c++) {
+			ax[c] += (1.0f - weights[i]) * block->c[c][i];
+			bx[c] += weights[i] * block->c[c][i];
+		}
+	}
+
+	determinant = aa * bb - ab * ab;
+	if (fabsf(determinant) < 1e-6f) {
+		return false;
+	}
+
+	for (uint32_t c = 0; c < 4; c++) {
+		endpoints[0][c] = fminf(fmaxf((ax[c] * bb - bx[c] * ab) /
+			determinant, 0.0f), 255.0f);
+		endpoints[1][c] = fminf(fmaxf((bx[c] * aa - ax[c] * ab) /
+			determinant, 0.0f), 255.0f);
+	}
+
+	return true;
+}
+
+static uint16_t
+_vk_dev_compress_pack_565(const float colour[4])
+{
+	return (uint16_t)(
+		(uint32_t)_vk_dev_compress_round(colour[0] * 31.0f / 255.0f) << 11 |
+		(uint32_t)_vk_dev_compress_round(colour[1] * 63.0f / 255.0f) << 5 |
+		(uint32_t)_vk_dev_compress_round(colour[2] * 31.0f / 255.0f));
+}
+
+static void
+_vk_dev_compress_unpack_565(const uint16_t value, uint32_t colour[3])
+{
+	colour[0] = (value >> 11 & 31) << 3 | (value >> 13 & 7);
+	colour[1] = (value >> 5 & 63) << 2 | (value >> 9 & 3);
+	colour[2] = (value & 31) << 3 | (value >> 2 & 7);
+}
+
+/*
+ *	NOTE:	The four colour BC1 palette, in index order, built the way the
+ *			decoder builds it.
+ */
+static void
+_vk_dev_compress_bc1_palette(const uint16_t colour0, const uint16_t colour1,
+	float palette[4][4])
+{
+	uint32_t a[3], b[3];
+
+	_vk_dev_compress_unpack_565(colour0, a);
+	_vk_dev_compress_unpack_565(colour1, b);
+
+	for (uint32_t c = 0; c < 3; c++) {
+		palette[0][c] = (float)a[c];
+		palette[1][c] = (float)b[c];
+		palette[2][c] = (float)((2 * a[c] + b[c]) / 3);
+		palette[3][c] = (float)((a[c] + 2 * b[c]) / 3);
+	}
+
+	for (uint32_t j = 0; j < 4; j++) {
+		palette[j][3] = 0.0f;
+	}
+}
+
+static void
+_vk_dev_compress_encode_bc1(const struct _vk_dev_compress_block* source,
+	uint8_t* output)
+{
+	static const float weights[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+
+	uint16_t colours[2], best_colours[2], swap;
+	uint8_t indices[16], best_indices[16];
+	uint32_t bits;
+	float endpoints[2][4], palette[4][4], texel_weights[16], error, best;
+	struct _vk_dev_compress_block block;
+
+	// NOTE: Alpha is not stored, so it must not steer the search.
+	block = *source;
+	memset(block.c[3], 0, sizeof(block.c[3]));
+
+	_vk_dev_compress_fit(&block, 3, endpoints);
+
+	best_colours[0] = best_colours[1] = 0;
+	best = INFINITY;
+	for (uint32_t pass = 0; pass < 2; pass++) {
+		colours[0] = _vk_dev_compress_pack_565(endpoints[0]);
+		colours[1] = _vk_dev_compress_pack_565(endpoints[1]);
+
+		// NOTE: colour0 > colour1 selects the four colour mode.
+		if (colours[0] < colours[1]) {
+			swap = colours[0];
+			colours[0] = colours[1];
+			colours[1] = swap;
+		}
+
+		_vk_dev_compress_bc1_palette(colours[0], colours[1], palette);
+		error = _vk_dev_compress_select(&block, palette, 4, indices);
+
+		if (error < best) {
+			best = error;
+			best_colours[0] = colours[0];
+			best_colours[1] = colours[1];
+			memcpy(best_indices, indices, sizeof(indices));
+		}
+
+		for (uint32_t i = 0; i < 16; i++) {
+			texel_weights[i] = weights[indices[i]];
+		}
+
+		if (colours[0] == colours[1] ||
+			!_vk_dev_compress_refit(&block, texel_weights, endpoints)) {
+			break;
+		}
+	}
+
+	// NOTE: Equal endpoints decode in three colour mode; index 0 is safe.
+	if (best_colours[0] == best_colours[1]) {
+		memset(best_indices, 0, sizeof(best_indices));
+	}
+
+	bits = 0;
+	for (uint32_t i = 0; i < 16; i++) {
+		bits |= (uint32_t)best_indices[i] << (i * 2);
+	}
+
+	output[0] = (uint8_t)best_colours[0];
+	output[1] = (uint8_t)(best_colours[0] >> 8);
+	output[2] = (uint8_t)best_colours[1];
+	output[3] = (uint8_t)(best_colours[1] >> 8);
+	for (uint32_t i = 0; i < 4; i++) {
+		output[4 + i] = (uint8_t)(bits >> (i * 8));
+	}
+}
+
+static uint32_t
+_vk_dev_compress_bc4_value(const uint32_t value0, const uint32_t value1,
+	const uint32_t index)
+{
+	if (index < 2) {
+		return index == 0 ? value0 : value1;
+	}
+
+	if (value0 > value1) {
+		return ((8 - index) * value0 + (index - 1) * value1 + 3) / 7;
+	}
+
+	if (index >= 6) {
+		return index == 6 ? 0 : 255;
+	}
+
+	return ((6 - index) * value0 + (index - 1) * value1 + 2) / 5;
+}
+
+static void
+_vk_dev_compress_encode_bc4(const struct _vk_dev_compress_block* block,
+	const uint32_t channel, uint8_t* output)
+{
+	uint32_t value0, value1, index;
+	uint64_t bits;
+	float low, high, best, distance;
+
+	low = 255.0f;
+	high = 0.0f;
+	for (uint32_t i = 0; i < 16; i++) {
+		low = fminf(low, block->c[channel][i]);
+		high = fmaxf(high, block->c[channel][i]);
+	}
+
+	value0 = (uint32_t)high;
+	value1 = (uint32_t)low;
+
+	bits = 0;
+	if (value0 > value1) {
+		for (uint32_t i = 0; i < 16; i++) {
+			best = INFINITY;
+			index = 0;
+
+			for (uint32_t j = 0; j < 8; j++) {
+				distance = fabsf(block->c[channel][i] -
+					(float)_vk_dev_compress_bc4_value(value0, value1, j));
+				if (distance < best) {
+					best = distance;
+					index = j;
+				}
+			}
+
+			bits |= (uint64_t)index << (i * 3);
+		}
+	}
+
+	output[0] = (uint8_t)value0;
+	output[1] = (uint8_t)value1;
+	for (uint32_t i = 0; i < 6; i++) {
+		output[2 + i] = (uint8_t)(bits >> (i * 8));
+	}
+}
+
+static void
+_vk_dev_compress_bc7_quantize(const float endpoint[4], uint32_t quantized[4],
+	uint32_t* parity)
+{
+	uint32_t q[2][4];
+	float error[2], difference;
+
+	for (uint32_t p = 0; p < 2; p++) {
+		error[p] = 0.0f;
+		for (uint32_t c = 0; c < 4; c++) {
+			q[p][c] = (uint32_t)fminf(fmaxf(_vk_dev_compress_round(
+				(endpoint[c] - (float)p) / 2.0f), 0.0f), 127.0f);
+			difference = (float)(q[p][c] << 1 | p) - endpoint[c];
+			error[p] += difference * difference;
+		}
+	}
+
+	// NOTE: Only odd values reach 255, so opaque endpoints stay opaque.
+	*parity = error[1] < error[0] || endpoint[3] >= 255.0f ? 1 : 0;
+	memcpy(quantized, q[*parity], sizeof(q[*parity]));
+}
+
+static void
+_vk_dev_compress_bc7_palette(const uint32_t quantized[2][4],
+	const uint32_t parity[2], float palette[16][4])
+{
+	uint32_t a, b;
+
+	for (uint32_t c = 0; c < 4; c++) {
+		a = quantized[0][c] << 1 | parity[0];
+		b = quantized[1][c] << 1 | parity[1];
+
+		for (uint32_t j = 0; j < 16; j++) {
+			palette[j][c] = (float)(((64 - _bc7_weights[j]) * a +
+				_bc7_weights[j] * b + 32) >> 6);
+		}
+	}
+}
+
+static void
+_vk_dev_compress_write_bits(uint64_t bits[2], uint32_t* position,
+	const uint32_t value, const uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++, (*position)++) {
+		bits[*position >> 6] |= (uint64_t)(value >> i & 1) <<
+			(*position & 63);
+	}
+}
+
+static void
+_vk_dev_compress_encode_bc7(const struct _vk_dev_compress_block* block,
+	uint8_t* output)
+{
+	uint8_t indices[16], best_indices[16];
+	uint32_t quantized[2][4], best_quantized[2][4], parity[2],
+		best_parity[2], position, swap;
+	uint64_t bits[2];
+	float endpoints[2][4], palette[16][4], weights[16], error, best;
+
+	_vk_dev_compress_fit(block, 4, endpoints);
+
+	memset(best_quantized, 0, sizeof(best_quantized));
+	best_parity[0] = best_parity[1] = 0;
+	best = INFINITY;
+	for (uint32_t pass = 0; pass < 2; pass++) {
+		_vk_dev_compress_bc7_quantize(endpoints[0], quantized[0], &parity[0]);
+		_vk_dev_compress_bc7_quantize(endpoints[1], quantized[1], &parity[1]);
+
+		_vk_dev_compress_bc7_palette(quantized, parity, palette);
+		error = _vk_dev_compress_select(block, palette, 16, indices);
+
+		if (error < best) {
+			best = error;
+			memcpy(best_quantized, quantized, sizeof(quantized));
+			memcpy(best_parity, parity, sizeof(parity));
+			memcpy(best_indices, indices, sizeof(indices));
+		}
+
+		for (uint32_t i = 0; i < 16; i++) {
+			weights[i] = _bc7_weights[indices[i]] / 64.0f;
+		}
+
+		if (!_vk_dev_compress_refit(block, weights, endpoints)) {
+			break;
+		}
+	}
+
+	// NOTE: The first index is stored without its top bit, which must be 0.
+	if (best_indices[0] >= 8) {
+		for (uint32_t c = 0; c < 4; c++) {
+			swap = best_quantized[0][c];
+			best_quantized[0][c] = best_quantized[1][c];
+			best_quantized[1][c] = swap;
+		}
+
+		swap = best_parity[0];
+		best_parity[0] = best_parity[1];
+		best_parity[1] = swap;
+
+		for (uint32_t i = 0; i < 16; i++) {
+			best_indices[i] = (uint8_t)(15 - best_indices[i]);
+		}
+	}
+
+	bits[0] = 0;
+	bits[1] = 0;
+	position = 0;
+
+	_vk_dev_compress_write_bits(bits, &position, 1 << 6, 7);
+	for (uint32_t c = 0; c < 4; c++) {
+		_vk_dev_compress_write_bits(bits, &position, best_quantized[0][c], 7);
+		_vk_dev_compress_write_bits(bits, &position, best_quantized[1][c], 7);
+	}
+	_vk_dev_compress_write_bits(bits, &position, best_parity[0], 1);
+	_vk_dev_compress_write_bits(bits, &position, best_parity[1], 1);
+	for (uint32_t i = 0; i < 16; i++) {
+		_vk_dev_compress_write_bits(bits, &position, best_indices[i],
+			i == 0 ? 3 : 4);
+	}
+
+	for (uint32_t i = 0; i < 16; i++) {
+		output[i] = (uint8_t)(bits[i >> 3] >> ((i & 7) * 8));
+	}
+}
+
+static void
+_vk_dev_compress_encode_row(void* arg, const uint32_t row)
+{
+	uint8_t* output;
+	struct _vk_dev_compress_block block;
+	const struct _vk_dev_compress_job* job;
+
+	job = arg;
+	output = job->blocks + (size_t)row * job->blocks_x *
+		vk_dev_compress_get_block_size(job->format);
+
+	for (uint32_t x = 0; x < job->blocks_x; x++) {
+		_vk_dev_compress_load(job, x, row, &block);
+
+		switch (job->format) {
+		case VK_DEV_COMPRESS_BC1:
+			_vk_dev_compress_encode_bc1(&block, output);
+			output += 8;
+			break;
+		case VK_DEV_COMPRESS_BC3:
+			_vk_dev_compress_encode_bc4(&block, 3, output);
+			_vk_dev_compress_encode_bc1(&block, output + 8);
+			output += 16;
+			break;
+		case VK_DEV_COMPRESS_BC5:
+			_vk_dev_compress_encode_bc4(&block, 0, output);
+			_vk_dev_compress_encode_bc4(&block, 1, output + 8);
+			output += 16;
+			break;
+		case VK_DEV_COMPRESS_BC7:
+			_vk_dev_compress_encode_bc7(&block, output);
+			output += 16;
+			break;
+		}
+	}
+}
+
+void
+vk_dev_compress_encode(const enum vk_dev_compress_format format,
+	const uint8_t* texels, const uint32_t width, const uint32_t height,
+	void* blocks, struct vk_dev_jobs* jobs)
+{
+	uint32_t rows;
+	struct _vk_dev_compress_job job;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_compress_encode");
+
+	job.format = format;
+	job.texels = texels;
+	job.width = width;
+	job.height = height;
+	job.blocks_x = (width + 3) / 4;
+	job.blocks = blocks;
+
+	rows = (height + 3) / 4;
+
+	if (jobs != NULL) {
+		vk_dev_jobs_run(jobs, rows, _vk_dev_compress_encode_row, &job);
+	} else {
+		for (uint32_t i = 0; i < rows; i++) {
+			_vk_dev_compress_encode_row(&job, i);
+		}
+	}
+
+	VK_DEV_TRACE_END("vk_dev_compress_encode");
+}
+
+static void
+_vk_dev_compress_decode_bc1(const uint8_t* input, uint8_t texels[16][4])
+{
+	uint16_t colour0, colour1;
+	uint32_t a[3], b[3], palette[4][4], bits;
+
+	colour0 = (uint16_t)(input[0] | input[1] << 8);
+	colour1 = (uint16_t)(input[2] | input[3] << 8);
+	bits = (uint32_t)input[4] | (uint32_t)input[5] << 8 |
+		(uint32_t)input[6] << 16 | (uint32_t)input[7] << 24;
+
+	_vk_dev_compress_unpack_565(colour0, a);
+	_vk_dev_compress_unpack_565(colour1, b);
+
+	for (uint32_t c = 0; c < 3; c++) {
+		palette[0][c] = a[c];
+		palette[1][c] = b[c];
+
+		if (colour0 > colour1) {
+			palette[2][c] = (2 * a[c] + b[c]) / 3;
+			palette[3][c] = (a[c] + 2 * b[c]) / 3;
+		} else {
+			palette[2][c] = (a[c] + b[c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+
+	palette[0][3] = palette[1][3] = palette[2][3] = 255;
+	palette[3][3] = colour0 > colour1 ? 255 : 0;
+
+	for (uint32_t i = 0; i < 16; i++) {
+		for (uint32_t c = 0; c < 4; c++) {
+			texels[i][c] = (uint8_t)palette[bits >> (i * 2) & 3][c];
+		}
+	}
+}
+
+static void
+_vk_dev_compress_decode_bc4(const uint8_t* input, uint8_t texels[16][4],
+	const uint32_t channel)
+{
+	uint64_t bits;
+
+	bits = 0;
+	for (uint32_t i = 0; i < 6; i++) {
+		bits |= (uint64_t)input[2 + i] << (i * 8);
+	}
+
+	for (uint32_t i = 0; i < 16; i++) {
+		texels[i][channel] = (uint8_t)_vk_dev_compress_bc4_value(input[0],
+			input[1], bits >> (i * 3) & 7);
+	}
+}
+
+static uint32_t
+_vk_dev_compress_read_bits(const uint8_t* input, uint32_t* position,
+	const uint32_t count)
+{
+	uint32_t value;
+
+	value = 0;
+	for (uint32_t i = 0; i < count; i++, (*position)++) {
+		value |= (uint32_t)(input[*position >> 3] >> (*position & 7) & 1) <<
+			i;
+	}
+
+	return value;
+}
+
+static void
+_vk_dev_compress_decode_bc7(const uint8_t* input, uint8_t texels[16][4])
+{
+	uint32_t position, endpoints[2][4], parity[2], index, a, b;
+
+	// NOTE: Mode 6 is six zero bits and a one.
+	if ((input[0] & 0x7f) != 1 << 6) {
+		memset(texels, 0, sizeof(uint8_t) * 16 * 4);
+		return;
+	}
+
+	position = 7;
+	for (uint32_t c = 0; c < 4; c++) {
+		endpoints[0][c] = _vk_dev_compress_read_bits(input, &position, 7);
+		endpoints[1][c] = _vk_dev_compress_read_bits(input, &position, 7);
+	}
+	parity[0] = _vk_dev_compress_read_bits(input, &position, 1);
+	parity[1] = _vk_dev_compress_read_bits(input, &position, 1);
+
+	for (uint32_t i = 0; i < 16; i++) {
+		index = _vk_dev_compress_read_bits(input, &position, i == 0 ? 3 : 4);
+
+		for (uint32_t c = 0; c < 4; c++) {
+			a = endpoints[0][c] << 1 | parity[0];
+			b = endpoints[1][c] << 1 | parity[1];
+			texels[i][c] = (uint8_t)(((64 - _bc7_weights[index]) * a +
+				_bc7_weights[index] * b + 32) >> 6);
+		}
+	}
+}
+
+void
+vk_dev_compress_decode(const enum vk_dev_compress_format format,
+	const void* blocks, const uint32_t width, const uint32_t height,
+	uint8_t* texels)
+{
+	uint32_t blocks_x, blocks_y, x, y;
+	uint8_t decoded[16][4];
+	const uint8_t* input;
+
+	blocks_x = (width + 3) / 4;
+	blocks_y = (height + 3) / 4;
+	input = blocks;
+
+	for (uint32_t block_y = 0; block_y < blocks_y; block_y++) {
+		for (uint32_t block_x = 0; block_x < blocks_x; block_x++) {
+			memset(decoded, 0, sizeof(decoded));
+
+			switch (format) {
+			case VK_DEV_COMPRESS_BC1:
+				_vk_dev_compress_decode_bc1(input, decoded);
+				break;
+			case VK_DEV_COMPRESS_BC3:
+				_vk_dev_compress_decode_bc1(input + 8, decoded);
+				_vk_dev_compress_decode_bc4(input, decoded, 3);
+				break;
+			case VK_DEV_COMPRESS_BC5:
+				_vk_dev_compress_decode_bc4(input, decoded, 0);
+				_vk_dev_compress_decode_bc4(input + 8, decoded, 1);
+				for (uint32_t i = 0; i < 16; i++) {
+					decoded[i][3] = 255;
+				}
+				break;
+			case VK_DEV_COMPRESS_BC7:
+				_vk_dev_compress_decode_bc7(input, decoded);
+				break;
+			}
+
+			input += vk_dev_compress_get_block_size(format);
+
+			for (uint32_t i = 0; i < 16; i++) {
+				x = block_x * 4 + (i & 3);
+				y = block_y * 4 + (i >> 2);
+				if (x < width && y < height) {
+					memcpy(texels + ((size_t)y * width + x) * 4, decoded[i], 4);
+				}
+			}
+		}
+	}
+}
+
+static double
+_vk_dev_compress_psnr(const double squared_error, const uint64_t count)
+{
+	if (count == 0 || squared_error <= 0.0) {
+		return INFINITY;
+	}
+
+	return 10.0 * log10(255.0 * 255.0 * count / squared_error);
+}
+
+void
+vk_dev_compress_measure(const enum vk_dev_compress_format format,
+	const uint8_t* reference, const uint8_t* texels, const uint32_t width,
+	const uint32_t height, struct vk_dev_compress_quality* quality)
+{
+	int32_t difference;
+	uint32_t colour_channels;
+	bool alpha;
+	double error[2];
+	uint64_t count[2];
+
+	colour_channels = format == VK_DEV_COMPRESS_BC5 ? 2 : 3;
+	alpha = format == VK_DEV_COMPRESS_BC3 || format == VK_DEV_COMPRESS_BC7;
+
+	error[0] = error[1] = 0.0;
+	count[0] = count[1] = 0;
+	quality->max_error = 0;
+
+	for (size_t i = 0; i < (size_t)width * height; i++) {
+		for (uint32_t c = 0; c < 4; c++) {
+			if (c == 3 ? !alpha : c >= colour_channels) {
+				continue;
+			}
+
+			difference = (int32_t)reference[i * 4 + c] -
+				(int32_t)texels[i * 4 + c];
+			error[c == 3] += (double)difference * difference;
+			count[c == 3]++;
+
+			if ((uint32_t)abs(difference) > quality->max_error) {
+				quality->max_error = (uint32_t)abs(difference);
+			}
+		}
+	}
+
+	quality->psnr_rgb = _vk_dev_compress_psnr(error[0], count[0]);
+	quality->psnr_alpha = _vk_dev_compress_psnr(error[1], count[1]);
+}
+
+static void
+_vk_dev_compress_sampler_create(struct vk_dev_compress* compress)
+{
+	VkResult result;
+	VkSamplerCreateInfo create_info;
+
+	create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	create_info.pNext = NULL;
+	create_info.flags = 0;
+	create_info.magFilter = VK_FILTER_NEAREST;
+	create_info.minFilter = VK_FILTER_NEAREST;
+	create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	create_info.mipLodBias = 0.0f;
+	create_info.anisotropyEnable = VK_FALSE;
+	create_info.maxAnisotropy = 1.0f;
+	create_info.compareEnable = VK_FALSE;
+	create_info.compareOp = VK_COMPARE_OP_ALWAYS;
+	create_info.minLod = 0.0f;
+	create_info.maxLod = 0.0f;
+	create_info.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+	create_info.unnormalizedCoordinates = VK_FALSE;
+
+	result = compress->context->vk.CreateSampler(compress->context->device,
+		&create_info, NULL, &compress->sampler);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[COMPRESS] Failed to create sampler.");
+	}
+}
+
+static void
+_vk_dev_compress_pipeline_create(struct vk_dev_compress* compress)
+{
+	VkResult result;
+	VkDescriptorSetLayout set_layout;
+	VkPushConstantRange push_constants;
+	VkPipelineLayoutCreateInfo create_info;
+
+	compress->binding_layout = vk_dev_binding_layout_create(
+		compress->context, _bindings, ARRAY_SIZE(_bindings));
+	set_layout = vk_dev_binding_layout_get_layout(compress->binding_layout);
+
+	push_constants.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	push_constants.offset = 0;
+	push_constants.size = sizeof(struct _vk_dev_compress_constants);
+
+	create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	create_info.pNext = NULL;
+	create_info.flags = 0;
+	create_info.setLayoutCount = 1;
+	create_info.pSetLayouts = &set_layout;
+	create_info.pushConstantRangeCount = 1;
+	create_info.pPushConstantRanges = &push_constants;
+
+	result = compress->context->vk.CreatePipelineLayout(
+		compress->context->device, &create_info, NULL,
+		&compress->pipeline_layout);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[COMPRESS] Failed to create pipeline layout.");
+	}
+
+	vk_dev_binding_layout_set_pipeline(compress->binding_layout,
+		VK_PIPELINE_BIND_POINT_COMPUTE, compress->pipeline_layout, 0);
+
+	compress->pipeline = vk_dev_compute_pipeline_create(compress->context,
+		VK_DEV_SHADER_DIR "/compress.comp.spv", compress->pipeline_layout);
+}
+
+struct vk_dev_compress*
+vk_dev_compress_create(struct vk_dev_context* context)
+{
+	struct vk_dev_compress* compress;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_compress_create");
+
+	compress = calloc(1, sizeof(*compress));
+	if (compress == NULL) {
+		vk_dev_fatal_error("[COMPRESS] Failed to allocate encoder.");
+	}
+
+	compress->context = context;
+
+	_vk_dev_compress_sampler_create(compress);
+	_vk_dev_compress_pipeline_create(compress);
+
+	VK_DEV_TRACE_END("vk_dev_compress_create");
+
+	return compress;
+}
+
+void
+vk_dev_compress_destroy(struct vk_dev_compress* compress)
+{
+	struct vk_dev_context* context;
+
+	if (compress == NULL) {
+		return;
+	}
+
+	context = compress->context;
+
+	context->vk.DestroyPipeline(context->device, compress->pipeline, NULL);
+	context->vk.DestroyPipelineLayout(context->device,
+		compress->pipeline_layout, NULL);
+	vk_dev_binding_layout_destroy(compress->binding_layout);
+
+	context->vk.DestroySampler(context->device, compress->sampler, NULL);
+
+	free(compress);
+}
+
+void
+vk_dev_compress_record(struct vk_dev_compress* compress,
+	VkCommandBuffer command_buffer,
+	struct vk_dev_descriptor_allocator* allocator,
+	const enum vk_dev_compress_format format, VkImageView source,
+	const VkImageLayout source_layout, const uint32_t width,
+	const uint32_t height, VkBuffer destination, const VkDeviceSize offset)
+{
+	VkMemoryBarrier barrier;
+	struct vk_dev_context* context;
+	struct _vk_dev_compress_bindings bindings;
+	struct _vk_dev_compress_constants constants;
+
+	context = compress->context;
+
+	if (offset % 16 != 0) {
+		vk_dev_fatal_error("[COMPRESS] Misaligned destination offset.");
+	}
+
+	VK_DEV_TRACE_BEGIN("vk_dev_compress_record");
+
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.pNext = NULL;
+	barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT |
+		VK_ACCESS_SHADER_WRITE_BIT;
+
+	context->vk.CmdPipelineBarrier(command_buffer,
+		VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, NULL, 0,
+		NULL);
+
+	bindings.source.sampler = compress->sampler;
+	bindings.source.imageView = source;
+	bindings.source.imageLayout = source_layout;
+	bindings.destination.buffer = destination;
+	bindings.destination.offset = 0;
+	bindings.destination.range = VK_WHOLE_SIZE;
+
+	constants.size[0] = width;
+	constants.size[1] = height;
+	constants.format = format;
+	constants.offset = (uint32_t)(offset / sizeof(uint32_t));
+
+	context->vk.CmdBindPipeline(command_buffer,
+		VK_PIPELINE_BIND_POINT_COMPUTE, compress->pipeline);
+	vk_dev_binding_layout_write(compress->binding_layout, command_buffer,
+		allocator, &bindings);
+	context->vk.CmdPushConstants(command_buffer, compress->pipeline_layout,
+		VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+	context->vk.CmdDispatch(command_buffer,
+		((width + 3) / 4 + VK_DEV_COMPRESS_GROUP_SIZE - 1) /
+		VK_DEV_COMPRESS_GROUP_SIZE,
+		((height + 3) / 4 + VK_DEV_COMPRESS_GROUP_SIZE - 1) /
+		VK_DEV_COMPRESS_GROUP_SIZE, 1);
+
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT |
+		VK_ACCESS_HOST_READ_BIT;
+
+	context->vk.CmdPipelineBarrier(command_buffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 1,
+		&barrier, 0, NULL, 0, NULL);
+
+	VK_DEV_TRACE_END("vk_dev_compress_record");
+}
@@ -0,0 +1,299 @@
+#include <vulkan-dev/deletion.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/trace.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#define VK_DEV_DELETION_MIN_CAPACITY 64
+
+/*
+ *	NOTE:	Entries are moved out of the ring this many at a time, so the
+ *			lock is never held across a vkDestroy* call.
+ */
+#define VK_DEV_DELETION_CHUNK 64
+
+enum _vk_dev_deletion_kind {
+	_VK_DEV_DELETION_BUFFER,
+	_VK_DEV_DELETION_IMAGE,
+	_VK_DEV_DELETION_IMAGE_VIEW,
+	_VK_DEV_DELETION_SAMPLER,
+	_VK_DEV_DELETION_PIPELINE,
+	_VK_DEV_DELETION_PIPELINE_LAYOUT,
+};
+
+struct _vk_dev_deletion_entry {
+	uint64_t value;
+	enum _vk_dev_deletion_kind kind;
+
+	union {
+		struct vk_dev_buffer buffer;
+		struct vk_dev_image image;
+		VkImageView view;
+		VkSampler sampler;
+		VkPipeline pipeline;
+		VkPipelineLayout pipeline_layout;
+	} resource;
+};
+
+struct vk_dev_deletion_queue {
+	struct vk_dev_context* context;
+
+	pthread_mutex_t lock;
+
+	// NOTE: A ring of count entries from head, in retirement order.
+	struct _vk_dev_deletion_entry* entries;
+	uint32_t capacity;
+	uint32_t head;
+	uint32_t count;
+
+	struct vk_dev_deletion_stats stats;
+};
+
+struct vk_dev_deletion_queue*
+vk_dev_deletion_queue_create(struct vk_dev_context* context)
+{
+	struct vk_dev_deletion_queue* queue;
+
+	queue = calloc(1, sizeof(*queue));
+	if (queue == NULL) {
+		vk_dev_fatal_error("[DELETION] Failed to allocate queue.");
+	}
+
+	queue->context = context;
+	queue->capacity = VK_DEV_DELETION_MIN_CAPACITY;
+	queue->entries = malloc(sizeof(*queue->entries) * queue->capacity);
+	if (queue->entries == NULL) {
+		vk_dev_fatal_error("[DELETION] Failed to allocate entries.");
+	}
+
+	if (pthread_mutex_init(&queue->lock, NULL) != 0) {
+		vk_dev_fatal_error("[DELETION] Failed to create lock.");
+	}
+
+	return queue;
+}
+
+void
+vk_dev_deletion_queue_destroy(struct vk_dev_deletion_queue* queue)
+{
+	if (queue == NULL) {
+		return;
+	}
+
+	queue->context->vk.DeviceWaitIdle(queue->context->device);
+	vk_dev_deletion_queue_collect(queue, UINT64_MAX, 0);
+
+	pthread_mutex_destroy(&queue->lock);
+	free(queue->entries);
+	free(queue);
+}
+
+static void
+_vk_dev_deletion_grow(struct vk_dev_deletion_queue* queue)
+{
+	uint32_t capacity, tail;
+	struct _vk_dev_deletion_entry* entries;
+
+	capacity = queue->capacity * 2;
+	entries = realloc(queue->entries, sizeof(*entries) * capacity);
+	if (entries == NULL) {
+		vk_dev_fatal_error("[DELETION] Failed to grow entries.");
+	}
+
+	// NOTE: Entries that wrapped around move past the old end.
+	tail = queue->head + queue->count > queue->capacity ?
+		queue->head + queue->count - queue->capacity : 0;
+	memcpy(entries + queue->capacity, entries, sizeof(*entries) * tail);
+
+	queue->entries = entries;
+	queue->capacity = capacity;
+}
+
+static void
+_vk_dev_deletion_push(struct vk_dev_deletion_queue* queue,
+	const struct _vk_dev_deletion_entry* entry)
+{
+	pthread_mutex_lock(&queue->lock);
+
+	if (queue->count == queue->capacity) {
+		_vk_dev_deletion_grow(queue);
+	}
+
+	queue->entries[(queue->head + queue->count) % queue->capacity] = *entry;
+	queue->count++;
+	queue->stats.retired++;
+
+	pthread_mutex_unlock(&queue->lock);
+}
+
+void
+vk_dev_deletion_queue_retire_buffer(struct vk_dev_deletion_queue* queue,
+	const uint64_t value, struct vk_dev_buffer* buffer)
+{
+	struct _vk_dev_deletion_entry entry;
+
+	entry.value = value;
+	entry.kind = _VK_DEV_DELETION_BUFFER;
+	entry.resource.buffer = *buffer;
+	_vk_dev_deletion_push(queue, &entry);
+
+	memset(buffer, 0, sizeof(*buffer));
+}
+
+void
+vk_dev_deletion_queue_retire_image(struct vk_dev_deletion_queue* queue,
+	const uint64_t value, struct vk_dev_image* image)
+{
+	struct _vk_dev_deletion_entry entry;
+
+	entry.value = value;
+	entry.kind = _VK_DEV_DELETION_IMAGE;
+	entry.resource.image = *image;
+	_vk_dev_deletion_push(queue, &entry);
+
+	memset(image, 0, sizeof(*image));
+}
+
+void
+vk_dev_deletion_queue_retire_image_view(struct vk_dev_deletion_queue* queue,
+	const uint64_t value, VkImageView view)
+{
+	struct _vk_dev_deletion_entry entry;
+
+	entry.value = value;
+	entry.kind = _VK_DEV_DELETION_IMAGE_VIEW;
+	entry.resource.view = view;
+	_vk_dev_deletion_push(queue, &entry);
+}
+
+void
+vk_dev_deletion_queue_retire_sampler(struct vk_dev_deletion_queue* queue,
+	const uint64_t value, VkSampler sampler)
+{
+	struct _vk_dev_deletion_entry entry;
+
+	entry.value = value;
+	entry.kind = _VK_DEV_DELETION_SAMPLER;
+	entry.resource.sampler = sampler;
+	_vk_dev_deletion_push(queue, &entry);
+}
+
+void
+vk_dev_deletion_queue_retire_pipeline(struct vk_dev_deletion_queue* queue,
+	const uint64_t value, VkPipeline pipeline)
+{
+	struct _vk_dev_deletion_entry entry;
+
+	entry.value = value;
+	entry.kind = _VK_DEV_DELETION_PIPELINE;
+	entry.resource.pipeline = pipeline;
+	_vk_dev_deletion_push(queue, &entry);
+}
+
+void
+vk_dev_deletion_queue_retire_pipeline_layout(
+	struct vk_dev_deletion_queue* queue, const uint64_t value,
+	VkPipelineLayout layout)
+{
+	struct _vk_dev_deletion_entry entry;
+
+	entry.value = value;
+	entry.kind = _VK_DEV_DELETION_PIPELINE_LAYOUT;
+	entry.resource.pipeline_layout = layout;
+	_vk_dev_deletion_push(queue, &entry);
+}
+
+static void
+_vk_dev_deletion_destroy(struct vk_dev_context* context,
+	struct _vk_dev_deletion_entry* entry)
+{
+	switch (entry->kind) {
+	case _VK_DEV_DELETION_BUFFER:
+		vk_dev_buffer_destroy(context, &entry->resource.buffer);
+		break;
+	case _VK_DEV_DELETION_IMAGE:
+		vk_dev_image_destroy(context, &entry->resource.image);
+		break;
+	case _VK_DEV_DELETION_IMAGE_VIEW:
+		context->vk.DestroyImageView(context->device, entry->resource.view,
+			NULL);
+		break;
+	case _VK_DEV_DELETION_SAMPLER:
+		context->vk.DestroySampler(context->device, entry->resource.sampler,
+			NULL);
+		break;
+	case _VK_DEV_DELETION_PIPELINE:
+		context->vk.DestroyPipeline(context->device,
+			entry->resource.pipeline, NULL);
+		break;
+	case _VK_DEV_DELETION_PIPELINE_LAYOUT:
+		context->vk.DestroyPipelineLayout(context->device,
+			entry->resource.pipeline_layout, NULL);
+		break;
+	}
+}
+
+uint32_t
+vk_dev_deletion_queue_collect(struct vk_dev_deletion_queue* queue,
+	const uint64_t completed, const uint32_t max_count)
+{
+	uint32_t destroyed, limit, taken;
+	struct _vk_dev_deletion_entry chunk[VK_DEV_DELETION_CHUNK];
+
+	limit = max_count > 0 ? max_count : UINT32_MAX;
+	destroyed = 0;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_deletion_queue_collect");
+
+	while (destroyed < limit) {
+		pthread_mutex_lock(&queue->lock);
+
+		taken = 0;
+		while (taken < VK_DEV_DELETION_CHUNK && destroyed + taken < limit &&
+			queue->count > 0 &&
+			queue->entries[queue->head].value <= completed) {
+			chunk[taken++] = queue->entries[queue->head];
+			queue->head = (queue->head + 1) % queue->capacity;
+			queue->count--;
+		}
+
+		pthread_mutex_unlock(&queue->lock);
+
+		if (taken == 0) {
+			break;
+		}
+
+		for (uint32_t i = 0; i < taken; i++) {
+			_vk_dev_deletion_destroy(queue->context, &chunk[i]);
+		}
+
+		destroyed += taken;
+	}
+
+	if (destroyed > 0) {
+		pthread_mutex_lock(&queue->lock);
+		queue->stats.destroyed += destroyed;
+		queue->stats.batches++;
+		if (destroyed > queue->stats.largest_batch) {
+			queue->stats.largest_batch = destroyed;
+		}
+		pthread_mutex_unlock(&queue->lock);
+	}
+
+	VK_DEV_TRACE_END("vk_dev_deletion_queue_collect");
+
+	return destroyed;
+}
+
+void
+vk_dev_deletion_queue_get_stats(struct vk_dev_deletion_queue* queue,
+	struct vk_dev_deletion_stats* stats)
+{
+	pthread_mutex_lock(&queue->lock);
+	*stats = queue->stats;
+	stats->pending = queue->count;
+	pthread_mutex_unlock(&queue->lock);
+}
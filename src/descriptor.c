@@ -0,0 +1,510 @@
+#include <vulkan-dev/descriptor.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/trace.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define ARRAY_SIZE(x) (sizeof(x)/sizeof(*x))
+
+#define VK_DEV_HANDLE_BITS(handle) ((uint64_t)(uintptr_t)(handle))
+
+/*
+ *	NOTE:	The first pool holds this many sets and every pool chained on
+ *			after it doubles, up to the maximum, so a frame that needs many
+ *			sets settles on a handful of large pools.
+ */
+#define VK_DEV_DESCRIPTOR_POOL_MIN_SETS 64
+#define VK_DEV_DESCRIPTOR_POOL_MAX_SETS 4096
+
+#define VK_DEV_DESCRIPTOR_CACHE_MIN_CAPACITY 64
+
+/*
+ *	NOTE:	Descriptors of each type reserved per set in a pool. Pools are
+ *			shared by every layout, so these are averages; a layout that
+ *			overruns them just makes the chain grow sooner.
+ */
+static const struct {
+	VkDescriptorType type;
+	float per_set;
+} _pool_ratios[] = {
+	{VK_DESCRIPTOR_TYPE_SAMPLER, 0.5f},
+	{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f},
+	{VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 4.0f},
+	{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f},
+	{VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 1.0f},
+	{VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 1.0f},
+	{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f},
+	{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f},
+	{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f},
+	{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.0f},
+	{VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 0.5f},
+};
+
+struct _vk_dev_descriptor_pools {
+	VkDescriptorPool* pools;
+	uint32_t count;
+	uint32_t capacity;
+};
+
+/*
+ *	NOTE:	A cache entry's key is a run of words in the frame's key arena:
+ *			the layout followed by every write flattened to its binding,
+ *			type and descriptor handles. Entries are compared on the full
+ *			key, the hash only narrows the search.
+ */
+struct _vk_dev_descriptor_entry {
+	uint64_t hash;
+	uint32_t key_offset;
+	uint32_t key_length;
+	VkDescriptorSet set;
+};
+
+struct _vk_dev_descriptor_frame {
+	struct _vk_dev_descriptor_pools used;
+
+	struct _vk_dev_descriptor_entry* entries;
+	uint32_t entry_count;
+	uint32_t entry_capacity;
+
+	uint64_t* keys;
+	uint32_t key_count;
+	uint32_t key_capacity;
+};
+
+struct vk_dev_descriptor_allocator {
+	struct vk_dev_context* context;
+
+	struct _vk_dev_descriptor_frame* frames;
+	uint32_t frame_count;
+	uint32_t frame;
+
+	struct _vk_dev_descriptor_pools free;
+	uint32_t next_pool_sets;
+
+	VkWriteDescriptorSet* writes;
+	uint32_t write_capacity;
+
+	struct vk_dev_descriptor_stats stats;
+};
+
+static void*
+_vk_dev_descriptor_grow(void* array, uint32_t* capacity, const uint32_t count,
+	const size_t element_size)
+{
+	uint32_t new_capacity;
+
+	if (count <= *capacity) {
+		return array;
+	}
+
+	new_capacity = *capacity > 0 ? *capacity : 16;
+	while (new_capacity < count) {
+		new_capacity *= 2;
+	}
+
+	array = realloc(array, new_capacity * element_size);
+	if (array == NULL) {
+		vk_dev_fatal_error("[DESCRIPTOR] Failed to grow allocator storage.");
+	}
+
+	*capacity = new_capacity;
+
+	return array;
+}
+
+static void
+_vk_dev_descriptor_pools_push(struct _vk_dev_descriptor_pools* pools,
+	VkDescriptorPool pool)
+{
+	pools->pools = _vk_dev_descriptor_grow(pools->pools, &pools->capacity,
+		pools->count + 1, sizeof(*pools->pools));
+	pools->pools[pools->count++] = pool;
+}
+
+static VkDescriptorPool
+_vk_dev_descriptor_pool_create(struct vk_dev_descriptor_allocator* allocator)
+{
+	VkResult result;
+	VkDescriptorPool pool;
+	VkDescriptorPoolSize pool_sizes[ARRAY_SIZE(_pool_ratios)];
+	VkDescriptorPoolCreateInfo create_info;
+	const uint32_t sets = allocator->next_pool_sets;
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(_pool_ratios); i++) {
+		pool_sizes[i].type = _pool_ratios[i].type;
+		pool_sizes[i].descriptorCount =
+			(uint32_t)(_pool_ratios[i].per_set * sets) + 1;
+	}
+
+	create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	create_info.pNext = NULL;
+	create_info.flags = 0;
+	create_info.maxSets = sets;
+	create_info.poolSizeCount = ARRAY_SIZE(pool_sizes);
+	create_info.pPoolSizes = pool_sizes;
+
+	result = allocator->context->vk.CreateDescriptorPool(
+		allocator->context->device, &create_info, NULL, &pool);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[DESCRIPTOR] Failed to create descriptor pool.");
+	}
+
+	if (allocator->next_pool_sets < VK_DEV_DESCRIPTOR_POOL_MAX_SETS) {
+		allocator->next_pool_sets *= 2;
+	}
+
+	allocator->stats.pool_creations++;
+	VK_DEV_TRACE_INSTANT("vk_dev_descriptor_pool_create");
+
+	return pool;
+}
+
+/*
+ *	NOTE:	Chains a pool onto the current frame, preferring one released by
+ *			an earlier reset over creating another.
+ */
+static VkDescriptorPool
+_vk_dev_descriptor_pool_acquire(struct vk_dev_descriptor_allocator* allocator)
+{
+	VkDescriptorPool pool;
+	struct _vk_dev_descriptor_frame* frame;
+
+	frame = &allocator->frames[allocator->frame];
+
+	if (allocator->free.count > 0) {
+		pool = allocator->free.pools[--allocator->free.count];
+	} else {
+		pool = _vk_dev_descriptor_pool_create(allocator);
+	}
+
+	_vk_dev_descriptor_pools_push(&frame->used, pool);
+
+	return pool;
+}
+
+struct vk_dev_descriptor_allocator*
+vk_dev_descriptor_allocator_create(struct vk_dev_context* context,
+	const uint32_t frame_count)
+{
+	struct vk_dev_descriptor_allocator* allocator;
+
+	if (frame_count == 0) {
+		vk_dev_fatal_error("[DESCRIPTOR] Frame count must be non-zero.");
+	}
+
+	allocator = calloc(1, sizeof(*allocator));
+	if (allocator == NULL) {
+		vk_dev_fatal_error("[DESCRIPTOR] Failed to allocate allocator.");
+	}
+
+	allocator->frames = calloc(frame_count, sizeof(*allocator->frames));
+	if (allocator->frames == NULL) {
+		vk_dev_fatal_error("[DESCRIPTOR] Failed to allocate frames.");
+	}
+
+	allocator->context = context;
+	allocator->frame_count = frame_count;
+	allocator->next_pool_sets = VK_DEV_DESCRIPTOR_POOL_MIN_SETS;
+
+	return allocator;
+}
+
+void
+vk_dev_descriptor_allocator_destroy(
+	struct vk_dev_descriptor_allocator* allocator)
+{
+	struct _vk_dev_descriptor_frame* frame;
+
+	for (uint32_t i = 0; i < allocator->frame_count; i++) {
+		frame = &allocator->frames[i];
+
+		for (uint32_t j = 0; j < frame->used.count; j++) {
+			allocator->context->vk.DestroyDescriptorPool(
+				allocator->context->device, frame->used.pools[j], NULL);
+		}
+
+		free(frame->used.pools);
+		free(frame->entries);
+		free(frame->keys);
+	}
+
+	for (uint32_t i = 0; i < allocator->free.count; i++) {
+		allocator->context->vk.DestroyDescriptorPool(
+			allocator->context->device, allocator->free.pools[i], NULL);
+	}
+
+	free(allocator->free.pools);
+	free(allocator->writes);
+	free(allocator->frames);
+	free(allocator);
+}
+
+void
+vk_dev_descriptor_allocator_begin_frame(
+	struct vk_dev_descriptor_allocator* allocator, const uint32_t frame_index)
+{
+	struct _vk_dev_descriptor_frame* frame;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_descriptor_allocator_begin_frame");
+
+	allocator->frame = frame_index % allocator->frame_count;
+	frame = &allocator->frames[allocator->frame];
+
+	for (uint32_t i = 0; i < frame->used.count; i++) {
+		allocator->context->vk.ResetDescriptorPool(allocator->context->device,
+			frame->used.pools[i], 0);
+		_vk_dev_descriptor_pools_push(&allocator->free, frame->used.pools[i]);
+	}
+
+	allocator->stats.pool_resets += frame->used.count;
+	frame->used.count = 0;
+
+	if (frame->entry_count > 0) {
+		memset(frame->entries, 0,
+			frame->entry_capacity * sizeof(*frame->entries));
+	}
+
+	frame->entry_count = 0;
+	frame->key_count = 0;
+
+	VK_DEV_TRACE_END("vk_dev_descriptor_allocator_begin_frame");
+}
+
+VkDescriptorSet
+vk_dev_descriptor_allocator_allocate(
+	struct vk_dev_descriptor_allocator* allocator,
+	VkDescriptorSetLayout layout)
+{
+	VkResult result;
+	VkDescriptorSet set;
+	VkDescriptorSetAllocateInfo allocate_info;
+	struct _vk_dev_descriptor_frame* frame;
+
+	frame = &allocator->frames[allocator->frame];
+
+	allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocate_info.pNext = NULL;
+	allocate_info.descriptorSetCount = 1;
+	allocate_info.pSetLayouts = &layout;
+
+	if (frame->used.count == 0) {
+		_vk_dev_descriptor_pool_acquire(allocator);
+	}
+
+	allocate_info.descriptorPool = frame->used.pools[frame->used.count - 1];
+	result = allocator->context->vk.AllocateDescriptorSets(
+		allocator->context->device, &allocate_info, &set);
+
+	if (result == VK_ERROR_OUT_OF_POOL_MEMORY ||
+		result == VK_ERROR_FRAGMENTED_POOL) {
+		allocate_info.descriptorPool =
+			_vk_dev_descriptor_pool_acquire(allocator);
+		result = allocator->context->vk.AllocateDescriptorSets(
+			allocator->context->device, &allocate_info, &set);
+	}
+
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[DESCRIPTOR] Failed to allocate descriptor set.");
+	}
+
+	allocator->stats.allocations++;
+
+	return set;
+}
+
+static void
+_vk_dev_descriptor_key_push(struct _vk_dev_descriptor_frame* frame,
+	const uint64_t word)
+{
+	frame->keys = _vk_dev_descriptor_grow(frame->keys, &frame->key_capacity,
+		frame->key_count + 1, sizeof(*frame->keys));
+	frame->keys[frame->key_count++] = word;
+}
+
+static void
+_vk_dev_descriptor_key_build(struct _vk_dev_descriptor_frame* frame,
+	VkDescriptorSetLayout layout, const VkWriteDescriptorSet* writes,
+	const uint32_t write_count)
+{
+	const VkWriteDescriptorSet* write;
+
+	_vk_dev_descriptor_key_push(frame, VK_DEV_HANDLE_BITS(layout));
+
+	for (uint32_t i = 0; i < write_count; i++) {
+		write = &writes[i];
+
+		_vk_dev_descriptor_key_push(frame, (uint64_t)write->dstBinding << 32 |
+			write->dstArrayElement);
+		_vk_dev_descriptor_key_push(frame, (uint64_t)write->descriptorType << 32 |
+			write->descriptorCount);
+
+		/*
+		 *	NOTE:	Only the members Vulkan reads for the descriptor type go
+		 *			into the key; the others may be left uninitialized.
+		 */
+		for (uint32_t j = 0; j < write->descriptorCount; j++) {
+			switch (write->descriptorType) {
+			case VK_DESCRIPTOR_TYPE_SAMPLER:
+				_vk_dev_descriptor_key_push(frame,
+					VK_DEV_HANDLE_BITS(write->pImageInfo[j].sampler));
+				break;
+			case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+				_vk_dev_descriptor_key_push(frame,
+					VK_DEV_HANDLE_BITS(write->pImageInfo[j].sampler));
+				// fallthrough
+			case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+			case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+			case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+				_vk_dev_descriptor_key_push(frame,
+					VK_DEV_HANDLE_BITS(write->pImageInfo[j].imageView));
+				_vk_dev_descriptor_key_push(frame,
+					write->pImageInfo[j].imageLayout);
+				break;
+			case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+			case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+				_vk_dev_descriptor_key_push(frame,
+					VK_DEV_HANDLE_BITS(write->pTexelBufferView[j]));
+				break;
+			default:
+				_vk_dev_descriptor_key_push(frame,
+					VK_DEV_HANDLE_BITS(write->pBufferInfo[j].buffer));
+				_vk_dev_descriptor_key_push(frame,
+					write->pBufferInfo[j].offset);
+				_vk_dev_descriptor_key_push(frame,
+					write->pBufferInfo[j].range);
+				break;
+			}
+		}
+	}
+}
+
+static uint64_t
+_vk_dev_descriptor_key_hash(const uint64_t* key, const uint32_t length)
+{
+	uint64_t hash;
+
+	hash = 0xcbf29ce484222325ull;
+	for (uint32_t i = 0; i < length; i++) {
+		hash ^= key[i];
+		hash *= 0x100000001b3ull;
+		hash ^= hash >> 29;
+	}
+
+	// NOTE: Zero marks an empty slot.
+	return hash | 1;
+}
+
+static struct _vk_dev_descriptor_entry*
+_vk_dev_descriptor_cache_find(struct _vk_dev_descriptor_frame* frame,
+	const uint64_t hash, const uint32_t key_offset, const uint32_t key_length)
+{
+	uint32_t mask;
+	struct _vk_dev_descriptor_entry* entry;
+
+	mask = frame->entry_capacity - 1;
+	for (uint32_t i = (uint32_t)hash & mask;; i = (i + 1) & mask) {
+		entry = &frame->entries[i];
+
+		if (entry->hash == 0) {
+			return entry;
+		}
+
+		if (entry->hash == hash && entry->key_length == key_length &&
+			memcmp(&frame->keys[entry->key_offset], &frame->keys[key_offset],
+			key_length * sizeof(*frame->keys)) == 0) {
+			return entry;
+		}
+	}
+}
+
+static void
+_vk_dev_descriptor_cache_reserve(struct _vk_dev_descriptor_frame* frame)
+{
+	uint32_t old_capacity;
+	struct _vk_dev_descriptor_entry* old_entries;
+	struct _vk_dev_descriptor_entry* entry;
+
+	// NOTE: Keep the table at most half full so probe runs stay short.
+	if ((frame->entry_count + 1) * 2 <= frame->entry_capacity) {
+		return;
+	}
+
+	old_entries = frame->entries;
+	old_capacity = frame->entry_capacity;
+
+	frame->entry_capacity = old_capacity > 0 ? old_capacity * 2 :
+		VK_DEV_DESCRIPTOR_CACHE_MIN_CAPACITY;
+	frame->entries = calloc(frame->entry_capacity, sizeof(*frame->entries));
+	if (frame->entries == NULL) {
+		vk_dev_fatal_error("[DESCRIPTOR] Failed to grow set cache.");
+	}
+
+	for (uint32_t i = 0; i < old_capacity; i++) {
+		if (old_entries[i].hash != 0) {
+			entry = _vk_dev_descriptor_cache_find(frame, old_entries[i].hash,
+				old_entries[i].key_offset, old_entries[i].key_length);
+			*entry = old_entries[i];
+		}
+	}
+
+	free(old_entries);
+}
+
+VkDescriptorSet
+vk_dev_descriptor_allocator_get(struct vk_dev_descriptor_allocator* allocator,
+	VkDescriptorSetLayout layout, const VkWriteDescriptorSet* writes,
+	const uint32_t write_count)
+{
+	uint64_t hash;
+	uint32_t key_offset;
+	uint32_t key_length;
+	struct _vk_dev_descriptor_frame* frame;
+	struct _vk_dev_descriptor_entry* entry;
+
+	frame = &allocator->frames[allocator->frame];
+
+	key_offset = frame->key_count;
+	_vk_dev_descriptor_key_build(frame, layout, writes, write_count);
+	key_length = frame->key_count - key_offset;
+	hash = _vk_dev_descriptor_key_hash(&frame->keys[key_offset], key_length);
+
+	_vk_dev_descriptor_cache_reserve(frame);
+	entry = _vk_dev_descriptor_cache_find(frame, hash, key_offset, key_length);
+
+	if (entry->hash != 0) {
+		// NOTE: Drop the probe key, the matching entry owns an identical one.
+		frame->key_count = key_offset;
+		allocator->stats.cache_hits++;
+		return entry->set;
+	}
+
+	allocator->stats.cache_misses++;
+
+	entry->hash = hash;
+	entry->key_offset = key_offset;
+	entry->key_length = key_length;
+	entry->set = vk_dev_descriptor_allocator_allocate(allocator, layout);
+	frame->entry_count++;
+
+	allocator->writes = _vk_dev_descriptor_grow(allocator->writes,
+		&allocator->write_capacity, write_count, sizeof(*allocator->writes));
+	for (uint32_t i = 0; i < write_count; i++) {
+		allocator->writes[i] = writes[i];
+		allocator->writes[i].dstSet = entry->set;
+	}
+
+	allocator->context->vk.UpdateDescriptorSets(allocator->context->device,
+		write_count, allocator->writes, 0, NULL);
+
+	return entry->set;
+}
+
+void
+vk_dev_descriptor_allocator_get_stats(
+	const struct vk_dev_descriptor_allocator* allocator,
+	struct vk_dev_descriptor_stats* stats)
+{
+	*stats = allocator->stats;
+}
@@ -0,0 +1,459 @@
+#include <vulkan-dev/downsample.h>
+#include <vulkan-dev/binding.h>
+#include <vulkan-dev/buffer.h>
+#include <vulkan-dev/shader.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/trace.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ARRAY_SIZE(x) (sizeof(x)/sizeof(*x))
+
+#define VK_DEV_DOWNSAMPLE_TILE_SIZE 64
+#define VK_DEV_DOWNSAMPLE_MAX_GROUPS 64
+
+struct _vk_dev_downsample_bindings {
+	VkDescriptorImageInfo source;
+	VkDescriptorImageInfo destinations[VK_DEV_DOWNSAMPLE_MAX_LEVELS - 1];
+	VkDescriptorBufferInfo counter;
+	VkDescriptorBufferInfo intermediate;
+};
+
+// NOTE: Matches the push constant block in shaders/downsample.comp.
+struct _vk_dev_downsample_constants {
+	uint32_t size[2];
+	uint32_t groups[2];
+	uint32_t levels;
+};
+
+static const struct vk_dev_binding _bindings[] = {
+	VK_DEV_BINDING(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+		VK_SHADER_STAGE_COMPUTE_BIT, struct _vk_dev_downsample_bindings,
+		source),
+	VK_DEV_BINDING(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+		VK_DEV_DOWNSAMPLE_MAX_LEVELS - 1, VK_SHADER_STAGE_COMPUTE_BIT,
+		struct _vk_dev_downsample_bindings, destinations),
+	VK_DEV_BINDING(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+		VK_SHADER_STAGE_COMPUTE_BIT, struct _vk_dev_downsample_bindings,
+		counter),
+	VK_DEV_BINDING(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+		VK_SHADER_STAGE_COMPUTE_BIT, struct _vk_dev_downsample_bindings,
+		intermediate),
+};
+
+struct vk_dev_downsample {
+	struct vk_dev_context* context;
+
+	const struct vk_dev_image* image;
+	VkImageView level_views[VK_DEV_DOWNSAMPLE_MAX_LEVELS];
+	VkSampler sampler;
+
+	/*
+	 *	NOTE:	The counter is zeroed once; the last group of every dispatch
+	 *			rearms it for the next one.
+	 */
+	struct vk_dev_buffer counter;
+	struct vk_dev_buffer intermediate;
+	bool counter_cleared;
+
+	struct vk_dev_binding_layout* binding_layout;
+	VkPipelineLayout pipeline_layout;
+	VkPipeline pipeline;
+};
+
+static uint32_t
+_vk_dev_downsample_level_size(const uint32_t size, const uint32_t level)
+{
+	return (size >> level) > 0 ? size >> level : 1;
+}
+
+static void
+_vk_dev_downsample_sampler_create(struct vk_dev_downsample* downsample)
+{
+	VkResult result;
+	VkSamplerCreateInfo create_info;
+
+	create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	create_info.pNext = NULL;
+	create_info.flags = 0;
+	create_info.magFilter = VK_FILTER_LINEAR;
+	create_info.minFilter = VK_FILTER_LINEAR;
+	create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	create_info.mipLodBias = 0.0f;
+	create_info.anisotropyEnable = VK_FALSE;
+	create_info.maxAnisotropy = 1.0f;
+	create_info.compareEnable = VK_FALSE;
+	create_info.compareOp = VK_COMPARE_OP_ALWAYS;
+	create_info.minLod = 0.0f;
+	create_info.maxLod = 0.0f;
+	create_info.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+	create_info.unnormalizedCoordinates = VK_FALSE;
+
+	result = downsample->context->vk.CreateSampler(
+		downsample->context->device, &create_info, NULL,
+		&downsample->sampler);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[DOWNSAMPLE] Failed to create sampler.");
+	}
+}
+
+static void
+_vk_dev_downsample_pipeline_create(struct vk_dev_downsample* downsample)
+{
+	VkResult result;
+	VkDescriptorSetLayout set_layout;
+	VkPushConstantRange push_constants;
+	VkPipelineLayoutCreateInfo create_info;
+
+	downsample->binding_layout = vk_dev_binding_layout_create(
+		downsample->context, _bindings, ARRAY_SIZE(_bindings));
+	set_layout = vk_dev_binding_layout_get_layout(downsample->binding_layout);
+
+	push_constants.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	push_constants.offset = 0;
+	push_constants.size = sizeof(struct _vk_dev_downsample_constants);
+
+	create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	create_info.pNext = NULL;
+	create_info.flags = 0;
+	create_info.setLayoutCount = 1;
+	create_info.pSetLayouts = &set_layout;
+	create_info.pushConstantRangeCount = 1;
+	create_info.pPushConstantRanges = &push_constants;
+
+	result = downsample->context->vk.CreatePipelineLayout(
+		downsample->context->device, &create_info, NULL,
+		&downsample->pipeline_layout);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[DOWNSAMPLE] Failed to create pipeline layout.");
+	}
+
+	vk_dev_binding_layout_set_pipeline(downsample->binding_layout,
+		VK_PIPELINE_BIND_POINT_COMPUTE, downsample->pipeline_layout, 0);
+
+	downsample->pipeline = vk_dev_compute_pipeline_create(downsample->context,
+		VK_DEV_SHADER_DIR "/downsample.comp.spv",
+		downsample->pipeline_layout);
+}
+
+struct vk_dev_downsample*
+vk_dev_downsample_create(struct vk_dev_context* context,
+	const struct vk_dev_image* image)
+{
+	struct vk_dev_downsample* downsample;
+
+	if (!context->features.shaderStorageImageWriteWithoutFormat ||
+		!context->features.shaderStorageImageArrayDynamicIndexing) {
+		vk_dev_fatal_error("[DOWNSAMPLE] Device cannot store to images "
+			"without a format.");
+	}
+
+	if (image->levels > VK_DEV_DOWNSAMPLE_MAX_LEVELS ||
+		image->width > VK_DEV_DOWNSAMPLE_TILE_SIZE *
+		VK_DEV_DOWNSAMPLE_MAX_GROUPS ||
+		image->height > VK_DEV_DOWNSAMPLE_TILE_SIZE *
+		VK_DEV_DOWNSAMPLE_MAX_GROUPS) {
+		vk_dev_fatal_error("[DOWNSAMPLE] Image too large.");
+	}
+
+	VK_DEV_TRACE_BEGIN("vk_dev_downsample_create");
+
+	downsample = calloc(1, sizeof(*downsample));
+	if (downsample == NULL) {
+		vk_dev_fatal_error("[DOWNSAMPLE] Failed to allocate downsampler.");
+	}
+
+	downsample->context = context;
+	downsample->image = image;
+
+	for (uint32_t i = 0; i < image->levels; i++) {
+		downsample->level_views[i] = vk_dev_image_view_create(context, image,
+			i, 1);
+	}
+
+	vk_dev_buffer_create(context, sizeof(uint32_t),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &downsample->counter);
+
+	// NOTE: One RGBA32F texel of level 6 per group.
+	vk_dev_buffer_create(context, sizeof(float) * 4 *
+		VK_DEV_DOWNSAMPLE_MAX_GROUPS * VK_DEV_DOWNSAMPLE_MAX_GROUPS,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &downsample->intermediate);
+
+	_vk_dev_downsample_sampler_create(downsample);
+	_vk_dev_downsample_pipeline_create(downsample);
+
+	VK_DEV_TRACE_END("vk_dev_downsample_create");
+
+	return downsample;
+}
+
+void
+vk_dev_downsample_destroy(struct vk_dev_downsample* downsample)
+{
+	struct vk_dev_context* context;
+
+	if (downsample == NULL) {
+		return;
+	}
+
+	context = downsample->context;
+
+	context->vk.DestroyPipeline(context->device, downsample->pipeline, NULL);
+	context->vk.DestroyPipelineLayout(context->device,
+		downsample->pipeline_layout, NULL);
+	vk_dev_binding_layout_destroy(downsample->binding_layout);
+
+	context->vk.DestroySampler(context->device, downsample->sampler, NULL);
+
+	vk_dev_buffer_destroy(context, &downsample->intermediate);
+	vk_dev_buffer_destroy(context, &downsample->counter);
+
+	for (uint32_t i = 0; i < downsample->image->levels; i++) {
+		context->vk.DestroyImageView(context->device,
+			downsample->level_views[i], NULL);
+	}
+
+	free(downsample);
+}
+
+static void
+_vk_dev_downsample_prepare(struct vk_dev_downsample* downsample,
+	VkCommandBuffer command_buffer, const VkImageLayout layout)
+{
+	VkImageMemoryBarrier barriers[2];
+	VkBufferMemoryBarrier counter_barrier;
+	struct vk_dev_context* context;
+
+	context = downsample->context;
+
+	for (uint32_t i = 0; i < 2; i++) {
+		barriers[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barriers[i].pNext = NULL;
+		barriers[i].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barriers[i].image = downsample->image->image;
+		barriers[i].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barriers[i].subresourceRange.baseArrayLayer = 0;
+		barriers[i].subresourceRange.layerCount = 1;
+	}
+
+	barriers[0].srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+	barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	barriers[0].oldLayout = layout;
+	barriers[0].subresourceRange.baseMipLevel = 0;
+	barriers[0].subresourceRange.levelCount = 1;
+
+	// NOTE: Every other level is rewritten, so its contents are discarded.
+	barriers[1].srcAccessMask = 0;
+	barriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barriers[1].subresourceRange.baseMipLevel = 1;
+	barriers[1].subresourceRange.levelCount =
+		downsample->image->levels - 1;
+
+	context->vk.CmdPipelineBarrier(command_buffer,
+		VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, NULL, 0, NULL, 2,
+		barriers);
+
+	if (downsample->counter_cleared) {
+		return;
+	}
+
+	context->vk.CmdFillBuffer(command_buffer, downsample->counter.buffer, 0,
+		VK_WHOLE_SIZE, 0);
+
+	counter_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	counter_barrier.pNext = NULL;
+	counter_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	counter_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT |
+		VK_ACCESS_SHADER_WRITE_BIT;
+	counter_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	counter_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	counter_barrier.buffer = downsample->counter.buffer;
+	counter_barrier.offset = 0;
+	counter_barrier.size = VK_WHOLE_SIZE;
+
+	context->vk.CmdPipelineBarrier(command_buffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 0, NULL, 1, &counter_barrier, 0, NULL);
+
+	downsample->counter_cleared = true;
+}
+
+void
+vk_dev_downsample_record(struct vk_dev_downsample* downsample,
+	VkCommandBuffer command_buffer,
+	struct vk_dev_descriptor_allocator* allocator, const VkImageLayout layout)
+{
+	uint32_t last;
+	VkMemoryBarrier barrier;
+	struct vk_dev_context* context;
+	const struct vk_dev_image* image;
+	struct _vk_dev_downsample_bindings bindings;
+	struct _vk_dev_downsample_constants constants;
+
+	context = downsample->context;
+	image = downsample->image;
+
+	if (image->levels < 2) {
+		return;
+	}
+
+	VK_DEV_TRACE_BEGIN("vk_dev_downsample_record");
+
+	_vk_dev_downsample_prepare(downsample, command_buffer, layout);
+
+	bindings.source.sampler = downsample->sampler;
+	bindings.source.imageView = downsample->level_views[0];
+	bindings.source.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	// NOTE: Slots past the last level are never stored to but must be valid.
+	last = image->levels - 1;
+	for (uint32_t i = 1; i < VK_DEV_DOWNSAMPLE_MAX_LEVELS; i++) {
+		bindings.destinations[i - 1].sampler = VK_NULL_HANDLE;
+		bindings.destinations[i - 1].imageView =
+			downsample->level_views[i < last ? i : last];
+		bindings.destinations[i - 1].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	}
+
+	bindings.counter.buffer = downsample->counter.buffer;
+	bindings.counter.offset = 0;
+	bindings.counter.range = VK_WHOLE_SIZE;
+	bindings.intermediate.buffer = downsample->intermediate.buffer;
+	bindings.intermediate.offset = 0;
+	bindings.intermediate.range = VK_WHOLE_SIZE;
+
+	constants.size[0] = image->width;
+	constants.size[1] = image->height;
+	constants.groups[0] = (image->width + VK_DEV_DOWNSAMPLE_TILE_SIZE - 1) /
+		VK_DEV_DOWNSAMPLE_TILE_SIZE;
+	constants.groups[1] = (image->height + VK_DEV_DOWNSAMPLE_TILE_SIZE - 1) /
+		VK_DEV_DOWNSAMPLE_TILE_SIZE;
+	constants.levels = image->levels;
+
+	context->vk.CmdBindPipeline(command_buffer,
+		VK_PIPELINE_BIND_POINT_COMPUTE, downsample->pipeline);
+	vk_dev_binding_layout_write(downsample->binding_layout, command_buffer,
+		allocator, &bindings);
+	context->vk.CmdPushConstants(command_buffer, downsample->pipeline_layout,
+		VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+	context->vk.CmdDispatch(command_buffer, constants.groups[0],
+		constants.groups[1], 1);
+
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.pNext = NULL;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	context->vk.CmdPipelineBarrier(command_buffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, NULL, 0,
+		NULL);
+
+	VK_DEV_TRACE_END("vk_dev_downsample_record");
+}
+
+static void
+_vk_dev_downsample_transition(struct vk_dev_context* context,
+	VkCommandBuffer command_buffer, const struct vk_dev_image* image,
+	const uint32_t level, const uint32_t level_count,
+	const VkImageLayout old_layout,
+	const VkImageLayout new_layout, const VkAccessFlags source_access,
+	const VkAccessFlags destination_access,
+	const VkPipelineStageFlags source_stage,
+	const VkPipelineStageFlags destination_stage)
+{
+	VkImageMemoryBarrier barrier;
+
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.pNext = NULL;
+	barrier.srcAccessMask = source_access;
+	barrier.dstAccessMask = destination_access;
+	barrier.oldLayout = old_layout;
+	barrier.newLayout = new_layout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image->image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = level;
+	barrier.subresourceRange.levelCount = level_count;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	context->vk.CmdPipelineBarrier(command_buffer, source_stage,
+		destination_stage, 0, 0, NULL, 0, NULL, 1, &barrier);
+}
+
+void
+vk_dev_downsample_blit(struct vk_dev_context* context,
+	VkCommandBuffer command_buffer, const struct vk_dev_image* image,
+	const VkImageLayout layout)
+{
+	VkImageBlit blit;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_downsample_blit");
+
+	_vk_dev_downsample_transition(context, command_buffer, image, 0, 1,
+		layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_MEMORY_WRITE_BIT,
+		VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+	blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	blit.srcSubresource.baseArrayLayer = 0;
+	blit.srcSubresource.layerCount = 1;
+	blit.dstSubresource = blit.srcSubresource;
+	blit.srcOffsets[0].x = 0;
+	blit.srcOffsets[0].y = 0;
+	blit.srcOffsets[0].z = 0;
+	blit.dstOffsets[0] = blit.srcOffsets[0];
+
+	for (uint32_t i = 1; i < image->levels; i++) {
+		_vk_dev_downsample_transition(context, command_buffer, image, i, 1,
+			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+		blit.srcSubresource.mipLevel = i - 1;
+		blit.srcOffsets[1].x = _vk_dev_downsample_level_size(image->width,
+			i - 1);
+		blit.srcOffsets[1].y = _vk_dev_downsample_level_size(image->height,
+			i - 1);
+		blit.srcOffsets[1].z = 1;
+
+		blit.dstSubresource.mipLevel = i;
+		blit.dstOffsets[1].x = _vk_dev_downsample_level_size(image->width, i);
+		blit.dstOffsets[1].y = _vk_dev_downsample_level_size(image->height,
+			i);
+		blit.dstOffsets[1].z = 1;
+
+		context->vk.CmdBlitImage(command_buffer, image->image,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image->image,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+		// NOTE: The level just written is the source of the next blit.
+		_vk_dev_downsample_transition(context, command_buffer, image, i, 1,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT);
+	}
+
+	_vk_dev_downsample_transition(context, command_buffer, image, 0,
+		image->levels, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+	VK_DEV_TRACE_END("vk_dev_downsample_blit");
+}
@@ -0,0 +1,333 @@
+#include <vulkan-dev/hiz.h>
+#include <vulkan-dev/binding.h>
+#include <vulkan-dev/image.h>
+#include <vulkan-dev/shader.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/trace.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#define ARRAY_SIZE(x) (sizeof(x)/sizeof(*x))
+
+#define VK_DEV_HIZ_GROUP_SIZE 8
+
+struct _vk_dev_hiz_bindings {
+	VkDescriptorImageInfo source;
+	VkDescriptorImageInfo destination;
+};
+
+// NOTE: Matches the push constant block in shaders/hiz.comp.
+struct _vk_dev_hiz_constants {
+	uint32_t source_size[2];
+	uint32_t destination_size[2];
+};
+
+static const struct vk_dev_binding _bindings[] = {
+	VK_DEV_BINDING(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+		VK_SHADER_STAGE_COMPUTE_BIT, struct _vk_dev_hiz_bindings, source),
+	VK_DEV_BINDING(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1,
+		VK_SHADER_STAGE_COMPUTE_BIT, struct _vk_dev_hiz_bindings,
+		destination),
+};
+
+struct vk_dev_hiz {
+	struct vk_dev_context* context;
+
+	struct vk_dev_image pyramid;
+	VkImageView view;
+	VkImageView* level_views;
+	VkSampler sampler;
+
+	uint32_t depth_width;
+	uint32_t depth_height;
+
+	struct vk_dev_binding_layout* binding_layout;
+	VkPipelineLayout pipeline_layout;
+	VkPipeline pipeline;
+};
+
+static uint32_t
+_vk_dev_hiz_previous_power_of_two(uint32_t value)
+{
+	uint32_t result;
+
+	result = 1;
+	while (result * 2 <= value) {
+		result *= 2;
+	}
+
+	return result;
+}
+
+static void
+_vk_dev_hiz_sampler_create(struct vk_dev_hiz* hiz)
+{
+	VkResult result;
+	VkSamplerCreateInfo create_info;
+
+	create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	create_info.pNext = NULL;
+	create_info.flags = 0;
+	create_info.magFilter = VK_FILTER_NEAREST;
+	create_info.minFilter = VK_FILTER_NEAREST;
+	create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	create_info.mipLodBias = 0.0f;
+	create_info.anisotropyEnable = VK_FALSE;
+	create_info.maxAnisotropy = 1.0f;
+	create_info.compareEnable = VK_FALSE;
+	create_info.compareOp = VK_COMPARE_OP_ALWAYS;
+	create_info.minLod = 0.0f;
+	create_info.maxLod = VK_LOD_CLAMP_NONE;
+	create_info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	create_info.unnormalizedCoordinates = VK_FALSE;
+
+	result = hiz->context->vk.CreateSampler(hiz->context->device,
+		&create_info, NULL, &hiz->sampler);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[HIZ] Failed to create sampler.");
+	}
+}
+
+static void
+_vk_dev_hiz_pipeline_create(struct vk_dev_hiz* hiz)
+{
+	VkResult result;
+	VkDescriptorSetLayout set_layout;
+	VkPushConstantRange push_constants;
+	VkPipelineLayoutCreateInfo create_info;
+
+	hiz->binding_layout = vk_dev_binding_layout_create(hiz->context,
+		_bindings, ARRAY_SIZE(_bindings));
+	set_layout = vk_dev_binding_layout_get_layout(hiz->binding_layout);
+
+	push_constants.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	push_constants.offset = 0;
+	push_constants.size = sizeof(struct _vk_dev_hiz_constants);
+
+	create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	create_info.pNext = NULL;
+	create_info.flags = 0;
+	create_info.setLayoutCount = 1;
+	create_info.pSetLayouts = &set_layout;
+	create_info.pushConstantRangeCount = 1;
+	create_info.pPushConstantRanges = &push_constants;
+
+	result = hiz->context->vk.CreatePipelineLayout(hiz->context->device,
+		&create_info, NULL, &hiz->pipeline_layout);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[HIZ] Failed to create pipeline layout.");
+	}
+
+	vk_dev_binding_layout_set_pipeline(hiz->binding_layout,
+		VK_PIPELINE_BIND_POINT_COMPUTE, hiz->pipeline_layout, 0);
+
+	hiz->pipeline = vk_dev_compute_pipeline_create(hiz->context,
+		VK_DEV_SHADER_DIR "/hiz.comp.spv", hiz->pipeline_layout);
+}
+
+struct vk_dev_hiz*
+vk_dev_hiz_create(struct vk_dev_context* context, const uint32_t depth_width,
+	const uint32_t depth_height)
+{
+	uint32_t width, height, levels;
+	struct vk_dev_hiz* hiz;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_hiz_create");
+
+	hiz = calloc(1, sizeof(*hiz));
+	if (hiz == NULL) {
+		vk_dev_fatal_error("[HIZ] Failed to allocate pyramid.");
+	}
+
+	hiz->context = context;
+	hiz->depth_width = depth_width;
+	hiz->depth_height = depth_height;
+
+	width = _vk_dev_hiz_previous_power_of_two(depth_width);
+	height = _vk_dev_hiz_previous_power_of_two(depth_height);
+
+	levels = 1;
+	while ((width >> levels) > 0 || (height >> levels) > 0) {
+		levels++;
+	}
+
+	vk_dev_image_create(context, width, height, levels, VK_FORMAT_R32_SFLOAT,
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
+		&hiz->pyramid);
+
+	hiz->view = vk_dev_image_view_create(context, &hiz->pyramid, 0, levels);
+
+	hiz->level_views = malloc(sizeof(*hiz->level_views) * levels);
+	if (hiz->level_views == NULL) {
+		vk_dev_fatal_error("[HIZ] Failed to allocate level views.");
+	}
+
+	for (uint32_t i = 0; i < levels; i++) {
+		hiz->level_views[i] = vk_dev_image_view_create(context, &hiz->pyramid,
+			i, 1);
+	}
+
+	_vk_dev_hiz_sampler_create(hiz);
+	_vk_dev_hiz_pipeline_create(hiz);
+
+	VK_DEV_TRACE_END("vk_dev_hiz_create");
+
+	return hiz;
+}
+
+void
+vk_dev_hiz_destroy(struct vk_dev_hiz* hiz)
+{
+	struct vk_dev_context* context;
+
+	context = hiz->context;
+
+	context->vk.DestroyPipeline(context->device, hiz->pipeline, NULL);
+	context->vk.DestroyPipelineLayout(context->device, hiz->pipeline_layout,
+		NULL);
+	vk_dev_binding_layout_destroy(hiz->binding_layout);
+
+	context->vk.DestroySampler(context->device, hiz->sampler, NULL);
+
+	for (uint32_t i = 0; i < hiz->pyramid.levels; i++) {
+		context->vk.DestroyImageView(context->device, hiz->level_views[i],
+			NULL);
+	}
+
+	context->vk.DestroyImageView(context->device, hiz->view, NULL);
+	vk_dev_image_destroy(context, &hiz->pyramid);
+
+	free(hiz->level_views);
+	free(hiz);
+}
+
+static uint32_t
+_vk_dev_hiz_level_size(const uint32_t size, const uint32_t level)
+{
+	return (size >> level) > 0 ? size >> level : 1;
+}
+
+static void
+_vk_dev_hiz_barrier(const struct vk_dev_hiz* hiz,
+	VkCommandBuffer command_buffer)
+{
+	VkMemoryBarrier barrier;
+
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.pNext = NULL;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	hiz->context->vk.CmdPipelineBarrier(command_buffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, NULL, 0,
+		NULL);
+}
+
+void
+vk_dev_hiz_build(struct vk_dev_hiz* hiz, VkCommandBuffer command_buffer,
+	struct vk_dev_descriptor_allocator* allocator, VkImageView depth_view,
+	const VkImageLayout depth_layout)
+{
+	VkImageMemoryBarrier barrier;
+	struct vk_dev_context* context;
+	struct _vk_dev_hiz_bindings bindings;
+	struct _vk_dev_hiz_constants constants;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_hiz_build");
+
+	context = hiz->context;
+
+	/*
+	 *	NOTE:	Every level is rewritten, so the old contents are discarded;
+	 *			the barrier only has to wait for the previous frame's culling
+	 *			to finish reading them.
+	 */
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.pNext = NULL;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = hiz->pyramid.image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = hiz->pyramid.levels;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	context->vk.CmdPipelineBarrier(command_buffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, NULL, 0, NULL, 1,
+		&barrier);
+
+	context->vk.CmdBindPipeline(command_buffer,
+		VK_PIPELINE_BIND_POINT_COMPUTE, hiz->pipeline);
+
+	for (uint32_t i = 0; i < hiz->pyramid.levels; i++) {
+		bindings.source.sampler = hiz->sampler;
+		bindings.destination.sampler = VK_NULL_HANDLE;
+		bindings.destination.imageView = hiz->level_views[i];
+		bindings.destination.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		if (i == 0) {
+			bindings.source.imageView = depth_view;
+			bindings.source.imageLayout = depth_layout;
+			constants.source_size[0] = hiz->depth_width;
+			constants.source_size[1] = hiz->depth_height;
+		} else {
+			bindings.source.imageView = hiz->level_views[i - 1];
+			bindings.source.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+			constants.source_size[0] = _vk_dev_hiz_level_size(
+				hiz->pyramid.width, i - 1);
+			constants.source_size[1] = _vk_dev_hiz_level_size(
+				hiz->pyramid.height, i - 1);
+		}
+
+		constants.destination_size[0] = _vk_dev_hiz_level_size(
+			hiz->pyramid.width, i);
+		constants.destination_size[1] = _vk_dev_hiz_level_size(
+			hiz->pyramid.height, i);
+
+		vk_dev_binding_layout_write(hiz->binding_layout, command_buffer,
+			allocator, &bindings);
+		context->vk.CmdPushConstants(command_buffer, hiz->pipeline_layout,
+			VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+		context->vk.CmdDispatch(command_buffer,
+			(constants.destination_size[0] + VK_DEV_HIZ_GROUP_SIZE - 1) /
+			VK_DEV_HIZ_GROUP_SIZE,
+			(constants.destination_size[1] + VK_DEV_HIZ_GROUP_SIZE - 1) /
+			VK_DEV_HIZ_GROUP_SIZE, 1);
+
+		_vk_dev_hiz_barrier(hiz, command_buffer);
+	}
+
+	VK_DEV_TRACE_END("vk_dev_hiz_build");
+}
+
+VkImageView
+vk_dev_hiz_get_view(const struct vk_dev_hiz* hiz)
+{
+	return hiz->view;
+}
+
+VkSampler
+vk_dev_hiz_get_sampler(const struct vk_dev_hiz* hiz)
+{
+	return hiz->sampler;
+}
+
+void
+vk_dev_hiz_get_size(const struct vk_dev_hiz* hiz, uint32_t* width,
+	uint32_t* height, uint32_t* levels)
+{
+	*width = hiz->pyramid.width;
+	*height = hiz->pyramid.height;
+	*levels = hiz->pyramid.levels;
+}
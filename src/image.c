@@ -0,0 +1,109 @@
+#include <vulkan-dev/image.h>
+#include <vulkan-dev/buffer.h>
+#include <vulkan-dev/context.h>
+
+void
+vk_dev_image_create(struct vk_dev_context* context, const uint32_t width,
+	const uint32_t height, const uint32_t levels, const VkFormat format,
+	const VkImageUsageFlags usage, struct vk_dev_image* image)
+{
+	VkResult result;
+	VkMemoryRequirements requirements;
+	VkImageCreateInfo create_info;
+	VkMemoryAllocateInfo allocate_info;
+
+	create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	create_info.pNext = NULL;
+	create_info.flags = 0;
+	create_info.imageType = VK_IMAGE_TYPE_2D;
+	create_info.format = format;
+	create_info.extent.width = width;
+	create_info.extent.height = height;
+	create_info.extent.depth = 1;
+	create_info.mipLevels = levels;
+	create_info.arrayLayers = 1;
+	create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+	create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+	create_info.usage = usage;
+	create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	create_info.queueFamilyIndexCount = 0;
+	create_info.pQueueFamilyIndices = NULL;
+	create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	result = context->vk.CreateImage(context->device, &create_info, NULL,
+		&image->image);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[IMAGE] Failed to create image.");
+	}
+
+	context->vk.GetImageMemoryRequirements(context->device, image->image,
+		&requirements);
+
+	allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocate_info.pNext = NULL;
+	allocate_info.allocationSize = requirements.size;
+	allocate_info.memoryTypeIndex = vk_dev_find_memory_type(context,
+		requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	result = context->vk.AllocateMemory(context->device, &allocate_info, NULL,
+		&image->memory);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[IMAGE] Failed to allocate image memory.");
+	}
+
+	result = context->vk.BindImageMemory(context->device, image->image,
+		image->memory, 0);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[IMAGE] Failed to bind image memory.");
+	}
+
+	image->format = format;
+	image->width = width;
+	image->height = height;
+	image->levels = levels;
+}
+
+void
+vk_dev_image_destroy(struct vk_dev_context* context,
+	struct vk_dev_image* image)
+{
+	context->vk.DestroyImage(context->device, image->image, NULL);
+	context->vk.FreeMemory(context->device, image->memory, NULL);
+
+	image->image = VK_NULL_HANDLE;
+	image->memory = VK_NULL_HANDLE;
+}
+
+VkImageView
+vk_dev_image_view_create(struct vk_dev_context* context,
+	const struct vk_dev_image* image, const uint32_t base_level,
+	const uint32_t level_count)
+{
+	VkResult result;
+	VkImageView view;
+	VkImageViewCreateInfo create_info;
+
+	create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	create_info.pNext = NULL;
+	create_info.flags = 0;
+	create_info.image = image->image;
+	create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	create_info.format = image->format;
+	create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+	create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+	create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+	create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+	create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	create_info.subresourceRange.baseMipLevel = base_level;
+	create_info.subresourceRange.levelCount = level_count;
+	create_info.subresourceRange.baseArrayLayer = 0;
+	create_info.subresourceRange.layerCount = 1;
+
+	result = context->vk.CreateImageView(context->device, &create_info, NULL,
+		&view);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[IMAGE] Failed to create image view.");
+	}
+
+	return view;
+}
@@ -0,0 +1,365 @@
+#include <vulkan-dev/indirect.h>
+#include <vulkan-dev/hiz.h>
+#include <vulkan-dev/binding.h>
+#include <vulkan-dev/buffer.h>
+#include <vulkan-dev/shader.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/trace.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define ARRAY_SIZE(x) (sizeof(x)/sizeof(*x))
+
+#define VK_DEV_INDIRECT_GROUP_SIZE 64
+
+struct _vk_dev_indirect_bindings {
+	VkDescriptorBufferInfo objects;
+	VkDescriptorBufferInfo meshes;
+	VkDescriptorBufferInfo draws;
+	VkDescriptorBufferInfo stats;
+	VkDescriptorImageInfo pyramid;
+};
+
+// NOTE: Matches the push constant block in shaders/cull.glsl.
+struct _vk_dev_indirect_constants {
+	float view_projection[16];
+	float camera_position[4];
+	float pyramid_size[2];
+	uint32_t pyramid_levels;
+	uint32_t object_count;
+};
+
+/*
+ *	NOTE:	The occlusion variant adds the Hi-Z pyramid as binding 4. The
+ *			frustum-only variant leaves it out of its layout entirely, so it
+ *			never needs a valid pyramid to bind.
+ */
+static const struct vk_dev_binding _bindings[] = {
+	VK_DEV_BINDING(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+		VK_SHADER_STAGE_COMPUTE_BIT, struct _vk_dev_indirect_bindings, objects),
+	VK_DEV_BINDING(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+		VK_SHADER_STAGE_COMPUTE_BIT, struct _vk_dev_indirect_bindings, meshes),
+	VK_DEV_BINDING(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+		VK_SHADER_STAGE_COMPUTE_BIT, struct _vk_dev_indirect_bindings, draws),
+	VK_DEV_BINDING(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+		VK_SHADER_STAGE_COMPUTE_BIT, struct _vk_dev_indirect_bindings, stats),
+	VK_DEV_BINDING(4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+		VK_SHADER_STAGE_COMPUTE_BIT, struct _vk_dev_indirect_bindings,
+		pyramid),
+};
+
+enum _vk_dev_indirect_variant {
+	_VK_DEV_INDIRECT_FRUSTUM,
+	_VK_DEV_INDIRECT_OCCLUSION,
+	_VK_DEV_INDIRECT_VARIANT_COUNT,
+};
+
+static const struct {
+	const char* path;
+	uint32_t binding_count;
+} _variants[_VK_DEV_INDIRECT_VARIANT_COUNT] = {
+	{VK_DEV_SHADER_DIR "/cull.comp.spv", ARRAY_SIZE(_bindings) - 1},
+	{VK_DEV_SHADER_DIR "/cull_occlusion.comp.spv", ARRAY_SIZE(_bindings)},
+};
+
+struct _vk_dev_indirect_pass {
+	struct vk_dev_binding_layout* binding_layout;
+	VkPipelineLayout pipeline_layout;
+	VkPipeline pipeline;
+};
+
+struct vk_dev_indirect {
+	struct vk_dev_context* context;
+
+	struct _vk_dev_indirect_pass passes[_VK_DEV_INDIRECT_VARIANT_COUNT];
+
+	struct vk_dev_buffer objects;
+	struct vk_dev_buffer meshes;
+	struct vk_dev_buffer draws;
+	struct vk_dev_buffer stats;
+	struct _vk_dev_indirect_bindings bindings;
+
+	uint32_t object_capacity;
+	uint32_t object_count;
+};
+
+static void
+_vk_dev_indirect_pass_create(struct vk_dev_indirect* indirect,
+	const enum _vk_dev_indirect_variant variant)
+{
+	VkResult result;
+	VkDescriptorSetLayout set_layout;
+	VkPushConstantRange push_constants;
+	VkPipelineLayoutCreateInfo create_info;
+	struct _vk_dev_indirect_pass* pass;
+
+	pass = &indirect->passes[variant];
+
+	pass->binding_layout = vk_dev_binding_layout_create(indirect->context,
+		_bindings, _variants[variant].binding_count);
+	set_layout = vk_dev_binding_layout_get_layout(pass->binding_layout);
+
+	push_constants.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	push_constants.offset = 0;
+	push_constants.size = sizeof(struct _vk_dev_indirect_constants);
+
+	create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	create_info.pNext = NULL;
+	create_info.flags = 0;
+	create_info.setLayoutCount = 1;
+	create_info.pSetLayouts = &set_layout;
+	create_info.pushConstantRangeCount = 1;
+	create_info.pPushConstantRanges = &push_constants;
+
+	result = indirect->context->vk.CreatePipelineLayout(
+		indirect->context->device, &create_info, NULL,
+		&pass->pipeline_layout);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[INDIRECT] Failed to create pipeline layout.");
+	}
+
+	vk_dev_binding_layout_set_pipeline(pass->binding_layout,
+		VK_PIPELINE_BIND_POINT_COMPUTE, pass->pipeline_layout, 0);
+
+	pass->pipeline = vk_dev_compute_pipeline_create(indirect->context,
+		_variants[variant].path, pass->pipeline_layout);
+}
+
+struct vk_dev_indirect*
+vk_dev_indirect_create(struct vk_dev_context* context,
+	const uint32_t object_capacity, const uint32_t mesh_capacity)
+{
+	struct vk_dev_indirect* indirect;
+	const VkMemoryPropertyFlags host = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_indirect_create");
+
+	if (context->features.multiDrawIndirect == VK_FALSE ||
+		context->features.drawIndirectFirstInstance == VK_FALSE) {
+		vk_dev_fatal_error("[INDIRECT] Multi-draw indirect not supported.");
+	}
+
+	indirect = calloc(1, sizeof(*indirect));
+	if (indirect == NULL) {
+		vk_dev_fatal_error("[INDIRECT] Failed to allocate indirect drawer.");
+	}
+
+	indirect->context = context;
+	indirect->object_capacity = object_capacity;
+
+	vk_dev_buffer_create(context,
+		sizeof(struct vk_dev_indirect_object) * object_capacity,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, host, &indirect->objects);
+	vk_dev_buffer_create(context,
+		sizeof(struct vk_dev_indirect_mesh) * mesh_capacity,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, host, &indirect->meshes);
+	vk_dev_buffer_create(context,
+		sizeof(VkDrawIndexedIndirectCommand) * object_capacity,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+		VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &indirect->draws);
+	vk_dev_buffer_create(context, sizeof(struct vk_dev_indirect_stats),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+		VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT, host, &indirect->stats);
+
+	indirect->bindings.objects.buffer = indirect->objects.buffer;
+	indirect->bindings.objects.offset = 0;
+	indirect->bindings.objects.range = VK_WHOLE_SIZE;
+	indirect->bindings.meshes.buffer = indirect->meshes.buffer;
+	indirect->bindings.meshes.offset = 0;
+	indirect->bindings.meshes.range = VK_WHOLE_SIZE;
+	indirect->bindings.draws.buffer = indirect->draws.buffer;
+	indirect->bindings.draws.offset = 0;
+	indirect->bindings.draws.range = VK_WHOLE_SIZE;
+	indirect->bindings.stats.buffer = indirect->stats.buffer;
+	indirect->bindings.stats.offset = 0;
+	indirect->bindings.stats.range = VK_WHOLE_SIZE;
+
+	for (int i = 0; i < _VK_DEV_INDIRECT_VARIANT_COUNT; i++) {
+		_vk_dev_indirect_pass_create(indirect, i);
+	}
+
+	VK_DEV_TRACE_END("vk_dev_indirect_create");
+
+	return indirect;
+}
+
+void
+vk_dev_indirect_destroy(struct vk_dev_indirect* indirect)
+{
+	struct vk_dev_context* context;
+
+	context = indirect->context;
+
+	for (int i = 0; i < _VK_DEV_INDIRECT_VARIANT_COUNT; i++) {
+		context->vk.DestroyPipeline(context->device,
+			indirect->passes[i].pipeline, NULL);
+		context->vk.DestroyPipelineLayout(context->device,
+			indirect->passes[i].pipeline_layout, NULL);
+		vk_dev_binding_layout_destroy(indirect->passes[i].binding_layout);
+	}
+
+	vk_dev_buffer_destroy(context, &indirect->stats);
+	vk_dev_buffer_destroy(context, &indirect->draws);
+	vk_dev_buffer_destroy(context, &indirect->meshes);
+	vk_dev_buffer_destroy(context, &indirect->objects);
+
+	free(indirect);
+}
+
+struct vk_dev_indirect_object*
+vk_dev_indirect_get_objects(struct vk_dev_indirect* indirect)
+{
+	return indirect->objects.mapped;
+}
+
+struct vk_dev_indirect_mesh*
+vk_dev_indirect_get_meshes(struct vk_dev_indirect* indirect)
+{
+	return indirect->meshes.mapped;
+}
+
+void
+vk_dev_indirect_set_object_count(struct vk_dev_indirect* indirect,
+	const uint32_t object_count)
+{
+	if (object_count > indirect->object_capacity) {
+		vk_dev_fatal_error("[INDIRECT] Object count exceeds capacity.");
+	}
+
+	indirect->object_count = object_count;
+}
+
+VkBuffer
+vk_dev_indirect_get_object_buffer(const struct vk_dev_indirect* indirect)
+{
+	return indirect->objects.buffer;
+}
+
+static void
+_vk_dev_indirect_barrier(const struct vk_dev_indirect* indirect,
+	VkCommandBuffer command_buffer, const VkPipelineStageFlags src_stages,
+	const VkAccessFlags src_access, const VkPipelineStageFlags dst_stages,
+	const VkAccessFlags dst_access)
+{
+	VkMemoryBarrier barrier;
+
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.pNext = NULL;
+	barrier.srcAccessMask = src_access;
+	barrier.dstAccessMask = dst_access;
+
+	indirect->context->vk.CmdPipelineBarrier(command_buffer, src_stages,
+		dst_stages, 0, 1, &barrier, 0, NULL, 0, NULL);
+}
+
+void
+vk_dev_indirect_cull(struct vk_dev_indirect* indirect,
+	VkCommandBuffer command_buffer,
+	struct vk_dev_descriptor_allocator* allocator,
+	const float view_projection[16], const float camera_position[3],
+	const struct vk_dev_hiz* hiz)
+{
+	uint32_t width, height, levels;
+	struct vk_dev_context* context;
+	const struct _vk_dev_indirect_pass* pass;
+	struct _vk_dev_indirect_constants constants;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_indirect_cull");
+
+	context = indirect->context;
+
+	memcpy(constants.view_projection, view_projection,
+		sizeof(constants.view_projection));
+	memcpy(constants.camera_position, camera_position, sizeof(float) * 3);
+	constants.camera_position[3] = 0.0f;
+	constants.object_count = indirect->object_count;
+
+	if (hiz != NULL) {
+		pass = &indirect->passes[_VK_DEV_INDIRECT_OCCLUSION];
+
+		vk_dev_hiz_get_size(hiz, &width, &height, &levels);
+		constants.pyramid_size[0] = width;
+		constants.pyramid_size[1] = height;
+		constants.pyramid_levels = levels;
+
+		indirect->bindings.pyramid.sampler = vk_dev_hiz_get_sampler(hiz);
+		indirect->bindings.pyramid.imageView = vk_dev_hiz_get_view(hiz);
+		indirect->bindings.pyramid.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	} else {
+		pass = &indirect->passes[_VK_DEV_INDIRECT_FRUSTUM];
+
+		constants.pyramid_size[0] = 0.0f;
+		constants.pyramid_size[1] = 0.0f;
+		constants.pyramid_levels = 0;
+	}
+
+	// NOTE: The previous frame's draws must have read the buffers first.
+	_vk_dev_indirect_barrier(indirect, command_buffer,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, 0);
+
+	context->vk.CmdFillBuffer(command_buffer, indirect->stats.buffer, 0,
+		VK_WHOLE_SIZE, 0);
+
+	/*
+	 *	NOTE:	Without VK_KHR_draw_indirect_count every slot up to the object
+	 *			count is drawn, so slots the cull leaves unwritten must be
+	 *			empty draws.
+	 */
+	if (context->extensions.draw_indirect_count == false) {
+		context->vk.CmdFillBuffer(command_buffer, indirect->draws.buffer, 0,
+			VK_WHOLE_SIZE, 0);
+	}
+
+	_vk_dev_indirect_barrier(indirect, command_buffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+	context->vk.CmdBindPipeline(command_buffer,
+		VK_PIPELINE_BIND_POINT_COMPUTE, pass->pipeline);
+	vk_dev_binding_layout_write(pass->binding_layout, command_buffer,
+		allocator, &indirect->bindings);
+	context->vk.CmdPushConstants(command_buffer, pass->pipeline_layout,
+		VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+	context->vk.CmdDispatch(command_buffer,
+		(indirect->object_count + VK_DEV_INDIRECT_GROUP_SIZE - 1) /
+		VK_DEV_INDIRECT_GROUP_SIZE, 1, 1);
+
+	_vk_dev_indirect_barrier(indirect, command_buffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+		VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT);
+
+	VK_DEV_TRACE_END("vk_dev_indirect_cull");
+}
+
+void
+vk_dev_indirect_draw(const struct vk_dev_indirect* indirect,
+	VkCommandBuffer command_buffer)
+{
+	if (indirect->context->extensions.draw_indirect_count) {
+		indirect->context->vk.CmdDrawIndexedIndirectCountKHR(command_buffer,
+			indirect->draws.buffer, 0, indirect->stats.buffer,
+			offsetof(struct vk_dev_indirect_stats, draw_count),
+			indirect->object_count, sizeof(VkDrawIndexedIndirectCommand));
+	} else {
+		indirect->context->vk.CmdDrawIndexedIndirect(command_buffer,
+			indirect->draws.buffer, 0, indirect->object_count,
+			sizeof(VkDrawIndexedIndirectCommand));
+	}
+}
+
+void
+vk_dev_indirect_get_stats(const struct vk_dev_indirect* indirect,
+	struct vk_dev_indirect_stats* stats)
+{
+	*stats = *(const struct vk_dev_indirect_stats*)indirect->stats.mapped;
+}
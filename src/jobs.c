@@ -0,0 +1,182 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <vulkan-dev/jobs.h>
+#include <vulkan-dev/vulkan-dev.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+
+struct vk_dev_jobs {
+	pthread_t* threads;
+	uint32_t thread_count;
+
+	pthread_mutex_t lock;
+	pthread_cond_t start;
+	pthread_cond_t done;
+	uint64_t generation;
+	uint32_t active;
+	bool quit;
+
+	vk_dev_job_fn fn;
+	void* arg;
+	uint32_t count;
+	uint32_t next;
+};
+
+/*
+ *	NOTE:	Indices are claimed one at a time from a shared counter, so a
+ *			batch of unevenly sized jobs still balances across threads.
+ */
+static void
+_vk_dev_jobs_work(struct vk_dev_jobs* jobs, vk_dev_job_fn fn, void* arg,
+	const uint32_t count)
+{
+	uint32_t index;
+
+	for (;;) {
+		index = __atomic_fetch_add(&jobs->next, 1, __ATOMIC_RELAXED);
+		if (index >= count) {
+			break;
+		}
+
+		fn(arg, index);
+	}
+}
+
+static void*
+_vk_dev_jobs_thread(void* arg)
+{
+	uint64_t seen;
+	void* job_arg;
+	uint32_t count;
+	vk_dev_job_fn fn;
+	struct vk_dev_jobs* jobs;
+
+	jobs = arg;
+	seen = 0;
+
+	for (;;) {
+		pthread_mutex_lock(&jobs->lock);
+		while (jobs->generation == seen && jobs->quit == false) {
+			pthread_cond_wait(&jobs->start, &jobs->lock);
+		}
+
+		if (jobs->quit) {
+			pthread_mutex_unlock(&jobs->lock);
+			break;
+		}
+
+		seen = jobs->generation;
+		fn = jobs->fn;
+		job_arg = jobs->arg;
+		count = jobs->count;
+		pthread_mutex_unlock(&jobs->lock);
+
+		_vk_dev_jobs_work(jobs, fn, job_arg, count);
+
+		pthread_mutex_lock(&jobs->lock);
+		if (--jobs->active == 0) {
+			pthread_cond_signal(&jobs->done);
+		}
+		pthread_mutex_unlock(&jobs->lock);
+	}
+
+	return NULL;
+}
+
+struct vk_dev_jobs*
+vk_dev_jobs_create(uint32_t thread_count)
+{
+	long cpus;
+	struct vk_dev_jobs* jobs;
+
+	if (thread_count == 0) {
+		cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		thread_count = cpus > 0 ? cpus : 1;
+	}
+
+	jobs = calloc(1, sizeof(*jobs));
+	if (jobs == NULL) {
+		vk_dev_fatal_error("[JOBS] Failed to allocate job pool.");
+	}
+
+	// NOTE: The calling thread is the remaining worker.
+	jobs->thread_count = thread_count - 1;
+	jobs->threads = malloc(sizeof(*jobs->threads) * thread_count);
+	if (jobs->threads == NULL) {
+		vk_dev_fatal_error("[JOBS] Failed to allocate worker threads.");
+	}
+
+	pthread_mutex_init(&jobs->lock, NULL);
+	pthread_cond_init(&jobs->start, NULL);
+	pthread_cond_init(&jobs->done, NULL);
+
+	for (uint32_t i = 0; i < jobs->thread_count; i++) {
+		if (pthread_create(&jobs->threads[i], NULL, _vk_dev_jobs_thread,
+			jobs) != 0) {
+			vk_dev_fatal_error("[JOBS] Failed to start worker thread.");
+		}
+	}
+
+	return jobs;
+}
+
+void
+vk_dev_jobs_destroy(struct vk_dev_jobs* jobs)
+{
+	pthread_mutex_lock(&jobs->lock);
+	jobs->quit = true;
+	pthread_cond_broadcast(&jobs->start);
+	pthread_mutex_unlock(&jobs->lock);
+
+	for (uint32_t i = 0; i < jobs->thread_count; i++) {
+		pthread_join(jobs->threads[i], NULL);
+	}
+
+	pthread_cond_destroy(&jobs->done);
+	pthread_cond_destroy(&jobs->start);
+	pthread_mutex_destroy(&jobs->lock);
+
+	free(jobs->threads);
+	free(jobs);
+}
+
+uint32_t
+vk_dev_jobs_get_thread_count(const struct vk_dev_jobs* jobs)
+{
+	return jobs->thread_count + 1;
+}
+
+void
+vk_dev_jobs_run(struct vk_dev_jobs* jobs, const uint32_t count,
+	vk_dev_job_fn fn, void* arg)
+{
+	// NOTE: Not worth waking the workers for a single job.
+	if (count <= 1 || jobs->thread_count == 0) {
+		for (uint32_t i = 0; i < count; i++) {
+			fn(arg, i);
+		}
+		return;
+	}
+
+	pthread_mutex_lock(&jobs->lock);
+	jobs->fn = fn;
+	jobs->arg = arg;
+	jobs->count = count;
+	jobs->next = 0;
+	jobs->active = jobs->thread_count;
+	jobs->generation++;
+	pthread_cond_broadcast(&jobs->start);
+	pthread_mutex_unlock(&jobs->lock);
+
+	_vk_dev_jobs_work(jobs, fn, arg, count);
+
+	pthread_mutex_lock(&jobs->lock);
+	while (jobs->active > 0) {
+		pthread_cond_wait(&jobs->done, &jobs->lock);
+	}
+	pthread_mutex_unlock(&jobs->lock);
+}
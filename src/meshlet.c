@@ -0,0 +1,547 @@
+#include <vulkan-dev/meshlet.h>
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/trace.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+/*
+ *	NOTE:	Triangles per parallel build job. Meshlets never straddle a run,
+ *			which costs a partial meshlet every 64k triangles in exchange for
+ *			output that is identical on any number of threads.
+ */
+#define VK_DEV_MESHLET_RUN_TRIANGLES (1u << 16)
+
+// NOTE: Bump whenever the build or file layout changes to invalidate caches.
+#define VK_DEV_MESHLET_CACHE_VERSION 1
+
+#define VK_DEV_MESHLET_SLOTS 128
+#define VK_DEV_MESHLET_EMPTY UINT32_MAX
+
+struct _vk_dev_meshlet_cache_header {
+	char magic[4];
+	uint32_t version;
+	uint64_t key;
+	uint32_t meshlet_count;
+	uint32_t vertex_count;
+	uint32_t triangle_count;
+	uint32_t padding;
+};
+
+struct _vk_dev_meshlet_build {
+	const uint32_t* indices;
+	uint32_t triangle_count;
+	const float* positions;
+	size_t position_stride;
+	uint32_t vertex_count;
+
+	struct vk_dev_meshlet_mesh* runs;
+};
+
+/*
+ *	NOTE:	Maps source vertices to meshlet-local indices for the meshlet
+ *			being filled. Meshlets hold at most 64 vertices, so a 128 slot
+ *			open-addressed table never gets more than half full.
+ */
+struct _vk_dev_meshlet_table {
+	uint32_t keys[VK_DEV_MESHLET_SLOTS];
+	uint8_t values[VK_DEV_MESHLET_SLOTS];
+};
+
+static const float*
+_vk_dev_meshlet_position(const struct _vk_dev_meshlet_build* build,
+	const uint32_t vertex)
+{
+	return (const float*)((const char*)build->positions +
+		vertex * build->position_stride);
+}
+
+static uint32_t*
+_vk_dev_meshlet_table_slot(struct _vk_dev_meshlet_table* table,
+	const uint32_t vertex)
+{
+	uint32_t slot;
+
+	slot = (vertex * 2654435761u) >> 25;
+	while (table->keys[slot] != VK_DEV_MESHLET_EMPTY &&
+		table->keys[slot] != vertex) {
+		slot = (slot + 1) & (VK_DEV_MESHLET_SLOTS - 1);
+	}
+
+	return &table->keys[slot];
+}
+
+static bool
+_vk_dev_meshlet_table_contains(struct _vk_dev_meshlet_table* table,
+	const uint32_t vertex)
+{
+	return *_vk_dev_meshlet_table_slot(table, vertex) == vertex;
+}
+
+static void
+_vk_dev_meshlet_bounds(const struct _vk_dev_meshlet_build* build,
+	const struct vk_dev_meshlet_mesh* run, struct vk_dev_meshlet* meshlet)
+{
+	float low[3], high[3], axis[3], normals[VK_DEV_MESHLET_MAX_TRIANGLES][3];
+	float e1[3], e2[3];
+	float length, distance, min_dot;
+	float* n;
+	const float* p[3];
+	const uint32_t* vertices;
+	const uint8_t* triangles;
+	uint32_t normal_count;
+
+	vertices = &run->vertices[meshlet->vertex_offset];
+	triangles = &run->triangles[meshlet->triangle_offset * 3];
+
+	for (int i = 0; i < 3; i++) {
+		low[i] = INFINITY;
+		high[i] = -INFINITY;
+	}
+
+	for (uint32_t i = 0; i < meshlet->vertex_count; i++) {
+		p[0] = _vk_dev_meshlet_position(build, vertices[i]);
+		for (int j = 0; j < 3; j++) {
+			low[j] = fminf(low[j], p[0][j]);
+			high[j] = fmaxf(high[j], p[0][j]);
+		}
+	}
+
+	meshlet->radius = 0.0f;
+	for (int i = 0; i < 3; i++) {
+		meshlet->center[i] = (low[i] + high[i]) * 0.5f;
+	}
+
+	for (uint32_t i = 0; i < meshlet->vertex_count; i++) {
+		p[0] = _vk_dev_meshlet_position(build, vertices[i]);
+		distance = sqrtf(
+			(p[0][0] - meshlet->center[0]) * (p[0][0] - meshlet->center[0]) +
+			(p[0][1] - meshlet->center[1]) * (p[0][1] - meshlet->center[1]) +
+			(p[0][2] - meshlet->center[2]) * (p[0][2] - meshlet->center[2]));
+		meshlet->radius = fmaxf(meshlet->radius, distance);
+	}
+
+	axis[0] = axis[1] = axis[2] = 0.0f;
+	normal_count = 0;
+
+	for (uint32_t i = 0; i < meshlet->triangle_count; i++) {
+		for (int j = 0; j < 3; j++) {
+			p[j] = _vk_dev_meshlet_position(build,
+				vertices[triangles[i * 3 + j]]);
+		}
+
+		for (int j = 0; j < 3; j++) {
+			e1[j] = p[1][j] - p[0][j];
+			e2[j] = p[2][j] - p[0][j];
+		}
+
+		n = normals[normal_count];
+		n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+
+		length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (length == 0.0f) {
+			continue;
+		}
+
+		for (int j = 0; j < 3; j++) {
+			n[j] /= length;
+			axis[j] += n[j];
+		}
+
+		normal_count++;
+	}
+
+	length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+	min_dot = 1.0f;
+
+	if (length > 0.0f) {
+		for (int j = 0; j < 3; j++) {
+			axis[j] /= length;
+		}
+
+		for (uint32_t i = 0; i < normal_count; i++) {
+			min_dot = fminf(min_dot, normals[i][0] * axis[0] +
+				normals[i][1] * axis[1] + normals[i][2] * axis[2]);
+		}
+	}
+
+	memcpy(meshlet->cone_axis, axis, sizeof(axis));
+
+	// NOTE: Cones wider than ~84 degrees would almost never cull anything.
+	meshlet->cone_cutoff = length > 0.0f && min_dot > 0.1f ?
+		sqrtf(1.0f - min_dot * min_dot) : 1.0f;
+}
+
+static void
+_vk_dev_meshlet_finish(const struct _vk_dev_meshlet_build* build,
+	struct vk_dev_meshlet_mesh* run, struct vk_dev_meshlet* meshlet,
+	struct _vk_dev_meshlet_table* table)
+{
+	if (meshlet->triangle_count > 0) {
+		_vk_dev_meshlet_bounds(build, run, meshlet);
+		run->meshlets[run->meshlet_count++] = *meshlet;
+	}
+
+	meshlet->vertex_offset = run->vertex_count;
+	meshlet->triangle_offset = run->triangle_count;
+	meshlet->vertex_count = 0;
+	meshlet->triangle_count = 0;
+
+	memset(table->keys, 0xff, sizeof(table->keys));
+}
+
+static void
+_vk_dev_meshlet_build_run(void* arg, const uint32_t index)
+{
+	uint32_t first, count, fresh, v[3];
+	uint32_t* slot;
+	struct vk_dev_meshlet meshlet;
+	struct vk_dev_meshlet_mesh* run;
+	struct _vk_dev_meshlet_table table;
+	const struct _vk_dev_meshlet_build* build;
+
+	build = arg;
+	run = &build->runs[index];
+
+	first = index * VK_DEV_MESHLET_RUN_TRIANGLES;
+	count = build->triangle_count - first;
+	if (count > VK_DEV_MESHLET_RUN_TRIANGLES) {
+		count = VK_DEV_MESHLET_RUN_TRIANGLES;
+	}
+
+	run->meshlets = malloc(sizeof(*run->meshlets) * count);
+	run->vertices = malloc(sizeof(*run->vertices) * count * 3);
+	run->triangles = malloc(sizeof(*run->triangles) * count * 3);
+	if (run->meshlets == NULL || run->vertices == NULL ||
+		run->triangles == NULL) {
+		vk_dev_fatal_error("[MESHLET] Failed to allocate meshlet run.");
+	}
+
+	run->meshlet_count = 0;
+	run->vertex_count = 0;
+	run->triangle_count = 0;
+
+	memset(&meshlet, 0, sizeof(meshlet));
+	memset(table.keys, 0xff, sizeof(table.keys));
+
+	for (uint32_t i = first; i < first + count; i++) {
+		v[0] = build->indices[i * 3 + 0];
+		v[1] = build->indices[i * 3 + 1];
+		v[2] = build->indices[i * 3 + 2];
+
+		if (v[0] >= build->vertex_count || v[1] >= build->vertex_count ||
+			v[2] >= build->vertex_count) {
+			vk_dev_fatal_error("[MESHLET] Index out of range.");
+		}
+
+		fresh = !_vk_dev_meshlet_table_contains(&table, v[0]) +
+			(v[1] != v[0] && !_vk_dev_meshlet_table_contains(&table, v[1])) +
+			(v[2] != v[0] && v[2] != v[1] &&
+			!_vk_dev_meshlet_table_contains(&table, v[2]));
+
+		if (meshlet.vertex_count + fresh > VK_DEV_MESHLET_MAX_VERTICES ||
+			meshlet.triangle_count == VK_DEV_MESHLET_MAX_TRIANGLES) {
+			_vk_dev_meshlet_finish(build, run, &meshlet, &table);
+		}
+
+		for (int j = 0; j < 3; j++) {
+			slot = _vk_dev_meshlet_table_slot(&table, v[j]);
+			if (*slot == VK_DEV_MESHLET_EMPTY) {
+				*slot = v[j];
+				table.values[slot - table.keys] = meshlet.vertex_count++;
+				run->vertices[run->vertex_count++] = v[j];
+			}
+
+			run->triangles[run->triangle_count * 3 + j] =
+				table.values[slot - table.keys];
+		}
+
+		run->triangle_count++;
+		meshlet.triangle_count++;
+	}
+
+	_vk_dev_meshlet_finish(build, run, &meshlet, &table);
+}
+
+void
+vk_dev_meshlet_build(struct vk_dev_jobs* jobs, const uint32_t* indices,
+	const uint32_t index_count, const float* positions,
+	const size_t position_stride, const uint32_t vertex_count,
+	struct vk_dev_meshlet_mesh* mesh)
+{
+	uint32_t run_count, meshlet_base, vertex_base, triangle_base;
+	struct vk_dev_meshlet_mesh* run;
+	struct _vk_dev_meshlet_build build;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_meshlet_build");
+
+	build.indices = indices;
+	build.triangle_count = index_count / 3;
+	build.positions = positions;
+	build.position_stride = position_stride;
+	build.vertex_count = vertex_count;
+
+	run_count = (build.triangle_count + VK_DEV_MESHLET_RUN_TRIANGLES - 1) /
+		VK_DEV_MESHLET_RUN_TRIANGLES;
+	build.runs = calloc(run_count > 0 ? run_count : 1, sizeof(*build.runs));
+	if (build.runs == NULL) {
+		vk_dev_fatal_error("[MESHLET] Failed to allocate meshlet runs.");
+	}
+
+	if (jobs != NULL) {
+		vk_dev_jobs_run(jobs, run_count, _vk_dev_meshlet_build_run, &build);
+	} else {
+		for (uint32_t i = 0; i < run_count; i++) {
+			_vk_dev_meshlet_build_run(&build, i);
+		}
+	}
+
+	memset(mesh, 0, sizeof(*mesh));
+	for (uint32_t i = 0; i < run_count; i++) {
+		mesh->meshlet_count += build.runs[i].meshlet_count;
+		mesh->vertex_count += build.runs[i].vertex_count;
+		mesh->triangle_count += build.runs[i].triangle_count;
+	}
+
+	mesh->meshlets = malloc(sizeof(*mesh->meshlets) * mesh->meshlet_count + 1);
+	mesh->vertices = malloc(sizeof(*mesh->vertices) * mesh->vertex_count + 1);
+	mesh->triangles = malloc(mesh->triangle_count * 3 + 1);
+	if (mesh->meshlets == NULL || mesh->vertices == NULL ||
+		mesh->triangles == NULL) {
+		vk_dev_fatal_error("[MESHLET] Failed to allocate meshlets.");
+	}
+
+	meshlet_base = vertex_base = triangle_base = 0;
+	for (uint32_t i = 0; i < run_count; i++) {
+		run = &build.runs[i];
+
+		for (uint32_t j = 0; j < run->meshlet_count; j++) {
+			mesh->meshlets[meshlet_base + j] = run->meshlets[j];
+			mesh->meshlets[meshlet_base + j].vertex_offset += vertex_base;
+			mesh->meshlets[meshlet_base + j].triangle_offset += triangle_base;
+		}
+
+		memcpy(&mesh->vertices[vertex_base], run->vertices,
+			sizeof(*run->vertices) * run->vertex_count);
+		memcpy(&mesh->triangles[triangle_base * 3], run->triangles,
+			run->triangle_count * 3);
+
+		meshlet_base += run->meshlet_count;
+		vertex_base += run->vertex_count;
+		triangle_base += run->triangle_count;
+
+		vk_dev_meshlet_mesh_free(run);
+	}
+
+	free(build.runs);
+
+	VK_DEV_TRACE_END("vk_dev_meshlet_build");
+}
+
+void
+vk_dev_meshlet_mesh_free(struct vk_dev_meshlet_mesh* mesh)
+{
+	free(mesh->meshlets);
+	free(mesh->vertices);
+	free(mesh->triangles);
+
+	memset(mesh, 0, sizeof(*mesh));
+}
+
+static uint64_t
+_vk_dev_meshlet_hash(uint64_t hash, const void* data, const size_t size)
+{
+	const uint8_t* bytes;
+
+	bytes = data;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+uint64_t
+vk_dev_meshlet_key(const uint32_t* indices, const uint32_t index_count,
+	const float* positions, const size_t position_stride,
+	const uint32_t vertex_count)
+{
+	uint64_t hash;
+	const uint32_t parameters[] = {
+		VK_DEV_MESHLET_CACHE_VERSION,
+		VK_DEV_MESHLET_MAX_VERTICES,
+		VK_DEV_MESHLET_MAX_TRIANGLES,
+		VK_DEV_MESHLET_RUN_TRIANGLES,
+		index_count,
+		vertex_count,
+	};
+
+	hash = _vk_dev_meshlet_hash(0xcbf29ce484222325ull, parameters,
+		sizeof(parameters));
+	hash = _vk_dev_meshlet_hash(hash, indices, sizeof(*indices) * index_count);
+
+	for (uint32_t i = 0; i < vertex_count; i++) {
+		hash = _vk_dev_meshlet_hash(hash, (const char*)positions +
+			i * position_stride, sizeof(float) * 3);
+	}
+
+	return hash;
+}
+
+bool
+vk_dev_meshlet_cache_load(const char* path, const uint64_t key,
+	struct vk_dev_meshlet_mesh* mesh)
+{
+	FILE* file;
+	bool loaded;
+	struct _vk_dev_meshlet_cache_header header;
+
+	file = fopen(path, "rb");
+	if (file == NULL) {
+		return false;
+	}
+
+	if (fread(&header, sizeof(header), 1, file) != 1 ||
+		memcmp(header.magic, "VKML", 4) != 0 ||
+		header.version != VK_DEV_MESHLET_CACHE_VERSION || header.key != key) {
+		fclose(file);
+		return false;
+	}
+
+	mesh->meshlet_count = header.meshlet_count;
+	mesh->vertex_count = header.vertex_count;
+	mesh->triangle_count = header.triangle_count;
+	mesh->meshlets = malloc(sizeof(*mesh->meshlets) * mesh->meshlet_count + 1);
+	mesh->vertices = malloc(sizeof(*mesh->vertices) * mesh->vertex_count + 1);
+	mesh->triangles = malloc(mesh->triangle_count * 3 + 1);
+	if (mesh->meshlets == NULL || mesh->vertices == NULL ||
+		mesh->triangles == NULL) {
+		vk_dev_fatal_error("[MESHLET] Failed to allocate meshlets.");
+	}
+
+	loaded = fread(mesh->meshlets, sizeof(*mesh->meshlets),
+		mesh->meshlet_count, file) == mesh->meshlet_count &&
+		fread(mesh->vertices, sizeof(*mesh->vertices), mesh->vertex_count,
+		file) == mesh->vertex_count &&
+		fread(mesh->triangles, 3, mesh->triangle_count, file) ==
+		mesh->triangle_count;
+
+	fclose(file);
+
+	if (loaded == false) {
+		vk_dev_meshlet_mesh_free(mesh);
+	}
+
+	return loaded;
+}
+
+bool
+vk_dev_meshlet_cache_save(const char* path, const uint64_t key,
+	const struct vk_dev_meshlet_mesh* mesh)
+{
+	FILE* file;
+	bool saved;
+	struct _vk_dev_meshlet_cache_header header;
+
+	file = fopen(path, "wb");
+	if (file == NULL) {
+		return false;
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "VKML", 4);
+	header.version = VK_DEV_MESHLET_CACHE_VERSION;
+	header.key = key;
+	header.meshlet_count = mesh->meshlet_count;
+	header.vertex_count = mesh->vertex_count;
+	header.triangle_count = mesh->triangle_count;
+
+	saved = fwrite(&header, sizeof(header), 1, file) == 1 &&
+		fwrite(mesh->meshlets, sizeof(*mesh->meshlets), mesh->meshlet_count,
+		file) == mesh->meshlet_count &&
+		fwrite(mesh->vertices, sizeof(*mesh->vertices), mesh->vertex_count,
+		file) == mesh->vertex_count &&
+		fwrite(mesh->triangles, 3, mesh->triangle_count, file) ==
+		mesh->triangle_count;
+
+	return fclose(file) == 0 && saved;
+}
+
+void
+vk_dev_meshlet_build_cached(struct vk_dev_jobs* jobs, const char* path,
+	const uint32_t* indices, const uint32_t index_count,
+	const float* positions, const size_t position_stride,
+	const uint32_t vertex_count, struct vk_dev_meshlet_mesh* mesh)
+{
+	uint64_t key;
+
+	key = vk_dev_meshlet_key(indices, index_count, positions, position_stride,
+		vertex_count);
+
+	if (vk_dev_meshlet_cache_load(path, key, mesh)) {
+		VK_DEV_TRACE_INSTANT("vk_dev_meshlet_cache_hit");
+		return;
+	}
+
+	vk_dev_meshlet_build(jobs, indices, index_count, positions,
+		position_stride, vertex_count, mesh);
+
+	// NOTE: A cache that cannot be written only costs a rebuild next time.
+	vk_dev_meshlet_cache_save(path, key, mesh);
+}
+
+void
+vk_dev_meshlet_get_indices(const struct vk_dev_meshlet_mesh* mesh,
+	uint32_t* indices)
+{
+	const struct vk_dev_meshlet* meshlet;
+
+	for (uint32_t i = 0; i < mesh->meshlet_count; i++) {
+		meshlet = &mesh->meshlets[i];
+
+		for (uint32_t j = 0; j < meshlet->triangle_count * 3; j++) {
+			indices[meshlet->triangle_offset * 3 + j] =
+				mesh->vertices[meshlet->vertex_offset +
+				mesh->triangles[meshlet->triangle_offset * 3 + j]];
+		}
+	}
+}
+
+static uint32_t
+_vk_dev_meshlet_snorm8(const float value)
+{
+	float scaled;
+
+	scaled = roundf(value * 127.0f);
+	scaled = fminf(fmaxf(scaled, -127.0f), 127.0f);
+
+	return (uint8_t)(int8_t)scaled;
+}
+
+uint32_t
+vk_dev_meshlet_pack_cone(const struct vk_dev_meshlet* meshlet)
+{
+	float cutoff;
+
+	/*
+	 *	NOTE:	Rounding the axis moves it by at most sqrt(3)/254, so raising
+	 *			the cutoff by one extra step keeps every culled cluster truly
+	 *			back facing.
+	 */
+	cutoff = ceilf(meshlet->cone_cutoff * 127.0f) + 1.0f;
+	if (meshlet->cone_cutoff >= 1.0f || cutoff >= 127.0f) {
+		return 0;
+	}
+
+	return _vk_dev_meshlet_snorm8(meshlet->cone_axis[0]) |
+		_vk_dev_meshlet_snorm8(meshlet->cone_axis[1]) << 8 |
+		_vk_dev_meshlet_snorm8(meshlet->cone_axis[2]) << 16 |
+		(uint32_t)cutoff << 24;
+}
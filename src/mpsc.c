@@ -0,0 +1,70 @@
+#include <vulkan-dev/mpsc.h>
+
+#include <stddef.h>
+
+void
+vk_dev_mpsc_init(struct vk_dev_mpsc* queue)
+{
+	queue->stub.next = NULL;
+	queue->head = &queue->stub;
+	queue->tail = &queue->stub;
+}
+
+/*
+ *	NOTE:	The exchange orders producers; the release store publishes the
+ *			node's contents to the consumer along with the link.
+ */
+void
+vk_dev_mpsc_push(struct vk_dev_mpsc* queue, struct vk_dev_mpsc_node* node)
+{
+	struct vk_dev_mpsc_node* previous;
+
+	__atomic_store_n(&node->next, NULL, __ATOMIC_RELAXED);
+	previous = __atomic_exchange_n(&queue->head, node, __ATOMIC_ACQ_REL);
+	__atomic_store_n(&previous->next, node, __ATOMIC_RELEASE);
+}
+
+/*
+ *	NOTE:	The stub keeps the queue from ever being empty of nodes, so the
+ *			last real node can be handed out: once it is alone, the stub is
+ *			pushed behind it.
+ */
+struct vk_dev_mpsc_node*
+vk_dev_mpsc_pop(struct vk_dev_mpsc* queue)
+{
+	struct vk_dev_mpsc_node *tail, *next, *head;
+
+	tail = queue->tail;
+	next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+
+	if (tail == &queue->stub) {
+		if (next == NULL) {
+			return NULL;
+		}
+
+		queue->tail = next;
+		tail = next;
+		next = __atomic_load_n(&next->next, __ATOMIC_ACQUIRE);
+	}
+
+	if (next != NULL) {
+		queue->tail = next;
+		return tail;
+	}
+
+	// NOTE: A producer is between its exchange and its link.
+	head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+	if (tail != head) {
+		return NULL;
+	}
+
+	vk_dev_mpsc_push(queue, &queue->stub);
+
+	next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+	if (next != NULL) {
+		queue->tail = next;
+		return tail;
+	}
+
+	return NULL;
+}
@@ -0,0 +1,482 @@
+#include <vulkan-dev/optimize.h>
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/trace.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#define VK_DEV_OPTIMIZE_NONE UINT32_MAX
+
+/*
+ *	NOTE:	Vertex to triangle adjacency in compressed rows: the triangles
+ *			using vertex v are triangles[offsets[v]] up to offsets[v + 1].
+ */
+struct _vk_dev_optimize_adjacency {
+	uint32_t* offsets;
+	uint32_t* triangles;
+};
+
+struct _vk_dev_optimize_cluster {
+	float key;
+	uint32_t first;
+	uint32_t count;
+};
+
+static void*
+_vk_dev_optimize_alloc(const size_t size)
+{
+	void* memory;
+
+	memory = malloc(size > 0 ? size : 1);
+	if (memory == NULL) {
+		vk_dev_fatal_error("[OPTIMIZE] Failed to allocate scratch memory.");
+	}
+
+	return memory;
+}
+
+/*
+ *	NOTE:	Every pass indexes per-vertex scratch with indices and walks them
+ *			a triangle at a time.
+ */
+static void
+_vk_dev_optimize_check_indices(const uint32_t* indices,
+	const uint32_t index_count, const uint32_t vertex_count)
+{
+	if (index_count % 3 != 0) {
+		vk_dev_fatal_error("[OPTIMIZE] Index count is not a multiple of 3.");
+	}
+
+	for (uint32_t i = 0; i < index_count; i++) {
+		if (indices[i] >= vertex_count) {
+			vk_dev_fatal_error("[OPTIMIZE] Index out of range.");
+		}
+	}
+}
+
+static void
+_vk_dev_optimize_adjacency_build(struct _vk_dev_optimize_adjacency* adjacency,
+	const uint32_t* indices, const uint32_t index_count,
+	const uint32_t vertex_count, uint32_t* live)
+{
+	adjacency->offsets = _vk_dev_optimize_alloc(sizeof(uint32_t) *
+		(vertex_count + 1));
+	adjacency->triangles = _vk_dev_optimize_alloc(sizeof(uint32_t) *
+		index_count);
+
+	memset(live, 0, sizeof(*live) * vertex_count);
+	for (uint32_t i = 0; i < index_count; i++) {
+		live[indices[i]]++;
+	}
+
+	adjacency->offsets[0] = 0;
+	for (uint32_t i = 0; i < vertex_count; i++) {
+		adjacency->offsets[i + 1] = adjacency->offsets[i] + live[i];
+	}
+
+	// NOTE: live doubles as the fill cursor, then is restored.
+	memset(live, 0, sizeof(*live) * vertex_count);
+	for (uint32_t i = 0; i < index_count; i++) {
+		adjacency->triangles[adjacency->offsets[indices[i]] +
+			live[indices[i]]++] = i / 3;
+	}
+}
+
+static void
+_vk_dev_optimize_adjacency_free(struct _vk_dev_optimize_adjacency* adjacency)
+{
+	free(adjacency->offsets);
+	free(adjacency->triangles);
+}
+
+void
+vk_dev_optimize_analyze_vertex_cache(const uint32_t* indices,
+	const uint32_t index_count, const uint32_t vertex_count,
+	const uint32_t cache_size, struct vk_dev_vertex_cache_stats* stats)
+{
+	uint32_t time, used;
+	uint32_t* timestamps;
+
+	_vk_dev_optimize_check_indices(indices, index_count, vertex_count);
+
+	/*
+	 *	NOTE:	A FIFO cache modelled with insertion times: a vertex is still
+	 *			cached while fewer than cache_size vertices were inserted
+	 *			after it.
+	 */
+	timestamps = _vk_dev_optimize_alloc(sizeof(*timestamps) * vertex_count);
+	memset(timestamps, 0, sizeof(*timestamps) * vertex_count);
+
+	time = cache_size + 1;
+	used = 0;
+	stats->vertices_transformed = 0;
+
+	for (uint32_t i = 0; i < index_count; i++) {
+		if (timestamps[indices[i]] == 0) {
+			used++;
+		}
+
+		if (time - timestamps[indices[i]] > cache_size) {
+			timestamps[indices[i]] = time++;
+			stats->vertices_transformed++;
+		}
+	}
+
+	stats->acmr = index_count >= 3 ?
+		(float)stats->vertices_transformed / (index_count / 3) : 0.0f;
+	stats->atvr = used > 0 ? (float)stats->vertices_transformed / used : 0.0f;
+
+	free(timestamps);
+}
+
+/*
+ *	NOTE:	Tipsify's dead-end recovery: the most recently emitted vertex
+ *			that still has triangles left, or failing that the next such
+ *			vertex in input order.
+ */
+static uint32_t
+_vk_dev_optimize_skip_dead_end(const uint32_t* live, uint32_t* dead_end,
+	uint32_t* dead_end_count, uint32_t* cursor, const uint32_t vertex_count)
+{
+	uint32_t vertex;
+
+	while (*dead_end_count > 0) {
+		vertex = dead_end[--*dead_end_count];
+		if (live[vertex] > 0) {
+			return vertex;
+		}
+	}
+
+	while (*cursor < vertex_count) {
+		if (live[*cursor] > 0) {
+			return *cursor;
+		}
+
+		++*cursor;
+	}
+
+	return VK_DEV_OPTIMIZE_NONE;
+}
+
+void
+vk_dev_optimize_vertex_cache(uint32_t* destination, const uint32_t* indices,
+	const uint32_t index_count, const uint32_t vertex_count)
+{
+	uint32_t fan, time, cursor, output, dead_end_count, candidate_count;
+	uint32_t best, best_priority, priority, triangle, vertex;
+	uint32_t* live,* timestamps,* dead_end,* candidates,* source;
+	bool* emitted;
+	struct _vk_dev_optimize_adjacency adjacency;
+	const uint32_t cache_size = VK_DEV_OPTIMIZE_CACHE_SIZE;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_optimize_vertex_cache");
+
+	_vk_dev_optimize_check_indices(indices, index_count, vertex_count);
+
+	// NOTE: Keep a copy so destination may alias indices.
+	source = _vk_dev_optimize_alloc(sizeof(*source) * index_count);
+	memcpy(source, indices, sizeof(*source) * index_count);
+
+	live = _vk_dev_optimize_alloc(sizeof(*live) * vertex_count);
+	timestamps = _vk_dev_optimize_alloc(sizeof(*timestamps) * vertex_count);
+	dead_end = _vk_dev_optimize_alloc(sizeof(*dead_end) * index_count);
+	candidates = _vk_dev_optimize_alloc(sizeof(*candidates) * index_count);
+	emitted = _vk_dev_optimize_alloc(sizeof(*emitted) * (index_count / 3));
+
+	_vk_dev_optimize_adjacency_build(&adjacency, source, index_count,
+		vertex_count, live);
+	memset(timestamps, 0, sizeof(*timestamps) * vertex_count);
+	memset(emitted, 0, sizeof(*emitted) * (index_count / 3));
+
+	time = cache_size + 1;
+	cursor = 0;
+	output = 0;
+	dead_end_count = 0;
+
+	fan = _vk_dev_optimize_skip_dead_end(live, dead_end, &dead_end_count,
+		&cursor, vertex_count);
+
+	while (fan != VK_DEV_OPTIMIZE_NONE) {
+		candidate_count = 0;
+
+		// NOTE: Emit every remaining triangle around the fanning vertex.
+		for (uint32_t i = adjacency.offsets[fan];
+			i < adjacency.offsets[fan + 1]; i++) {
+			triangle = adjacency.triangles[i];
+			if (emitted[triangle]) {
+				continue;
+			}
+
+			for (int j = 0; j < 3; j++) {
+				vertex = source[triangle * 3 + j];
+
+				destination[output++] = vertex;
+				dead_end[dead_end_count++] = vertex;
+				candidates[candidate_count++] = vertex;
+				live[vertex]--;
+
+				if (time - timestamps[vertex] > cache_size) {
+					timestamps[vertex] = time++;
+				}
+			}
+
+			emitted[triangle] = true;
+		}
+
+		/*
+		 *	NOTE:	Next fan: the candidate that stays in cache longest while
+		 *			its remaining triangles are emitted. Candidates that would
+		 *			fall out of cache are left to the dead-end stack.
+		 */
+		best = VK_DEV_OPTIMIZE_NONE;
+		best_priority = 0;
+
+		for (uint32_t i = 0; i < candidate_count; i++) {
+			vertex = candidates[i];
+			if (live[vertex] == 0) {
+				continue;
+			}
+
+			priority = 0;
+			if (time - timestamps[vertex] + 2 * live[vertex] <= cache_size) {
+				priority = time - timestamps[vertex] + 1;
+			}
+
+			if (priority > best_priority) {
+				best_priority = priority;
+				best = vertex;
+			}
+		}
+
+		if (best == VK_DEV_OPTIMIZE_NONE) {
+			best = _vk_dev_optimize_skip_dead_end(live, dead_end,
+				&dead_end_count, &cursor, vertex_count);
+		}
+
+		fan = best;
+	}
+
+	_vk_dev_optimize_adjacency_free(&adjacency);
+
+	free(emitted);
+	free(candidates);
+	free(dead_end);
+	free(timestamps);
+	free(live);
+	free(source);
+
+	VK_DEV_TRACE_END("vk_dev_optimize_vertex_cache");
+}
+
+static int
+_vk_dev_optimize_cluster_compare(const void* a, const void* b)
+{
+	const struct _vk_dev_optimize_cluster* lhs = a;
+	const struct _vk_dev_optimize_cluster* rhs = b;
+
+	// NOTE: Descending key; ties keep input order for determinism.
+	if (lhs->key != rhs->key) {
+		return lhs->key < rhs->key ? 1 : -1;
+	}
+
+	return lhs->first < rhs->first ? -1 : lhs->first > rhs->first;
+}
+
+static const float*
+_vk_dev_optimize_position(const float* positions, const size_t stride,
+	const uint32_t vertex)
+{
+	return (const float*)((const char*)positions + vertex * stride);
+}
+
+void
+vk_dev_optimize_overdraw(uint32_t* destination, const uint32_t* indices,
+	const uint32_t index_count, const float* positions,
+	const size_t position_stride, const uint32_t vertex_count)
+{
+	float mesh_center[3], center[3], normal[3], e1[3], e2[3], area;
+	const float* p[3];
+	uint32_t cluster_count, time, misses, output;
+	uint32_t* timestamps;
+	struct _vk_dev_optimize_cluster* clusters;
+	struct _vk_dev_optimize_cluster* cluster;
+	const uint32_t triangle_count = index_count / 3;
+	const uint32_t cache_size = VK_DEV_OPTIMIZE_CACHE_SIZE;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_optimize_overdraw");
+
+	_vk_dev_optimize_check_indices(indices, index_count, vertex_count);
+
+	timestamps = _vk_dev_optimize_alloc(sizeof(*timestamps) * vertex_count);
+	clusters = _vk_dev_optimize_alloc(sizeof(*clusters) * triangle_count);
+	memset(timestamps, 0, sizeof(*timestamps) * vertex_count);
+
+	/*
+	 *	NOTE:	A triangle missing the cache on all three vertices starts a
+	 *			new cluster: nothing before it is reused, so moving the
+	 *			clusters around costs (almost) no extra transforms.
+	 */
+	time = cache_size + 1;
+	cluster_count = 0;
+
+	for (uint32_t i = 0; i < triangle_count; i++) {
+		misses = 0;
+		for (int j = 0; j < 3; j++) {
+			if (time - timestamps[indices[i * 3 + j]] > cache_size) {
+				timestamps[indices[i * 3 + j]] = time++;
+				misses++;
+			}
+		}
+
+		if (misses == 3 || cluster_count == 0) {
+			clusters[cluster_count].first = i;
+			clusters[cluster_count].count = 0;
+			cluster_count++;
+		}
+
+		clusters[cluster_count - 1].count++;
+	}
+
+	mesh_center[0] = mesh_center[1] = mesh_center[2] = 0.0f;
+	for (uint32_t i = 0; i < index_count; i++) {
+		p[0] = _vk_dev_optimize_position(positions, position_stride,
+			indices[i]);
+		for (int j = 0; j < 3; j++) {
+			mesh_center[j] += p[0][j] / index_count;
+		}
+	}
+
+	/*
+	 *	NOTE:	Sort key from Sander et al.: how far the cluster sits out
+	 *			along its own average normal, relative to the mesh center.
+	 *			Outward facing clusters tend to occlude the rest.
+	 */
+	for (uint32_t i = 0; i < cluster_count; i++) {
+		cluster = &clusters[i];
+
+		center[0] = center[1] = center[2] = 0.0f;
+		normal[0] = normal[1] = normal[2] = 0.0f;
+
+		for (uint32_t t = cluster->first; t < cluster->first + cluster->count;
+			t++) {
+			for (int j = 0; j < 3; j++) {
+				p[j] = _vk_dev_optimize_position(positions, position_stride,
+					indices[t * 3 + j]);
+			}
+
+			for (int j = 0; j < 3; j++) {
+				e1[j] = p[1][j] - p[0][j];
+				e2[j] = p[2][j] - p[0][j];
+				center[j] += (p[0][j] + p[1][j] + p[2][j]) /
+					(3.0f * cluster->count);
+			}
+
+			// NOTE: Unnormalized, so larger triangles weigh more.
+			normal[0] += e1[1] * e2[2] - e1[2] * e2[1];
+			normal[1] += e1[2] * e2[0] - e1[0] * e2[2];
+			normal[2] += e1[0] * e2[1] - e1[1] * e2[0];
+		}
+
+		area = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] +
+			normal[2] * normal[2]);
+
+		cluster->key = 0.0f;
+		if (area > 0.0f) {
+			for (int j = 0; j < 3; j++) {
+				cluster->key += (center[j] - mesh_center[j]) * normal[j] / area;
+			}
+		}
+	}
+
+	qsort(clusters, cluster_count, sizeof(*clusters),
+		_vk_dev_optimize_cluster_compare);
+
+	output = 0;
+	for (uint32_t i = 0; i < cluster_count; i++) {
+		memcpy(&destination[output], &indices[clusters[i].first * 3],
+			sizeof(*indices) * clusters[i].count * 3);
+		output += clusters[i].count * 3;
+	}
+
+	free(clusters);
+	free(timestamps);
+
+	VK_DEV_TRACE_END("vk_dev_optimize_overdraw");
+}
+
+uint32_t
+vk_dev_optimize_vertex_fetch(void* destination, const void* vertices,
+	uint32_t* indices, const uint32_t index_count,
+	const uint32_t vertex_count, const size_t vertex_size)
+{
+	uint32_t next;
+	uint32_t* remap;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_optimize_vertex_fetch");
+
+	_vk_dev_optimize_check_indices(indices, index_count, vertex_count);
+
+	remap = _vk_dev_optimize_alloc(sizeof(*remap) * vertex_count);
+	memset(remap, 0xff, sizeof(*remap) * vertex_count);
+
+	next = 0;
+	for (uint32_t i = 0; i < index_count; i++) {
+		if (remap[indices[i]] == VK_DEV_OPTIMIZE_NONE) {
+			memcpy((char*)destination + next * vertex_size,
+				(const char*)vertices + indices[i] * vertex_size, vertex_size);
+			remap[indices[i]] = next++;
+		}
+
+		indices[i] = remap[indices[i]];
+	}
+
+	free(remap);
+
+	VK_DEV_TRACE_END("vk_dev_optimize_vertex_fetch");
+
+	return next;
+}
+
+uint32_t
+vk_dev_optimize_mesh(void* vertices, uint32_t* indices,
+	const uint32_t index_count, const uint32_t vertex_count,
+	const size_t vertex_size, const float* positions,
+	struct vk_dev_optimize_report* report)
+{
+	void* scratch;
+	uint32_t* ordered;
+	uint32_t used;
+
+	_vk_dev_optimize_check_indices(indices, index_count, vertex_count);
+
+	if (report != NULL) {
+		vk_dev_optimize_analyze_vertex_cache(indices, index_count,
+			vertex_count, VK_DEV_OPTIMIZE_CACHE_SIZE, &report->before);
+	}
+
+	vk_dev_optimize_vertex_cache(indices, indices, index_count, vertex_count);
+
+	if (positions != NULL) {
+		ordered = _vk_dev_optimize_alloc(sizeof(*ordered) * index_count);
+		vk_dev_optimize_overdraw(ordered, indices, index_count, positions,
+			vertex_size, vertex_count);
+		memcpy(indices, ordered, sizeof(*indices) * index_count);
+		free(ordered);
+	}
+
+	scratch = _vk_dev_optimize_alloc(vertex_size * vertex_count);
+	used = vk_dev_optimize_vertex_fetch(scratch, vertices, indices,
+		index_count, vertex_count, vertex_size);
+	memcpy(vertices, scratch, vertex_size * used);
+	free(scratch);
+
+	if (report != NULL) {
+		vk_dev_optimize_analyze_vertex_cache(indices, index_count, used,
+			VK_DEV_OPTIMIZE_CACHE_SIZE, &report->after);
+	}
+
+	return used;
+}
@@ -0,0 +1,262 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <vulkan-dev/parallel.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/trace.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+// NOTE: Chunks per thread, so a thread that finishes early takes another.
+#define VK_DEV_PARALLEL_CHUNKS_PER_THREAD 4
+
+struct vk_dev_parallel_pass {
+	struct vk_dev_context* context;
+	struct vk_dev_jobs* jobs;
+
+	// NOTE: Slots are created on first use; used counts the last record's.
+	VkCommandPool command_pools[VK_DEV_PARALLEL_MAX_CHUNKS];
+	VkCommandBuffer command_buffers[VK_DEV_PARALLEL_MAX_CHUNKS];
+	uint32_t slot_count;
+	uint32_t used_count;
+
+	// NOTE: The record in progress, read by the workers.
+	VkCommandBufferInheritanceInfo inheritance;
+	vk_dev_parallel_record_fn fn;
+	void* arg;
+	uint32_t draw_count;
+	uint32_t chunk_size;
+
+	struct vk_dev_parallel_stats stats;
+};
+
+static uint64_t
+_vk_dev_parallel_time_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+struct vk_dev_parallel_pass*
+vk_dev_parallel_pass_create(struct vk_dev_context* context,
+	struct vk_dev_jobs* jobs)
+{
+	struct vk_dev_parallel_pass* pass;
+
+	pass = calloc(1, sizeof(*pass));
+	if (pass == NULL) {
+		vk_dev_fatal_error("[PARALLEL] Failed to allocate parallel pass.");
+	}
+
+	pass->context = context;
+	pass->jobs = jobs;
+
+	return pass;
+}
+
+void
+vk_dev_parallel_pass_destroy(struct vk_dev_parallel_pass* pass)
+{
+	struct vk_dev_context* context;
+
+	if (pass == NULL) {
+		return;
+	}
+
+	context = pass->context;
+
+	for (uint32_t i = 0; i < pass->slot_count; i++) {
+		context->vk.DestroyCommandPool(context->device,
+			pass->command_pools[i], NULL);
+	}
+
+	free(pass);
+}
+
+static void
+_vk_dev_parallel_create_slot(struct vk_dev_parallel_pass* pass)
+{
+	uint32_t slot;
+	VkCommandPoolCreateInfo pool_info;
+	VkCommandBufferAllocateInfo allocate_info;
+	struct vk_dev_context* context;
+
+	context = pass->context;
+	slot = pass->slot_count;
+
+	pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	pool_info.pNext = NULL;
+	pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	pool_info.queueFamilyIndex = context->queue_family;
+
+	if (context->vk.CreateCommandPool(context->device, &pool_info, NULL,
+		&pass->command_pools[slot]) != VK_SUCCESS) {
+		vk_dev_fatal_error("[PARALLEL] Failed to create command pool.");
+	}
+
+	allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocate_info.pNext = NULL;
+	allocate_info.commandPool = pass->command_pools[slot];
+	allocate_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+	allocate_info.commandBufferCount = 1;
+
+	if (context->vk.AllocateCommandBuffers(context->device, &allocate_info,
+		&pass->command_buffers[slot]) != VK_SUCCESS) {
+		vk_dev_fatal_error("[PARALLEL] Failed to allocate command buffer.");
+	}
+
+	pass->slot_count++;
+}
+
+static void
+_vk_dev_parallel_record_chunk(void* arg, const uint32_t index)
+{
+	uint32_t first, count;
+	VkCommandBuffer command_buffer;
+	VkCommandBufferBeginInfo begin_info;
+	struct vk_dev_parallel_pass* pass;
+	struct vk_dev_context* context;
+
+	pass = arg;
+	context = pass->context;
+	command_buffer = pass->command_buffers[index];
+
+	first = index * pass->chunk_size;
+	count = pass->draw_count - first < pass->chunk_size ?
+		pass->draw_count - first : pass->chunk_size;
+
+	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.pNext = NULL;
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+		VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	begin_info.pInheritanceInfo = &pass->inheritance;
+
+	if (context->vk.BeginCommandBuffer(command_buffer, &begin_info) !=
+		VK_SUCCESS) {
+		vk_dev_fatal_error("[PARALLEL] Failed to begin command buffer.");
+	}
+
+	pass->fn(pass->arg, command_buffer, first, count);
+
+	if (context->vk.EndCommandBuffer(command_buffer) != VK_SUCCESS) {
+		vk_dev_fatal_error("[PARALLEL] Failed to record command buffer.");
+	}
+}
+
+/*
+ *	NOTE:	Fills in chunk_size and returns the chunk count, 0 to record
+ *			inline.
+ */
+static uint32_t
+_vk_dev_parallel_split(struct vk_dev_parallel_pass* pass,
+	const uint32_t draw_count)
+{
+	uint32_t thread_count, chunk_size, chunks;
+
+	thread_count = vk_dev_jobs_get_thread_count(pass->jobs);
+	if (thread_count < 2 || draw_count < 2 * VK_DEV_PARALLEL_MIN_DRAWS) {
+		pass->chunk_size = draw_count;
+		return 0;
+	}
+
+	chunks = thread_count * VK_DEV_PARALLEL_CHUNKS_PER_THREAD;
+	chunk_size = (draw_count + chunks - 1) / chunks;
+	if (chunk_size < VK_DEV_PARALLEL_MIN_DRAWS) {
+		chunk_size = VK_DEV_PARALLEL_MIN_DRAWS;
+	}
+
+	chunks = (draw_count + chunk_size - 1) / chunk_size;
+	if (chunks > VK_DEV_PARALLEL_MAX_CHUNKS) {
+		chunk_size = (draw_count + VK_DEV_PARALLEL_MAX_CHUNKS - 1) /
+			VK_DEV_PARALLEL_MAX_CHUNKS;
+		chunks = (draw_count + chunk_size - 1) / chunk_size;
+	}
+
+	pass->chunk_size = chunk_size;
+
+	return chunks;
+}
+
+void
+vk_dev_parallel_pass_record(struct vk_dev_parallel_pass* pass,
+	VkCommandBuffer primary, const VkRenderPassBeginInfo* begin_info,
+	const uint32_t draw_count, vk_dev_parallel_record_fn fn, void* arg)
+{
+	uint64_t start;
+	uint32_t chunks;
+	struct vk_dev_context* context;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_parallel_pass_record");
+
+	context = pass->context;
+	start = _vk_dev_parallel_time_ns();
+
+	for (uint32_t i = 0; i < pass->used_count; i++) {
+		if (context->vk.ResetCommandPool(context->device,
+			pass->command_pools[i], 0) != VK_SUCCESS) {
+			vk_dev_fatal_error("[PARALLEL] Failed to reset command pool.");
+		}
+	}
+
+	chunks = _vk_dev_parallel_split(pass, draw_count);
+
+	if (chunks == 0) {
+		context->vk.CmdBeginRenderPass(primary, begin_info,
+			VK_SUBPASS_CONTENTS_INLINE);
+		if (draw_count > 0) {
+			fn(arg, primary, 0, draw_count);
+		}
+	} else {
+		while (pass->slot_count < chunks) {
+			_vk_dev_parallel_create_slot(pass);
+		}
+
+		pass->inheritance.sType =
+			VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		pass->inheritance.pNext = NULL;
+		pass->inheritance.renderPass = begin_info->renderPass;
+		pass->inheritance.subpass = 0;
+		pass->inheritance.framebuffer = begin_info->framebuffer;
+		pass->inheritance.occlusionQueryEnable = VK_FALSE;
+		pass->inheritance.queryFlags = 0;
+		pass->inheritance.pipelineStatistics = 0;
+
+		pass->fn = fn;
+		pass->arg = arg;
+		pass->draw_count = draw_count;
+
+		/*
+		 *	NOTE:	Secondaries are recorded before the pass begins, so
+		 *			the primary is not touched while workers run.
+		 */
+		vk_dev_jobs_run(pass->jobs, chunks, _vk_dev_parallel_record_chunk,
+			pass);
+
+		context->vk.CmdBeginRenderPass(primary, begin_info,
+			VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		context->vk.CmdExecuteCommands(primary, chunks,
+			pass->command_buffers);
+	}
+
+	context->vk.CmdEndRenderPass(primary);
+
+	pass->used_count = chunks;
+
+	pass->stats.draw_count = draw_count;
+	pass->stats.chunk_count = chunks;
+	pass->stats.chunk_size = pass->chunk_size;
+	pass->stats.record_ns = _vk_dev_parallel_time_ns() - start;
+
+	VK_DEV_TRACE_END("vk_dev_parallel_pass_record");
+}
+
+void
+vk_dev_parallel_pass_get_stats(const struct vk_dev_parallel_pass* pass,
+	struct vk_dev_parallel_stats* stats)
+{
+	*stats = pass->stats;
+}
@@ -0,0 +1,269 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <vulkan-dev/replay.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/trace.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#define VK_DEV_REPLAY_MIN_CAPACITY 8
+
+struct _vk_dev_replay_entry {
+	struct vk_dev_replay_info info;
+
+	// NOTE: current is the recorded one; the other is the next to record.
+	VkCommandBuffer command_buffers[2];
+	uint64_t last_use[2];
+	uint32_t current;
+
+	bool recorded;
+	bool invalidated;
+	uint64_t key;
+	uint64_t record_ns;
+};
+
+struct vk_dev_replay {
+	struct vk_dev_context* context;
+	struct vk_dev_timeline* timeline;
+
+	VkCommandPool command_pool;
+
+	struct _vk_dev_replay_entry* entries;
+	uint32_t entry_count;
+	uint32_t entry_capacity;
+
+	struct vk_dev_replay_stats stats;
+};
+
+static uint64_t
+_vk_dev_replay_time_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+struct vk_dev_replay*
+vk_dev_replay_create(struct vk_dev_context* context,
+	struct vk_dev_timeline* timeline)
+{
+	VkCommandPoolCreateInfo pool_info;
+	struct vk_dev_replay* replay;
+
+	replay = calloc(1, sizeof(*replay));
+	if (replay == NULL) {
+		vk_dev_fatal_error("[REPLAY] Failed to allocate replay cache.");
+	}
+
+	replay->context = context;
+	replay->timeline = timeline;
+
+	pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	pool_info.pNext = NULL;
+	pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	pool_info.queueFamilyIndex = context->queue_family;
+
+	if (context->vk.CreateCommandPool(context->device, &pool_info, NULL,
+		&replay->command_pool) != VK_SUCCESS) {
+		vk_dev_fatal_error("[REPLAY] Failed to create command pool.");
+	}
+
+	return replay;
+}
+
+void
+vk_dev_replay_destroy(struct vk_dev_replay* replay)
+{
+	uint64_t last_use;
+	struct vk_dev_context* context;
+
+	if (replay == NULL) {
+		return;
+	}
+
+	context = replay->context;
+
+	last_use = 0;
+	for (uint32_t i = 0; i < replay->entry_count; i++) {
+		for (uint32_t j = 0; j < 2; j++) {
+			if (replay->entries[i].last_use[j] > last_use) {
+				last_use = replay->entries[i].last_use[j];
+			}
+		}
+	}
+
+	vk_dev_timeline_wait(replay->timeline, last_use);
+
+	context->vk.DestroyCommandPool(context->device, replay->command_pool,
+		NULL);
+
+	free(replay->entries);
+	free(replay);
+}
+
+uint32_t
+vk_dev_replay_add(struct vk_dev_replay* replay,
+	const struct vk_dev_replay_info* info)
+{
+	uint32_t capacity;
+	VkCommandBufferAllocateInfo allocate_info;
+	struct _vk_dev_replay_entry* entries;
+	struct _vk_dev_replay_entry* entry;
+	struct vk_dev_context* context;
+
+	context = replay->context;
+
+	if (replay->entry_count == replay->entry_capacity) {
+		capacity = replay->entry_capacity > 0 ?
+			replay->entry_capacity * 2 : VK_DEV_REPLAY_MIN_CAPACITY;
+
+		entries = realloc(replay->entries, sizeof(*entries) * capacity);
+		if (entries == NULL) {
+			vk_dev_fatal_error("[REPLAY] Failed to grow entries.");
+		}
+
+		replay->entries = entries;
+		replay->entry_capacity = capacity;
+	}
+
+	entry = &replay->entries[replay->entry_count];
+	entry->info = *info;
+	entry->last_use[0] = 0;
+	entry->last_use[1] = 0;
+	entry->current = 0;
+	entry->recorded = false;
+	entry->invalidated = false;
+	entry->key = 0;
+	entry->record_ns = 0;
+
+	allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocate_info.pNext = NULL;
+	allocate_info.commandPool = replay->command_pool;
+	allocate_info.level = info->level;
+	allocate_info.commandBufferCount = 2;
+
+	if (context->vk.AllocateCommandBuffers(context->device, &allocate_info,
+		entry->command_buffers) != VK_SUCCESS) {
+		vk_dev_fatal_error("[REPLAY] Failed to allocate command buffers.");
+	}
+
+	return replay->entry_count++;
+}
+
+static void
+_vk_dev_replay_record(struct vk_dev_replay* replay,
+	struct _vk_dev_replay_entry* entry)
+{
+	uint64_t start;
+	uint32_t next;
+	VkCommandBuffer command_buffer;
+	VkCommandBufferBeginInfo begin_info;
+	VkCommandBufferInheritanceInfo inheritance;
+	struct vk_dev_context* context;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_replay_record");
+
+	context = replay->context;
+
+	// NOTE: The first recording has nothing in flight to step around.
+	next = entry->recorded ? 1 - entry->current : entry->current;
+	command_buffer = entry->command_buffers[next];
+
+	if (vk_dev_timeline_poll(replay->timeline) < entry->last_use[next]) {
+		VK_DEV_TRACE_BEGIN("vk_dev_replay_stall");
+		vk_dev_timeline_wait(replay->timeline, entry->last_use[next]);
+		VK_DEV_TRACE_END("vk_dev_replay_stall");
+	}
+
+	start = _vk_dev_replay_time_ns();
+
+	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.pNext = NULL;
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+	begin_info.pInheritanceInfo = NULL;
+
+	if (entry->info.level == VK_COMMAND_BUFFER_LEVEL_SECONDARY) {
+		inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritance.pNext = NULL;
+		inheritance.renderPass = entry->info.render_pass;
+		inheritance.subpass = entry->info.subpass;
+		inheritance.framebuffer = entry->info.framebuffer;
+		inheritance.occlusionQueryEnable = VK_FALSE;
+		inheritance.queryFlags = 0;
+		inheritance.pipelineStatistics = 0;
+
+		begin_info.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		begin_info.pInheritanceInfo = &inheritance;
+	}
+
+	// NOTE: Beginning implicitly resets a buffer from a resettable pool.
+	if (context->vk.BeginCommandBuffer(command_buffer, &begin_info) !=
+		VK_SUCCESS) {
+		vk_dev_fatal_error("[REPLAY] Failed to begin command buffer.");
+	}
+
+	entry->info.fn(entry->info.arg, command_buffer);
+
+	if (context->vk.EndCommandBuffer(command_buffer) != VK_SUCCESS) {
+		vk_dev_fatal_error("[REPLAY] Failed to record command buffer.");
+	}
+
+	entry->current = next;
+	entry->recorded = true;
+	entry->record_ns = _vk_dev_replay_time_ns() - start;
+
+	replay->stats.records++;
+	replay->stats.record_ns += entry->record_ns;
+
+	VK_DEV_TRACE_END("vk_dev_replay_record");
+}
+
+VkCommandBuffer
+vk_dev_replay_get(struct vk_dev_replay* replay, const uint32_t entry_index,
+	const uint64_t key)
+{
+	struct _vk_dev_replay_entry* entry;
+
+	if (entry_index >= replay->entry_count) {
+		vk_dev_fatal_error("[REPLAY] Entry out of range.");
+	}
+
+	entry = &replay->entries[entry_index];
+
+	if (entry->recorded == false || entry->invalidated || entry->key != key) {
+		_vk_dev_replay_record(replay, entry);
+		entry->invalidated = false;
+		entry->key = key;
+	} else {
+		replay->stats.replays++;
+		replay->stats.saved_ns += entry->record_ns;
+	}
+
+	entry->last_use[entry->current] =
+		vk_dev_timeline_get_signalled(replay->timeline) + 1;
+
+	return entry->command_buffers[entry->current];
+}
+
+void
+vk_dev_replay_invalidate(struct vk_dev_replay* replay,
+	const uint32_t entry_index)
+{
+	if (entry_index >= replay->entry_count) {
+		vk_dev_fatal_error("[REPLAY] Entry out of range.");
+	}
+
+	replay->entries[entry_index].invalidated = true;
+}
+
+void
+vk_dev_replay_get_stats(const struct vk_dev_replay* replay,
+	struct vk_dev_replay_stats* stats)
+{
+	*stats = replay->stats;
+}
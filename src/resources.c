@@ -0,0 +1,683 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <vulkan-dev/resources.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/trace.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#define VK_DEV_RESOURCES_INDEX_BITS 20
+#define VK_DEV_RESOURCES_INDEX_MASK ((1u << VK_DEV_RESOURCES_INDEX_BITS) - 1)
+#define VK_DEV_RESOURCES_GENERATION_MASK \
+	((1u << (32 - VK_DEV_RESOURCES_INDEX_BITS)) - 1)
+
+#define VK_DEV_RESOURCES_CACHE_LINE 64
+
+/*
+ *	NOTE:	Hot records open with their slot's generation and are padded to
+ *			16 or 32 bytes, so with the array cache line aligned none of
+ *			them straddles two lines. The primary handle is VK_NULL_HANDLE
+ *			while a slot is free.
+ */
+struct _vk_dev_buffer_hot {
+	uint32_t generation;
+	uint32_t padding;
+	VkBuffer buffer;
+};
+
+struct _vk_dev_buffer_cold {
+	VkDeviceMemory memory;
+	VkDeviceSize size;
+	void* mapped;
+};
+
+struct _vk_dev_image_hot {
+	uint32_t generation;
+	uint32_t padding;
+	VkImage image;
+	VkImageView view;
+	uint64_t reserved;
+};
+
+struct _vk_dev_image_cold {
+	VkDeviceMemory memory;
+	VkFormat format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t levels;
+};
+
+struct _vk_dev_pipeline_hot {
+	uint32_t generation;
+	uint32_t bind_point;
+	VkPipeline pipeline;
+	VkPipelineLayout layout;
+	uint64_t reserved;
+};
+
+struct _vk_dev_sampler_hot {
+	uint32_t generation;
+	uint32_t padding;
+	VkSampler sampler;
+};
+
+struct _vk_dev_pool {
+	pthread_mutex_t lock;
+
+	uint8_t* hot;
+	uint8_t* cold;
+	uint32_t hot_size;
+	uint32_t cold_size;
+	uint32_t capacity;
+
+	// NOTE: A stack of free slots; lowest indices are handed out first.
+	uint32_t* free_slots;
+	uint32_t free_count;
+};
+
+struct vk_dev_resources {
+	struct vk_dev_context* context;
+
+	struct _vk_dev_pool buffers;
+	struct _vk_dev_pool images;
+	struct _vk_dev_pool pipelines;
+	struct _vk_dev_pool samplers;
+
+	uint64_t stale_lookups;
+};
+
+static void
+_vk_dev_pool_create(struct _vk_dev_pool* pool, const uint32_t capacity,
+	const uint32_t hot_size, const uint32_t cold_size)
+{
+	void* hot;
+
+	if (capacity > VK_DEV_RESOURCES_MAX_CAPACITY) {
+		vk_dev_fatal_error("[RESOURCES] Pool capacity too large.");
+	}
+
+	pool->capacity = capacity;
+	pool->hot_size = hot_size;
+	pool->cold_size = cold_size;
+
+	if (posix_memalign(&hot, VK_DEV_RESOURCES_CACHE_LINE,
+		(size_t)hot_size * (capacity > 0 ? capacity : 1)) != 0) {
+		vk_dev_fatal_error("[RESOURCES] Failed to allocate pool.");
+	}
+
+	pool->hot = hot;
+	memset(pool->hot, 0, (size_t)hot_size * capacity);
+
+	pool->cold = calloc(capacity > 0 ? capacity : 1, cold_size > 0 ?
+		cold_size : 1);
+	pool->free_slots = malloc(sizeof(*pool->free_slots) *
+		(capacity > 0 ? capacity : 1));
+	if (pool->cold == NULL || pool->free_slots == NULL) {
+		vk_dev_fatal_error("[RESOURCES] Failed to allocate pool.");
+	}
+
+	for (uint32_t i = 0; i < capacity; i++) {
+		*(uint32_t*)(pool->hot + (size_t)i * hot_size) = 1;
+		pool->free_slots[i] = capacity - 1 - i;
+	}
+
+	pool->free_count = capacity;
+
+	if (pthread_mutex_init(&pool->lock, NULL) != 0) {
+		vk_dev_fatal_error("[RESOURCES] Failed to create lock.");
+	}
+}
+
+static void
+_vk_dev_pool_destroy(struct _vk_dev_pool* pool)
+{
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->free_slots);
+	free(pool->cold);
+	free(pool->hot);
+}
+
+/*
+ *	NOTE:	Returns a free slot's index; the caller fills the record, then
+ *			hands out its handle.
+ */
+static uint32_t
+_vk_dev_pool_acquire(struct _vk_dev_pool* pool)
+{
+	uint32_t index;
+
+	pthread_mutex_lock(&pool->lock);
+
+	if (pool->free_count == 0) {
+		vk_dev_fatal_error("[RESOURCES] Pool is full.");
+	}
+
+	index = pool->free_slots[--pool->free_count];
+
+	pthread_mutex_unlock(&pool->lock);
+
+	return index;
+}
+
+static void*
+_vk_dev_pool_hot(const struct _vk_dev_pool* pool, const uint32_t index)
+{
+	return pool->hot + (size_t)index * pool->hot_size;
+}
+
+static void*
+_vk_dev_pool_cold(const struct _vk_dev_pool* pool, const uint32_t index)
+{
+	return pool->cold + (size_t)index * pool->cold_size;
+}
+
+static uint32_t
+_vk_dev_pool_handle(const struct _vk_dev_pool* pool, const uint32_t index)
+{
+	uint32_t generation;
+
+	generation = __atomic_load_n((uint32_t*)_vk_dev_pool_hot(pool, index),
+		__ATOMIC_RELAXED);
+
+	return generation << VK_DEV_RESOURCES_INDEX_BITS | index;
+}
+
+/*
+ *	NOTE:	The slot's hot record if bits names its current occupant, NULL
+ *			otherwise. Readers learn bits from the thread that added the
+ *			record, and that hand-off (a lock, a queue, starting a thread)
+ *			is what makes the filled record visible to them. The acquire
+ *			load only keeps the record's reads after the generation check.
+ */
+static void*
+_vk_dev_pool_lookup(struct vk_dev_resources* resources,
+	const struct _vk_dev_pool* pool, const uint32_t bits)
+{
+	uint32_t index;
+	uint8_t* record;
+
+	index = bits & VK_DEV_RESOURCES_INDEX_MASK;
+
+	if (index < pool->capacity) {
+		record = _vk_dev_pool_hot(pool, index);
+		if (__atomic_load_n((uint32_t*)record, __ATOMIC_ACQUIRE) ==
+			bits >> VK_DEV_RESOURCES_INDEX_BITS) {
+			return record;
+		}
+	}
+
+	__atomic_fetch_add(&resources->stale_lookups, 1, __ATOMIC_RELAXED);
+
+	return NULL;
+}
+
+/*
+ *	NOTE:	Bumps the generation first, so the handle stops resolving before
+ *			the record is cleared and the slot can be handed out again.
+ *			Returns false if bits is stale.
+ */
+static bool
+_vk_dev_pool_release(struct _vk_dev_pool* pool, const uint32_t bits,
+	void* hot, void* cold)
+{
+	uint32_t index, generation;
+	uint8_t* record;
+
+	index = bits & VK_DEV_RESOURCES_INDEX_MASK;
+	if (index >= pool->capacity) {
+		return false;
+	}
+
+	record = _vk_dev_pool_hot(pool, index);
+
+	pthread_mutex_lock(&pool->lock);
+
+	generation = *(uint32_t*)record;
+	if (generation != bits >> VK_DEV_RESOURCES_INDEX_BITS) {
+		pthread_mutex_unlock(&pool->lock);
+		return false;
+	}
+
+	memcpy(hot, record, pool->hot_size);
+	if (cold != NULL) {
+		memcpy(cold, _vk_dev_pool_cold(pool, index), pool->cold_size);
+	}
+
+	generation = (generation + 1) & VK_DEV_RESOURCES_GENERATION_MASK;
+	__atomic_store_n((uint32_t*)record, generation > 0 ? generation : 1,
+		__ATOMIC_RELEASE);
+
+	memset(record + sizeof(uint32_t), 0, pool->hot_size - sizeof(uint32_t));
+	memset(_vk_dev_pool_cold(pool, index), 0, pool->cold_size);
+
+	pool->free_slots[pool->free_count++] = index;
+
+	pthread_mutex_unlock(&pool->lock);
+
+	return true;
+}
+
+struct vk_dev_resources*
+vk_dev_resources_create(struct vk_dev_context* context,
+	const struct vk_dev_resources_capacity* capacity)
+{
+	struct vk_dev_resources* resources;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_resources_create");
+
+	resources = calloc(1, sizeof(*resources));
+	if (resources == NULL) {
+		vk_dev_fatal_error("[RESOURCES] Failed to allocate resources.");
+	}
+
+	resources->context = context;
+
+	_vk_dev_pool_create(&resources->buffers, capacity->buffers,
+		sizeof(struct _vk_dev_buffer_hot), sizeof(struct _vk_dev_buffer_cold));
+	_vk_dev_pool_create(&resources->images, capacity->images,
+		sizeof(struct _vk_dev_image_hot), sizeof(struct _vk_dev_image_cold));
+	_vk_dev_pool_create(&resources->pipelines, capacity->pipelines,
+		sizeof(struct _vk_dev_pipeline_hot), 0);
+	_vk_dev_pool_create(&resources->samplers, capacity->samplers,
+		sizeof(struct _vk_dev_sampler_hot), 0);
+
+	VK_DEV_TRACE_END("vk_dev_resources_create");
+
+	return resources;
+}
+
+void
+vk_dev_resources_destroy(struct vk_dev_resources* resources)
+{
+	struct _vk_dev_pool* pool;
+
+	if (resources == NULL) {
+		return;
+	}
+
+	pool = &resources->buffers;
+	for (uint32_t i = 0; i < pool->capacity; i++) {
+		if (((struct _vk_dev_buffer_hot*)_vk_dev_pool_hot(pool,
+			i))->buffer != VK_NULL_HANDLE) {
+			vk_dev_resources_remove_buffer(resources,
+				(vk_dev_buffer_handle){_vk_dev_pool_handle(pool, i)}, NULL, 0);
+		}
+	}
+
+	pool = &resources->images;
+	for (uint32_t i = 0; i < pool->capacity; i++) {
+		if (((struct _vk_dev_image_hot*)_vk_dev_pool_hot(pool,
+			i))->image != VK_NULL_HANDLE) {
+			vk_dev_resources_remove_image(resources,
+				(vk_dev_image_handle){_vk_dev_pool_handle(pool, i)}, NULL, 0);
+		}
+	}
+
+	pool = &resources->pipelines;
+	for (uint32_t i = 0; i < pool->capacity; i++) {
+		if (((struct _vk_dev_pipeline_hot*)_vk_dev_pool_hot(pool,
+			i))->pipeline != VK_NULL_HANDLE) {
+			vk_dev_resources_remove_pipeline(resources,
+				(vk_dev_pipeline_handle){_vk_dev_pool_handle(pool, i)}, NULL,
+				0);
+		}
+	}
+
+	pool = &resources->samplers;
+	for (uint32_t i = 0; i < pool->capacity; i++) {
+		if (((struct _vk_dev_sampler_hot*)_vk_dev_pool_hot(pool,
+			i))->sampler != VK_NULL_HANDLE) {
+			vk_dev_resources_remove_sampler(resources,
+				(vk_dev_sampler_handle){_vk_dev_pool_handle(pool, i)}, NULL,
+				0);
+		}
+	}
+
+	_vk_dev_pool_destroy(&resources->samplers);
+	_vk_dev_pool_destroy(&resources->pipelines);
+	_vk_dev_pool_destroy(&resources->images);
+	_vk_dev_pool_destroy(&resources->buffers);
+
+	free(resources);
+}
+
+vk_dev_buffer_handle
+vk_dev_resources_add_buffer(struct vk_dev_resources* resources,
+	const struct vk_dev_buffer* buffer)
+{
+	uint32_t index;
+	struct _vk_dev_pool* pool;
+	struct _vk_dev_buffer_hot* hot;
+	struct _vk_dev_buffer_cold* cold;
+
+	pool = &resources->buffers;
+	index = _vk_dev_pool_acquire(pool);
+
+	hot = _vk_dev_pool_hot(pool, index);
+	hot->buffer = buffer->buffer;
+
+	cold = _vk_dev_pool_cold(pool, index);
+	cold->memory = buffer->memory;
+	cold->size = buffer->size;
+	cold->mapped = buffer->mapped;
+
+	return (vk_dev_buffer_handle){_vk_dev_pool_handle(pool, index)};
+}
+
+bool
+vk_dev_resources_remove_buffer(struct vk_dev_resources* resources,
+	const vk_dev_buffer_handle handle, struct vk_dev_deletion_queue* queue,
+	const uint64_t value)
+{
+	struct vk_dev_buffer buffer;
+	struct _vk_dev_buffer_hot hot;
+	struct _vk_dev_buffer_cold cold;
+
+	if (!_vk_dev_pool_release(&resources->buffers, handle.bits, &hot,
+		&cold)) {
+		return false;
+	}
+
+	buffer.buffer = hot.buffer;
+	buffer.memory = cold.memory;
+	buffer.size = cold.size;
+	buffer.mapped = cold.mapped;
+
+	if (queue != NULL) {
+		vk_dev_deletion_queue_retire_buffer(queue, value, &buffer);
+	} else {
+		vk_dev_buffer_destroy(resources->context, &buffer);
+	}
+
+	return true;
+}
+
+vk_dev_image_handle
+vk_dev_resources_add_image(struct vk_dev_resources* resources,
+	const struct vk_dev_image* image, VkImageView view)
+{
+	uint32_t index;
+	struct _vk_dev_pool* pool;
+	struct _vk_dev_image_hot* hot;
+	struct _vk_dev_image_cold* cold;
+
+	pool = &resources->images;
+	index = _vk_dev_pool_acquire(pool);
+
+	hot = _vk_dev_pool_hot(pool, index);
+	hot->image = image->image;
+	hot->view = view;
+
+	cold = _vk_dev_pool_cold(pool, index);
+	cold->memory = image->memory;
+	cold->format = image->format;
+	cold->width = image->width;
+	cold->height = image->height;
+	cold->levels = image->levels;
+
+	return (vk_dev_image_handle){_vk_dev_pool_handle(pool, index)};
+}
+
+bool
+vk_dev_resources_remove_image(struct vk_dev_resources* resources,
+	const vk_dev_image_handle handle, struct vk_dev_deletion_queue* queue,
+	const uint64_t value)
+{
+	struct vk_dev_image image;
+	struct _vk_dev_image_hot hot;
+	struct _vk_dev_image_cold cold;
+	struct vk_dev_context* context;
+
+	if (!_vk_dev_pool_release(&resources->images, handle.bits, &hot,
+		&cold)) {
+		return false;
+	}
+
+	context = resources->context;
+
+	image.image = hot.image;
+	image.memory = cold.memory;
+	image.format = cold.format;
+	image.width = cold.width;
+	image.height = cold.height;
+	image.levels = cold.levels;
+
+	if (queue != NULL) {
+		if (hot.view != VK_NULL_HANDLE) {
+			vk_dev_deletion_queue_retire_image_view(queue, value, hot.view);
+		}
+		vk_dev_deletion_queue_retire_image(queue, value, &image);
+	} else {
+		if (hot.view != VK_NULL_HANDLE) {
+			context->vk.DestroyImageView(context->device, hot.view, NULL);
+		}
+		vk_dev_image_destroy(context, &image);
+	}
+
+	return true;
+}
+
+vk_dev_pipeline_handle
+vk_dev_resources_add_pipeline(struct vk_dev_resources* resources,
+	VkPipeline pipeline, VkPipelineLayout layout,
+	const VkPipelineBindPoint bind_point)
+{
+	uint32_t index;
+	struct _vk_dev_pool* pool;
+	struct _vk_dev_pipeline_hot* hot;
+
+	pool = &resources->pipelines;
+	index = _vk_dev_pool_acquire(pool);
+
+	hot = _vk_dev_pool_hot(pool, index);
+	hot->pipeline = pipeline;
+	hot->layout = layout;
+	hot->bind_point = (uint32_t)bind_point;
+
+	return (vk_dev_pipeline_handle){_vk_dev_pool_handle(pool, index)};
+}
+
+bool
+vk_dev_resources_remove_pipeline(struct vk_dev_resources* resources,
+	const vk_dev_pipeline_handle handle, struct vk_dev_deletion_queue* queue,
+	const uint64_t value)
+{
+	struct _vk_dev_pipeline_hot hot;
+	struct vk_dev_context* context;
+
+	if (!_vk_dev_pool_release(&resources->pipelines, handle.bits, &hot,
+		NULL)) {
+		return false;
+	}
+
+	context = resources->context;
+
+	if (queue != NULL) {
+		vk_dev_deletion_queue_retire_pipeline(queue, value, hot.pipeline);
+	} else {
+		context->vk.DestroyPipeline(context->device, hot.pipeline, NULL);
+	}
+
+	return true;
+}
+
+vk_dev_sampler_handle
+vk_dev_resources_add_sampler(struct vk_dev_resources* resources,
+	VkSampler sampler)
+{
+	uint32_t index;
+	struct _vk_dev_pool* pool;
+	struct _vk_dev_sampler_hot* hot;
+
+	pool = &resources->samplers;
+	index = _vk_dev_pool_acquire(pool);
+
+	hot = _vk_dev_pool_hot(pool, index);
+	hot->sampler = sampler;
+
+	return (vk_dev_sampler_handle){_vk_dev_pool_handle(pool, index)};
+}
+
+bool
+vk_dev_resources_remove_sampler(struct vk_dev_resources* resources,
+	const vk_dev_sampler_handle handle, struct vk_dev_deletion_queue* queue,
+	const uint64_t value)
+{
+	struct _vk_dev_sampler_hot hot;
+	struct vk_dev_context* context;
+
+	if (!_vk_dev_pool_release(&resources->samplers, handle.bits, &hot,
+		NULL)) {
+		return false;
+	}
+
+	context = resources->context;
+
+	if (queue != NULL) {
+		vk_dev_deletion_queue_retire_sampler(queue, value, hot.sampler);
+	} else {
+		context->vk.DestroySampler(context->device, hot.sampler, NULL);
+	}
+
+	return true;
+}
+
+VkBuffer
+vk_dev_resources_get_buffer(struct vk_dev_resources* resources,
+	const vk_dev_buffer_handle handle)
+{
+	struct _vk_dev_buffer_hot* hot;
+
+	hot = _vk_dev_pool_lookup(resources, &resources->buffers, handle.bits);
+
+	return hot != NULL ? hot->buffer : VK_NULL_HANDLE;
+}
+
+VkImageView
+vk_dev_resources_get_image_view(struct vk_dev_resources* resources,
+	const vk_dev_image_handle handle)
+{
+	struct _vk_dev_image_hot* hot;
+
+	hot = _vk_dev_pool_lookup(resources, &resources->images, handle.bits);
+
+	return hot != NULL ? hot->view : VK_NULL_HANDLE;
+}
+
+VkImage
+vk_dev_resources_get_image(struct vk_dev_resources* resources,
+	const vk_dev_image_handle handle)
+{
+	struct _vk_dev_image_hot* hot;
+
+	hot = _vk_dev_pool_lookup(resources, &resources->images, handle.bits);
+
+	return hot != NULL ? hot->image : VK_NULL_HANDLE;
+}
+
+bool
+vk_dev_resources_get_pipeline(struct vk_dev_resources* resources,
+	const vk_dev_pipeline_handle handle, VkPipeline* pipeline,
+	VkPipelineLayout* layout, VkPipelineBindPoint* bind_point)
+{
+	struct _vk_dev_pipeline_hot* hot;
+
+	hot = _vk_dev_pool_lookup(resources, &resources->pipelines, handle.bits);
+	if (hot == NULL) {
+		return false;
+	}
+
+	*pipeline = hot->pipeline;
+	*layout = hot->layout;
+	*bind_point = (VkPipelineBindPoint)hot->bind_point;
+
+	return true;
+}
+
+VkSampler
+vk_dev_resources_get_sampler(struct vk_dev_resources* resources,
+	const vk_dev_sampler_handle handle)
+{
+	struct _vk_dev_sampler_hot* hot;
+
+	hot = _vk_dev_pool_lookup(resources, &resources->samplers, handle.bits);
+
+	return hot != NULL ? hot->sampler : VK_NULL_HANDLE;
+}
+
+bool
+vk_dev_resources_get_buffer_info(struct vk_dev_resources* resources,
+	const vk_dev_buffer_handle handle, struct vk_dev_buffer* buffer)
+{
+	uint32_t index;
+	struct _vk_dev_buffer_hot* hot;
+	struct _vk_dev_buffer_cold* cold;
+
+	hot = _vk_dev_pool_lookup(resources, &resources->buffers, handle.bits);
+	if (hot == NULL) {
+		return false;
+	}
+
+	index = handle.bits & VK_DEV_RESOURCES_INDEX_MASK;
+	cold = _vk_dev_pool_cold(&resources->buffers, index);
+
+	buffer->buffer = hot->buffer;
+	buffer->memory = cold->memory;
+	buffer->size = cold->size;
+	buffer->mapped = cold->mapped;
+
+	return true;
+}
+
+bool
+vk_dev_resources_get_image_info(struct vk_dev_resources* resources,
+	const vk_dev_image_handle handle, struct vk_dev_image* image)
+{
+	uint32_t index;
+	struct _vk_dev_image_hot* hot;
+	struct _vk_dev_image_cold* cold;
+
+	hot = _vk_dev_pool_lookup(resources, &resources->images, handle.bits);
+	if (hot == NULL) {
+		return false;
+	}
+
+	index = handle.bits & VK_DEV_RESOURCES_INDEX_MASK;
+	cold = _vk_dev_pool_cold(&resources->images, index);
+
+	image->image = hot->image;
+	image->memory = cold->memory;
+	image->format = cold->format;
+	image->width = cold->width;
+	image->height = cold->height;
+	image->levels = cold->levels;
+
+	return true;
+}
+
+static uint32_t
+_vk_dev_pool_get_live(struct _vk_dev_pool* pool)
+{
+	uint32_t live;
+
+	pthread_mutex_lock(&pool->lock);
+	live = pool->capacity - pool->free_count;
+	pthread_mutex_unlock(&pool->lock);
+
+	return live;
+}
+
+void
+vk_dev_resources_get_stats(struct vk_dev_resources* resources,
+	struct vk_dev_resources_stats* stats)
+{
+	stats->live_buffers = _vk_dev_pool_get_live(&resources->buffers);
+	stats->live_images = _vk_dev_pool_get_live(&resources->images);
+	stats->live_pipelines = _vk_dev_pool_get_live(&resources->pipelines);
+	stats->live_samplers = _vk_dev_pool_get_live(&resources->samplers);
+	stats->stale_lookups = __atomic_load_n(&resources->stale_lookups,
+		__ATOMIC_RELAXED);
+}
@@ -0,0 +1,96 @@
+#include <vulkan-dev/shader.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/trace.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+VkShaderModule
+vk_dev_shader_module_load(struct vk_dev_context* context, const char* path)
+{
+	FILE* file;
+	long size;
+	uint32_t* code;
+
+	VkResult result;
+	VkShaderModule module;
+	VkShaderModuleCreateInfo create_info;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_shader_module_load");
+
+	file = fopen(path, "rb");
+	if (file == NULL) {
+		fprintf(stderr, "[SHADER] %s\n", path);
+		vk_dev_fatal_error("[SHADER] Failed to open shader.");
+	}
+
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	// NOTE: SPIR-V is a stream of 32-bit words.
+	if (size <= 0 || size % sizeof(*code) != 0) {
+		vk_dev_fatal_error("[SHADER] Shader is not valid SPIR-V.");
+	}
+
+	code = malloc(size);
+	if (code == NULL || fread(code, 1, size, file) != (size_t)size) {
+		vk_dev_fatal_error("[SHADER] Failed to read shader.");
+	}
+
+	fclose(file);
+
+	create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	create_info.pNext = NULL;
+	create_info.flags = 0;
+	create_info.codeSize = size;
+	create_info.pCode = code;
+
+	result = context->vk.CreateShaderModule(context->device, &create_info,
+		NULL, &module);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[SHADER] Failed to create shader module.");
+	}
+
+	free(code);
+
+	VK_DEV_TRACE_END("vk_dev_shader_module_load");
+
+	return module;
+}
+
+VkPipeline
+vk_dev_compute_pipeline_create(struct vk_dev_context* context,
+	const char* path, VkPipelineLayout layout)
+{
+	VkResult result;
+	VkPipeline pipeline;
+	VkComputePipelineCreateInfo create_info;
+
+	create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	create_info.pNext = NULL;
+	create_info.flags = 0;
+	create_info.stage.sType =
+		VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	create_info.stage.pNext = NULL;
+	create_info.stage.flags = 0;
+	create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	create_info.stage.module = vk_dev_shader_module_load(context, path);
+	create_info.stage.pName = "main";
+	create_info.stage.pSpecializationInfo = NULL;
+	create_info.layout = layout;
+	create_info.basePipelineHandle = VK_NULL_HANDLE;
+	create_info.basePipelineIndex = -1;
+
+	result = context->vk.CreateComputePipelines(context->device,
+		VK_NULL_HANDLE, 1, &create_info, NULL, &pipeline);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[SHADER] Failed to create compute pipeline.");
+	}
+
+	context->vk.DestroyShaderModule(context->device, create_info.stage.module,
+		NULL);
+
+	return pipeline;
+}
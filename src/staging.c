@@ -0,0 +1,418 @@
+#include <vulkan-dev/staging.h>
+#include <vulkan-dev/buffer.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/trace.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+/*
+ *	NOTE:	Every copy source is aligned to a full compressed block, which
+ *			also satisfies the texel size of every uncompressed format used.
+ */
+#define VK_DEV_STAGING_ALIGNMENT 16
+
+struct vk_dev_staging {
+	struct vk_dev_context* context;
+
+	struct vk_dev_buffer buffer;
+	VkDeviceSize head;
+
+	VkCommandPool command_pool;
+	VkCommandBuffer command_buffer;
+	VkFence fence;
+	bool recording;
+
+	VkSemaphore wait_semaphore;
+	VkPipelineStageFlags wait_stages;
+};
+
+struct vk_dev_staging*
+vk_dev_staging_create(struct vk_dev_context* context,
+	const VkDeviceSize capacity)
+{
+	VkResult result;
+	struct vk_dev_staging* staging;
+	VkFenceCreateInfo fence_info;
+	VkCommandPoolCreateInfo pool_info;
+	VkCommandBufferAllocateInfo allocate_info;
+
+	staging = malloc(sizeof(*staging));
+	if (staging == NULL) {
+		vk_dev_fatal_error("[STAGING] Failed to allocate staging buffer.");
+	}
+
+	staging->context = context;
+	staging->head = 0;
+	staging->recording = false;
+	staging->wait_semaphore = VK_NULL_HANDLE;
+	staging->wait_stages = 0;
+
+	vk_dev_buffer_create(context, capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &staging->buffer);
+
+	pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	pool_info.pNext = NULL;
+	pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	pool_info.queueFamilyIndex = context->queue_family;
+
+	result = context->vk.CreateCommandPool(context->device, &pool_info, NULL,
+		&staging->command_pool);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[STAGING] Failed to create command pool.");
+	}
+
+	allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocate_info.pNext = NULL;
+	allocate_info.commandPool = staging->command_pool;
+	allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocate_info.commandBufferCount = 1;
+
+	result = context->vk.AllocateCommandBuffers(context->device,
+		&allocate_info, &staging->command_buffer);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[STAGING] Failed to allocate command buffer.");
+	}
+
+	fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fence_info.pNext = NULL;
+	fence_info.flags = 0;
+
+	result = context->vk.CreateFence(context->device, &fence_info, NULL,
+		&staging->fence);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[STAGING] Failed to create fence.");
+	}
+
+	return staging;
+}
+
+void
+vk_dev_staging_destroy(struct vk_dev_staging* staging)
+{
+	struct vk_dev_context* context;
+
+	if (staging == NULL) {
+		return;
+	}
+
+	context = staging->context;
+
+	vk_dev_staging_flush(staging);
+
+	context->vk.DestroyFence(context->device, staging->fence, NULL);
+	context->vk.DestroyCommandPool(context->device, staging->command_pool,
+		NULL);
+	vk_dev_buffer_destroy(context, &staging->buffer);
+
+	free(staging);
+}
+
+void
+vk_dev_staging_flush(struct vk_dev_staging* staging)
+{
+	VkResult result;
+	VkSubmitInfo submit_info;
+	VkMemoryBarrier barrier;
+	struct vk_dev_context* context;
+
+	if (!staging->recording && staging->wait_semaphore == VK_NULL_HANDLE) {
+		return;
+	}
+
+	VK_DEV_TRACE_BEGIN("vk_dev_staging_flush");
+
+	context = staging->context;
+
+	/*
+	 *	NOTE:	Waiting on the fence only covers the host; this makes the
+	 *			copies visible to everything submitted after them.
+	 */
+	if (staging->recording) {
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.pNext = NULL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+
+		context->vk.CmdPipelineBarrier(staging->command_buffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, NULL, 0,
+			NULL);
+
+		result = context->vk.EndCommandBuffer(staging->command_buffer);
+		if (result != VK_SUCCESS) {
+			vk_dev_fatal_error("[STAGING] Failed to record command buffer.");
+		}
+	}
+
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.pNext = NULL;
+	submit_info.waitSemaphoreCount =
+		staging->wait_semaphore != VK_NULL_HANDLE ? 1 : 0;
+	submit_info.pWaitSemaphores = &staging->wait_semaphore;
+	submit_info.pWaitDstStageMask = &staging->wait_stages;
+	submit_info.commandBufferCount = staging->recording ? 1 : 0;
+	submit_info.pCommandBuffers = &staging->command_buffer;
+	submit_info.signalSemaphoreCount = 0;
+	submit_info.pSignalSemaphores = NULL;
+
+	result = context->vk.QueueSubmit(context->queue, 1, &submit_info,
+		staging->fence);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[STAGING] Failed to submit uploads.");
+	}
+
+	result = context->vk.WaitForFences(context->device, 1, &staging->fence,
+		VK_TRUE, UINT64_MAX);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[STAGING] Failed to wait for uploads.");
+	}
+
+	context->vk.ResetFences(context->device, 1, &staging->fence);
+	context->vk.ResetCommandPool(context->device, staging->command_pool, 0);
+
+	staging->head = 0;
+	staging->recording = false;
+	staging->wait_semaphore = VK_NULL_HANDLE;
+
+	VK_DEV_TRACE_END("vk_dev_staging_flush");
+}
+
+void
+vk_dev_staging_wait(struct vk_dev_staging* staging, VkSemaphore semaphore,
+	const VkPipelineStageFlags stages)
+{
+	// NOTE: Only one wait can be pending; an earlier one is submitted first.
+	if (staging->wait_semaphore != VK_NULL_HANDLE) {
+		vk_dev_staging_flush(staging);
+	}
+
+	staging->wait_semaphore = semaphore;
+	staging->wait_stages = stages;
+}
+
+static void
+_vk_dev_staging_begin(struct vk_dev_staging* staging)
+{
+	VkResult result;
+	VkCommandBufferBeginInfo begin_info;
+
+	if (staging->recording) {
+		return;
+	}
+
+	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.pNext = NULL;
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	begin_info.pInheritanceInfo = NULL;
+
+	result = staging->context->vk.BeginCommandBuffer(staging->command_buffer,
+		&begin_info);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[STAGING] Failed to begin command buffer.");
+	}
+
+	staging->recording = true;
+}
+
+/*
+ *	NOTE:	Copies data into the staging buffer, flushing first if it does
+ *			not fit behind what is already queued, and returns its offset.
+ */
+static VkDeviceSize
+_vk_dev_staging_push(struct vk_dev_staging* staging, const void* data,
+	const VkDeviceSize size)
+{
+	VkDeviceSize offset;
+
+	offset = (staging->head + VK_DEV_STAGING_ALIGNMENT - 1) &
+		~(VkDeviceSize)(VK_DEV_STAGING_ALIGNMENT - 1);
+	if (offset + size > staging->buffer.size) {
+		vk_dev_staging_flush(staging);
+		offset = 0;
+	}
+
+	_vk_dev_staging_begin(staging);
+
+	memcpy((char*)staging->buffer.mapped + offset, data, size);
+	staging->head = offset + size;
+
+	return offset;
+}
+
+void
+vk_dev_staging_upload_buffer(struct vk_dev_staging* staging,
+	VkBuffer buffer, const VkDeviceSize offset, const void* data,
+	const VkDeviceSize size)
+{
+	VkDeviceSize done, chunk;
+	VkBufferCopy region;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_staging_upload_buffer");
+
+	for (done = 0; done < size; done += chunk) {
+		chunk = size - done;
+		if (chunk > staging->buffer.size) {
+			chunk = staging->buffer.size;
+		}
+
+		region.srcOffset = _vk_dev_staging_push(staging,
+			(const char*)data + done, chunk);
+		region.dstOffset = offset + done;
+		region.size = chunk;
+
+		staging->context->vk.CmdCopyBuffer(staging->command_buffer,
+			staging->buffer.buffer, buffer, 1, &region);
+	}
+
+	VK_DEV_TRACE_END("vk_dev_staging_upload_buffer");
+}
+
+static void
+_vk_dev_staging_transition(struct vk_dev_staging* staging,
+	const struct vk_dev_image* image, const uint32_t level,
+	const VkImageLayout old_layout, const VkImageLayout new_layout)
+{
+	VkImageMemoryBarrier barrier;
+	VkPipelineStageFlags source_stage, destination_stage;
+
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.pNext = NULL;
+	barrier.oldLayout = old_layout;
+	barrier.newLayout = new_layout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image->image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = level;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	if (new_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		source_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		destination_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	} else {
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		source_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		destination_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	}
+
+	staging->context->vk.CmdPipelineBarrier(staging->command_buffer,
+		source_stage, destination_stage, 0, 0, NULL, 0, NULL, 1, &barrier);
+}
+
+void
+vk_dev_staging_upload_image(struct vk_dev_staging* staging,
+	const struct vk_dev_image* image, const uint32_t level, const void* data,
+	const VkDeviceSize size)
+{
+	VkBufferImageCopy region;
+
+	if (size > staging->buffer.size) {
+		vk_dev_fatal_error("[STAGING] Image level does not fit the staging "
+			"buffer.");
+	}
+
+	VK_DEV_TRACE_BEGIN("vk_dev_staging_upload_image");
+
+	region.bufferOffset = _vk_dev_staging_push(staging, data, size);
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = level;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset.x = 0;
+	region.imageOffset.y = 0;
+	region.imageOffset.z = 0;
+	region.imageExtent.width = image->width >> level > 0 ?
+		image->width >> level : 1;
+	region.imageExtent.height = image->height >> level > 0 ?
+		image->height >> level : 1;
+	region.imageExtent.depth = 1;
+
+	_vk_dev_staging_transition(staging, image, level,
+		VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+	staging->context->vk.CmdCopyBufferToImage(staging->command_buffer,
+		staging->buffer.buffer, image->image,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+	_vk_dev_staging_transition(staging, image, level,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+	VK_DEV_TRACE_END("vk_dev_staging_upload_image");
+}
+
+void
+vk_dev_staging_prepare_image(struct vk_dev_staging* staging,
+	const struct vk_dev_image* image)
+{
+	VkImageMemoryBarrier barrier;
+
+	_vk_dev_staging_begin(staging);
+
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.pNext = NULL;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image->image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = image->levels;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	staging->context->vk.CmdPipelineBarrier(staging->command_buffer,
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+		0, NULL, 0, NULL, 1, &barrier);
+}
+
+void
+vk_dev_staging_upload_image_region(struct vk_dev_staging* staging,
+	const struct vk_dev_image* image, const uint32_t level,
+	const VkOffset2D offset, const VkExtent2D extent, const void* data,
+	const VkDeviceSize size)
+{
+	VkBufferImageCopy region;
+
+	if (size > staging->buffer.size) {
+		vk_dev_fatal_error("[STAGING] Image region does not fit the staging "
+			"buffer.");
+	}
+
+	VK_DEV_TRACE_BEGIN("vk_dev_staging_upload_image_region");
+
+	region.bufferOffset = _vk_dev_staging_push(staging, data, size);
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = level;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset.x = offset.x;
+	region.imageOffset.y = offset.y;
+	region.imageOffset.z = 0;
+	region.imageExtent.width = extent.width;
+	region.imageExtent.height = extent.height;
+	region.imageExtent.depth = 1;
+
+	// NOTE: Made visible by the barrier recorded in vk_dev_staging_flush.
+	staging->context->vk.CmdCopyBufferToImage(staging->command_buffer,
+		staging->buffer.buffer, image->image, VK_IMAGE_LAYOUT_GENERAL, 1,
+		&region);
+
+	VK_DEV_TRACE_END("vk_dev_staging_upload_image_region");
+}
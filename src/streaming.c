@@ -0,0 +1,681 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <vulkan-dev/streaming.h>
+#include <vulkan-dev/buffer.h>
+#include <vulkan-dev/image.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/trace.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#define VK_DEV_STREAMING_NONE UINT32_MAX
+#define VK_DEV_STREAMING_PAGE_SIZE 4096
+
+/*
+ *	NOTE:	level is the finest resident mip and requested the finest one
+ *			shaders asked for, both as levels of the full texture.
+ */
+struct _vk_dev_streaming_texture {
+	const struct vk_dev_asset_file* file;
+	const struct vk_dev_asset_entry* entry;
+
+	struct vk_dev_image image;
+	VkImageView view;
+	uint32_t handle;
+
+	uint32_t level;
+	uint32_t tail_level;
+	uint32_t requested;
+	uint64_t last_used;
+	bool pending;
+};
+
+/*
+ *	NOTE:	A texture's table entry, read by shaders/streaming.glsl. level
+ *			is the finest resident level and feedback the finest level
+ *			sampled, lowered by shaders with atomicMin and reset by the CPU.
+ */
+struct _vk_dev_streaming_entry {
+	uint32_t handle;
+	uint32_t level;
+	uint32_t feedback;
+	uint32_t padding;
+};
+
+struct _vk_dev_streaming_retired {
+	struct vk_dev_image image;
+	VkImageView view;
+	uint32_t handle;
+	VkDeviceSize bytes;
+};
+
+struct _vk_dev_streaming_retired_list {
+	struct _vk_dev_streaming_retired* items;
+	uint32_t count;
+	uint32_t capacity;
+};
+
+struct _vk_dev_streaming_request {
+	uint32_t texture;
+	uint32_t level;
+	uint32_t resident_level;
+};
+
+/*
+ *	NOTE:	A ring of requests; a texture has at most one request in flight,
+ *			so texture_capacity entries always suffice.
+ */
+struct _vk_dev_streaming_queue {
+	struct _vk_dev_streaming_request* requests;
+	uint32_t head;
+	uint32_t count;
+};
+
+struct vk_dev_streaming {
+	struct vk_dev_context* context;
+	struct vk_dev_bindless* bindless;
+	struct vk_dev_staging* staging;
+
+	struct _vk_dev_streaming_texture* textures;
+	uint32_t texture_count;
+	uint32_t texture_capacity;
+
+	// NOTE: Per frame: the table buffer, its bindless handle and retirees.
+	struct vk_dev_buffer* tables;
+	uint32_t* table_handles;
+	struct _vk_dev_streaming_retired_list* retired;
+	uint32_t frame_count;
+	uint64_t serial;
+
+	VkDeviceSize budget;
+	VkDeviceSize effective_budget;
+	VkDeviceSize resident_bytes;
+	uint64_t loads;
+	uint64_t evictions;
+
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	struct _vk_dev_streaming_queue requests;
+	struct _vk_dev_streaming_queue ready;
+	bool quit;
+};
+
+static void
+_vk_dev_streaming_queue_push(struct _vk_dev_streaming_queue* queue,
+	const uint32_t capacity, const struct _vk_dev_streaming_request* request)
+{
+	queue->requests[(queue->head + queue->count++) % capacity] = *request;
+}
+
+static void
+_vk_dev_streaming_queue_pop(struct _vk_dev_streaming_queue* queue,
+	const uint32_t capacity, struct _vk_dev_streaming_request* request)
+{
+	*request = queue->requests[queue->head];
+	queue->head = (queue->head + 1) % capacity;
+	queue->count--;
+}
+
+static uint32_t
+_vk_dev_streaming_extent(const uint32_t size, const uint32_t level)
+{
+	return size >> level > 0 ? size >> level : 1;
+}
+
+static VkDeviceSize
+_vk_dev_streaming_bytes(const struct _vk_dev_streaming_texture* texture,
+	const uint32_t level)
+{
+	VkDeviceSize bytes;
+	const struct vk_dev_asset_texture* info;
+
+	info = &texture->entry->info.texture;
+
+	bytes = 0;
+	for (uint32_t i = level; i < info->levels; i++) {
+		bytes += info->level_sizes[i];
+	}
+
+	return bytes;
+}
+
+/*
+ *	NOTE:	Touches every page of the levels a request adds so the staging
+ *			copies on the render thread never wait on the disk.
+ */
+static void
+_vk_dev_streaming_prefault(const struct vk_dev_streaming* streaming,
+	const struct _vk_dev_streaming_request* request)
+{
+	const char* data;
+	volatile char sink;
+	const struct _vk_dev_streaming_texture* texture;
+	const struct vk_dev_asset_texture* info;
+
+	texture = &streaming->textures[request->texture];
+	info = &texture->entry->info.texture;
+	data = vk_dev_asset_get_data(texture->file, texture->entry);
+
+	for (uint32_t i = request->level; i < request->resident_level; i++) {
+		for (uint64_t offset = 0; offset < info->level_sizes[i];
+			offset += VK_DEV_STREAMING_PAGE_SIZE) {
+			sink = data[info->level_offsets[i] + offset];
+		}
+	}
+
+	(void)sink;
+}
+
+static void*
+_vk_dev_streaming_thread(void* arg)
+{
+	struct vk_dev_streaming* streaming;
+	struct _vk_dev_streaming_request request;
+
+	streaming = arg;
+
+	for (;;) {
+		pthread_mutex_lock(&streaming->lock);
+		while (streaming->requests.count == 0 && streaming->quit == false) {
+			pthread_cond_wait(&streaming->wake, &streaming->lock);
+		}
+
+		if (streaming->quit) {
+			pthread_mutex_unlock(&streaming->lock);
+			break;
+		}
+
+		_vk_dev_streaming_queue_pop(&streaming->requests,
+			streaming->texture_capacity, &request);
+		pthread_mutex_unlock(&streaming->lock);
+
+		_vk_dev_streaming_prefault(streaming, &request);
+
+		pthread_mutex_lock(&streaming->lock);
+		_vk_dev_streaming_queue_push(&streaming->ready,
+			streaming->texture_capacity, &request);
+		pthread_mutex_unlock(&streaming->lock);
+	}
+
+	return NULL;
+}
+
+struct vk_dev_streaming*
+vk_dev_streaming_create(struct vk_dev_context* context,
+	struct vk_dev_bindless* bindless, struct vk_dev_staging* staging,
+	const uint32_t texture_capacity, const uint32_t frame_count,
+	const VkDeviceSize budget)
+{
+	struct _vk_dev_streaming_entry* table;
+	struct vk_dev_streaming* streaming;
+
+	// NOTE: Shaders report the mip they sample with a fragment atomicMin.
+	if (!context->features.fragmentStoresAndAtomics) {
+		vk_dev_fatal_error("[STREAMING] Device cannot store from fragment "
+			"shaders.");
+	}
+
+	streaming = calloc(1, sizeof(*streaming));
+	if (streaming == NULL) {
+		vk_dev_fatal_error("[STREAMING] Failed to allocate streaming.");
+	}
+
+	streaming->context = context;
+	streaming->bindless = bindless;
+	streaming->staging = staging;
+	streaming->texture_capacity = texture_capacity;
+	streaming->frame_count = frame_count;
+	streaming->budget = budget;
+	streaming->effective_budget = budget;
+
+	streaming->textures = calloc(texture_capacity,
+		sizeof(*streaming->textures));
+	streaming->tables = calloc(frame_count, sizeof(*streaming->tables));
+	streaming->table_handles = calloc(frame_count,
+		sizeof(*streaming->table_handles));
+	streaming->retired = calloc(frame_count, sizeof(*streaming->retired));
+	streaming->requests.requests = calloc(texture_capacity,
+		sizeof(*streaming->requests.requests));
+	streaming->ready.requests = calloc(texture_capacity,
+		sizeof(*streaming->ready.requests));
+	if (streaming->textures == NULL || streaming->tables == NULL ||
+		streaming->table_handles == NULL || streaming->retired == NULL ||
+		streaming->requests.requests == NULL ||
+		streaming->ready.requests == NULL) {
+		vk_dev_fatal_error("[STREAMING] Failed to allocate streaming.");
+	}
+
+	for (uint32_t i = 0; i < frame_count; i++) {
+		vk_dev_buffer_create(context,
+			sizeof(struct _vk_dev_streaming_entry) * texture_capacity,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &streaming->tables[i]);
+
+		table = streaming->tables[i].mapped;
+		for (uint32_t j = 0; j < texture_capacity; j++) {
+			table[j].handle = 0;
+			table[j].level = 0;
+			table[j].feedback = VK_DEV_STREAMING_NONE;
+			table[j].padding = 0;
+		}
+
+		streaming->table_handles[i] = vk_dev_bindless_add_buffer(bindless,
+			streaming->tables[i].buffer, 0, VK_WHOLE_SIZE);
+	}
+
+	pthread_mutex_init(&streaming->lock, NULL);
+	pthread_cond_init(&streaming->wake, NULL);
+
+	if (pthread_create(&streaming->thread, NULL, _vk_dev_streaming_thread,
+		streaming) != 0) {
+		vk_dev_fatal_error("[STREAMING] Failed to create streaming thread.");
+	}
+
+	return streaming;
+}
+
+static void
+_vk_dev_streaming_release(struct vk_dev_streaming* streaming,
+	struct _vk_dev_streaming_retired* retired)
+{
+	struct vk_dev_context* context;
+
+	context = streaming->context;
+
+	vk_dev_bindless_remove(streaming->bindless, VK_DEV_BINDLESS_TEXTURE,
+		retired->handle);
+	context->vk.DestroyImageView(context->device, retired->view, NULL);
+	vk_dev_image_destroy(context, &retired->image);
+
+	streaming->resident_bytes -= retired->bytes;
+}
+
+void
+vk_dev_streaming_destroy(struct vk_dev_streaming* streaming)
+{
+	struct _vk_dev_streaming_retired retired;
+	struct _vk_dev_streaming_texture* texture;
+
+	if (streaming == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&streaming->lock);
+	streaming->quit = true;
+	pthread_cond_signal(&streaming->wake);
+	pthread_mutex_unlock(&streaming->lock);
+
+	pthread_join(streaming->thread, NULL);
+
+	vk_dev_staging_flush(streaming->staging);
+
+	for (uint32_t i = 0; i < streaming->frame_count; i++) {
+		for (uint32_t j = 0; j < streaming->retired[i].count; j++) {
+			_vk_dev_streaming_release(streaming,
+				&streaming->retired[i].items[j]);
+		}
+
+		free(streaming->retired[i].items);
+
+		vk_dev_bindless_remove(streaming->bindless, VK_DEV_BINDLESS_BUFFER,
+			streaming->table_handles[i]);
+		vk_dev_buffer_destroy(streaming->context, &streaming->tables[i]);
+	}
+
+	for (uint32_t i = 0; i < streaming->texture_count; i++) {
+		texture = &streaming->textures[i];
+
+		retired.image = texture->image;
+		retired.view = texture->view;
+		retired.handle = texture->handle;
+		retired.bytes = _vk_dev_streaming_bytes(texture, texture->level);
+		_vk_dev_streaming_release(streaming, &retired);
+	}
+
+	pthread_cond_destroy(&streaming->wake);
+	pthread_mutex_destroy(&streaming->lock);
+
+	free(streaming->ready.requests);
+	free(streaming->requests.requests);
+	free(streaming->retired);
+	free(streaming->table_handles);
+	free(streaming->tables);
+	free(streaming->textures);
+	free(streaming);
+}
+
+static void
+_vk_dev_streaming_retire(struct vk_dev_streaming* streaming,
+	const uint32_t frame, const struct _vk_dev_streaming_texture* texture)
+{
+	struct _vk_dev_streaming_retired* retired;
+	struct _vk_dev_streaming_retired_list* list;
+
+	list = &streaming->retired[frame];
+	if (list->count == list->capacity) {
+		list->capacity = list->capacity > 0 ? list->capacity * 2 : 16;
+		list->items = realloc(list->items,
+			sizeof(*list->items) * list->capacity);
+		if (list->items == NULL) {
+			vk_dev_fatal_error("[STREAMING] Failed to allocate retire list.");
+		}
+	}
+
+	retired = &list->items[list->count++];
+	retired->image = texture->image;
+	retired->view = texture->view;
+	retired->handle = texture->handle;
+	retired->bytes = _vk_dev_streaming_bytes(texture, texture->level);
+}
+
+/*
+ *	NOTE:	Replaces the texture's image with one holding level and every
+ *			coarser level, uploaded straight from the asset mapping. The old
+ *			image, if any, is retired on frame.
+ */
+static void
+_vk_dev_streaming_set_level(struct vk_dev_streaming* streaming,
+	const uint32_t frame, struct _vk_dev_streaming_texture* texture,
+	const uint32_t level, const bool replace)
+{
+	const char* data;
+	struct vk_dev_image image;
+	const struct vk_dev_asset_texture* info;
+
+	info = &texture->entry->info.texture;
+	data = vk_dev_asset_get_data(texture->file, texture->entry);
+
+	vk_dev_image_create(streaming->context,
+		_vk_dev_streaming_extent(info->width, level),
+		_vk_dev_streaming_extent(info->height, level), info->levels - level,
+		(VkFormat)info->format,
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, &image);
+
+	for (uint32_t i = level; i < info->levels; i++) {
+		vk_dev_staging_upload_image(streaming->staging, &image, i - level,
+			data + info->level_offsets[i], info->level_sizes[i]);
+	}
+
+	if (replace) {
+		_vk_dev_streaming_retire(streaming, frame, texture);
+	}
+
+	texture->image = image;
+	texture->view = vk_dev_image_view_create(streaming->context, &image, 0,
+		image.levels);
+	texture->handle = vk_dev_bindless_add_texture(streaming->bindless,
+		texture->view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	texture->level = level;
+
+	streaming->resident_bytes += _vk_dev_streaming_bytes(texture, level);
+}
+
+uint32_t
+vk_dev_streaming_add_texture(struct vk_dev_streaming* streaming,
+	const struct vk_dev_asset_file* file,
+	const struct vk_dev_asset_entry* entry)
+{
+	uint32_t index, tail;
+	struct _vk_dev_streaming_texture* texture;
+	const struct vk_dev_asset_texture* info;
+
+	if (entry->kind != VK_DEV_ASSET_TEXTURE) {
+		vk_dev_fatal_error("[STREAMING] Entry is not a texture.");
+	}
+
+	if (streaming->texture_count == streaming->texture_capacity) {
+		vk_dev_fatal_error("[STREAMING] Texture capacity exceeded.");
+	}
+
+	VK_DEV_TRACE_BEGIN("vk_dev_streaming_add_texture");
+
+	info = &entry->info.texture;
+
+	tail = 0;
+	while (tail + 1 < info->levels &&
+		(_vk_dev_streaming_extent(info->width, tail) >
+		VK_DEV_STREAMING_TAIL_SIZE ||
+		_vk_dev_streaming_extent(info->height, tail) >
+		VK_DEV_STREAMING_TAIL_SIZE)) {
+		tail++;
+	}
+
+	index = streaming->texture_count++;
+	texture = &streaming->textures[index];
+
+	texture->file = file;
+	texture->entry = entry;
+	texture->tail_level = tail;
+	texture->requested = tail;
+	texture->last_used = 0;
+	texture->pending = false;
+
+	_vk_dev_streaming_set_level(streaming, 0, texture, tail, false);
+
+	VK_DEV_TRACE_END("vk_dev_streaming_add_texture");
+
+	return index;
+}
+
+/*
+ *	NOTE:	Textures sampled this frame only give up levels finer than they
+ *			asked for; the rest give up levels in least recently used order.
+ *			Returns the texture to shrink and the level to shrink it to, or
+ *			VK_DEV_STREAMING_NONE.
+ */
+static uint32_t
+_vk_dev_streaming_find_victim(const struct vk_dev_streaming* streaming,
+	const uint32_t exclude, uint32_t* level)
+{
+	uint32_t victim, target;
+	VkDeviceSize growth;
+	const struct _vk_dev_streaming_texture* texture;
+
+	victim = VK_DEV_STREAMING_NONE;
+
+	for (uint32_t i = 0; i < streaming->texture_count; i++) {
+		texture = &streaming->textures[i];
+		if (i == exclude || texture->level >= texture->tail_level) {
+			continue;
+		}
+
+		if (texture->last_used == streaming->serial) {
+			if (texture->requested <= texture->level) {
+				continue;
+			}
+
+			target = texture->requested;
+		} else {
+			target = texture->tail_level;
+		}
+
+		// NOTE: The smaller image must fit before the old one is released.
+		growth = _vk_dev_streaming_bytes(texture, target);
+		if (streaming->resident_bytes + growth >
+			streaming->effective_budget) {
+			continue;
+		}
+
+		if (victim == VK_DEV_STREAMING_NONE ||
+			texture->last_used < streaming->textures[victim].last_used) {
+			victim = i;
+			*level = target;
+		}
+	}
+
+	return victim;
+}
+
+static void
+_vk_dev_streaming_update_budget(struct vk_dev_streaming* streaming)
+{
+	VkDeviceSize heap_budget, heap_usage, available;
+
+	streaming->effective_budget = streaming->budget;
+
+	if (vk_dev_get_memory_budget(streaming->context, &heap_budget,
+		&heap_usage)) {
+		available = heap_budget > heap_usage ? heap_budget - heap_usage : 0;
+		available += streaming->resident_bytes;
+
+		if (available < streaming->effective_budget) {
+			streaming->effective_budget = available;
+		}
+	}
+}
+
+/*
+ *	NOTE:	Returns true if need more bytes fit in the budget. Otherwise one
+ *			texture is shrunk; its memory only comes back once the old image
+ *			is retired, so the load is left to be requested again.
+ */
+static bool
+_vk_dev_streaming_make_room(struct vk_dev_streaming* streaming,
+	const uint32_t frame, const uint32_t exclude, const VkDeviceSize need)
+{
+	uint32_t victim, level;
+
+	if (streaming->resident_bytes + need <= streaming->effective_budget) {
+		return true;
+	}
+
+	victim = _vk_dev_streaming_find_victim(streaming, exclude, &level);
+	if (victim != VK_DEV_STREAMING_NONE) {
+		_vk_dev_streaming_set_level(streaming, frame,
+			&streaming->textures[victim], level, true);
+		streaming->evictions++;
+	}
+
+	return false;
+}
+
+void
+vk_dev_streaming_begin_frame(struct vk_dev_streaming* streaming,
+	const uint32_t frame)
+{
+	uint32_t ready_count;
+	struct _vk_dev_streaming_entry* table;
+	VkDeviceSize need;
+	struct _vk_dev_streaming_retired_list* retired;
+	struct _vk_dev_streaming_texture* texture;
+	struct _vk_dev_streaming_request request;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_streaming_begin_frame");
+
+	streaming->serial++;
+
+	retired = &streaming->retired[frame];
+	for (uint32_t i = 0; i < retired->count; i++) {
+		_vk_dev_streaming_release(streaming, &retired->items[i]);
+	}
+	retired->count = 0;
+
+	_vk_dev_streaming_update_budget(streaming);
+
+	/*
+	 *	NOTE:	The frame that last used this table has finished, so its
+	 *			feedback is complete.
+	 */
+	table = streaming->tables[frame].mapped;
+
+	pthread_mutex_lock(&streaming->lock);
+
+	for (uint32_t i = 0; i < streaming->texture_count; i++) {
+		texture = &streaming->textures[i];
+
+		if (table[i].feedback != VK_DEV_STREAMING_NONE) {
+			texture->requested = table[i].feedback < texture->tail_level ?
+				table[i].feedback : texture->tail_level;
+			texture->last_used = streaming->serial;
+			table[i].feedback = VK_DEV_STREAMING_NONE;
+		} else if (texture->last_used + streaming->frame_count <=
+			streaming->serial) {
+			// NOTE: Unseen in every table since, so off screen.
+			texture->requested = texture->tail_level;
+		}
+
+		if (texture->requested < texture->level && !texture->pending) {
+			request.texture = i;
+			request.level = texture->requested;
+			request.resident_level = texture->level;
+
+			_vk_dev_streaming_queue_push(&streaming->requests,
+				streaming->texture_capacity, &request);
+			texture->pending = true;
+		}
+	}
+
+	pthread_cond_signal(&streaming->wake);
+	ready_count = streaming->ready.count;
+
+	pthread_mutex_unlock(&streaming->lock);
+
+	for (uint32_t i = 0; i < ready_count; i++) {
+		pthread_mutex_lock(&streaming->lock);
+		_vk_dev_streaming_queue_pop(&streaming->ready,
+			streaming->texture_capacity, &request);
+		pthread_mutex_unlock(&streaming->lock);
+
+		texture = &streaming->textures[request.texture];
+		texture->pending = false;
+
+		// NOTE: The texture may have been shrunk or wanted less since.
+		if (request.level < texture->requested) {
+			request.level = texture->requested;
+		}
+
+		if (request.level >= texture->level) {
+			continue;
+		}
+
+		need = _vk_dev_streaming_bytes(texture, request.level);
+		if (!_vk_dev_streaming_make_room(streaming, frame, request.texture,
+			need)) {
+			continue;
+		}
+
+		_vk_dev_streaming_set_level(streaming, frame, texture,
+			request.level, true);
+		streaming->loads++;
+	}
+
+	for (uint32_t i = 0; i < streaming->texture_count; i++) {
+		table[i].handle = streaming->textures[i].handle;
+		table[i].level = streaming->textures[i].level;
+	}
+
+	vk_dev_staging_flush(streaming->staging);
+
+	VK_DEV_TRACE_END("vk_dev_streaming_begin_frame");
+}
+
+uint32_t
+vk_dev_streaming_get_table(const struct vk_dev_streaming* streaming,
+	const uint32_t frame)
+{
+	return streaming->table_handles[frame];
+}
+
+void
+vk_dev_streaming_get_stats(const struct vk_dev_streaming* streaming,
+	struct vk_dev_streaming_stats* stats)
+{
+	uint32_t pending;
+
+	pending = 0;
+	for (uint32_t i = 0; i < streaming->texture_count; i++) {
+		pending += streaming->textures[i].pending ? 1 : 0;
+	}
+
+	stats->texture_count = streaming->texture_count;
+	stats->pending = pending;
+	stats->loads = streaming->loads;
+	stats->evictions = streaming->evictions;
+	stats->resident_bytes = streaming->resident_bytes;
+	stats->budget_bytes = streaming->effective_budget;
+}
@@ -0,0 +1,405 @@
+#include <vulkan-dev/submit.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/mpsc.h>
+#include <vulkan-dev/trace.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#define VK_DEV_SUBMIT_MIN_CAPACITY 16
+
+/*
+ *	NOTE:	A batch is a future VkSubmitInfo, as ranges into its list's
+ *			arrays; they only become pointers at flush, once the arrays
+ *			have stopped growing.
+ */
+struct _vk_dev_submit_batch {
+	uint32_t wait_first;
+	uint32_t wait_count;
+	uint32_t command_buffer_first;
+	uint32_t command_buffer_count;
+	uint32_t signal_first;
+	uint32_t signal_count;
+};
+
+/*
+ *	NOTE:	A submission in flight from a producer, in one allocation with
+ *			copies of its arrays behind it.
+ */
+struct _vk_dev_submit_node {
+	struct vk_dev_mpsc_node link;
+	struct vk_dev_submission submission;
+};
+
+struct _vk_dev_submit_list {
+	struct _vk_dev_submit_batch* batches;
+	uint32_t batch_count;
+	uint32_t batch_capacity;
+
+	VkCommandBuffer* command_buffers;
+	uint32_t command_buffer_count;
+	uint32_t command_buffer_capacity;
+
+	// NOTE: Waits and signals share these; stages is unused for signals.
+	VkSemaphore* semaphores;
+	VkPipelineStageFlags* stages;
+	uint32_t semaphore_count;
+	uint32_t semaphore_capacity;
+
+	uint32_t submissions;
+};
+
+struct vk_dev_submitter {
+	struct vk_dev_context* context;
+	struct vk_dev_timeline* timeline;
+	VkQueue queue;
+
+	// NOTE: Producers push here; flush drains it into list.
+	struct vk_dev_mpsc submissions;
+	struct _vk_dev_submit_list list;
+
+	VkSubmitInfo* infos;
+	uint32_t info_capacity;
+
+	// NOTE: Guards the counters only; producers never take it.
+	pthread_mutex_t lock;
+	struct vk_dev_submit_stats stats;
+	uint32_t frame_submits;
+	uint32_t frame_batches;
+	uint32_t frame_command_buffers;
+};
+
+static void
+_vk_dev_submit_reserve(void** items, uint32_t* capacity, const uint32_t count,
+	const size_t size)
+{
+	void* grown;
+	uint32_t grown_capacity;
+
+	if (count <= *capacity) {
+		return;
+	}
+
+	grown_capacity = *capacity > 0 ? *capacity : VK_DEV_SUBMIT_MIN_CAPACITY;
+	while (grown_capacity < count) {
+		grown_capacity *= 2;
+	}
+
+	grown = realloc(*items, size * grown_capacity);
+	if (grown == NULL) {
+		vk_dev_fatal_error("[SUBMIT] Failed to grow submissions.");
+	}
+
+	*items = grown;
+	*capacity = grown_capacity;
+}
+
+static void
+_vk_dev_submit_list_destroy(struct _vk_dev_submit_list* list)
+{
+	free(list->stages);
+	free(list->semaphores);
+	free(list->command_buffers);
+	free(list->batches);
+}
+
+static void
+_vk_dev_submit_list_clear(struct _vk_dev_submit_list* list)
+{
+	list->batch_count = 0;
+	list->command_buffer_count = 0;
+	list->semaphore_count = 0;
+	list->submissions = 0;
+}
+
+struct vk_dev_submitter*
+vk_dev_submitter_create(struct vk_dev_context* context, VkQueue queue,
+	struct vk_dev_timeline* timeline)
+{
+	struct vk_dev_submitter* submitter;
+
+	submitter = calloc(1, sizeof(*submitter));
+	if (submitter == NULL) {
+		vk_dev_fatal_error("[SUBMIT] Failed to allocate submitter.");
+	}
+
+	submitter->context = context;
+	submitter->queue = queue;
+	submitter->timeline = timeline;
+	vk_dev_mpsc_init(&submitter->submissions);
+
+	if (pthread_mutex_init(&submitter->lock, NULL) != 0) {
+		vk_dev_fatal_error("[SUBMIT] Failed to create lock.");
+	}
+
+	return submitter;
+}
+
+void
+vk_dev_submitter_destroy(struct vk_dev_submitter* submitter)
+{
+	struct vk_dev_mpsc_node* node;
+
+	if (submitter == NULL) {
+		return;
+	}
+
+	while ((node = vk_dev_mpsc_pop(&submitter->submissions)) != NULL) {
+		free(node);
+	}
+
+	pthread_mutex_destroy(&submitter->lock);
+	_vk_dev_submit_list_destroy(&submitter->list);
+	free(submitter->infos);
+	free(submitter);
+}
+
+static void
+_vk_dev_submit_list_append(struct _vk_dev_submit_list* list,
+	const struct vk_dev_submission* submission)
+{
+	uint32_t semaphore_count, capacity;
+	struct _vk_dev_submit_batch* batch;
+
+	semaphore_count = list->semaphore_count +
+		submission->wait_semaphore_count + submission->signal_semaphore_count;
+
+	// NOTE: Both start from the same capacity, so they grow alike.
+	capacity = list->semaphore_capacity;
+	_vk_dev_submit_reserve((void**)&list->semaphores, &capacity,
+		semaphore_count, sizeof(*list->semaphores));
+	_vk_dev_submit_reserve((void**)&list->stages, &list->semaphore_capacity,
+		semaphore_count, sizeof(*list->stages));
+
+	_vk_dev_submit_reserve((void**)&list->command_buffers,
+		&list->command_buffer_capacity, list->command_buffer_count +
+		submission->command_buffer_count, sizeof(*list->command_buffers));
+
+	/*
+	 *	NOTE:	The last batch's command buffers and semaphores end their
+	 *			arrays, so extending it is a matter of appending.
+	 */
+	batch = list->batch_count > 0 ? &list->batches[list->batch_count - 1] :
+		NULL;
+	if (batch == NULL || submission->wait_semaphore_count > 0 ||
+		batch->signal_count > 0) {
+		_vk_dev_submit_reserve((void**)&list->batches, &list->batch_capacity,
+			list->batch_count + 1, sizeof(*list->batches));
+
+		batch = &list->batches[list->batch_count++];
+		batch->wait_first = list->semaphore_count;
+		batch->wait_count = submission->wait_semaphore_count;
+		batch->command_buffer_first = list->command_buffer_count;
+		batch->command_buffer_count = 0;
+		batch->signal_first = 0;
+		batch->signal_count = 0;
+
+		if (submission->wait_semaphore_count > 0) {
+			memcpy(list->semaphores + list->semaphore_count,
+				submission->wait_semaphores, sizeof(*list->semaphores) *
+				submission->wait_semaphore_count);
+			memcpy(list->stages + list->semaphore_count,
+				submission->wait_stages, sizeof(*list->stages) *
+				submission->wait_semaphore_count);
+			list->semaphore_count += submission->wait_semaphore_count;
+		}
+	}
+
+	if (submission->command_buffer_count > 0) {
+		memcpy(list->command_buffers + list->command_buffer_count,
+			submission->command_buffers, sizeof(*list->command_buffers) *
+			submission->command_buffer_count);
+		list->command_buffer_count += submission->command_buffer_count;
+		batch->command_buffer_count += submission->command_buffer_count;
+	}
+
+	if (submission->signal_semaphore_count > 0) {
+		batch->signal_first = list->semaphore_count;
+		batch->signal_count = submission->signal_semaphore_count;
+
+		memcpy(list->semaphores + list->semaphore_count,
+			submission->signal_semaphores,
+			sizeof(*list->semaphores) * submission->signal_semaphore_count);
+		list->semaphore_count += submission->signal_semaphore_count;
+	}
+
+	list->submissions++;
+}
+
+void
+vk_dev_submitter_add(struct vk_dev_submitter* submitter,
+	const struct vk_dev_submission* submission)
+{
+	size_t size;
+	VkSemaphore* semaphores;
+	VkCommandBuffer* command_buffers;
+	VkPipelineStageFlags* stages;
+	struct _vk_dev_submit_node* node;
+
+	size = sizeof(*node) + sizeof(*semaphores) *
+		(submission->wait_semaphore_count +
+		submission->signal_semaphore_count) + sizeof(*command_buffers) *
+		submission->command_buffer_count + sizeof(*stages) *
+		submission->wait_semaphore_count;
+
+	node = malloc(size);
+	if (node == NULL) {
+		vk_dev_fatal_error("[SUBMIT] Failed to allocate submission.");
+	}
+
+	// NOTE: Widest first, so each array stays aligned.
+	semaphores = (VkSemaphore*)(node + 1);
+	command_buffers = (VkCommandBuffer*)(semaphores +
+		submission->wait_semaphore_count +
+		submission->signal_semaphore_count);
+	stages = (VkPipelineStageFlags*)(command_buffers +
+		submission->command_buffer_count);
+
+	if (submission->wait_semaphore_count > 0) {
+		memcpy(semaphores, submission->wait_semaphores,
+			sizeof(*semaphores) * submission->wait_semaphore_count);
+		memcpy(stages, submission->wait_stages,
+			sizeof(*stages) * submission->wait_semaphore_count);
+	}
+
+	if (submission->signal_semaphore_count > 0) {
+		memcpy(semaphores + submission->wait_semaphore_count,
+			submission->signal_semaphores,
+			sizeof(*semaphores) * submission->signal_semaphore_count);
+	}
+
+	if (submission->command_buffer_count > 0) {
+		memcpy(command_buffers, submission->command_buffers,
+			sizeof(*command_buffers) * submission->command_buffer_count);
+	}
+
+	node->submission.wait_semaphore_count = submission->wait_semaphore_count;
+	node->submission.wait_semaphores = semaphores;
+	node->submission.wait_stages = stages;
+	node->submission.command_buffer_count = submission->command_buffer_count;
+	node->submission.command_buffers = command_buffers;
+	node->submission.signal_semaphore_count =
+		submission->signal_semaphore_count;
+	node->submission.signal_semaphores = semaphores +
+		submission->wait_semaphore_count;
+
+	vk_dev_mpsc_push(&submitter->submissions, &node->link);
+}
+
+uint64_t
+vk_dev_submitter_flush(struct vk_dev_submitter* submitter)
+{
+	uint64_t value;
+	VkFence fence;
+	VkResult result;
+	VkSubmitInfo* info;
+	struct vk_dev_mpsc_node* node;
+	struct _vk_dev_submit_list* list;
+	struct _vk_dev_submit_batch* batch;
+	struct vk_dev_context* context;
+
+	context = submitter->context;
+	list = &submitter->list;
+
+	while ((node = vk_dev_mpsc_pop(&submitter->submissions)) != NULL) {
+		_vk_dev_submit_list_append(list,
+			&((struct _vk_dev_submit_node*)node)->submission);
+		free(node);
+	}
+
+	if (list->batch_count == 0) {
+		return submitter->timeline != NULL ?
+			vk_dev_timeline_get_signalled(submitter->timeline) : 0;
+	}
+
+	VK_DEV_TRACE_BEGIN("vk_dev_submitter_flush");
+
+	_vk_dev_submit_reserve((void**)&submitter->infos,
+		&submitter->info_capacity, list->batch_count,
+		sizeof(*submitter->infos));
+
+	for (uint32_t i = 0; i < list->batch_count; i++) {
+		batch = &list->batches[i];
+		info = &submitter->infos[i];
+
+		info->sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		info->pNext = NULL;
+		info->waitSemaphoreCount = batch->wait_count;
+		info->pWaitSemaphores = list->semaphores + batch->wait_first;
+		info->pWaitDstStageMask = list->stages + batch->wait_first;
+		info->commandBufferCount = batch->command_buffer_count;
+		info->pCommandBuffers = list->command_buffers +
+			batch->command_buffer_first;
+		info->signalSemaphoreCount = batch->signal_count;
+		info->pSignalSemaphores = list->semaphores + batch->signal_first;
+	}
+
+	value = 0;
+	fence = VK_NULL_HANDLE;
+	if (submitter->timeline != NULL) {
+		fence = vk_dev_timeline_signal(submitter->timeline, &value);
+	}
+
+	result = context->vk.QueueSubmit(submitter->queue, list->batch_count,
+		submitter->infos, fence);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[SUBMIT] Failed to submit.");
+	}
+
+	pthread_mutex_lock(&submitter->lock);
+
+	submitter->stats.submissions += list->submissions;
+	submitter->stats.submits++;
+	submitter->stats.batches += list->batch_count;
+	submitter->stats.command_buffers += list->command_buffer_count;
+	if (list->command_buffer_count > submitter->stats.largest_submit) {
+		submitter->stats.largest_submit = list->command_buffer_count;
+	}
+
+	submitter->frame_submits++;
+	submitter->frame_batches += list->batch_count;
+	submitter->frame_command_buffers += list->command_buffer_count;
+
+	pthread_mutex_unlock(&submitter->lock);
+
+	_vk_dev_submit_list_clear(list);
+
+	VK_DEV_TRACE_END("vk_dev_submitter_flush");
+
+	return value;
+}
+
+uint64_t
+vk_dev_submitter_end_frame(struct vk_dev_submitter* submitter)
+{
+	uint64_t value;
+
+	value = vk_dev_submitter_flush(submitter);
+
+	pthread_mutex_lock(&submitter->lock);
+
+	submitter->stats.frames++;
+	submitter->stats.frame_submits = submitter->frame_submits;
+	submitter->stats.frame_batches = submitter->frame_batches;
+	submitter->stats.frame_command_buffers =
+		submitter->frame_command_buffers;
+
+	submitter->frame_submits = 0;
+	submitter->frame_batches = 0;
+	submitter->frame_command_buffers = 0;
+
+	pthread_mutex_unlock(&submitter->lock);
+
+	return value;
+}
+
+void
+vk_dev_submitter_get_stats(struct vk_dev_submitter* submitter,
+	struct vk_dev_submit_stats* stats)
+{
+	pthread_mutex_lock(&submitter->lock);
+	*stats = submitter->stats;
+	pthread_mutex_unlock(&submitter->lock);
+}
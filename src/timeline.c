@@ -0,0 +1,181 @@
+#include <vulkan-dev/timeline.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/trace.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+
+struct vk_dev_timeline {
+	struct vk_dev_context* context;
+
+	/*
+	 *	NOTE:	Fences in flight occupy count slots from head, oldest first;
+	 *			the others are unsignalled and free.
+	 */
+	VkFence* fences;
+	uint64_t* values;
+	uint32_t capacity;
+	uint32_t head;
+	uint32_t count;
+
+	uint64_t signalled;
+	uint64_t completed;
+};
+
+struct vk_dev_timeline*
+vk_dev_timeline_create(struct vk_dev_context* context,
+	const uint32_t capacity)
+{
+	VkResult result;
+	VkFenceCreateInfo create_info;
+	struct vk_dev_timeline* timeline;
+
+	if (capacity == 0) {
+		vk_dev_fatal_error("[TIMELINE] Capacity must not be zero.");
+	}
+
+	VK_DEV_TRACE_BEGIN("vk_dev_timeline_create");
+
+	timeline = calloc(1, sizeof(*timeline));
+	if (timeline == NULL) {
+		vk_dev_fatal_error("[TIMELINE] Failed to allocate timeline.");
+	}
+
+	timeline->context = context;
+	timeline->capacity = capacity;
+	timeline->fences = calloc(capacity, sizeof(*timeline->fences));
+	timeline->values = calloc(capacity, sizeof(*timeline->values));
+	if (timeline->fences == NULL || timeline->values == NULL) {
+		vk_dev_fatal_error("[TIMELINE] Failed to allocate fences.");
+	}
+
+	create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	create_info.pNext = NULL;
+	create_info.flags = 0;
+
+	for (uint32_t i = 0; i < capacity; i++) {
+		result = context->vk.CreateFence(context->device, &create_info, NULL,
+			&timeline->fences[i]);
+		if (result != VK_SUCCESS) {
+			vk_dev_fatal_error("[TIMELINE] Failed to create fence.");
+		}
+	}
+
+	VK_DEV_TRACE_END("vk_dev_timeline_create");
+
+	return timeline;
+}
+
+void
+vk_dev_timeline_destroy(struct vk_dev_timeline* timeline)
+{
+	struct vk_dev_context* context;
+
+	if (timeline == NULL) {
+		return;
+	}
+
+	context = timeline->context;
+
+	vk_dev_timeline_wait(timeline, timeline->signalled);
+
+	for (uint32_t i = 0; i < timeline->capacity; i++) {
+		context->vk.DestroyFence(context->device, timeline->fences[i], NULL);
+	}
+
+	free(timeline->values);
+	free(timeline->fences);
+	free(timeline);
+}
+
+static void
+_vk_dev_timeline_retire(struct vk_dev_timeline* timeline)
+{
+	struct vk_dev_context* context;
+
+	context = timeline->context;
+
+	if (context->vk.ResetFences(context->device, 1,
+		&timeline->fences[timeline->head]) != VK_SUCCESS) {
+		vk_dev_fatal_error("[TIMELINE] Failed to reset fence.");
+	}
+
+	timeline->completed = timeline->values[timeline->head];
+	timeline->head = (timeline->head + 1) % timeline->capacity;
+	timeline->count--;
+}
+
+static void
+_vk_dev_timeline_wait_oldest(struct vk_dev_timeline* timeline)
+{
+	struct vk_dev_context* context;
+
+	context = timeline->context;
+
+	if (context->vk.WaitForFences(context->device, 1,
+		&timeline->fences[timeline->head], VK_TRUE, UINT64_MAX) !=
+		VK_SUCCESS) {
+		vk_dev_fatal_error("[TIMELINE] Failed to wait for fence.");
+	}
+
+	_vk_dev_timeline_retire(timeline);
+}
+
+VkFence
+vk_dev_timeline_signal(struct vk_dev_timeline* timeline, uint64_t* value)
+{
+	uint32_t slot;
+
+	if (timeline->count == timeline->capacity) {
+		VK_DEV_TRACE_BEGIN("vk_dev_timeline_stall");
+		_vk_dev_timeline_wait_oldest(timeline);
+		VK_DEV_TRACE_END("vk_dev_timeline_stall");
+	}
+
+	slot = (timeline->head + timeline->count) % timeline->capacity;
+	timeline->values[slot] = ++timeline->signalled;
+	timeline->count++;
+
+	*value = timeline->signalled;
+
+	return timeline->fences[slot];
+}
+
+uint64_t
+vk_dev_timeline_poll(struct vk_dev_timeline* timeline)
+{
+	VkResult result;
+	struct vk_dev_context* context;
+
+	context = timeline->context;
+
+	while (timeline->count > 0) {
+		result = context->vk.GetFenceStatus(context->device,
+			timeline->fences[timeline->head]);
+		if (result == VK_NOT_READY) {
+			break;
+		}
+
+		if (result != VK_SUCCESS) {
+			vk_dev_fatal_error("[TIMELINE] Failed to query fence.");
+		}
+
+		_vk_dev_timeline_retire(timeline);
+	}
+
+	return timeline->completed;
+}
+
+void
+vk_dev_timeline_wait(struct vk_dev_timeline* timeline, const uint64_t value)
+{
+	while (timeline->completed < value && timeline->count > 0) {
+		_vk_dev_timeline_wait_oldest(timeline);
+	}
+}
+
+uint64_t
+vk_dev_timeline_get_signalled(const struct vk_dev_timeline* timeline)
+{
+	return timeline->signalled;
+}
@@ -0,0 +1,582 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <vulkan-dev/trace.h>
+#include <vulkan-dev/vulkan-dev.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+
+#define TRACE_MAGIC 0x54444b56
+#define TRACE_VERSION 1
+
+#define TRACE_CACHE_LINE 64
+#define TRACE_RING_SIZE (1 << 14)
+#define TRACE_NAME_TABLE_SIZE 4096
+#define TRACE_FLUSH_INTERVAL_NS 10000000L
+
+enum _vk_dev_trace_record_kind {
+	TRACE_RECORD_CLOCK = 1,
+	TRACE_RECORD_NAME = 2,
+	TRACE_RECORD_EVENTS = 3,
+};
+
+/*
+ *	NOTE:	The on-disk layout of an event is identical to the in-memory one,
+ *			so the flusher writes ring contents with a single fwrite. The
+ *			name is the address of the string literal and is resolved
+ *			through a NAME record written the first time it is seen.
+ */
+struct _vk_dev_trace_event {
+	uint64_t ticks;
+	uint64_t name;
+	uint32_t thread_id;
+	uint32_t phase;
+};
+
+struct _vk_dev_trace_record {
+	uint32_t kind;
+	uint32_t count;
+};
+
+struct _vk_dev_trace_clock {
+	uint64_t ticks;
+	uint64_t ns;
+};
+
+/*
+ *	NOTE:	Single producer (the owning thread), single consumer (the flusher).
+ *			The producer and consumer indices live on separate cache lines so
+ *			the hot path never contends with the flusher unless the ring is
+ *			full.
+ */
+struct _vk_dev_trace_ring {
+	uint32_t head;
+	uint32_t cached_tail;
+	uint32_t thread_id;
+	uint32_t dropped;
+	char producer_pad[TRACE_CACHE_LINE - 4 * sizeof(uint32_t)];
+
+	uint32_t tail;
+	uint32_t retired;
+	struct _vk_dev_trace_ring* next;
+	char consumer_pad[TRACE_CACHE_LINE - 2 * sizeof(uint32_t) -
+		sizeof(void*)];
+
+	struct _vk_dev_trace_event events[TRACE_RING_SIZE];
+};
+
+struct _vk_dev_trace_state {
+	FILE* file;
+	bool enabled;
+	bool running;
+	uint32_t next_thread_id;
+	uint64_t dropped;
+	pthread_t flusher;
+	pthread_key_t key;
+	pthread_once_t key_once;
+	pthread_mutex_t lock;
+	struct _vk_dev_trace_ring* rings;
+	uint64_t names[TRACE_NAME_TABLE_SIZE];
+};
+
+static __thread struct _vk_dev_trace_ring* _ring;
+static struct _vk_dev_trace_state _trace = {
+	.key_once = PTHREAD_ONCE_INIT,
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/*
+ *	NOTE:	On x86 the raw TSC is read (a handful of cycles) and converted to
+ *			nanoseconds offline using the CLOCK records bracketing the trace.
+ */
+static inline uint64_t
+_vk_dev_trace_ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif
+}
+
+static uint64_t
+_vk_dev_trace_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+static void
+_vk_dev_trace_ring_retire(void* ring)
+{
+	__atomic_store_n(&((struct _vk_dev_trace_ring*)ring)->retired, 1,
+		__ATOMIC_RELEASE);
+}
+
+static void
+_vk_dev_trace_key_create(void)
+{
+	pthread_key_create(&_trace.key, _vk_dev_trace_ring_retire);
+}
+
+static struct _vk_dev_trace_ring*
+_vk_dev_trace_ring_register(void)
+{
+	void* memory;
+	struct _vk_dev_trace_ring* ring;
+
+	if (posix_memalign(&memory, TRACE_CACHE_LINE, sizeof(*ring)) != 0) {
+		return NULL;
+	}
+
+	ring = memory;
+	memset(ring, 0, offsetof(struct _vk_dev_trace_ring, events));
+
+	pthread_once(&_trace.key_once, _vk_dev_trace_key_create);
+
+	pthread_mutex_lock(&_trace.lock);
+	ring->thread_id = ++_trace.next_thread_id;
+	ring->next = _trace.rings;
+	_trace.rings = ring;
+	pthread_mutex_unlock(&_trace.lock);
+
+	pthread_setspecific(_trace.key, ring);
+	_ring = ring;
+
+	return ring;
+}
+
+void
+vk_dev_trace_emit(const char* name, const uint32_t phase)
+{
+	uint32_t head;
+	struct _vk_dev_trace_ring* ring;
+	struct _vk_dev_trace_event* event;
+
+	if (__atomic_load_n(&_trace.enabled, __ATOMIC_RELAXED) == false) {
+		return;
+	}
+
+	ring = _ring;
+	if (ring == NULL && (ring = _vk_dev_trace_ring_register()) == NULL) {
+		return;
+	}
+
+	head = ring->head;
+	if (head - ring->cached_tail == TRACE_RING_SIZE) {
+		ring->cached_tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+		if (head - ring->cached_tail == TRACE_RING_SIZE) {
+			__atomic_store_n(&ring->dropped, ring->dropped + 1,
+				__ATOMIC_RELAXED);
+			return;
+		}
+	}
+
+	event = &ring->events[head & (TRACE_RING_SIZE - 1)];
+	event->ticks = _vk_dev_trace_ticks();
+	event->name = (uint64_t)(uintptr_t)name;
+	event->thread_id = ring->thread_id;
+	event->phase = phase;
+
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+static void
+_vk_dev_trace_write_clock(void)
+{
+	struct _vk_dev_trace_record record = {TRACE_RECORD_CLOCK, 0};
+	struct _vk_dev_trace_clock clock;
+
+	clock.ticks = _vk_dev_trace_ticks();
+	clock.ns = _vk_dev_trace_ns();
+
+	fwrite(&record, sizeof(record), 1, _trace.file);
+	fwrite(&clock, sizeof(clock), 1, _trace.file);
+}
+
+static void
+_vk_dev_trace_write_name(const uint64_t name)
+{
+	uint32_t slot;
+	struct _vk_dev_trace_record record;
+
+	slot = (uint32_t)((name >> 3) * 0x9e3779b1u) & (TRACE_NAME_TABLE_SIZE - 1);
+	for (int i = 0; i < TRACE_NAME_TABLE_SIZE; i++) {
+		if (_trace.names[slot] == name) {
+			return;
+		}
+
+		if (_trace.names[slot] == 0) {
+			_trace.names[slot] = name;
+			break;
+		}
+
+		slot = (slot + 1) & (TRACE_NAME_TABLE_SIZE - 1);
+	}
+
+	/*
+	 *	NOTE:	If the table is full the name is simply written again; the
+	 *			converter keeps the first definition it sees.
+	 */
+	record.kind = TRACE_RECORD_NAME;
+	record.count = strlen((const char*)(uintptr_t)name);
+
+	fwrite(&record, sizeof(record), 1, _trace.file);
+	fwrite(&name, sizeof(name), 1, _trace.file);
+	fwrite((const char*)(uintptr_t)name, 1, record.count, _trace.file);
+}
+
+static void
+_vk_dev_trace_drain_ring(struct _vk_dev_trace_ring* ring)
+{
+	uint32_t head, tail, count;
+	struct _vk_dev_trace_record record;
+	const struct _vk_dev_trace_event* events;
+
+	head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+	tail = ring->tail;
+
+	while (tail != head) {
+		events = &ring->events[tail & (TRACE_RING_SIZE - 1)];
+		count = head - tail;
+		if (count > TRACE_RING_SIZE - (tail & (TRACE_RING_SIZE - 1))) {
+			count = TRACE_RING_SIZE - (tail & (TRACE_RING_SIZE - 1));
+		}
+
+		for (int i = 0; i < count; i++) {
+			_vk_dev_trace_write_name(events[i].name);
+		}
+
+		record.kind = TRACE_RECORD_EVENTS;
+		record.count = count;
+		fwrite(&record, sizeof(record), 1, _trace.file);
+		fwrite(events, sizeof(*events), count, _trace.file);
+
+		tail += count;
+		__atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+	}
+}
+
+static void
+_vk_dev_trace_drain(void)
+{
+	uint32_t retired;
+	struct _vk_dev_trace_ring** link;
+	struct _vk_dev_trace_ring* ring;
+
+	pthread_mutex_lock(&_trace.lock);
+
+	link = &_trace.rings;
+	while ((ring = *link) != NULL) {
+		/*
+		 *	NOTE:	Retirement is observed before the final drain so every
+		 *			event the exiting thread published is written out.
+		 */
+		retired = __atomic_load_n(&ring->retired, __ATOMIC_ACQUIRE);
+
+		_vk_dev_trace_drain_ring(ring);
+
+		if (retired) {
+			_trace.dropped += ring->dropped;
+			*link = ring->next;
+			free(ring);
+		} else {
+			link = &ring->next;
+		}
+	}
+
+	_vk_dev_trace_write_clock();
+	fflush(_trace.file);
+
+	pthread_mutex_unlock(&_trace.lock);
+}
+
+static void*
+_vk_dev_trace_flush_thread(void* arg)
+{
+	struct timespec interval = {0, TRACE_FLUSH_INTERVAL_NS};
+
+	while (__atomic_load_n(&_trace.running, __ATOMIC_ACQUIRE)) {
+		nanosleep(&interval, NULL);
+		_vk_dev_trace_drain();
+	}
+
+	return NULL;
+}
+
+void
+vk_dev_trace_start(const char* path)
+{
+	const uint32_t header[2] = {TRACE_MAGIC, TRACE_VERSION};
+	struct _vk_dev_trace_ring* ring;
+
+	if (_trace.running) {
+		return;
+	}
+
+	_trace.file = fopen(path, "wb");
+	if (_trace.file == NULL) {
+		vk_dev_fatal_error("[TRACE] Failed to open trace file.");
+	}
+
+	fwrite(header, sizeof(header), 1, _trace.file);
+	_vk_dev_trace_write_clock();
+
+	/*
+	 *	NOTE:	Rings outlive a trace session, so anything a producer raced
+	 *			in after the previous stop is discarded here.
+	 */
+	pthread_mutex_lock(&_trace.lock);
+	memset(_trace.names, 0, sizeof(_trace.names));
+	for (ring = _trace.rings; ring != NULL; ring = ring->next) {
+		__atomic_store_n(&ring->tail,
+			__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+		__atomic_store_n(&ring->dropped, 0, __ATOMIC_RELAXED);
+	}
+	pthread_mutex_unlock(&_trace.lock);
+
+	_trace.dropped = 0;
+	__atomic_store_n(&_trace.running, true, __ATOMIC_RELEASE);
+	if (pthread_create(&_trace.flusher, NULL, _vk_dev_trace_flush_thread,
+		NULL) != 0) {
+		vk_dev_fatal_error("[TRACE] Failed to start flush thread.");
+	}
+
+	__atomic_store_n(&_trace.enabled, true, __ATOMIC_RELEASE);
+}
+
+void
+vk_dev_trace_stop(void)
+{
+	struct _vk_dev_trace_ring* ring;
+
+	if (_trace.running == false) {
+		return;
+	}
+
+	__atomic_store_n(&_trace.enabled, false, __ATOMIC_RELEASE);
+	__atomic_store_n(&_trace.running, false, __ATOMIC_RELEASE);
+	pthread_join(_trace.flusher, NULL);
+
+	_vk_dev_trace_drain();
+
+	for (ring = _trace.rings; ring != NULL; ring = ring->next) {
+		_trace.dropped += __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+	}
+
+	if (_trace.dropped != 0) {
+		fprintf(stderr, "[TRACE] %llu events dropped (ring buffer full).\n",
+			(unsigned long long)_trace.dropped);
+	}
+
+	fclose(_trace.file);
+	_trace.file = NULL;
+}
+
+struct _vk_dev_trace_name {
+	uint64_t id;
+	uint32_t length;
+	const char* string;
+};
+
+static const struct _vk_dev_trace_name*
+_vk_dev_trace_find_name(const struct _vk_dev_trace_name* names,
+	const uint32_t count, const uint64_t id)
+{
+	for (int i = 0; i < count; i++) {
+		if (names[i].id == id) {
+			return &names[i];
+		}
+	}
+
+	return NULL;
+}
+
+// NOTE: The number of bytes that follow a record header.
+static size_t
+_vk_dev_trace_payload_size(const struct _vk_dev_trace_record* record)
+{
+	if (record->kind == TRACE_RECORD_CLOCK) {
+		return sizeof(struct _vk_dev_trace_clock);
+	} else if (record->kind == TRACE_RECORD_NAME) {
+		return sizeof(uint64_t) + record->count;
+	}
+
+	return (size_t)record->count * sizeof(struct _vk_dev_trace_event);
+}
+
+/*
+ *	NOTE:	Converts a binary trace into the Chrome trace event JSON format
+ *			(chrome://tracing, Perfetto). Ticks are mapped to microseconds
+ *			using the first and last CLOCK records. Returns 0 on success.
+ */
+int
+vk_dev_trace_export_chrome(const char* trace_path, const char* json_path)
+{
+	FILE* in;
+	FILE* out;
+	char* data;
+	struct _vk_dev_trace_name* names;
+	struct _vk_dev_trace_name* grown;
+	const struct _vk_dev_trace_name* name;
+
+	long size;
+	size_t offset;
+	uint32_t header[2];
+	uint32_t name_count, name_capacity;
+	bool first_event, valid;
+	double scale;
+	struct _vk_dev_trace_record record;
+	struct _vk_dev_trace_event event;
+	struct _vk_dev_trace_clock clock, first_clock, last_clock;
+
+	static const char* const phases[] = {"B", "E", "i"};
+
+	in = fopen(trace_path, "rb");
+	if (in == NULL) {
+		return -1;
+	}
+
+	fseek(in, 0, SEEK_END);
+	size = ftell(in);
+	fseek(in, 0, SEEK_SET);
+
+	data = malloc(size);
+	if (data == NULL || size < sizeof(header) ||
+		fread(data, 1, size, in) != size) {
+		free(data);
+		fclose(in);
+		return -1;
+	}
+	fclose(in);
+
+	memcpy(header, data, sizeof(header));
+	if (header[0] != TRACE_MAGIC || header[1] != TRACE_VERSION) {
+		free(data);
+		return -1;
+	}
+
+	/*
+	 *	NOTE:	First pass collects the clock calibration and the name table,
+	 *			second pass emits the events. A record cut short by the end of
+	 *			the file fails the export, so the second pass only walks
+	 *			records the first one checked.
+	 */
+	names = NULL;
+	name_count = name_capacity = 0;
+	memset(&first_clock, 0, sizeof(first_clock));
+	last_clock = first_clock;
+	valid = true;
+	for (offset = sizeof(header); offset < size;) {
+		if (offset + sizeof(record) > size) {
+			valid = false;
+			break;
+		}
+
+		memcpy(&record, data + offset, sizeof(record));
+		offset += sizeof(record);
+
+		if (offset + _vk_dev_trace_payload_size(&record) > size) {
+			valid = false;
+			break;
+		}
+
+		if (record.kind == TRACE_RECORD_CLOCK) {
+			memcpy(&clock, data + offset, sizeof(clock));
+			if (first_clock.ticks == 0) {
+				first_clock = clock;
+			}
+			last_clock = clock;
+			offset += sizeof(clock);
+		} else if (record.kind == TRACE_RECORD_NAME) {
+			if (name_count == name_capacity) {
+				name_capacity = name_capacity ? name_capacity * 2 : 64;
+				grown = realloc(names, sizeof(*names) * name_capacity);
+				if (grown == NULL) {
+					valid = false;
+					break;
+				}
+				names = grown;
+			}
+			memcpy(&names[name_count].id, data + offset, sizeof(uint64_t));
+			names[name_count].length = record.count;
+			names[name_count].string = data + offset + sizeof(uint64_t);
+			if (_vk_dev_trace_find_name(names, name_count,
+				names[name_count].id) == NULL) {
+				name_count++;
+			}
+			offset += sizeof(uint64_t) + record.count;
+		} else {
+			offset += (size_t)record.count * sizeof(event);
+		}
+	}
+
+	if (valid == false) {
+		free(names);
+		free(data);
+		return -1;
+	}
+
+	scale = 1.0;
+	if (last_clock.ticks > first_clock.ticks) {
+		scale = (double)(last_clock.ns - first_clock.ns) /
+			(double)(last_clock.ticks - first_clock.ticks);
+	}
+
+	out = fopen(json_path, "w");
+	if (out == NULL) {
+		free(names);
+		free(data);
+		return -1;
+	}
+
+	fprintf(out, "{\"traceEvents\":[\n");
+
+	first_event = true;
+	for (offset = sizeof(header); offset + sizeof(record) <= size;) {
+		memcpy(&record, data + offset, sizeof(record));
+		offset += sizeof(record);
+
+		if (record.kind == TRACE_RECORD_CLOCK ||
+			record.kind == TRACE_RECORD_NAME) {
+			offset += _vk_dev_trace_payload_size(&record);
+			continue;
+		}
+
+		for (int i = 0; i < record.count; i++, offset += sizeof(event)) {
+			memcpy(&event, data + offset, sizeof(event));
+			if (event.phase > VK_DEV_TRACE_PHASE_INSTANT) {
+				continue;
+			}
+
+			name = _vk_dev_trace_find_name(names, name_count, event.name);
+
+			fprintf(out, "%s{\"name\":\"%.*s\",\"ph\":\"%s\",\"ts\":%.3f,"
+				"\"pid\":1,\"tid\":%u%s}", first_event ? "" : ",\n",
+				name != NULL ? (int)name->length : 0,
+				name != NULL ? name->string : "", phases[event.phase],
+				((double)(int64_t)(event.ticks - first_clock.ticks) * scale) /
+				1000.0, event.thread_id,
+				event.phase == VK_DEV_TRACE_PHASE_INSTANT ? ",\"s\":\"t\"" : "");
+			first_event = false;
+		}
+	}
+
+	fprintf(out, "\n]}\n");
+	fclose(out);
+	free(names);
+	free(data);
+
+	return 0;
+}
@@ -0,0 +1,314 @@
+#include <vulkan-dev/vertex.h>
+#include <vulkan-dev/trace.h>
+
+#include <math.h>
+#include <float.h>
+#include <string.h>
+
+#define VK_DEV_VERTEX_NONE UINT32_MAX
+
+static const float*
+_vk_dev_vertex_read(const struct vk_dev_vertex_source* source,
+	const uint32_t vertex, const enum vk_dev_vertex_attribute attribute)
+{
+	return (const float*)((const char*)source->data +
+		vertex * source->stride + source->offsets[attribute]);
+}
+
+static uint16_t
+_vk_dev_vertex_unorm16(const float value)
+{
+	if (!(value > 0.0f)) {
+		return 0;
+	}
+
+	if (value >= 1.0f) {
+		return UINT16_MAX;
+	}
+
+	return (uint16_t)(value * UINT16_MAX + 0.5f);
+}
+
+/*
+ *	NOTE:	Round to nearest even, with overflow to infinity and gradual
+ *			underflow, so UVs round trip as closely as half floats allow.
+ */
+static uint16_t
+_vk_dev_vertex_half(const float value)
+{
+	uint32_t bits, sign, exponent, mantissa, half, shift;
+
+	memcpy(&bits, &value, sizeof(bits));
+
+	sign = (bits >> 16) & 0x8000;
+	exponent = (bits >> 23) & 0xff;
+	mantissa = bits & 0x7fffff;
+
+	if (exponent == 0xff) {
+		return (uint16_t)(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));
+	}
+
+	if (exponent > 142) {
+		return (uint16_t)(sign | 0x7c00);
+	}
+
+	if (exponent < 113) {
+		if (exponent < 102) {
+			return (uint16_t)sign;
+		}
+
+		mantissa |= 0x800000;
+		shift = 126 - exponent;
+		half = mantissa >> shift;
+
+		if ((mantissa >> (shift - 1) & 1) &&
+			((mantissa & ((1u << (shift - 1)) - 1)) || (half & 1))) {
+			half++;
+		}
+
+		return (uint16_t)(sign | half);
+	}
+
+	half = ((exponent - 112) << 10) | (mantissa >> 13);
+	if ((mantissa & 0x1000) && ((mantissa & 0xfff) || (half & 1))) {
+		half++;
+	}
+
+	return (uint16_t)(sign | half);
+}
+
+/*
+ *	NOTE:	Projects a unit vector onto the octahedron |x| + |y| + |z| = 1
+ *			and folds the lower half over the upper, giving two snorm
+ *			components. Of the four neighbouring quantized points, the one
+ *			decoding closest to the input is kept.
+ */
+static void
+_vk_dev_vertex_octahedral(const float* vector, const int32_t max,
+	int32_t* encoded)
+{
+	float length, x, y, z, ox, oy, best_error, error, decoded[3];
+	int32_t cx, cy, qx, qy;
+
+	length = fabsf(vector[0]) + fabsf(vector[1]) + fabsf(vector[2]);
+	if (length == 0.0f) {
+		encoded[0] = encoded[1] = 0;
+		return;
+	}
+
+	x = vector[0] / length;
+	y = vector[1] / length;
+	z = vector[2] / length;
+
+	if (z < 0.0f) {
+		ox = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		oy = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = ox;
+		y = oy;
+	}
+
+	cx = (int32_t)floorf(x * max);
+	cy = (int32_t)floorf(y * max);
+	best_error = FLT_MAX;
+
+	for (int i = 0; i < 4; i++) {
+		qx = cx + (i & 1);
+		qy = cy + (i >> 1);
+		if (qx > max || qy > max) {
+			continue;
+		}
+
+		decoded[0] = (float)qx / max;
+		decoded[1] = (float)qy / max;
+		decoded[2] = 1.0f - fabsf(decoded[0]) - fabsf(decoded[1]);
+
+		if (decoded[2] < 0.0f) {
+			decoded[0] += decoded[0] >= 0.0f ? decoded[2] : -decoded[2];
+			decoded[1] += decoded[1] >= 0.0f ? decoded[2] : -decoded[2];
+		}
+
+		length = sqrtf(decoded[0] * decoded[0] + decoded[1] * decoded[1] +
+			decoded[2] * decoded[2]);
+
+		// NOTE: Maximizing the cosine minimizes the angular error.
+		error = -(decoded[0] * vector[0] + decoded[1] * vector[1] +
+			decoded[2] * vector[2]) / length;
+
+		if (error < best_error) {
+			best_error = error;
+			encoded[0] = qx;
+			encoded[1] = qy;
+		}
+	}
+}
+
+static void
+_vk_dev_vertex_write_octahedral(const float* vector, const VkFormat format,
+	char* destination)
+{
+	int32_t encoded[2];
+	int16_t packed16[2];
+	int8_t packed8[2];
+
+	if (format == VK_FORMAT_R16G16_SNORM) {
+		_vk_dev_vertex_octahedral(vector, INT16_MAX, encoded);
+
+		packed16[0] = (int16_t)encoded[0];
+		packed16[1] = (int16_t)encoded[1];
+		memcpy(destination, packed16, sizeof(packed16));
+	} else {
+		_vk_dev_vertex_octahedral(vector, INT8_MAX, encoded);
+
+		packed8[0] = (int8_t)encoded[0];
+		packed8[1] = (int8_t)encoded[1];
+		memcpy(destination, packed8, sizeof(packed8));
+	}
+}
+
+void
+vk_dev_vertex_format_init(const struct vk_dev_vertex_source* source,
+	const bool high_precision, struct vk_dev_vertex_format* format)
+{
+	uint32_t offset;
+	float min[3], max[3];
+	const float* position;
+
+	static const uint32_t sizes[VK_DEV_VERTEX_ATTRIBUTE_COUNT] = {
+		[VK_DEV_VERTEX_POSITION] = 8,
+		[VK_DEV_VERTEX_UV] = 4,
+		[VK_DEV_VERTEX_NORMAL] = 2,
+		[VK_DEV_VERTEX_TANGENT] = 2,
+	};
+
+	format->formats[VK_DEV_VERTEX_POSITION] = VK_FORMAT_R16G16B16A16_UNORM;
+	format->formats[VK_DEV_VERTEX_UV] = VK_FORMAT_R16G16_SFLOAT;
+	format->formats[VK_DEV_VERTEX_NORMAL] = high_precision ?
+		VK_FORMAT_R16G16_SNORM : VK_FORMAT_R8G8_SNORM;
+	format->formats[VK_DEV_VERTEX_TANGENT] =
+		format->formats[VK_DEV_VERTEX_NORMAL];
+
+	offset = 0;
+	for (int i = 0; i < VK_DEV_VERTEX_ATTRIBUTE_COUNT; i++) {
+		format->offsets[i] = VK_DEV_VERTEX_NONE;
+
+		if (i != VK_DEV_VERTEX_POSITION &&
+			source->offsets[i] == VK_DEV_VERTEX_ABSENT) {
+			continue;
+		}
+
+		format->offsets[i] = offset;
+		offset += sizes[i] * (high_precision &&
+			(i == VK_DEV_VERTEX_NORMAL || i == VK_DEV_VERTEX_TANGENT) ? 2 : 1);
+	}
+
+	// NOTE: Keep every vertex 4 byte aligned.
+	format->stride = (offset + 3) & ~3u;
+
+	for (int i = 0; i < 3; i++) {
+		min[i] = source->count > 0 ? FLT_MAX : 0.0f;
+		max[i] = source->count > 0 ? -FLT_MAX : 0.0f;
+	}
+
+	for (uint32_t v = 0; v < source->count; v++) {
+		position = _vk_dev_vertex_read(source, v, VK_DEV_VERTEX_POSITION);
+		for (int i = 0; i < 3; i++) {
+			min[i] = fminf(min[i], position[i]);
+			max[i] = fmaxf(max[i], position[i]);
+		}
+	}
+
+	for (int i = 0; i < 3; i++) {
+		format->position_offset[i] = min[i];
+		format->position_scale[i] = max[i] - min[i];
+	}
+}
+
+void
+vk_dev_vertex_quantize(const struct vk_dev_vertex_format* format,
+	const struct vk_dev_vertex_source* source, void* destination)
+{
+	char* vertex;
+	const float* input;
+	uint16_t position[4], uv[2];
+
+	VK_DEV_TRACE_BEGIN("vk_dev_vertex_quantize");
+
+	for (uint32_t v = 0; v < source->count; v++) {
+		vertex = (char*)destination + (size_t)v * format->stride;
+		memset(vertex, 0, format->stride);
+
+		input = _vk_dev_vertex_read(source, v, VK_DEV_VERTEX_POSITION);
+		for (int i = 0; i < 3; i++) {
+			position[i] = format->position_scale[i] > 0.0f ?
+				_vk_dev_vertex_unorm16((input[i] - format->position_offset[i]) /
+					format->position_scale[i]) : 0;
+		}
+
+		position[3] = UINT16_MAX;
+
+		if (format->offsets[VK_DEV_VERTEX_TANGENT] != VK_DEV_VERTEX_NONE) {
+			input = _vk_dev_vertex_read(source, v, VK_DEV_VERTEX_TANGENT);
+			position[3] = input[3] < 0.0f ? 0 : UINT16_MAX;
+
+			_vk_dev_vertex_write_octahedral(input,
+				format->formats[VK_DEV_VERTEX_TANGENT],
+				vertex + format->offsets[VK_DEV_VERTEX_TANGENT]);
+		}
+
+		memcpy(vertex + format->offsets[VK_DEV_VERTEX_POSITION], position,
+			sizeof(position));
+
+		if (format->offsets[VK_DEV_VERTEX_UV] != VK_DEV_VERTEX_NONE) {
+			input = _vk_dev_vertex_read(source, v, VK_DEV_VERTEX_UV);
+			uv[0] = _vk_dev_vertex_half(input[0]);
+			uv[1] = _vk_dev_vertex_half(input[1]);
+
+			memcpy(vertex + format->offsets[VK_DEV_VERTEX_UV], uv, sizeof(uv));
+		}
+
+		if (format->offsets[VK_DEV_VERTEX_NORMAL] != VK_DEV_VERTEX_NONE) {
+			_vk_dev_vertex_write_octahedral(
+				_vk_dev_vertex_read(source, v, VK_DEV_VERTEX_NORMAL),
+				format->formats[VK_DEV_VERTEX_NORMAL],
+				vertex + format->offsets[VK_DEV_VERTEX_NORMAL]);
+		}
+	}
+
+	VK_DEV_TRACE_END("vk_dev_vertex_quantize");
+}
+
+VkVertexInputBindingDescription
+vk_dev_vertex_get_binding(const struct vk_dev_vertex_format* format,
+	const uint32_t binding)
+{
+	VkVertexInputBindingDescription description = {
+		.binding = binding,
+		.stride = format->stride,
+		.inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+	};
+
+	return description;
+}
+
+uint32_t
+vk_dev_vertex_get_attributes(const struct vk_dev_vertex_format* format,
+	const uint32_t binding,
+	VkVertexInputAttributeDescription attributes[VK_DEV_VERTEX_ATTRIBUTE_COUNT])
+{
+	uint32_t count;
+
+	count = 0;
+	for (uint32_t i = 0; i < VK_DEV_VERTEX_ATTRIBUTE_COUNT; i++) {
+		if (format->offsets[i] == VK_DEV_VERTEX_NONE) {
+			continue;
+		}
+
+		attributes[count].location = i;
+		attributes[count].binding = binding;
+		attributes[count].format = format->formats[i];
+		attributes[count].offset = format->offsets[i];
+		count++;
+	}
+
+	return count;
+}
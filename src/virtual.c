@@ -0,0 +1,1119 @@
+#include <vulkan-dev/virtual.h>
+#include <vulkan-dev/buffer.h>
+#include <vulkan-dev/image.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/trace.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ *	NOTE:	Atlas tiles are VK_DEV_VIRTUAL_TILE_SIZE texels across, a page
+ *			of VK_DEV_VIRTUAL_TILE_SIZE - 2 * VK_DEV_VIRTUAL_BORDER texels
+ *			surrounded by a copy of its neighbours, which covers anisotropic
+ *			filtering up to 8x without sampling the next tile.
+ */
+#define VK_DEV_VIRTUAL_TILE_SIZE 128
+#define VK_DEV_VIRTUAL_BORDER 4
+#define VK_DEV_VIRTUAL_BLOCK_PAGES 64
+#define VK_DEV_VIRTUAL_LOADS_PER_FRAME 64
+
+/*
+ *	NOTE:	Page table entry of mip tail levels of a sparse image, which are
+ *			bound once at creation and own no physical page.
+ */
+#define VK_DEV_VIRTUAL_TAIL (UINT32_MAX - 1)
+
+/*
+ *	NOTE:	Layout of a frame's table, in 32-bit words; shaders/virtual.glsl
+ *			reads it with the same offsets. Page entries follow the header,
+ *			level by level and row by row, then one feedback word per page.
+ *			Level offsets are word offsets of a level's first entry and the
+ *			feedback word is the distance from an entry to its feedback.
+ */
+enum _vk_dev_virtual_header {
+	VK_DEV_VIRTUAL_HEADER_SPARSE = 0,
+	VK_DEV_VIRTUAL_HEADER_HANDLE = 1,
+	VK_DEV_VIRTUAL_HEADER_WIDTH = 2,
+	VK_DEV_VIRTUAL_HEADER_HEIGHT = 3,
+	VK_DEV_VIRTUAL_HEADER_LEVELS = 4,
+	VK_DEV_VIRTUAL_HEADER_PAGE_WIDTH = 5,
+	VK_DEV_VIRTUAL_HEADER_PAGE_HEIGHT = 6,
+	VK_DEV_VIRTUAL_HEADER_BORDER = 7,
+	VK_DEV_VIRTUAL_HEADER_TILE_SIZE = 8,
+	VK_DEV_VIRTUAL_HEADER_TILES_PER_ROW = 9,
+	VK_DEV_VIRTUAL_HEADER_ATLAS_SIZE = 10,
+	VK_DEV_VIRTUAL_HEADER_FEEDBACK = 11,
+	VK_DEV_VIRTUAL_HEADER_LEVEL_OFFSETS = 16,
+	VK_DEV_VIRTUAL_HEADER_PAGES_X = 32,
+	VK_DEV_VIRTUAL_HEADER_PAGES_Y = 48,
+	VK_DEV_VIRTUAL_HEADER_WORDS = 64
+};
+
+/*
+ *	NOTE:	reusable is the first serial at which an evicted sparse page may
+ *			take a slot again; until its retired slot is released, frames
+ *			in flight may still sample its region through the old binding.
+ */
+struct _vk_dev_virtual_page {
+	uint32_t slot;
+	uint32_t level;
+	uint32_t x;
+	uint32_t y;
+	uint64_t last_used;
+	uint64_t reusable;
+};
+
+struct _vk_dev_virtual_retired {
+	uint32_t slot;
+	uint32_t page;
+};
+
+struct _vk_dev_virtual_retired_list {
+	struct _vk_dev_virtual_retired* items;
+	uint32_t count;
+	uint32_t capacity;
+};
+
+struct vk_dev_virtual_texture {
+	struct vk_dev_context* context;
+	struct vk_dev_bindless* bindless;
+	struct vk_dev_staging* staging;
+	const struct vk_dev_asset_file* file;
+	const struct vk_dev_asset_entry* entry;
+
+	bool sparse;
+	struct vk_dev_image image;
+	VkImageView view;
+	uint32_t handle;
+	uint32_t texel_size;
+
+	uint32_t page_width;
+	uint32_t page_height;
+	uint32_t tail_level;
+	uint32_t level_offsets[VK_DEV_ASSET_MAX_LEVELS];
+	uint32_t pages_x[VK_DEV_ASSET_MAX_LEVELS];
+	uint32_t pages_y[VK_DEV_ASSET_MAX_LEVELS];
+
+	struct _vk_dev_virtual_page* pages;
+	uint32_t page_count;
+
+	/*
+	 *	NOTE:	Physical pages. In the atlas the first tail_count slots hold
+	 *			the mip tail; in sparse mode slot s is page s % BLOCK_PAGES of
+	 *			memory block s / BLOCK_PAGES, allocated on first use.
+	 */
+	uint32_t* slot_pages;
+	uint32_t* free_slots;
+	uint32_t slot_count;
+	uint32_t free_count;
+	uint32_t page_capacity;
+	uint32_t resident_count;
+
+	uint32_t tiles_per_row;
+	uint32_t atlas_size;
+
+	VkDeviceMemory* blocks;
+	uint32_t block_count;
+	uint32_t memory_type;
+	VkDeviceSize page_bytes;
+	VkDeviceMemory tail_memory;
+	VkDeviceSize tail_bytes;
+	VkSemaphore bound;
+
+	VkSparseImageMemoryBind* binds;
+	uint32_t bind_count;
+	uint32_t bind_capacity;
+
+	uint32_t* loads;
+	void* scratch;
+
+	// NOTE: Per frame: the table buffer, its bindless handle and retirees.
+	struct vk_dev_buffer* tables;
+	uint32_t* table_handles;
+	struct _vk_dev_virtual_retired_list* retired;
+	uint32_t frame_count;
+	uint64_t serial;
+
+	uint64_t load_total;
+	uint64_t evictions;
+	uint64_t bind_batches;
+};
+
+static uint32_t
+_vk_dev_virtual_extent(const uint32_t size, const uint32_t level)
+{
+	return size >> level > 0 ? size >> level : 1;
+}
+
+static uint32_t
+_vk_dev_virtual_clamp(const int64_t value, const uint32_t size)
+{
+	if (value < 0) {
+		return 0;
+	}
+
+	return value >= size ? size - 1 : (uint32_t)value;
+}
+
+/*
+ *	NOTE:	Sparse residency needs the features, a queue that can bind and
+ *			a format the device can make sparse, and then only standard
+ *			color-only requirements are handled; anything else takes the
+ *			atlas path.
+ */
+static bool
+_vk_dev_virtual_supports_sparse(const struct vk_dev_context* context,
+	const VkFormat format)
+{
+	uint32_t count;
+
+	if (!context->features.sparseBinding ||
+		!context->features.sparseResidencyImage2D ||
+		!(context->queue_flags & VK_QUEUE_SPARSE_BINDING_BIT)) {
+		return false;
+	}
+
+	count = 0;
+	context->vk.GetPhysicalDeviceSparseImageFormatProperties(
+		context->physical_device, format, VK_IMAGE_TYPE_2D,
+		VK_SAMPLE_COUNT_1_BIT,
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+		VK_IMAGE_TILING_OPTIMAL, &count, NULL);
+
+	return count > 0;
+}
+
+static void
+_vk_dev_virtual_submit_binds(struct vk_dev_virtual_texture* texture,
+	const VkSparseImageOpaqueMemoryBindInfo* opaque)
+{
+	VkResult result;
+	VkBindSparseInfo bind_info;
+	VkSparseImageMemoryBindInfo image_info;
+	struct vk_dev_context* context;
+
+	if (texture->bind_count == 0 && opaque == NULL) {
+		return;
+	}
+
+	VK_DEV_TRACE_BEGIN("vk_dev_virtual_texture_bind");
+
+	context = texture->context;
+
+	image_info.image = texture->image.image;
+	image_info.bindCount = texture->bind_count;
+	image_info.pBinds = texture->binds;
+
+	bind_info.sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO;
+	bind_info.pNext = NULL;
+	bind_info.waitSemaphoreCount = 0;
+	bind_info.pWaitSemaphores = NULL;
+	bind_info.bufferBindCount = 0;
+	bind_info.pBufferBinds = NULL;
+	bind_info.imageOpaqueBindCount = opaque != NULL ? 1 : 0;
+	bind_info.pImageOpaqueBinds = opaque;
+	bind_info.imageBindCount = texture->bind_count > 0 ? 1 : 0;
+	bind_info.pImageBinds = &image_info;
+	bind_info.signalSemaphoreCount = 1;
+	bind_info.pSignalSemaphores = &texture->bound;
+
+	/*
+	 *	NOTE:	Binding is not ordered against command buffer submissions on
+	 *			the same queue, so the next staging submission, which holds
+	 *			the uploads into the new pages, waits for it on the GPU.
+	 */
+	result = context->vk.QueueBindSparse(context->queue, 1, &bind_info,
+		VK_NULL_HANDLE);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[VIRTUAL] Failed to bind sparse memory.");
+	}
+
+	vk_dev_staging_wait(texture->staging, texture->bound,
+		VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+	texture->bind_count = 0;
+	texture->bind_batches++;
+
+	VK_DEV_TRACE_END("vk_dev_virtual_texture_bind");
+}
+
+/*
+ *	NOTE:	Queues binding page to slot's memory, or unbinding it when slot
+ *			is VK_DEV_VIRTUAL_PAGE_NONE.
+ */
+static void
+_vk_dev_virtual_bind(struct vk_dev_virtual_texture* texture,
+	const uint32_t page, const uint32_t slot)
+{
+	uint32_t block, level_width, level_height;
+	VkSparseImageMemoryBind* bind;
+	const struct _vk_dev_virtual_page* info;
+	VkMemoryAllocateInfo allocate_info;
+
+	info = &texture->pages[page];
+
+	if (texture->bind_count == texture->bind_capacity) {
+		texture->bind_capacity = texture->bind_capacity > 0 ?
+			texture->bind_capacity * 2 : 64;
+		texture->binds = realloc(texture->binds,
+			sizeof(*texture->binds) * texture->bind_capacity);
+		if (texture->binds == NULL) {
+			vk_dev_fatal_error("[VIRTUAL] Failed to allocate binds.");
+		}
+	}
+
+	level_width = _vk_dev_virtual_extent(texture->image.width, info->level);
+	level_height = _vk_dev_virtual_extent(texture->image.height,
+		info->level);
+
+	bind = &texture->binds[texture->bind_count++];
+	bind->subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	bind->subresource.mipLevel = info->level;
+	bind->subresource.arrayLayer = 0;
+	bind->offset.x = info->x * texture->page_width;
+	bind->offset.y = info->y * texture->page_height;
+	bind->offset.z = 0;
+	bind->extent.width = level_width - bind->offset.x < texture->page_width ?
+		level_width - bind->offset.x : texture->page_width;
+	bind->extent.height = level_height - bind->offset.y <
+		texture->page_height ?
+		level_height - bind->offset.y : texture->page_height;
+	bind->extent.depth = 1;
+	bind->memory = VK_NULL_HANDLE;
+	bind->memoryOffset = 0;
+	bind->flags = 0;
+
+	if (slot == VK_DEV_VIRTUAL_PAGE_NONE) {
+		return;
+	}
+
+	block = slot / VK_DEV_VIRTUAL_BLOCK_PAGES;
+	if (texture->blocks[block] == VK_NULL_HANDLE) {
+		allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocate_info.pNext = NULL;
+		allocate_info.allocationSize =
+			texture->page_bytes * VK_DEV_VIRTUAL_BLOCK_PAGES;
+		allocate_info.memoryTypeIndex = texture->memory_type;
+
+		if (texture->context->vk.AllocateMemory(texture->context->device,
+			&allocate_info, NULL, &texture->blocks[block]) != VK_SUCCESS) {
+			vk_dev_fatal_error("[VIRTUAL] Failed to allocate page block.");
+		}
+	}
+
+	bind->memory = texture->blocks[block];
+	bind->memoryOffset = (VkDeviceSize)(slot % VK_DEV_VIRTUAL_BLOCK_PAGES) *
+		texture->page_bytes;
+}
+
+/*
+ *	NOTE:	Copies a width by height region of level, starting border
+ *			texels above and left of (x, y), into the scratch buffer.
+ *			Texels outside the level repeat its edge, as clamp to edge
+ *			addressing would.
+ */
+static void
+_vk_dev_virtual_gather(const struct vk_dev_virtual_texture* texture,
+	const uint32_t level, const uint32_t x, const uint32_t y,
+	const uint32_t width, const uint32_t height, const uint32_t border)
+{
+	char* destination;
+	const char* source;
+	const char* row;
+	int64_t left, first, last;
+	uint32_t level_width, level_height, texel;
+	const struct vk_dev_asset_texture* info;
+
+	info = &texture->entry->info.texture;
+	source = (const char*)vk_dev_asset_get_data(texture->file,
+		texture->entry) + info->level_offsets[level];
+	destination = texture->scratch;
+	texel = texture->texel_size;
+
+	level_width = _vk_dev_virtual_extent(info->width, level);
+	level_height = _vk_dev_virtual_extent(info->height, level);
+
+	left = (int64_t)x - border;
+	first = left > 0 ? left : 0;
+	last = left + width < level_width ? left + width : level_width;
+
+	for (uint32_t i = 0; i < height; i++) {
+		row = source + (size_t)_vk_dev_virtual_clamp((int64_t)y - border + i,
+			level_height) * level_width * texel;
+
+		for (int64_t j = left; j < first; j++) {
+			memcpy(destination, row, texel);
+			destination += texel;
+		}
+
+		memcpy(destination, row + first * texel, (last - first) * texel);
+		destination += (last - first) * texel;
+
+		for (int64_t j = last; j < left + width; j++) {
+			memcpy(destination, row + (size_t)(level_width - 1) * texel,
+				texel);
+			destination += texel;
+		}
+	}
+}
+
+static void
+_vk_dev_virtual_upload(struct vk_dev_virtual_texture* texture,
+	const uint32_t page)
+{
+	uint32_t level_width, level_height;
+	VkOffset2D offset;
+	VkExtent2D extent;
+	const struct _vk_dev_virtual_page* info;
+
+	info = &texture->pages[page];
+
+	if (texture->sparse) {
+		level_width = _vk_dev_virtual_extent(texture->image.width,
+			info->level);
+		level_height = _vk_dev_virtual_extent(texture->image.height,
+			info->level);
+
+		offset.x = info->x * texture->page_width;
+		offset.y = info->y * texture->page_height;
+		extent.width = level_width - offset.x < texture->page_width ?
+			level_width - offset.x : texture->page_width;
+		extent.height = level_height - offset.y < texture->page_height ?
+			level_height - offset.y : texture->page_height;
+
+		_vk_dev_virtual_gather(texture, info->level, offset.x, offset.y,
+			extent.width, extent.height, 0);
+		vk_dev_staging_upload_image_region(texture->staging, &texture->image,
+			info->level, offset, extent, texture->scratch,
+			(VkDeviceSize)extent.width * extent.height * texture->texel_size);
+	} else {
+		offset.x = info->slot % texture->tiles_per_row *
+			VK_DEV_VIRTUAL_TILE_SIZE;
+		offset.y = info->slot / texture->tiles_per_row *
+			VK_DEV_VIRTUAL_TILE_SIZE;
+		extent.width = VK_DEV_VIRTUAL_TILE_SIZE;
+		extent.height = VK_DEV_VIRTUAL_TILE_SIZE;
+
+		_vk_dev_virtual_gather(texture, info->level,
+			info->x * texture->page_width, info->y * texture->page_height,
+			VK_DEV_VIRTUAL_TILE_SIZE, VK_DEV_VIRTUAL_TILE_SIZE,
+			VK_DEV_VIRTUAL_BORDER);
+		vk_dev_staging_upload_image_region(texture->staging, &texture->image,
+			0, offset, extent, texture->scratch,
+			(VkDeviceSize)VK_DEV_VIRTUAL_TILE_SIZE * VK_DEV_VIRTUAL_TILE_SIZE *
+			texture->texel_size);
+	}
+}
+
+/*
+ *	NOTE:	Creates the sparse image and binds its mip tail. Returns false,
+ *			with nothing left behind, if the device's requirements for it
+ *			are not ones handled here.
+ */
+static bool
+_vk_dev_virtual_create_sparse(struct vk_dev_virtual_texture* texture)
+{
+	uint32_t count, color;
+	VkResult result;
+	VkImageCreateInfo create_info;
+	VkMemoryRequirements requirements;
+	VkSparseImageMemoryRequirements* sparse_requirements;
+	VkMemoryAllocateInfo allocate_info;
+	VkSparseMemoryBind tail_bind;
+	VkSparseImageOpaqueMemoryBindInfo tail_info;
+	struct vk_dev_context* context;
+	const struct vk_dev_asset_texture* info;
+
+	context = texture->context;
+	info = &texture->entry->info.texture;
+
+	create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	create_info.pNext = NULL;
+	create_info.flags = VK_IMAGE_CREATE_SPARSE_BINDING_BIT |
+		VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT;
+	create_info.imageType = VK_IMAGE_TYPE_2D;
+	create_info.format = (VkFormat)info->format;
+	create_info.extent.width = info->width;
+	create_info.extent.height = info->height;
+	create_info.extent.depth = 1;
+	create_info.mipLevels = info->levels;
+	create_info.arrayLayers = 1;
+	create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+	create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+	create_info.usage = VK_IMAGE_USAGE_SAMPLED_BIT |
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	create_info.queueFamilyIndexCount = 0;
+	create_info.pQueueFamilyIndices = NULL;
+	create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	result = context->vk.CreateImage(context->device, &create_info, NULL,
+		&texture->image.image);
+	if (result != VK_SUCCESS) {
+		return false;
+	}
+
+	context->vk.GetImageMemoryRequirements(context->device,
+		texture->image.image, &requirements);
+
+	count = 0;
+	context->vk.GetImageSparseMemoryRequirements(context->device,
+		texture->image.image, &count, NULL);
+
+	sparse_requirements = malloc(sizeof(*sparse_requirements) *
+		(count > 0 ? count : 1));
+	if (sparse_requirements == NULL) {
+		vk_dev_fatal_error("[VIRTUAL] Failed to allocate requirements.");
+	}
+
+	context->vk.GetImageSparseMemoryRequirements(context->device,
+		texture->image.image, &count, sparse_requirements);
+
+	// NOTE: Formats needing metadata (multi-aspect compression) are left out.
+	color = count;
+	for (uint32_t i = 0; i < count; i++) {
+		if (sparse_requirements[i].formatProperties.aspectMask !=
+			VK_IMAGE_ASPECT_COLOR_BIT) {
+			color = count;
+			break;
+		}
+
+		color = i;
+	}
+
+	if (color == count) {
+		free(sparse_requirements);
+		context->vk.DestroyImage(context->device, texture->image.image, NULL);
+		return false;
+	}
+
+	texture->page_width =
+		sparse_requirements[color].formatProperties.imageGranularity.width;
+	texture->page_height =
+		sparse_requirements[color].formatProperties.imageGranularity.height;
+	texture->tail_level = sparse_requirements[color].imageMipTailFirstLod <
+		info->levels ? sparse_requirements[color].imageMipTailFirstLod :
+		info->levels;
+	texture->page_bytes = requirements.alignment;
+	texture->memory_type = vk_dev_find_memory_type(context,
+		requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	texture->image.memory = VK_NULL_HANDLE;
+	texture->image.format = (VkFormat)info->format;
+	texture->image.width = info->width;
+	texture->image.height = info->height;
+	texture->image.levels = info->levels;
+
+	texture->tail_memory = VK_NULL_HANDLE;
+	texture->tail_bytes = 0;
+
+	if (texture->tail_level < info->levels) {
+		texture->tail_bytes = sparse_requirements[color].imageMipTailSize;
+
+		allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocate_info.pNext = NULL;
+		allocate_info.allocationSize = texture->tail_bytes;
+		allocate_info.memoryTypeIndex = texture->memory_type;
+
+		result = context->vk.AllocateMemory(context->device, &allocate_info,
+			NULL, &texture->tail_memory);
+		if (result != VK_SUCCESS) {
+			vk_dev_fatal_error("[VIRTUAL] Failed to allocate mip tail.");
+		}
+
+		tail_bind.resourceOffset =
+			sparse_requirements[color].imageMipTailOffset;
+		tail_bind.size = texture->tail_bytes;
+		tail_bind.memory = texture->tail_memory;
+		tail_bind.memoryOffset = 0;
+		tail_bind.flags = 0;
+
+		tail_info.image = texture->image.image;
+		tail_info.bindCount = 1;
+		tail_info.pBinds = &tail_bind;
+
+		_vk_dev_virtual_submit_binds(texture, &tail_info);
+	}
+
+	free(sparse_requirements);
+
+	return true;
+}
+
+static void
+_vk_dev_virtual_create_atlas(struct vk_dev_virtual_texture* texture,
+	const uint32_t tail_count)
+{
+	uint32_t tiles;
+	const struct vk_dev_asset_texture* info;
+
+	info = &texture->entry->info.texture;
+
+	tiles = texture->page_capacity + tail_count;
+	texture->tiles_per_row = 1;
+	while (texture->tiles_per_row * texture->tiles_per_row < tiles) {
+		texture->tiles_per_row++;
+	}
+
+	texture->atlas_size = texture->tiles_per_row * VK_DEV_VIRTUAL_TILE_SIZE;
+	if (texture->atlas_size >
+		texture->context->properties.limits.maxImageDimension2D) {
+		vk_dev_fatal_error("[VIRTUAL] Page capacity exceeds the atlas size.");
+	}
+
+	vk_dev_image_create(texture->context, texture->atlas_size,
+		texture->atlas_size, 1, (VkFormat)info->format,
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+		&texture->image);
+}
+
+/*
+ *	NOTE:	Lays out the page table: every level above the tail is split
+ *			into pages, each tail level is a single page.
+ */
+static void
+_vk_dev_virtual_create_pages(struct vk_dev_virtual_texture* texture)
+{
+	uint32_t page, width, height;
+	const struct vk_dev_asset_texture* info;
+
+	info = &texture->entry->info.texture;
+
+	texture->page_count = 0;
+	for (uint32_t i = 0; i < info->levels; i++) {
+		width = _vk_dev_virtual_extent(info->width, i);
+		height = _vk_dev_virtual_extent(info->height, i);
+
+		texture->level_offsets[i] = texture->page_count;
+		if (i < texture->tail_level) {
+			texture->pages_x[i] = (width + texture->page_width - 1) /
+				texture->page_width;
+			texture->pages_y[i] = (height + texture->page_height - 1) /
+				texture->page_height;
+		} else {
+			texture->pages_x[i] = 1;
+			texture->pages_y[i] = 1;
+		}
+
+		texture->page_count += texture->pages_x[i] * texture->pages_y[i];
+	}
+
+	texture->pages = malloc(sizeof(*texture->pages) * texture->page_count);
+	if (texture->pages == NULL) {
+		vk_dev_fatal_error("[VIRTUAL] Failed to allocate page table.");
+	}
+
+	for (uint32_t i = 0; i < info->levels; i++) {
+		for (uint32_t y = 0; y < texture->pages_y[i]; y++) {
+			for (uint32_t x = 0; x < texture->pages_x[i]; x++) {
+				page = texture->level_offsets[i] + y * texture->pages_x[i] + x;
+
+				texture->pages[page].slot = VK_DEV_VIRTUAL_PAGE_NONE;
+				texture->pages[page].level = i;
+				texture->pages[page].x = x;
+				texture->pages[page].y = y;
+				texture->pages[page].last_used = 0;
+				texture->pages[page].reusable = 0;
+			}
+		}
+	}
+}
+
+static void
+_vk_dev_virtual_write_header(const struct vk_dev_virtual_texture* texture,
+	uint32_t* table)
+{
+	const struct vk_dev_asset_texture* info;
+
+	info = &texture->entry->info.texture;
+
+	memset(table, 0, sizeof(*table) * VK_DEV_VIRTUAL_HEADER_WORDS);
+
+	table[VK_DEV_VIRTUAL_HEADER_SPARSE] = texture->sparse ? 1 : 0;
+	table[VK_DEV_VIRTUAL_HEADER_HANDLE] = texture->handle;
+	table[VK_DEV_VIRTUAL_HEADER_WIDTH] = info->width;
+	table[VK_DEV_VIRTUAL_HEADER_HEIGHT] = info->height;
+	table[VK_DEV_VIRTUAL_HEADER_LEVELS] = info->levels;
+	table[VK_DEV_VIRTUAL_HEADER_PAGE_WIDTH] = texture->page_width;
+	table[VK_DEV_VIRTUAL_HEADER_PAGE_HEIGHT] = texture->page_height;
+	table[VK_DEV_VIRTUAL_HEADER_BORDER] = VK_DEV_VIRTUAL_BORDER;
+	table[VK_DEV_VIRTUAL_HEADER_TILE_SIZE] = VK_DEV_VIRTUAL_TILE_SIZE;
+	table[VK_DEV_VIRTUAL_HEADER_TILES_PER_ROW] = texture->tiles_per_row;
+	table[VK_DEV_VIRTUAL_HEADER_ATLAS_SIZE] = texture->atlas_size;
+	table[VK_DEV_VIRTUAL_HEADER_FEEDBACK] = texture->page_count;
+
+	for (uint32_t i = 0; i < info->levels; i++) {
+		table[VK_DEV_VIRTUAL_HEADER_LEVEL_OFFSETS + i] =
+			VK_DEV_VIRTUAL_HEADER_WORDS + texture->level_offsets[i];
+		table[VK_DEV_VIRTUAL_HEADER_PAGES_X + i] = texture->pages_x[i];
+		table[VK_DEV_VIRTUAL_HEADER_PAGES_Y + i] = texture->pages_y[i];
+	}
+}
+
+/*
+ *	NOTE:	Makes the mip tail resident for good: in the atlas every tail
+ *			level takes one of the first tiles, in a sparse image the tail
+ *			memory is already bound and the levels are uploaded whole.
+ */
+static void
+_vk_dev_virtual_load_tail(struct vk_dev_virtual_texture* texture)
+{
+	uint32_t page, slot;
+	VkOffset2D offset;
+	VkExtent2D extent;
+	const struct vk_dev_asset_texture* info;
+
+	info = &texture->entry->info.texture;
+
+	slot = 0;
+	for (uint32_t i = texture->tail_level; i < info->levels; i++) {
+		page = texture->level_offsets[i];
+
+		if (texture->sparse) {
+			texture->pages[page].slot = VK_DEV_VIRTUAL_TAIL;
+
+			offset.x = 0;
+			offset.y = 0;
+			extent.width = _vk_dev_virtual_extent(info->width, i);
+			extent.height = _vk_dev_virtual_extent(info->height, i);
+
+			vk_dev_staging_upload_image_region(texture->staging,
+				&texture->image, i, offset, extent,
+				(const char*)vk_dev_asset_get_data(texture->file,
+				texture->entry) + info->level_offsets[i],
+				info->level_sizes[i]);
+		} else {
+			texture->pages[page].slot = slot;
+			texture->slot_pages[slot++] = page;
+
+			_vk_dev_virtual_upload(texture, page);
+		}
+	}
+}
+
+struct vk_dev_virtual_texture*
+vk_dev_virtual_texture_create(struct vk_dev_context* context,
+	struct vk_dev_bindless* bindless, struct vk_dev_staging* staging,
+	const struct vk_dev_asset_file* file,
+	const struct vk_dev_asset_entry* entry, const uint32_t page_capacity,
+	const uint32_t frame_count)
+{
+	uint32_t tail_count, tail_slots, table_words;
+	uint32_t* table;
+	VkResult result;
+	VkSemaphoreCreateInfo semaphore_info;
+	struct vk_dev_virtual_texture* texture;
+	const struct vk_dev_asset_texture* info;
+
+	if (entry->kind != VK_DEV_ASSET_TEXTURE) {
+		vk_dev_fatal_error("[VIRTUAL] Entry is not a texture.");
+	}
+
+	info = &entry->info.texture;
+	if (info->level_sizes[0] % ((uint64_t)info->width * info->height) != 0 ||
+		info->level_sizes[0] / ((uint64_t)info->width * info->height) == 0) {
+		vk_dev_fatal_error("[VIRTUAL] Compressed formats are not supported.");
+	}
+
+	// NOTE: Shaders record the pages they want from the fragment stage.
+	if (!context->features.fragmentStoresAndAtomics) {
+		vk_dev_fatal_error("[VIRTUAL] Device cannot store from fragment "
+			"shaders.");
+	}
+
+	VK_DEV_TRACE_BEGIN("vk_dev_virtual_texture_create");
+
+	texture = calloc(1, sizeof(*texture));
+	if (texture == NULL) {
+		vk_dev_fatal_error("[VIRTUAL] Failed to allocate virtual texture.");
+	}
+
+	texture->context = context;
+	texture->bindless = bindless;
+	texture->staging = staging;
+	texture->file = file;
+	texture->entry = entry;
+	texture->page_capacity = page_capacity;
+	texture->frame_count = frame_count;
+	texture->texel_size = (uint32_t)(info->level_sizes[0] /
+		((uint64_t)info->width * info->height));
+
+	semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphore_info.pNext = NULL;
+	semaphore_info.flags = 0;
+
+	result = context->vk.CreateSemaphore(context->device, &semaphore_info,
+		NULL, &texture->bound);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[VIRTUAL] Failed to create semaphore.");
+	}
+
+	texture->sparse = _vk_dev_virtual_supports_sparse(context,
+		(VkFormat)info->format) && _vk_dev_virtual_create_sparse(texture);
+
+	if (!texture->sparse) {
+		texture->page_width = VK_DEV_VIRTUAL_TILE_SIZE -
+			2 * VK_DEV_VIRTUAL_BORDER;
+		texture->page_height = texture->page_width;
+
+		texture->tail_level = 0;
+		while (texture->tail_level + 1 < info->levels &&
+			(_vk_dev_virtual_extent(info->width, texture->tail_level) >
+			texture->page_width ||
+			_vk_dev_virtual_extent(info->height, texture->tail_level) >
+			texture->page_height)) {
+			texture->tail_level++;
+		}
+	}
+
+	tail_count = info->levels - texture->tail_level;
+	tail_slots = texture->sparse ? 0 : tail_count;
+
+	if (!texture->sparse) {
+		_vk_dev_virtual_create_atlas(texture, tail_count);
+	}
+
+	_vk_dev_virtual_create_pages(texture);
+
+	texture->slot_count = page_capacity + tail_slots;
+	texture->block_count = texture->sparse ?
+		(page_capacity + VK_DEV_VIRTUAL_BLOCK_PAGES - 1) /
+		VK_DEV_VIRTUAL_BLOCK_PAGES : 0;
+
+	texture->slot_pages = malloc(sizeof(*texture->slot_pages) *
+		(texture->slot_count > 0 ? texture->slot_count : 1));
+	texture->free_slots = malloc(sizeof(*texture->free_slots) *
+		(texture->slot_count > 0 ? texture->slot_count : 1));
+	texture->blocks = calloc(texture->block_count > 0 ?
+		texture->block_count : 1, sizeof(*texture->blocks));
+	texture->loads = malloc(sizeof(*texture->loads) * texture->page_count);
+	texture->scratch = malloc((size_t)VK_DEV_VIRTUAL_TILE_SIZE *
+		VK_DEV_VIRTUAL_TILE_SIZE * texture->texel_size +
+		(size_t)texture->page_width * texture->page_height *
+		texture->texel_size);
+	texture->tables = calloc(frame_count, sizeof(*texture->tables));
+	texture->table_handles = calloc(frame_count,
+		sizeof(*texture->table_handles));
+	texture->retired = calloc(frame_count, sizeof(*texture->retired));
+	if (texture->slot_pages == NULL || texture->free_slots == NULL ||
+		texture->blocks == NULL || texture->loads == NULL ||
+		texture->scratch == NULL || texture->tables == NULL ||
+		texture->table_handles == NULL || texture->retired == NULL) {
+		vk_dev_fatal_error("[VIRTUAL] Failed to allocate virtual texture.");
+	}
+
+	// NOTE: Popped from the back, so blocks fill up in order.
+	for (uint32_t i = 0; i < texture->slot_count; i++) {
+		texture->slot_pages[i] = VK_DEV_VIRTUAL_PAGE_NONE;
+	}
+
+	for (uint32_t i = tail_slots; i < texture->slot_count; i++) {
+		texture->free_slots[texture->free_count++] =
+			texture->slot_count - 1 - (i - tail_slots);
+	}
+
+	vk_dev_staging_prepare_image(staging, &texture->image);
+	_vk_dev_virtual_load_tail(texture);
+	vk_dev_staging_flush(staging);
+
+	texture->view = vk_dev_image_view_create(context, &texture->image, 0,
+		texture->image.levels);
+	texture->handle = vk_dev_bindless_add_texture(bindless, texture->view,
+		VK_IMAGE_LAYOUT_GENERAL);
+
+	table_words = VK_DEV_VIRTUAL_HEADER_WORDS + texture->page_count * 2;
+
+	for (uint32_t i = 0; i < frame_count; i++) {
+		vk_dev_buffer_create(context, sizeof(uint32_t) * table_words,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &texture->tables[i]);
+
+		table = texture->tables[i].mapped;
+		_vk_dev_virtual_write_header(texture, table);
+
+		for (uint32_t j = 0; j < texture->page_count; j++) {
+			table[VK_DEV_VIRTUAL_HEADER_WORDS + j] = texture->pages[j].slot;
+			table[VK_DEV_VIRTUAL_HEADER_WORDS + texture->page_count + j] = 0;
+		}
+
+		texture->table_handles[i] = vk_dev_bindless_add_buffer(bindless,
+			texture->tables[i].buffer, 0, VK_WHOLE_SIZE);
+	}
+
+	VK_DEV_TRACE_END("vk_dev_virtual_texture_create");
+
+	return texture;
+}
+
+void
+vk_dev_virtual_texture_destroy(struct vk_dev_virtual_texture* texture)
+{
+	struct vk_dev_context* context;
+
+	if (texture == NULL) {
+		return;
+	}
+
+	context = texture->context;
+
+	for (uint32_t i = 0; i < texture->frame_count; i++) {
+		free(texture->retired[i].items);
+
+		vk_dev_bindless_remove(texture->bindless, VK_DEV_BINDLESS_BUFFER,
+			texture->table_handles[i]);
+		vk_dev_buffer_destroy(context, &texture->tables[i]);
+	}
+
+	vk_dev_bindless_remove(texture->bindless, VK_DEV_BINDLESS_TEXTURE,
+		texture->handle);
+	context->vk.DestroyImageView(context->device, texture->view, NULL);
+
+	if (texture->sparse) {
+		context->vk.DestroyImage(context->device, texture->image.image, NULL);
+
+		for (uint32_t i = 0; i < texture->block_count; i++) {
+			if (texture->blocks[i] != VK_NULL_HANDLE) {
+				context->vk.FreeMemory(context->device, texture->blocks[i],
+					NULL);
+			}
+		}
+
+		if (texture->tail_memory != VK_NULL_HANDLE) {
+			context->vk.FreeMemory(context->device, texture->tail_memory,
+				NULL);
+		}
+	} else {
+		vk_dev_image_destroy(context, &texture->image);
+	}
+
+	context->vk.DestroySemaphore(context->device, texture->bound, NULL);
+
+	free(texture->retired);
+	free(texture->table_handles);
+	free(texture->tables);
+	free(texture->scratch);
+	free(texture->loads);
+	free(texture->binds);
+	free(texture->blocks);
+	free(texture->free_slots);
+	free(texture->slot_pages);
+	free(texture->pages);
+	free(texture);
+}
+
+/*
+ *	NOTE:	Takes the least recently used page not sampled in the last
+ *			completed frame off the page table. Its physical page is freed
+ *			frame_count frames later, once no frame in flight can sample it.
+ */
+static void
+_vk_dev_virtual_evict(struct vk_dev_virtual_texture* texture,
+	const uint32_t frame)
+{
+	uint32_t victim, page;
+	struct _vk_dev_virtual_retired_list* list;
+
+	victim = VK_DEV_VIRTUAL_PAGE_NONE;
+	for (uint32_t i = 0; i < texture->slot_count; i++) {
+		page = texture->slot_pages[i];
+		if (page == VK_DEV_VIRTUAL_PAGE_NONE ||
+			texture->pages[page].level >= texture->tail_level ||
+			texture->pages[page].slot != i ||
+			texture->pages[page].last_used == texture->serial) {
+			continue;
+		}
+
+		if (victim == VK_DEV_VIRTUAL_PAGE_NONE ||
+			texture->pages[page].last_used <
+			texture->pages[victim].last_used) {
+			victim = page;
+		}
+	}
+
+	if (victim == VK_DEV_VIRTUAL_PAGE_NONE) {
+		return;
+	}
+
+	list = &texture->retired[frame];
+	if (list->count == list->capacity) {
+		list->capacity = list->capacity > 0 ? list->capacity * 2 : 16;
+		list->items = realloc(list->items,
+			sizeof(*list->items) * list->capacity);
+		if (list->items == NULL) {
+			vk_dev_fatal_error("[VIRTUAL] Failed to allocate retire list.");
+		}
+	}
+
+	list->items[list->count].slot = texture->pages[victim].slot;
+	list->items[list->count].page = victim;
+	list->count++;
+
+	texture->pages[victim].slot = VK_DEV_VIRTUAL_PAGE_NONE;
+	texture->resident_count--;
+	texture->evictions++;
+
+	// NOTE: Atlas tiles are not shared, so only sparse pages have to wait.
+	if (texture->sparse) {
+		texture->pages[victim].reusable = UINT64_MAX;
+	}
+}
+
+static void
+_vk_dev_virtual_release(struct vk_dev_virtual_texture* texture,
+	const uint32_t frame)
+{
+	struct _vk_dev_virtual_retired* retired;
+	struct _vk_dev_virtual_retired_list* list;
+
+	list = &texture->retired[frame];
+	for (uint32_t i = 0; i < list->count; i++) {
+		retired = &list->items[i];
+
+		/*
+		 *	NOTE:	The page is loaded again at the earliest next frame, so
+		 *			its unbind and rebind never share a batch.
+		 */
+		if (texture->sparse) {
+			_vk_dev_virtual_bind(texture, retired->page,
+				VK_DEV_VIRTUAL_PAGE_NONE);
+			texture->pages[retired->page].reusable = texture->serial + 1;
+		}
+
+		texture->slot_pages[retired->slot] = VK_DEV_VIRTUAL_PAGE_NONE;
+		texture->free_slots[texture->free_count++] = retired->slot;
+	}
+
+	list->count = 0;
+}
+
+void
+vk_dev_virtual_texture_begin_frame(struct vk_dev_virtual_texture* texture,
+	const uint32_t frame)
+{
+	uint32_t page, slot, request_count, load_count, attempts;
+	uint32_t* table;
+	uint32_t* feedback;
+	const struct vk_dev_asset_texture* info;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_virtual_texture_begin_frame");
+
+	info = &texture->entry->info.texture;
+
+	texture->serial++;
+
+	_vk_dev_virtual_release(texture, frame);
+
+	/*
+	 *	NOTE:	The frame that last used this table has finished, so its
+	 *			feedback is complete. Missing pages are requested coarsest
+	 *			level first, so a page never waits behind finer ones it
+	 *			would stand in for.
+	 */
+	table = texture->tables[frame].mapped;
+	feedback = table + VK_DEV_VIRTUAL_HEADER_WORDS + texture->page_count;
+
+	request_count = 0;
+	for (uint32_t i = info->levels; i-- > 0;) {
+		for (uint32_t j = 0; j < texture->pages_x[i] * texture->pages_y[i];
+			j++) {
+			page = texture->level_offsets[i] + j;
+			if (feedback[page] == 0) {
+				continue;
+			}
+
+			feedback[page] = 0;
+			texture->pages[page].last_used = texture->serial;
+
+			if (texture->pages[page].slot == VK_DEV_VIRTUAL_PAGE_NONE &&
+				texture->pages[page].reusable <= texture->serial) {
+				texture->loads[request_count++] = page;
+			}
+		}
+	}
+
+	/*
+	 *	NOTE:	A request that finds no free physical page evicts one
+	 *			instead; the page it frees only comes back frame_count
+	 *			frames later, so the request is left to be made again.
+	 */
+	load_count = 0;
+	attempts = request_count < VK_DEV_VIRTUAL_LOADS_PER_FRAME ?
+		request_count : VK_DEV_VIRTUAL_LOADS_PER_FRAME;
+
+	for (uint32_t i = 0; i < attempts; i++) {
+		page = texture->loads[i];
+
+		if (texture->free_count == 0) {
+			_vk_dev_virtual_evict(texture, frame);
+			continue;
+		}
+
+		slot = texture->free_slots[--texture->free_count];
+		texture->pages[page].slot = slot;
+		texture->slot_pages[slot] = page;
+		texture->resident_count++;
+
+		if (texture->sparse) {
+			_vk_dev_virtual_bind(texture, page, slot);
+		}
+
+		texture->loads[load_count++] = page;
+	}
+
+	if (texture->sparse) {
+		_vk_dev_virtual_submit_binds(texture, NULL);
+	}
+
+	for (uint32_t i = 0; i < load_count; i++) {
+		_vk_dev_virtual_upload(texture, texture->loads[i]);
+	}
+
+	texture->load_total += load_count;
+
+	for (uint32_t i = 0; i < texture->page_count; i++) {
+		table[VK_DEV_VIRTUAL_HEADER_WORDS + i] = texture->pages[i].slot;
+	}
+
+	vk_dev_staging_flush(texture->staging);
+
+	VK_DEV_TRACE_END("vk_dev_virtual_texture_begin_frame");
+}
+
+uint32_t
+vk_dev_virtual_texture_get_table(const struct vk_dev_virtual_texture* texture,
+	const uint32_t frame)
+{
+	return texture->table_handles[frame];
+}
+
+void
+vk_dev_virtual_texture_get_stats(
+	const struct vk_dev_virtual_texture* texture,
+	struct vk_dev_virtual_texture_stats* stats)
+{
+	uint32_t blocks;
+
+	stats->sparse = texture->sparse;
+	stats->page_width = texture->page_width;
+	stats->page_height = texture->page_height;
+	stats->page_capacity = texture->page_capacity;
+	stats->resident_pages = texture->resident_count;
+	stats->loads = texture->load_total;
+	stats->evictions = texture->evictions;
+	stats->bind_batches = texture->bind_batches;
+
+	if (texture->sparse) {
+		blocks = 0;
+		for (uint32_t i = 0; i < texture->block_count; i++) {
+			blocks += texture->blocks[i] != VK_NULL_HANDLE ? 1 : 0;
+		}
+
+		stats->committed_bytes = texture->tail_bytes + blocks *
+			VK_DEV_VIRTUAL_BLOCK_PAGES * texture->page_bytes;
+	} else {
+		stats->committed_bytes = (VkDeviceSize)texture->atlas_size *
+			texture->atlas_size * texture->texel_size;
+	}
+}
@@ -1,22 +1,63 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/trace.h>
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdbool.h>
+#include <time.h>
+#include <dlfcn.h>
+#include <pthread.h>
 
 #include <glad/vulkan.h>
 
 #define ARRAY_SIZE(x) (sizeof(x)/sizeof(*x))
 
-struct vk_dev_context {
-	VkDevice device;
-	VkInstance instance;
+/*
+ *	NOTE:	The default context backs the vk_dev_setup family of functions.
+ *			It additionally loads glad's global entry points for application
+ *			code that calls vk* directly; contexts from vk_dev_context_create
+ *			never touch glad.
+ */
+static struct vk_dev_context* _context;
+
+static bool _setup_pending;
+static pthread_t _setup_thread;
+
+static const char* const _phase_names[VK_DEV_SETUP_PHASE_COUNT] = {
+	"dlopen",
+	"symbol resolution",
+	"extension enumeration",
+	"instance creation",
+	"device enumeration",
+	"device creation",
 };
 
-static VkResult _result;
-static struct vk_dev_context _context;
+/*
+ *	NOTE:	Device extensions vk_dev subsystems can make use of. Each one is
+ *			enabled only when the device reports it, and its flag in
+ *			context->extensions records the outcome.
+ */
+static const struct {
+	const char* name;
+	size_t offset;
+} _optional_device_extensions[] = {
+	{"VK_KHR_swapchain", offsetof(struct vk_dev_extensions, swapchain)},
+	{"VK_KHR_maintenance3", offsetof(struct vk_dev_extensions, maintenance3)},
+	{"VK_EXT_descriptor_indexing",
+		offsetof(struct vk_dev_extensions, descriptor_indexing)},
+	{"VK_KHR_push_descriptor",
+		offsetof(struct vk_dev_extensions, push_descriptor)},
+	{"VK_KHR_draw_indirect_count",
+		offsetof(struct vk_dev_extensions, draw_indirect_count)},
+	{"VK_EXT_memory_budget",
+		offsetof(struct vk_dev_extensions, memory_budget)},
+};
 
 static const char* const _required_extensions[2] = {
 	"VK_KHR_surface",
@@ -54,36 +95,123 @@ _vk_dev_found_required_extensions(char** extensions,
 	return extension_found[0] && extension_found[1];
 }
 
+static uint64_t
+_vk_dev_time_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+static void
+_vk_dev_phase_begin(struct vk_dev_context* context,
+	const enum vk_dev_setup_phase phase)
+{
+	VK_DEV_TRACE_BEGIN(_phase_names[phase]);
+	context->phase_start = _vk_dev_time_ns();
+}
+
+/*
+ *	NOTE:	Phases accumulate, since symbol resolution happens once for each
+ *			of the global, instance and device levels.
+ */
+static void
+_vk_dev_phase_end(struct vk_dev_context* context,
+	const enum vk_dev_setup_phase phase)
+{
+	context->timings.phase_ns[phase] += _vk_dev_time_ns() -
+		context->phase_start;
+	VK_DEV_TRACE_END(_phase_names[phase]);
+}
+
+static void
+_vk_dev_library_load(struct vk_dev_context* context)
+{
+	context->library = dlopen("libvulkan.so.1", RTLD_NOW | RTLD_LOCAL);
+	if (context->library == NULL) {
+		context->library = dlopen("libvulkan.so", RTLD_NOW | RTLD_LOCAL);
+	}
+	if (context->library == NULL) {
+		vk_dev_fatal_error("[VULKAN] Failed to open the Vulkan loader.");
+	}
+}
+
+/*
+ *	NOTE:	vkGetInstanceProcAddr is the only symbol taken from the library
+ *			directly, everything else is resolved through it.
+ */
+static void
+_vk_dev_global_functions_load(struct vk_dev_context* context)
+{
+	*(void**)&context->vk.GetInstanceProcAddr = dlsym(context->library,
+		"vkGetInstanceProcAddr");
+	if (context->vk.GetInstanceProcAddr == NULL) {
+		vk_dev_fatal_error("[VULKAN] Failed to resolve vkGetInstanceProcAddr.");
+	}
+
+#define VK_DEV_LOAD(name) \
+	context->vk.name = (PFN_vk##name)context->vk.GetInstanceProcAddr(NULL, \
+		"vk" #name);
+	VK_DEV_GLOBAL_FUNCTIONS(VK_DEV_LOAD)
+#undef VK_DEV_LOAD
+}
+
+static void
+_vk_dev_instance_functions_load(struct vk_dev_context* context)
+{
+#define VK_DEV_LOAD(name) \
+	context->vk.name = (PFN_vk##name)context->vk.GetInstanceProcAddr( \
+		context->instance, "vk" #name);
+	VK_DEV_INSTANCE_FUNCTIONS(VK_DEV_LOAD)
+#undef VK_DEV_LOAD
+}
+
+static void
+_vk_dev_device_functions_load(struct vk_dev_context* context)
+{
+#define VK_DEV_LOAD(name) \
+	context->vk.name = (PFN_vk##name)context->vk.GetDeviceProcAddr( \
+		context->device, "vk" #name);
+	VK_DEV_DEVICE_FUNCTIONS(VK_DEV_LOAD)
+#undef VK_DEV_LOAD
+}
+
 /*
  *	NOTE:	It's imperative that you initialize all members of a structs
  *			passed into the API since it is entirely feasable that vulkan
  *			will attempt to use uninitialized data and crash without warning.
  */
 
+/*
+ *	NOTE:	The returned names point into extension_properties, which must
+ *			stay alive until the instance has been created.
+ */
 static void
-_vk_dev_get_instance_extensions(char*** extensions,
-	uint32_t* extension_count)
+_vk_dev_get_instance_extensions(struct vk_dev_context* context,
+	char*** extensions, uint32_t* extension_count,
+	VkExtensionProperties** extension_properties)
 {
-	VkExtensionProperties* extension_properties;
+	VkResult result;
 
-	_result = vkEnumerateInstanceExtensionProperties(NULL,
+	result = context->vk.EnumerateInstanceExtensionProperties(NULL,
 		extension_count, NULL);
-	if (_result != VK_SUCCESS || extension_count == 0) {
+	if (result != VK_SUCCESS || extension_count == 0) {
 		vk_dev_fatal_error("[VULKAN] Failed to query instance extension count.");
 	}
 
-	extension_properties = malloc(sizeof(*extension_properties) *
+	*extension_properties = malloc(sizeof(*(*extension_properties)) *
 		*extension_count);
 
-	_result = vkEnumerateInstanceExtensionProperties(NULL, extension_count,
-		extension_properties);
-	if (_result != VK_SUCCESS) {
+	result = context->vk.EnumerateInstanceExtensionProperties(NULL,
+		extension_count, *extension_properties);
+	if (result != VK_SUCCESS) {
 		vk_dev_fatal_error("[VULKAN] Failed to query instance extensions.");
 	}
 
 	*extensions = malloc(sizeof(*(*extensions)) * *extension_count);
 	for (int i = 0; i < *extension_count; i++) {
-		(*extensions)[i] = extension_properties[i].extensionName;
+		(*extensions)[i] = (*extension_properties)[i].extensionName;
 	}
 
 	if (_vk_dev_found_required_extensions(*extensions,
@@ -91,18 +219,18 @@ _vk_dev_get_instance_extensions(char*** extensions,
 		vk_dev_fatal_error("[VULKAN] Query failed to find required platform\
 			instance extensions.");
 	}
-
-	free(extension_properties);
 }
 
 static VkPhysicalDevice
-_vk_dev_find_physical_device_of_type(const VkPhysicalDevice* physical_devices,
-	const uint32_t device_count, const VkPhysicalDeviceType device_type)
+_vk_dev_find_physical_device_of_type(struct vk_dev_context* context,
+	const VkPhysicalDevice* physical_devices, const uint32_t device_count,
+	const VkPhysicalDeviceType device_type)
 {
 	VkPhysicalDeviceProperties device_properties;
 
 	for (int i = 0; i < device_count; i++) {
-		vkGetPhysicalDeviceProperties(physical_devices[i], &device_properties);
+		context->vk.GetPhysicalDeviceProperties(physical_devices[i],
+			&device_properties);
 
 		if (device_properties.deviceType == device_type) {
 			return physical_devices[i];
@@ -112,34 +240,68 @@ _vk_dev_find_physical_device_of_type(const VkPhysicalDevice* physical_devices,
 	return VK_NULL_HANDLE;
 }
 
+/*
+ *	NOTE:	A negative device_index picks the best device by type, otherwise
+ *			the device at that position in enumeration order is used.
+ */
 static VkPhysicalDevice
-_vk_dev_get_physical_device(void)
+_vk_dev_get_physical_device(struct vk_dev_context* context,
+	const int32_t device_index)
 {
 	VkPhysicalDevice* physical_devices;
 
+	VkResult result;
 	uint32_t device_count;
 	VkPhysicalDevice physical_device;
 
-	_result = vkEnumeratePhysicalDevices(_context.instance, &device_count, NULL);
-	if (_result != VK_SUCCESS || device_count == 0) {
+	VK_DEV_TRACE_BEGIN("vk_dev_get_physical_device");
+
+	result = context->vk.EnumeratePhysicalDevices(context->instance,
+		&device_count, NULL);
+	if (result != VK_SUCCESS || device_count == 0) {
 		vk_dev_fatal_error("[VULKAN] Failed to query physical device count.");
 	}
 
 	physical_devices = malloc(sizeof(*physical_devices) * device_count);
 
-	_result = vkEnumeratePhysicalDevices(_context.instance, &device_count,
-		physical_devices);
-	if (_result != VK_SUCCESS) {
+	result = context->vk.EnumeratePhysicalDevices(context->instance,
+		&device_count, physical_devices);
+	if (result != VK_SUCCESS) {
 		vk_dev_fatal_error("[VULKAN] Failed to query physical devices.");
 	}
 
+	context->physical_device_count = device_count;
+
 	physical_device = VK_NULL_HANDLE;
 
-	physical_device = _vk_dev_find_physical_device_of_type(physical_devices,
-		device_count, VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU);
+	if (device_index >= 0) {
+		if (device_index >= device_count) {
+			vk_dev_fatal_error("[VULKAN] Physical device index out of range.");
+		}
+
+		physical_device = physical_devices[device_index];
+		free(physical_devices);
+
+		VK_DEV_TRACE_END("vk_dev_get_physical_device");
+
+		return physical_device;
+	}
+
+	physical_device = _vk_dev_find_physical_device_of_type(context,
+		physical_devices, device_count, VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU);
+	if (physical_device == VK_NULL_HANDLE) {
+		physical_device = _vk_dev_find_physical_device_of_type(context,
+			physical_devices, device_count,
+			VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU);
+	}
+
+	/*
+	 *	NOTE:	Software rasterizers (lavapipe, swiftshader) report as CPU
+	 *			devices and are only picked when nothing else is present.
+	 */
 	if (physical_device == VK_NULL_HANDLE) {
-		physical_device = _vk_dev_find_physical_device_of_type(physical_devices,
-			device_count, VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU);
+		physical_device = _vk_dev_find_physical_device_of_type(context,
+			physical_devices, device_count, VK_PHYSICAL_DEVICE_TYPE_CPU);
 		if (physical_device == VK_NULL_HANDLE) {
 			vk_dev_fatal_error("[VULKAN] No suitable physical device found.");
 		}
@@ -147,18 +309,23 @@ _vk_dev_get_physical_device(void)
 
 	free(physical_devices);
 
+	VK_DEV_TRACE_END("vk_dev_get_physical_device");
+
 	return physical_device;
 }
 
 static void
-_vk_dev_instance_create(void)
+_vk_dev_instance_create(struct vk_dev_context* context)
 {
 	char** extensions;
+	VkExtensionProperties* extension_properties;
 
+	VkResult result;
 	uint32_t extension_count;
 	VkApplicationInfo application_info;
 	VkInstanceCreateInfo create_info;
-	VkPhysicalDevice physical_device;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_instance_create");
 
 	/*
 	 * 	NOTE:	An optional structure to provide context to the drivers
@@ -177,7 +344,10 @@ _vk_dev_instance_create(void)
 	 * this function retrieves available instance extensions, as well as checks
 	 * if the required extensions have been queried
 	 */
-	_vk_dev_get_instance_extensions(&extensions, &extension_count);
+	_vk_dev_phase_begin(context, VK_DEV_SETUP_PHASE_EXTENSION_ENUMERATION);
+	_vk_dev_get_instance_extensions(context, &extensions, &extension_count,
+		&extension_properties);
+	_vk_dev_phase_end(context, VK_DEV_SETUP_PHASE_EXTENSION_ENUMERATION);
 
 	/*
 	 * NOTE: A non-optional stucture to global extensions and validation layers
@@ -191,36 +361,522 @@ _vk_dev_instance_create(void)
 	create_info.enabledExtensionCount = extension_count;
 	create_info.ppEnabledExtensionNames = (const char* const*)extensions;
 
+	_vk_dev_phase_begin(context, VK_DEV_SETUP_PHASE_INSTANCE_CREATION);
+	result = context->vk.CreateInstance(&create_info, NULL,
+		&context->instance);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[VULKAN] Failed to create instance (check ICD).");
+	}
+	_vk_dev_phase_end(context, VK_DEV_SETUP_PHASE_INSTANCE_CREATION);
+
 	free(extensions);
+	free(extension_properties);
 
-	_result = vkCreateInstance(&create_info, NULL, &_context.instance);
-	if (_result != VK_SUCCESS) {
-		vk_dev_fatal_error("[VULKAN] Failed to create instance (check ICD).");
+	VK_DEV_TRACE_END("vk_dev_instance_create");
+}
+
+static uint32_t
+_vk_dev_find_queue_family(struct vk_dev_context* context,
+	const VkQueueFlags flags, VkQueueFlags* family_flags)
+{
+	VkQueueFamilyProperties* families;
+
+	uint32_t family, family_count;
+
+	context->vk.GetPhysicalDeviceQueueFamilyProperties(
+		context->physical_device, &family_count, NULL);
+
+	families = malloc(sizeof(*families) * family_count);
+	context->vk.GetPhysicalDeviceQueueFamilyProperties(
+		context->physical_device, &family_count, families);
+
+	for (family = 0; family < family_count; family++) {
+		if ((families[family].queueFlags & flags) == flags) {
+			*family_flags = families[family].queueFlags;
+			break;
+		}
+	}
+
+	free(families);
+
+	if (family == family_count) {
+		vk_dev_fatal_error("[VULKAN] No suitable queue family found.");
+	}
+
+	return family;
+}
+
+static uint32_t
+_vk_dev_get_device_extensions(struct vk_dev_context* context,
+	const char** names)
+{
+	VkExtensionProperties* extension_properties;
+
+	VkResult result;
+	uint32_t extension_count, name_count;
+
+	result = context->vk.EnumerateDeviceExtensionProperties(
+		context->physical_device, NULL, &extension_count, NULL);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[VULKAN] Failed to query device extension count.");
+	}
+
+	extension_properties = malloc(sizeof(*extension_properties) *
+		extension_count);
+
+	result = context->vk.EnumerateDeviceExtensionProperties(
+		context->physical_device, NULL, &extension_count,
+		extension_properties);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[VULKAN] Failed to query device extensions.");
+	}
+
+	name_count = 0;
+	for (int i = 0; i < ARRAY_SIZE(_optional_device_extensions); i++) {
+		for (int j = 0; j < extension_count; j++) {
+			if (strcmp(extension_properties[j].extensionName,
+				_optional_device_extensions[i].name) == 0) {
+				*(bool*)((char*)&context->extensions +
+					_optional_device_extensions[i].offset) = true;
+				names[name_count++] = _optional_device_extensions[i].name;
+				break;
+			}
+		}
+	}
+
+	free(extension_properties);
+
+	return name_count;
+}
+
+/*
+ *	NOTE:	Only features a subsystem relies on are enabled, and only when
+ *			supported; enabling everything the device offers (notably
+ *			robustBufferAccess) has a real cost on some drivers.
+ */
+static void
+_vk_dev_select_device_features(struct vk_dev_context* context,
+	VkPhysicalDeviceFeatures2* features)
+{
+	VkPhysicalDeviceFeatures2 query;
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexing;
+
+	memset(&indexing, 0, sizeof(indexing));
+	indexing.sType =
+		VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
+	query.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	query.pNext = context->extensions.descriptor_indexing ? &indexing : NULL;
+	context->vk.GetPhysicalDeviceFeatures2(context->physical_device, &query);
+
+	memset(&context->features, 0, sizeof(context->features));
+	context->features.multiDrawIndirect = query.features.multiDrawIndirect;
+	context->features.drawIndirectFirstInstance =
+		query.features.drawIndirectFirstInstance;
+	context->features.shaderStorageImageWriteWithoutFormat =
+		query.features.shaderStorageImageWriteWithoutFormat;
+	context->features.shaderStorageImageArrayDynamicIndexing =
+		query.features.shaderStorageImageArrayDynamicIndexing;
+	context->features.sparseBinding = query.features.sparseBinding;
+	context->features.sparseResidencyImage2D =
+		query.features.sparseResidencyImage2D;
+	context->features.textureCompressionBC =
+		query.features.textureCompressionBC;
+	context->features.fragmentStoresAndAtomics =
+		query.features.fragmentStoresAndAtomics;
+
+	memset(&context->descriptor_indexing, 0,
+		sizeof(context->descriptor_indexing));
+	context->descriptor_indexing.sType =
+		VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+	context->descriptor_indexing.shaderSampledImageArrayNonUniformIndexing =
+		indexing.shaderSampledImageArrayNonUniformIndexing;
+	context->descriptor_indexing.shaderStorageBufferArrayNonUniformIndexing =
+		indexing.shaderStorageBufferArrayNonUniformIndexing;
+	context->descriptor_indexing.descriptorBindingSampledImageUpdateAfterBind =
+		indexing.descriptorBindingSampledImageUpdateAfterBind;
+	context->descriptor_indexing.descriptorBindingStorageBufferUpdateAfterBind =
+		indexing.descriptorBindingStorageBufferUpdateAfterBind;
+	context->descriptor_indexing.descriptorBindingUpdateUnusedWhilePending =
+		indexing.descriptorBindingUpdateUnusedWhilePending;
+	context->descriptor_indexing.descriptorBindingPartiallyBound =
+		indexing.descriptorBindingPartiallyBound;
+	context->descriptor_indexing.runtimeDescriptorArray =
+		indexing.runtimeDescriptorArray;
+
+	features->sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features->pNext = context->extensions.descriptor_indexing ?
+		&context->descriptor_indexing : NULL;
+	features->features = context->features;
+}
+
+/*
+ *	NOTE:	Extension property structs are chained in only when their
+ *			extension is enabled, and unchained again afterwards so the
+ *			copies kept in the context never point at stack memory.
+ */
+static void
+_vk_dev_get_device_properties(struct vk_dev_context* context)
+{
+	void** next;
+	VkPhysicalDeviceProperties2 properties;
+
+	context->vk.GetPhysicalDeviceMemoryProperties(context->physical_device,
+		&context->memory_properties);
+
+	memset(&context->descriptor_indexing_properties, 0,
+		sizeof(context->descriptor_indexing_properties));
+	context->descriptor_indexing_properties.sType =
+		VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+
+	memset(&context->push_descriptor_properties, 0,
+		sizeof(context->push_descriptor_properties));
+	context->push_descriptor_properties.sType =
+		VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PUSH_DESCRIPTOR_PROPERTIES_KHR;
+
+	properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties.pNext = NULL;
+	next = &properties.pNext;
+
+	if (context->extensions.descriptor_indexing) {
+		*next = &context->descriptor_indexing_properties;
+		next = &context->descriptor_indexing_properties.pNext;
+	}
+
+	if (context->extensions.push_descriptor) {
+		*next = &context->push_descriptor_properties;
+		next = &context->push_descriptor_properties.pNext;
+	}
+
+	context->vk.GetPhysicalDeviceProperties2(context->physical_device,
+		&properties);
+
+	context->properties = properties.properties;
+	context->descriptor_indexing_properties.pNext = NULL;
+	context->push_descriptor_properties.pNext = NULL;
+}
+
+static void
+_vk_dev_device_create(struct vk_dev_context* context)
+{
+	const char* extensions[ARRAY_SIZE(_optional_device_extensions)];
+
+	VkResult result;
+	float queue_priority;
+	VkDeviceQueueCreateInfo queue_info;
+	VkDeviceCreateInfo create_info;
+	VkPhysicalDeviceFeatures2 features;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_device_create");
+
+	context->queue_family = _vk_dev_find_queue_family(context,
+		VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT,
+		&context->queue_flags);
+
+	queue_priority = 1.0f;
+
+	queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+	queue_info.pNext = NULL;
+	queue_info.flags = 0;
+	queue_info.queueFamilyIndex = context->queue_family;
+	queue_info.queueCount = 1;
+	queue_info.pQueuePriorities = &queue_priority;
+
+	/*
+	 *	NOTE:	Features are passed through VkPhysicalDeviceFeatures2 in the
+	 *			pNext chain, so pEnabledFeatures must stay NULL.
+	 */
+	create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	create_info.pNext = &features;
+	create_info.flags = 0;
+	create_info.queueCreateInfoCount = 1;
+	create_info.pQueueCreateInfos = &queue_info;
+	create_info.enabledLayerCount = 0;
+	create_info.ppEnabledLayerNames = NULL;
+	create_info.enabledExtensionCount = _vk_dev_get_device_extensions(context,
+		extensions);
+	create_info.ppEnabledExtensionNames = extensions;
+	create_info.pEnabledFeatures = NULL;
+
+	_vk_dev_select_device_features(context, &features);
+	_vk_dev_get_device_properties(context);
+
+	result = context->vk.CreateDevice(context->physical_device, &create_info,
+		NULL, &context->device);
+	if (result != VK_SUCCESS) {
+		vk_dev_fatal_error("[VULKAN] Failed to create logical device.");
 	}
 
-	physical_device = _vk_dev_get_physical_device();
+	context->descriptor_indexing.pNext = NULL;
+
+	_vk_dev_device_functions_load(context);
+
+	context->vk.GetDeviceQueue(context->device, context->queue_family, 0,
+		&context->queue);
+
+	VK_DEV_TRACE_END("vk_dev_device_create");
+}
+
+static void
+_vk_dev_device_destroy(struct vk_dev_context* context)
+{
+	VK_DEV_TRACE_BEGIN("vk_dev_device_destroy");
+	context->vk.DeviceWaitIdle(context->device);
+	context->vk.DestroyDevice(context->device, NULL);
+	VK_DEV_TRACE_END("vk_dev_device_destroy");
 }
 
 static void
-_vk_dev_instance_destroy(void)
+_vk_dev_instance_destroy(struct vk_dev_context* context)
+{
+	VK_DEV_TRACE_BEGIN("vk_dev_instance_destroy");
+	context->vk.DestroyInstance(context->instance, NULL);
+	VK_DEV_TRACE_END("vk_dev_instance_destroy");
+}
+
+struct vk_dev_context*
+vk_dev_context_create(const int32_t device_index)
+{
+	struct vk_dev_context* context;
+
+	VK_DEV_TRACE_BEGIN("vk_dev_context_create");
+
+	context = calloc(1, sizeof(*context));
+	if (context == NULL) {
+		vk_dev_fatal_error("[VULKAN] Failed to allocate context.");
+	}
+
+	context->timings.total_ns = _vk_dev_time_ns();
+
+	_vk_dev_phase_begin(context, VK_DEV_SETUP_PHASE_DLOPEN);
+	_vk_dev_library_load(context);
+	_vk_dev_phase_end(context, VK_DEV_SETUP_PHASE_DLOPEN);
+
+	_vk_dev_phase_begin(context, VK_DEV_SETUP_PHASE_SYMBOL_RESOLUTION);
+	_vk_dev_global_functions_load(context);
+	_vk_dev_phase_end(context, VK_DEV_SETUP_PHASE_SYMBOL_RESOLUTION);
+
+	_vk_dev_instance_create(context);
+
+	_vk_dev_phase_begin(context, VK_DEV_SETUP_PHASE_SYMBOL_RESOLUTION);
+	_vk_dev_instance_functions_load(context);
+	_vk_dev_phase_end(context, VK_DEV_SETUP_PHASE_SYMBOL_RESOLUTION);
+
+	_vk_dev_phase_begin(context, VK_DEV_SETUP_PHASE_DEVICE_ENUMERATION);
+	context->physical_device = _vk_dev_get_physical_device(context,
+		device_index);
+	_vk_dev_phase_end(context, VK_DEV_SETUP_PHASE_DEVICE_ENUMERATION);
+
+	_vk_dev_phase_begin(context, VK_DEV_SETUP_PHASE_DEVICE_CREATION);
+	_vk_dev_device_create(context);
+	_vk_dev_phase_end(context, VK_DEV_SETUP_PHASE_DEVICE_CREATION);
+
+	context->timings.total_ns = _vk_dev_time_ns() - context->timings.total_ns;
+
+	VK_DEV_TRACE_END("vk_dev_context_create");
+
+	return context;
+}
+
+void
+vk_dev_context_destroy(struct vk_dev_context* context)
+{
+	VK_DEV_TRACE_BEGIN("vk_dev_context_destroy");
+
+	if (context->surface != VK_NULL_HANDLE) {
+		context->vk.DestroySurfaceKHR(context->instance, context->surface,
+			NULL);
+	}
+
+	_vk_dev_device_destroy(context);
+	_vk_dev_instance_destroy(context);
+
+	dlclose(context->library);
+	free(context);
+
+	VK_DEV_TRACE_END("vk_dev_context_destroy");
+}
+
+uint32_t
+vk_dev_context_get_physical_device_count(const struct vk_dev_context* context)
+{
+	return context->physical_device_count;
+}
+
+void
+vk_dev_context_get_setup_timings(const struct vk_dev_context* context,
+	struct vk_dev_setup_timings* timings)
 {
-	vkDestroyInstance(_context.instance, NULL);
+	*timings = context->timings;
+}
+
+/*
+ *	NOTE:	The surface is created by the windowing library against the
+ *			context's instance and handed over here; the context owns it
+ *			from then on and destroys it along with itself.
+ */
+void
+vk_dev_context_set_surface(struct vk_dev_context* context,
+	VkSurfaceKHR surface)
+{
+	VkResult result;
+	VkBool32 supported;
+
+	result = context->vk.GetPhysicalDeviceSurfaceSupportKHR(
+		context->physical_device, context->queue_family, surface, &supported);
+	if (result != VK_SUCCESS || supported == VK_FALSE) {
+		vk_dev_fatal_error("[VULKAN] Queue family cannot present to surface.");
+	}
+
+	context->surface = surface;
+}
+
+/*
+ *	NOTE:	Setting VK_DEV_TRACE=<file> records a CPU trace from setup until
+ *			terminate. If VK_DEV_TRACE_CHROME=<file> is also set, the trace
+ *			is converted to Chrome trace JSON on terminate.
+ */
+static void
+_vk_dev_setup(void)
+{
+#if !defined(VK_DEV_TRACE_DISABLE)
+	if (getenv("VK_DEV_TRACE") != NULL) {
+		vk_dev_trace_start(getenv("VK_DEV_TRACE"));
+	}
+#endif
+
+	VK_DEV_TRACE_BEGIN("vk_dev_setup");
+
+	_context = vk_dev_context_create(-1);
+
+	_vk_dev_phase_begin(_context, VK_DEV_SETUP_PHASE_SYMBOL_RESOLUTION);
+	if (gladLoaderLoadVulkan(_context->instance, _context->physical_device,
+		_context->device) == 0) {
+		vk_dev_fatal_error("[VULKAN] Failed to load global entry points.");
+	}
+	_vk_dev_phase_end(_context, VK_DEV_SETUP_PHASE_SYMBOL_RESOLUTION);
+	_context->timings.total_ns += _vk_dev_time_ns() - _context->phase_start;
+
+	if (getenv("VK_DEV_SETUP_TIMINGS") != NULL) {
+		vk_dev_print_setup_timings(stderr);
+	}
+
+	VK_DEV_TRACE_END("vk_dev_setup");
+}
+
+static void*
+_vk_dev_setup_thread(void* arg)
+{
+	_vk_dev_setup();
+
+	return NULL;
 }
 
 void
 vk_dev_setup(void)
 {
-	gladLoaderLoadVulkan(NULL, NULL, NULL);
+	_vk_dev_setup();
+}
+
+/*
+ *	NOTE:	Runs vk_dev_setup on a background thread so loader loading,
+ *			instance creation and device selection overlap with window
+ *			creation. Nothing else in vk_dev may be used until
+ *			vk_dev_setup_end (or vk_dev_set_surface) has joined it.
+ */
+void
+vk_dev_setup_begin(void)
+{
+	if (pthread_create(&_setup_thread, NULL, _vk_dev_setup_thread,
+		NULL) != 0) {
+		vk_dev_fatal_error("[VULKAN] Failed to start setup thread.");
+	}
 
-	_vk_dev_instance_create();
+	_setup_pending = true;
+}
+
+void
+vk_dev_setup_end(void)
+{
+	if (_setup_pending) {
+		pthread_join(_setup_thread, NULL);
+		_setup_pending = false;
+	}
+}
+
+struct vk_dev_context*
+vk_dev_get_context(void)
+{
+	vk_dev_setup_end();
+
+	return _context;
+}
+
+VkInstance
+vk_dev_get_instance(void)
+{
+	return vk_dev_get_context()->instance;
+}
+
+void
+vk_dev_set_surface(VkSurfaceKHR surface)
+{
+	vk_dev_context_set_surface(vk_dev_get_context(), surface);
 }
 
 void
 vk_dev_terminate(void)
 {
-	_vk_dev_instance_destroy();
+	VK_DEV_TRACE_BEGIN("vk_dev_terminate");
+
+	vk_dev_setup_end();
+
+	vk_dev_context_destroy(_context);
+	_context = NULL;
 
 	gladLoaderUnloadVulkan();
+
+	VK_DEV_TRACE_END("vk_dev_terminate");
+
+#if !defined(VK_DEV_TRACE_DISABLE)
+	if (getenv("VK_DEV_TRACE") != NULL) {
+		vk_dev_trace_stop();
+
+		if (getenv("VK_DEV_TRACE_CHROME") != NULL &&
+			vk_dev_trace_export_chrome(getenv("VK_DEV_TRACE"),
+			getenv("VK_DEV_TRACE_CHROME")) != 0) {
+			fprintf(stderr, "[TRACE] Failed to export Chrome trace.\n");
+		}
+	}
+#endif
+}
+
+void
+vk_dev_get_setup_timings(struct vk_dev_setup_timings* timings)
+{
+	vk_dev_context_get_setup_timings(vk_dev_get_context(), timings);
+}
+
+const char*
+vk_dev_setup_phase_name(const enum vk_dev_setup_phase phase)
+{
+	return _phase_names[phase];
+}
+
+void
+vk_dev_print_setup_timings(FILE* stream)
+{
+	struct vk_dev_setup_timings timings;
+
+	vk_dev_context_get_setup_timings(_context, &timings);
+
+	fprintf(stream, "[VULKAN] Setup timings:\n");
+	for (int i = 0; i < VK_DEV_SETUP_PHASE_COUNT; i++) {
+		fprintf(stream, "\t%-24s%10.3f ms\n", _phase_names[i],
+			(double)timings.phase_ns[i] / 1000000.0);
+	}
+	fprintf(stream, "\t%-24s%10.3f ms\n", "total",
+		(double)timings.total_ns / 1000000.0);
 }
 
 void
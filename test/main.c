@@ -40,9 +40,18 @@ _terminate(void)
 int
 main()
 {
+	VkSurfaceKHR surface;
+
+	vk_dev_setup_begin();
+
 	_setup();
 
-	vk_dev_setup();
+	if (glfwCreateWindowSurface(vk_dev_get_instance(), _window, NULL,
+		&surface) != VK_SUCCESS) {
+		vk_dev_fatal_error("[GLFW] Failed to create window surface.");
+	}
+
+	vk_dev_set_surface(surface);
 
 	while (!glfwWindowShouldClose(_window)) {
 		glfwPollEvents();
@@ -0,0 +1,749 @@
+/*
+ *	NOTE:	Offline asset baker: bake OUTPUT INPUT...
+ *
+ *			Wavefront .obj inputs become meshes: triangulated, run through
+ *			vk_dev_optimize_mesh and quantized with vk_dev_vertex_quantize.
+ *			Binary .ppm (P6) and .pam (P7) inputs become RGBA8 sRGB textures
+ *			with a full box filtered mip chain, block compressed when -f
+ *			names a format (bc1, bc3, bc5 or bc7). Each asset is named after
+ *			its file name.
+ */
+
+#include <vulkan-dev/baker.h>
+#include <vulkan-dev/asset.h>
+#include <vulkan-dev/compress.h>
+#include <vulkan-dev/jobs.h>
+#include <vulkan-dev/optimize.h>
+#include <vulkan-dev/vertex.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+struct _bake_vertex {
+	float position[3];
+	float uv[2];
+	float normal[3];
+};
+
+struct _bake_corner {
+	int32_t position;
+	int32_t uv;
+	int32_t normal;
+};
+
+// NOTE: -f arguments, in enum vk_dev_compress_format order.
+static const char* _bake_formats[VK_DEV_COMPRESS_FORMAT_COUNT] = {
+	"bc1", "bc3", "bc5", "bc7",
+};
+
+struct _bake_options {
+	bool compress;
+	enum vk_dev_compress_format format;
+	struct vk_dev_jobs* jobs;
+};
+
+struct _bake_array {
+	void* data;
+	size_t count;
+	size_t capacity;
+	size_t size;
+};
+
+static void*
+_bake_push(struct _bake_array* array)
+{
+	if (array->count == array->capacity) {
+		array->capacity = array->capacity > 0 ? array->capacity * 2 : 256;
+		array->data = realloc(array->data, array->capacity * array->size);
+		if (array->data == NULL) {
+			vk_dev_fatal_error("[BAKE] Out of memory.");
+		}
+	}
+
+	return (char*)array->data + array->size * array->count++;
+}
+
+static char*
+_bake_read_file(const char* path, size_t* size)
+{
+	FILE* file;
+	char* data;
+	long length;
+
+	file = fopen(path, "rb");
+	if (file == NULL) {
+		return NULL;
+	}
+
+	fseek(file, 0, SEEK_END);
+	length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	data = malloc(length + 1);
+	if (data == NULL) {
+		vk_dev_fatal_error("[BAKE] Out of memory.");
+	}
+
+	if (fread(data, 1, length, file) != (size_t)length) {
+		free(data);
+		fclose(file);
+		return NULL;
+	}
+
+	data[length] = '\0';
+	*size = length;
+
+	fclose(file);
+
+	return data;
+}
+
+static const char*
+_bake_name(const char* path)
+{
+	const char* slash;
+
+	slash = strrchr(path, '/');
+
+	return slash != NULL ? slash + 1 : path;
+}
+
+/*
+ *	NOTE:	OBJ indices are 1 based and negative ones count back from the
+ *			end; returns the 0 based index, or -1 when absent.
+ */
+static int32_t
+_bake_obj_index(const char** cursor, const size_t count)
+{
+	long index;
+	char* end;
+
+	index = strtol(*cursor, &end, 10);
+	if (end == *cursor) {
+		return -1;
+	}
+
+	*cursor = end;
+
+	return (int32_t)(index < 0 ? (long)count + index : index - 1);
+}
+
+static void
+_bake_obj_corner(const char** cursor, const size_t* counts,
+	struct _bake_corner* corner)
+{
+	corner->position = _bake_obj_index(cursor, counts[0]);
+	corner->uv = -1;
+	corner->normal = -1;
+
+	if (**cursor == '/') {
+		++*cursor;
+		corner->uv = _bake_obj_index(cursor, counts[1]);
+
+		if (**cursor == '/') {
+			++*cursor;
+			corner->normal = _bake_obj_index(cursor, counts[2]);
+		}
+	}
+}
+
+static uint32_t
+_bake_corner_hash(const struct _bake_corner* corner)
+{
+	return ((uint32_t)corner->position * 73856093u) ^
+		((uint32_t)corner->uv * 19349663u) ^
+		((uint32_t)corner->normal * 83492791u);
+}
+
+static int
+_bake_mesh(struct vk_dev_baker* baker, const char* path)
+{
+	int kind;
+	char* text;
+	const char* cursor;
+	size_t size, counts[3], table_size;
+	uint32_t start, count, slot, vertex_count, index_count, used;
+	uint32_t* table,* indices;
+	void* quantized;
+	float* values;
+	struct _bake_array arrays[3], corners, faces;
+	struct _bake_corner corner,* keys;
+	const struct _bake_corner* key;
+	struct _bake_vertex* vertices,* vertex;
+	struct vk_dev_optimize_report report;
+	struct vk_dev_vertex_source source;
+	struct vk_dev_vertex_format format;
+
+	text = _bake_read_file(path, &size);
+	if (text == NULL) {
+		fprintf(stderr, "bake: cannot read %s\n", path);
+		return 1;
+	}
+
+	for (int i = 0; i < 3; i++) {
+		memset(&arrays[i], 0, sizeof(arrays[i]));
+		arrays[i].size = sizeof(float) * 3;
+	}
+
+	memset(&corners, 0, sizeof(corners));
+	corners.size = sizeof(struct _bake_corner);
+
+	// NOTE: One entry per emitted corner, indexing corners.
+	memset(&faces, 0, sizeof(faces));
+	faces.size = sizeof(uint32_t);
+
+	for (cursor = text; *cursor != '\0'; cursor = strchr(cursor, '\n') ?
+		strchr(cursor, '\n') + 1 : cursor + strlen(cursor)) {
+		kind = -1;
+		if (strncmp(cursor, "v ", 2) == 0) {
+			kind = 0;
+		} else if (strncmp(cursor, "vt ", 3) == 0) {
+			kind = 1;
+		} else if (strncmp(cursor, "vn ", 3) == 0) {
+			kind = 2;
+		}
+
+		if (kind >= 0) {
+			cursor += kind == 0 ? 2 : 3;
+			values = _bake_push(&arrays[kind]);
+			for (int i = 0; i < 3; i++) {
+				values[i] = strtof(cursor, (char**)&cursor);
+			}
+
+			continue;
+		}
+
+		if (strncmp(cursor, "f ", 2) != 0) {
+			continue;
+		}
+
+		// NOTE: Polygons are triangulated as fans around their first corner.
+		cursor += 1;
+		start = corners.count;
+		count = 0;
+
+		for (int i = 0; i < 3; i++) {
+			counts[i] = arrays[i].count;
+		}
+
+		while (*cursor == ' ' || *cursor == '\t') {
+			while (*cursor == ' ' || *cursor == '\t') {
+				cursor++;
+			}
+
+			_bake_obj_corner(&cursor, counts, &corner);
+			if (corner.position < 0 ||
+				(size_t)corner.position >= counts[0]) {
+				break;
+			}
+
+			*(struct _bake_corner*)_bake_push(&corners) = corner;
+
+			if (++count >= 3) {
+				*(uint32_t*)_bake_push(&faces) = start;
+				*(uint32_t*)_bake_push(&faces) = start + count - 2;
+				*(uint32_t*)_bake_push(&faces) = start + count - 1;
+			}
+		}
+	}
+
+	index_count = faces.count;
+	if (index_count == 0) {
+		fprintf(stderr, "bake: %s has no faces\n", path);
+		free(corners.data);
+		free(faces.data);
+		for (int i = 0; i < 3; i++) {
+			free(arrays[i].data);
+		}
+		free(text);
+		return 1;
+	}
+
+	/*
+	 *	NOTE:	Corners sharing position, uv and normal indices become one
+	 *			vertex.
+	 */
+	table_size = 1;
+	while (table_size < corners.count * 2) {
+		table_size *= 2;
+	}
+
+	table = malloc(sizeof(*table) * table_size);
+	keys = malloc(sizeof(*keys) * corners.count);
+	indices = malloc(sizeof(*indices) * index_count);
+	vertices = malloc(sizeof(*vertices) * corners.count);
+	if (table == NULL || keys == NULL || indices == NULL || vertices == NULL) {
+		vk_dev_fatal_error("[BAKE] Out of memory.");
+	}
+
+	memset(table, 0xff, sizeof(*table) * table_size);
+	vertex_count = 0;
+
+	for (uint32_t i = 0; i < index_count; i++) {
+		key = &((struct _bake_corner*)corners.data)[
+			((uint32_t*)faces.data)[i]];
+		slot = _bake_corner_hash(key) & (table_size - 1);
+
+		while (table[slot] != UINT32_MAX) {
+			if (keys[table[slot]].position == key->position &&
+				keys[table[slot]].uv == key->uv &&
+				keys[table[slot]].normal == key->normal) {
+				break;
+			}
+
+			slot = (slot + 1) & (table_size - 1);
+		}
+
+		if (table[slot] == UINT32_MAX) {
+			table[slot] = vertex_count;
+			keys[vertex_count] = *key;
+
+			vertex = &vertices[vertex_count++];
+			memset(vertex, 0, sizeof(*vertex));
+
+			values = (float*)arrays[0].data + key->position * 3;
+			memcpy(vertex->position, values, sizeof(vertex->position));
+
+			if (key->uv >= 0 && (size_t)key->uv < arrays[1].count) {
+				values = (float*)arrays[1].data + key->uv * 3;
+				memcpy(vertex->uv, values, sizeof(vertex->uv));
+			}
+
+			if (key->normal >= 0 && (size_t)key->normal < arrays[2].count) {
+				values = (float*)arrays[2].data + key->normal * 3;
+				memcpy(vertex->normal, values, sizeof(vertex->normal));
+			}
+		}
+
+		indices[i] = table[slot];
+	}
+
+	used = vk_dev_optimize_mesh(vertices, indices, index_count, vertex_count,
+		sizeof(*vertices), vertices[0].position, &report);
+
+	source.data = vertices;
+	source.stride = sizeof(*vertices);
+	source.count = used;
+	source.offsets[VK_DEV_VERTEX_POSITION] =
+		offsetof(struct _bake_vertex, position);
+	source.offsets[VK_DEV_VERTEX_UV] = arrays[1].count > 0 ?
+		offsetof(struct _bake_vertex, uv) : VK_DEV_VERTEX_ABSENT;
+	source.offsets[VK_DEV_VERTEX_NORMAL] = arrays[2].count > 0 ?
+		offsetof(struct _bake_vertex, normal) : VK_DEV_VERTEX_ABSENT;
+	source.offsets[VK_DEV_VERTEX_TANGENT] = VK_DEV_VERTEX_ABSENT;
+
+	vk_dev_vertex_format_init(&source, false, &format);
+
+	quantized = malloc((size_t)used * format.stride);
+	if (quantized == NULL) {
+		vk_dev_fatal_error("[BAKE] Out of memory.");
+	}
+
+	vk_dev_vertex_quantize(&format, &source, quantized);
+
+	vk_dev_baker_add_mesh(baker, _bake_name(path), &format, quantized, used,
+		indices, index_count);
+
+	printf("%s: %u triangles, %u vertices, %u -> %u bytes per vertex, "
+		"acmr %.3f -> %.3f\n", _bake_name(path), index_count / 3, used,
+		(unsigned)sizeof(*vertices), format.stride, report.before.acmr,
+		report.after.acmr);
+
+	free(quantized);
+	free(vertices);
+	free(indices);
+	free(keys);
+	free(table);
+	free(corners.data);
+	free(faces.data);
+	for (int i = 0; i < 3; i++) {
+		free(arrays[i].data);
+	}
+	free(text);
+
+	return 0;
+}
+
+static const char*
+_bake_pnm_token(const char* cursor, const char* end)
+{
+	while (cursor < end) {
+		if (*cursor == '#') {
+			while (cursor < end && *cursor != '\n') {
+				cursor++;
+			}
+		} else if (*cursor == ' ' || *cursor == '\t' || *cursor == '\r' ||
+			*cursor == '\n') {
+			cursor++;
+		} else {
+			break;
+		}
+	}
+
+	return cursor;
+}
+
+/*
+ *	NOTE:	Reads an 8 bit P6 or P7 image into RGBA; returns NULL if the file
+ *			is anything else.
+ */
+static uint8_t*
+_bake_read_pnm(const char* path, uint32_t* width, uint32_t* height)
+{
+	char* text,* next;
+	const char* cursor,* end;
+	size_t size;
+	long depth, max, value;
+	uint8_t* pixels;
+
+	text = _bake_read_file(path, &size);
+	if (text == NULL) {
+		return NULL;
+	}
+
+	end = text + size;
+	depth = 0;
+	max = 0;
+	*width = 0;
+	*height = 0;
+
+	if (strncmp(text, "P6", 2) == 0) {
+		cursor = text + 2;
+		depth = 3;
+
+		cursor = _bake_pnm_token(cursor, end);
+		*width = strtoul(cursor, &next, 10);
+		cursor = _bake_pnm_token(next, end);
+		*height = strtoul(cursor, &next, 10);
+		cursor = _bake_pnm_token(next, end);
+		max = strtol(cursor, &next, 10);
+		cursor = next + 1;
+	} else if (strncmp(text, "P7", 2) == 0) {
+		cursor = text + 2;
+
+		for (;;) {
+			cursor = _bake_pnm_token(cursor, end);
+			if (cursor >= end) {
+				break;
+			}
+
+			if (strncmp(cursor, "ENDHDR", 6) == 0) {
+				cursor = strchr(cursor, '\n');
+				cursor = cursor != NULL ? cursor + 1 : end;
+				break;
+			}
+
+			next = strpbrk(cursor, " \t");
+			value = next != NULL ? strtol(next, NULL, 10) : 0;
+
+			if (strncmp(cursor, "WIDTH", 5) == 0) {
+				*width = value;
+			} else if (strncmp(cursor, "HEIGHT", 6) == 0) {
+				*height = value;
+			} else if (strncmp(cursor, "DEPTH", 5) == 0) {
+				depth = value;
+			} else if (strncmp(cursor, "MAXVAL", 6) == 0) {
+				max = value;
+			}
+
+			cursor = strchr(cursor, '\n');
+			if (cursor == NULL) {
+				cursor = end;
+			}
+		}
+	} else {
+		free(text);
+		return NULL;
+	}
+
+	if (max != 255 || depth < 1 || depth > 4 || *width == 0 ||
+		*height == 0 || (size_t)(end - cursor) <
+		(size_t)*width * *height * depth) {
+		free(text);
+		return NULL;
+	}
+
+	pixels = malloc((size_t)*width * *height * 4);
+	if (pixels == NULL) {
+		vk_dev_fatal_error("[BAKE] Out of memory.");
+	}
+
+	for (size_t i = 0; i < (size_t)*width * *height; i++) {
+		const uint8_t* texel = (const uint8_t*)cursor + i * depth;
+
+		pixels[i * 4 + 0] = texel[0];
+		pixels[i * 4 + 1] = depth >= 3 ? texel[1] : texel[0];
+		pixels[i * 4 + 2] = depth >= 3 ? texel[2] : texel[0];
+		pixels[i * 4 + 3] = depth == 4 ? texel[3] :
+			(depth == 2 ? texel[1] : 255);
+	}
+
+	free(text);
+
+	return pixels;
+}
+
+static float
+_bake_srgb_to_linear(const uint8_t value)
+{
+	float c;
+
+	c = value / 255.0f;
+
+	return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static uint8_t
+_bake_linear_to_srgb(const float value)
+{
+	float c;
+
+	c = value <= 0.0031308f ? value * 12.92f :
+		1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+
+	return (uint8_t)(c <= 0.0f ? 0 : (c >= 1.0f ? 255 : c * 255.0f + 0.5f));
+}
+
+/*
+ *	NOTE:	2x2 box filter in linear light; odd edges reuse the last texel.
+ *			Alpha is filtered as is.
+ */
+static void
+_bake_downsample(const uint8_t* source, const uint32_t width,
+	const uint32_t height, uint8_t* destination, const float* to_linear)
+{
+	uint32_t w, h, sx, sy;
+	float sum[4];
+	const uint8_t* texel;
+
+	w = width > 1 ? width / 2 : 1;
+	h = height > 1 ? height / 2 : 1;
+
+	for (uint32_t y = 0; y < h; y++) {
+		for (uint32_t x = 0; x < w; x++) {
+			sum[0] = sum[1] = sum[2] = sum[3] = 0.0f;
+
+			for (uint32_t i = 0; i < 4; i++) {
+				sx = x * 2 + (i & 1);
+				sy = y * 2 + (i >> 1);
+				sx = sx < width ? sx : width - 1;
+				sy = sy < height ? sy : height - 1;
+
+				texel = source + ((size_t)sy * width + sx) * 4;
+				for (int c = 0; c < 3; c++) {
+					sum[c] += to_linear[texel[c]];
+				}
+				sum[3] += texel[3];
+			}
+
+			for (int c = 0; c < 3; c++) {
+				destination[((size_t)y * w + x) * 4 + c] =
+					_bake_linear_to_srgb(sum[c] / 4.0f);
+			}
+			destination[((size_t)y * w + x) * 4 + 3] =
+				(uint8_t)(sum[3] / 4.0f + 0.5f);
+		}
+	}
+}
+
+/*
+ *	NOTE:	Replaces every level with its blocks and measures level 0
+ *			against the texels it was encoded from.
+ */
+static void
+_bake_compress(const struct _bake_options* options, uint8_t** levels,
+	uint64_t* level_sizes, const uint32_t level_count, const uint32_t width,
+	const uint32_t height, struct vk_dev_compress_quality* quality)
+{
+	uint32_t w, h;
+	uint8_t* blocks, * decoded;
+
+	w = width;
+	h = height;
+
+	for (uint32_t i = 0; i < level_count; i++) {
+		level_sizes[i] = vk_dev_compress_get_size(options->format, w, h);
+		blocks = malloc(level_sizes[i]);
+		if (blocks == NULL) {
+			vk_dev_fatal_error("[BAKE] Out of memory.");
+		}
+
+		vk_dev_compress_encode(options->format, levels[i], w, h, blocks,
+			options->jobs);
+
+		if (i == 0) {
+			decoded = malloc((size_t)w * h * 4);
+			if (decoded == NULL) {
+				vk_dev_fatal_error("[BAKE] Out of memory.");
+			}
+
+			vk_dev_compress_decode(options->format, blocks, w, h, decoded);
+			vk_dev_compress_measure(options->format, levels[i], decoded, w, h,
+				quality);
+			free(decoded);
+		}
+
+		free(levels[i]);
+		levels[i] = blocks;
+
+		w = w > 1 ? w / 2 : 1;
+		h = h > 1 ? h / 2 : 1;
+	}
+}
+
+static int
+_bake_texture(struct vk_dev_baker* baker, const struct _bake_options* options,
+	const char* path)
+{
+	uint32_t width, height, level_count, w, h;
+	float to_linear[256];
+	VkFormat format;
+	struct vk_dev_compress_quality quality;
+	uint8_t* levels[VK_DEV_ASSET_MAX_LEVELS];
+	uint64_t level_sizes[VK_DEV_ASSET_MAX_LEVELS];
+
+	levels[0] = _bake_read_pnm(path, &width, &height);
+	if (levels[0] == NULL) {
+		fprintf(stderr, "bake: cannot read %s as an 8 bit P6 or P7 image\n",
+			path);
+		return 1;
+	}
+
+	for (int i = 0; i < 256; i++) {
+		to_linear[i] = _bake_srgb_to_linear((uint8_t)i);
+	}
+
+	level_sizes[0] = (uint64_t)width * height * 4;
+	level_count = 1;
+	w = width;
+	h = height;
+
+	while ((w > 1 || h > 1) && level_count < VK_DEV_ASSET_MAX_LEVELS) {
+		levels[level_count] = malloc((size_t)(w > 1 ? w / 2 : 1) *
+			(h > 1 ? h / 2 : 1) * 4);
+		if (levels[level_count] == NULL) {
+			vk_dev_fatal_error("[BAKE] Out of memory.");
+		}
+
+		_bake_downsample(levels[level_count - 1], w, h, levels[level_count],
+			to_linear);
+
+		w = w > 1 ? w / 2 : 1;
+		h = h > 1 ? h / 2 : 1;
+		level_sizes[level_count++] = (uint64_t)w * h * 4;
+	}
+
+	format = VK_FORMAT_R8G8B8A8_SRGB;
+	if (options->compress) {
+		_bake_compress(options, levels, level_sizes, level_count, width,
+			height, &quality);
+		format = vk_dev_compress_get_vk_format(options->format, true);
+	}
+
+	vk_dev_baker_add_texture(baker, _bake_name(path), format, width, height,
+		level_count, (const void* const*)levels, level_sizes);
+
+	if (options->compress) {
+		printf("%s: %ux%u, %u levels, %s, PSNR %.2f dB colour, %.2f dB "
+			"alpha\n", _bake_name(path), width, height, level_count,
+			vk_dev_compress_get_name(options->format), quality.psnr_rgb,
+			quality.psnr_alpha);
+	} else {
+		printf("%s: %ux%u, %u levels\n", _bake_name(path), width, height,
+			level_count);
+	}
+
+	for (uint32_t i = 0; i < level_count; i++) {
+		free(levels[i]);
+	}
+
+	return 0;
+}
+
+static int
+_bake_input(struct vk_dev_baker* baker, const struct _bake_options* options,
+	const char* path)
+{
+	const char* extension;
+
+	extension = strrchr(path, '.');
+	if (extension == NULL) {
+		extension = "";
+	}
+
+	if (strcmp(extension, ".obj") == 0) {
+		return _bake_mesh(baker, path);
+	}
+
+	if (strcmp(extension, ".ppm") == 0 || strcmp(extension, ".pam") == 0) {
+		return _bake_texture(baker, options, path);
+	}
+
+	fprintf(stderr, "bake: don't know how to bake %s\n", path);
+
+	return 1;
+}
+
+int
+main(int argc, char** argv)
+{
+	int failures, first;
+	struct vk_dev_baker* baker;
+	struct _bake_options options;
+
+	options.compress = false;
+	options.format = VK_DEV_COMPRESS_BC7;
+	options.jobs = NULL;
+
+	first = 1;
+	if (argc > 2 && strcmp(argv[1], "-f") == 0) {
+		for (uint32_t f = 0; f < VK_DEV_COMPRESS_FORMAT_COUNT; f++) {
+			if (strcmp(argv[2], _bake_formats[f]) == 0) {
+				options.compress = true;
+				options.format = f;
+			}
+		}
+
+		if (!options.compress) {
+			fprintf(stderr, "bake: unknown format %s\n", argv[2]);
+			return 2;
+		}
+
+		first = 3;
+	}
+
+	if (argc < first + 2) {
+		fprintf(stderr, "usage: %s [-f bc1|bc3|bc5|bc7] OUTPUT INPUT...\n",
+			argv[0]);
+		return 2;
+	}
+
+	baker = vk_dev_baker_create(argv[first]);
+	if (baker == NULL) {
+		fprintf(stderr, "bake: cannot open %s\n", argv[first]);
+		return 1;
+	}
+
+	if (options.compress) {
+		options.jobs = vk_dev_jobs_create(0);
+	}
+
+	failures = 0;
+	for (int i = first + 1; i < argc; i++) {
+		failures += _bake_input(baker, &options, argv[i]);
+	}
+
+	if (options.jobs != NULL) {
+		vk_dev_jobs_destroy(options.jobs);
+	}
+
+	if (!vk_dev_baker_finish(baker)) {
+		fprintf(stderr, "bake: failed to write %s\n", argv[first]);
+		return 1;
+	}
+
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,333 @@
+/*
+ *	NOTE:	Block compression benchmark:
+ *			compress-bench [-c] [SIZE [ITERATIONS]]
+ *
+ *			Encodes a SIZE x SIZE RGBA8 test image (1024 by default: smooth
+ *			gradients, hard edges, noise and a wavy alpha) to every format
+ *			with the CPU encoder, on one thread and on every CPU, and with
+ *			the compute shader encoder, and reports throughput in megapixels
+ *			per second and PSNR against the source. -c skips the GPU. GPU
+ *			times run from vkQueueSubmit until the fence signals.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/buffer.h>
+#include <vulkan-dev/compress.h>
+#include <vulkan-dev/descriptor.h>
+#include <vulkan-dev/image.h>
+#include <vulkan-dev/jobs.h>
+#include <vulkan-dev/staging.h>
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct _bench {
+	struct vk_dev_context* context;
+	VkCommandPool command_pool;
+	VkCommandBuffer command_buffer;
+	VkFence fence;
+};
+
+static uint64_t
+_bench_time_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+static void
+_bench_create(struct _bench* bench, struct vk_dev_context* context)
+{
+	VkFenceCreateInfo fence_info;
+	VkCommandPoolCreateInfo pool_info;
+	VkCommandBufferAllocateInfo allocate_info;
+
+	bench->context = context;
+
+	pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	pool_info.pNext = NULL;
+	pool_info.flags = 0;
+	pool_info.queueFamilyIndex = context->queue_family;
+
+	if (context->vk.CreateCommandPool(context->device, &pool_info, NULL,
+		&bench->command_pool) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create command pool.");
+	}
+
+	allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocate_info.pNext = NULL;
+	allocate_info.commandPool = bench->command_pool;
+	allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocate_info.commandBufferCount = 1;
+
+	if (context->vk.AllocateCommandBuffers(context->device, &allocate_info,
+		&bench->command_buffer) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to allocate command buffer.");
+	}
+
+	fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fence_info.pNext = NULL;
+	fence_info.flags = 0;
+
+	if (context->vk.CreateFence(context->device, &fence_info, NULL,
+		&bench->fence) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create fence.");
+	}
+}
+
+static void
+_bench_destroy(struct _bench* bench)
+{
+	bench->context->vk.DestroyFence(bench->context->device, bench->fence,
+		NULL);
+	bench->context->vk.DestroyCommandPool(bench->context->device,
+		bench->command_pool, NULL);
+}
+
+static VkCommandBuffer
+_bench_begin(struct _bench* bench)
+{
+	VkCommandBufferBeginInfo begin_info;
+
+	bench->context->vk.ResetCommandPool(bench->context->device,
+		bench->command_pool, 0);
+
+	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.pNext = NULL;
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	begin_info.pInheritanceInfo = NULL;
+
+	if (bench->context->vk.BeginCommandBuffer(bench->command_buffer,
+		&begin_info) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to begin command buffer.");
+	}
+
+	return bench->command_buffer;
+}
+
+// NOTE: Returns the time from submission until the GPU finished.
+static uint64_t
+_bench_submit(struct _bench* bench)
+{
+	uint64_t start;
+	VkSubmitInfo submit_info;
+	struct vk_dev_context* context;
+
+	context = bench->context;
+
+	if (context->vk.EndCommandBuffer(bench->command_buffer) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to record command buffer.");
+	}
+
+	memset(&submit_info, 0, sizeof(submit_info));
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &bench->command_buffer;
+
+	start = _bench_time_ns();
+
+	if (context->vk.QueueSubmit(context->queue, 1, &submit_info,
+		bench->fence) != VK_SUCCESS ||
+		context->vk.WaitForFences(context->device, 1, &bench->fence, VK_TRUE,
+		UINT64_MAX) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to run command buffer.");
+	}
+
+	start = _bench_time_ns() - start;
+
+	context->vk.ResetFences(context->device, 1, &bench->fence);
+
+	return start;
+}
+
+static void
+_bench_fill(uint8_t* texels, const uint32_t size)
+{
+	uint32_t noise;
+	uint8_t* texel;
+
+	noise = 1;
+	for (uint32_t y = 0; y < size; y++) {
+		for (uint32_t x = 0; x < size; x++) {
+			texel = texels + ((size_t)y * size + x) * 4;
+			noise = noise * 1664525u + 1013904223u;
+
+			texel[0] = (uint8_t)(x * 255 / size);
+			texel[1] = (uint8_t)(128.0f + 100.0f *
+				sinf(x * 0.1f + y * 0.05f));
+			texel[2] = (uint8_t)(((x / 16 + y / 16) & 1 ? 200 : 30) +
+				(noise >> 29));
+			texel[3] = (uint8_t)(128.0f + 127.0f * sinf(x * 0.07f) *
+				cosf(y * 0.05f));
+		}
+	}
+}
+
+static void
+_bench_report(const char* encoder, const enum vk_dev_compress_format format,
+	const uint32_t size, const uint64_t ns, const uint8_t* reference,
+	const void* blocks, uint8_t* decoded)
+{
+	struct vk_dev_compress_quality quality;
+
+	vk_dev_compress_decode(format, blocks, size, size, decoded);
+	vk_dev_compress_measure(format, reference, decoded, size, size, &quality);
+
+	printf("%-4s %-12s %10.2f %10.2f %10.2f %6u\n",
+		vk_dev_compress_get_name(format), encoder,
+		(double)size * size / (ns / 1e3), quality.psnr_rgb,
+		quality.psnr_alpha, quality.max_error);
+}
+
+static void
+_bench_cpu(const uint32_t size, const uint32_t iterations,
+	const uint8_t* texels, uint8_t* blocks, uint8_t* decoded)
+{
+	uint64_t single_ns, parallel_ns;
+	struct vk_dev_jobs* jobs;
+
+	jobs = vk_dev_jobs_create(0);
+
+	for (uint32_t f = 0; f < VK_DEV_COMPRESS_FORMAT_COUNT; f++) {
+		single_ns = _bench_time_ns();
+		for (uint32_t i = 0; i < iterations; i++) {
+			vk_dev_compress_encode(f, texels, size, size, blocks, NULL);
+		}
+		single_ns = (_bench_time_ns() - single_ns) / iterations;
+
+		parallel_ns = _bench_time_ns();
+		for (uint32_t i = 0; i < iterations; i++) {
+			vk_dev_compress_encode(f, texels, size, size, blocks, jobs);
+		}
+		parallel_ns = (_bench_time_ns() - parallel_ns) / iterations;
+
+		_bench_report("cpu", f, size, single_ns, texels, blocks, decoded);
+		_bench_report("cpu jobs", f, size, parallel_ns, texels, blocks,
+			decoded);
+	}
+
+	printf("(cpu jobs on %u threads)\n", vk_dev_jobs_get_thread_count(jobs));
+
+	vk_dev_jobs_destroy(jobs);
+}
+
+static void
+_bench_gpu(const uint32_t size, const uint32_t iterations,
+	const uint8_t* texels, uint8_t* decoded)
+{
+	uint64_t ns;
+	VkImageView view;
+	VkCommandBuffer command_buffer;
+	struct _bench bench;
+	struct vk_dev_context* context;
+	struct vk_dev_staging* staging;
+	struct vk_dev_compress* compress;
+	struct vk_dev_descriptor_allocator* allocator;
+	struct vk_dev_image image;
+	struct vk_dev_buffer blocks;
+
+	context = vk_dev_context_create(-1);
+	_bench_create(&bench, context);
+
+	staging = vk_dev_staging_create(context, (VkDeviceSize)size * size * 4);
+	allocator = vk_dev_descriptor_allocator_create(context, 1);
+	compress = vk_dev_compress_create(context);
+
+	vk_dev_image_create(context, size, size, 1, VK_FORMAT_R8G8B8A8_UNORM,
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, &image);
+	vk_dev_staging_upload_image(staging, &image, 0, texels,
+		(VkDeviceSize)size * size * 4);
+	vk_dev_staging_flush(staging);
+	view = vk_dev_image_view_create(context, &image, 0, 1);
+
+	vk_dev_buffer_create(context,
+		vk_dev_compress_get_size(VK_DEV_COMPRESS_BC7, size, size),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &blocks);
+
+	for (uint32_t f = 0; f < VK_DEV_COMPRESS_FORMAT_COUNT; f++) {
+		ns = 0;
+		for (uint32_t i = 0; i < iterations; i++) {
+			vk_dev_descriptor_allocator_begin_frame(allocator, 0);
+
+			command_buffer = _bench_begin(&bench);
+			vk_dev_compress_record(compress, command_buffer, allocator, f,
+				view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, size, size,
+				blocks.buffer, 0);
+			ns += _bench_submit(&bench);
+		}
+
+		_bench_report("gpu", f, size, ns / iterations, texels, blocks.mapped,
+			decoded);
+	}
+
+	vk_dev_buffer_destroy(context, &blocks);
+	context->vk.DestroyImageView(context->device, view, NULL);
+	vk_dev_image_destroy(context, &image);
+	vk_dev_compress_destroy(compress);
+	vk_dev_descriptor_allocator_destroy(allocator);
+	vk_dev_staging_destroy(staging);
+	_bench_destroy(&bench);
+	vk_dev_context_destroy(context);
+}
+
+int
+main(int argc, char** argv)
+{
+	int argument;
+	bool gpu;
+	uint32_t size, iterations;
+	uint8_t* texels, * decoded, * blocks;
+
+	argument = 1;
+	gpu = true;
+	if (argc > argument && strcmp(argv[argument], "-c") == 0) {
+		gpu = false;
+		argument++;
+	}
+
+	size = argc > argument ? (uint32_t)strtoul(argv[argument], NULL, 10) :
+		1024;
+	iterations = argc > argument + 1 ?
+		(uint32_t)strtoul(argv[argument + 1], NULL, 10) : 4;
+	if (size == 0 || iterations == 0) {
+		fprintf(stderr, "usage: %s [-c] [SIZE [ITERATIONS]]\n", argv[0]);
+		return 1;
+	}
+
+	texels = malloc((size_t)size * size * 4);
+	decoded = malloc((size_t)size * size * 4);
+	blocks = malloc(vk_dev_compress_get_size(VK_DEV_COMPRESS_BC7, size,
+		size));
+	if (texels == NULL || decoded == NULL || blocks == NULL) {
+		vk_dev_fatal_error("[BENCH] Out of memory.");
+	}
+
+	_bench_fill(texels, size);
+
+	printf("%ux%u, %u iterations\n", size, size, iterations);
+	printf("%-4s %-12s %10s %10s %10s %6s\n", "", "encoder", "MPix/s",
+		"PSNR rgb", "PSNR a", "max");
+
+	_bench_cpu(size, iterations, texels, blocks, decoded);
+	if (gpu) {
+		_bench_gpu(size, iterations, texels, decoded);
+	}
+
+	free(blocks);
+	free(decoded);
+	free(texels);
+
+	return 0;
+}
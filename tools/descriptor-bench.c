@@ -0,0 +1,286 @@
+/*
+ *	NOTE:	Descriptor set allocation rate benchmark:
+ *			descriptor-bench [SETS [FRAMES]]
+ *
+ *			Builds SETS descriptor sets per frame (10000 by default) for
+ *			FRAMES frames (100 by default), each a uniform buffer and a
+ *			storage buffer at one of SETS / 4 distinct offsets, and reports
+ *			sets per second for three paths:
+ *
+ *				naive		vkAllocateDescriptorSets, vkUpdateDescriptorSets
+ *							and vkFreeDescriptorSets for every set, from one
+ *							pool created with FREE_DESCRIPTOR_SET.
+ *				allocator	vk_dev_descriptor_allocator_allocate and
+ *							vkUpdateDescriptorSets, with a pool reset per
+ *							frame.
+ *				cached		vk_dev_descriptor_allocator_get, which reuses
+ *							the set of an identical request this frame.
+ *
+ *			Only the CPU is measured; nothing is submitted.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/buffer.h>
+#include <vulkan-dev/descriptor.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_RANGE 256
+
+struct _bench {
+	struct vk_dev_context* context;
+	VkDescriptorSetLayout layout;
+	struct vk_dev_buffer buffer;
+
+	uint32_t sets;
+	uint32_t frames;
+	uint32_t variants;
+
+	VkDescriptorSet* handles;
+	VkDescriptorBufferInfo infos[2];
+	VkWriteDescriptorSet writes[2];
+};
+
+static uint64_t
+_bench_time_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+static void
+_bench_create(struct _bench* bench, struct vk_dev_context* context)
+{
+	VkDescriptorSetLayoutBinding bindings[2];
+	VkDescriptorSetLayoutCreateInfo layout_info;
+
+	bench->context = context;
+
+	for (uint32_t i = 0; i < 2; i++) {
+		bindings[i].binding = i;
+		bindings[i].descriptorType = i == 0 ?
+			VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER :
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_ALL;
+		bindings[i].pImmutableSamplers = NULL;
+	}
+
+	layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layout_info.pNext = NULL;
+	layout_info.flags = 0;
+	layout_info.bindingCount = 2;
+	layout_info.pBindings = bindings;
+
+	if (context->vk.CreateDescriptorSetLayout(context->device, &layout_info,
+		NULL, &bench->layout) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create set layout.");
+	}
+
+	vk_dev_buffer_create(context, (VkDeviceSize)bench->variants * BENCH_RANGE,
+		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &bench->buffer);
+
+	bench->handles = malloc(sizeof(*bench->handles) * bench->sets);
+	if (bench->handles == NULL) {
+		vk_dev_fatal_error("[BENCH] Out of memory.");
+	}
+
+	for (uint32_t i = 0; i < 2; i++) {
+		bench->infos[i].buffer = bench->buffer.buffer;
+		bench->infos[i].range = BENCH_RANGE;
+
+		memset(&bench->writes[i], 0, sizeof(bench->writes[i]));
+		bench->writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		bench->writes[i].dstBinding = i;
+		bench->writes[i].descriptorCount = 1;
+		bench->writes[i].descriptorType = bindings[i].descriptorType;
+		bench->writes[i].pBufferInfo = &bench->infos[i];
+	}
+}
+
+static void
+_bench_destroy(struct _bench* bench)
+{
+	free(bench->handles);
+	vk_dev_buffer_destroy(bench->context, &bench->buffer);
+	bench->context->vk.DestroyDescriptorSetLayout(bench->context->device,
+		bench->layout, NULL);
+}
+
+// NOTE: Points the writes at the offsets of set i, then at dst.
+static void
+_bench_prepare(struct _bench* bench, const uint32_t i, VkDescriptorSet dst)
+{
+	const VkDeviceSize offset =
+		(VkDeviceSize)(i % bench->variants) * BENCH_RANGE;
+
+	bench->infos[0].offset = offset;
+	bench->infos[1].offset = offset;
+	bench->writes[0].dstSet = dst;
+	bench->writes[1].dstSet = dst;
+}
+
+static uint64_t
+_bench_naive(struct _bench* bench)
+{
+	uint64_t start;
+	VkDescriptorPool pool;
+	VkDescriptorPoolSize pool_sizes[2];
+	VkDescriptorPoolCreateInfo pool_info;
+	VkDescriptorSetAllocateInfo allocate_info;
+	struct vk_dev_context* context;
+
+	context = bench->context;
+
+	pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	pool_sizes[0].descriptorCount = bench->sets;
+	pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	pool_sizes[1].descriptorCount = bench->sets;
+
+	pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.pNext = NULL;
+	pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+	pool_info.maxSets = bench->sets;
+	pool_info.poolSizeCount = 2;
+	pool_info.pPoolSizes = pool_sizes;
+
+	if (context->vk.CreateDescriptorPool(context->device, &pool_info, NULL,
+		&pool) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create descriptor pool.");
+	}
+
+	allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocate_info.pNext = NULL;
+	allocate_info.descriptorPool = pool;
+	allocate_info.descriptorSetCount = 1;
+	allocate_info.pSetLayouts = &bench->layout;
+
+	start = _bench_time_ns();
+
+	for (uint32_t f = 0; f < bench->frames; f++) {
+		for (uint32_t i = 0; i < bench->sets; i++) {
+			if (context->vk.AllocateDescriptorSets(context->device,
+				&allocate_info, &bench->handles[i]) != VK_SUCCESS) {
+				vk_dev_fatal_error("[BENCH] Failed to allocate set.");
+			}
+
+			_bench_prepare(bench, i, bench->handles[i]);
+			context->vk.UpdateDescriptorSets(context->device, 2,
+				bench->writes, 0, NULL);
+		}
+
+		for (uint32_t i = 0; i < bench->sets; i++) {
+			context->vk.FreeDescriptorSets(context->device, pool, 1,
+				&bench->handles[i]);
+		}
+	}
+
+	start = _bench_time_ns() - start;
+
+	context->vk.DestroyDescriptorPool(context->device, pool, NULL);
+
+	return start;
+}
+
+static uint64_t
+_bench_allocator(struct _bench* bench, const bool cached,
+	struct vk_dev_descriptor_stats* stats)
+{
+	uint64_t start;
+	struct vk_dev_context* context;
+	struct vk_dev_descriptor_allocator* allocator;
+
+	context = bench->context;
+	allocator = vk_dev_descriptor_allocator_create(context, 1);
+
+	start = _bench_time_ns();
+
+	for (uint32_t f = 0; f < bench->frames; f++) {
+		vk_dev_descriptor_allocator_begin_frame(allocator, 0);
+
+		for (uint32_t i = 0; i < bench->sets; i++) {
+			if (cached) {
+				_bench_prepare(bench, i, VK_NULL_HANDLE);
+				bench->handles[i] = vk_dev_descriptor_allocator_get(allocator,
+					bench->layout, bench->writes, 2);
+			} else {
+				bench->handles[i] = vk_dev_descriptor_allocator_allocate(
+					allocator, bench->layout);
+				_bench_prepare(bench, i, bench->handles[i]);
+				context->vk.UpdateDescriptorSets(context->device, 2,
+					bench->writes, 0, NULL);
+			}
+		}
+	}
+
+	start = _bench_time_ns() - start;
+
+	vk_dev_descriptor_allocator_get_stats(allocator, stats);
+	vk_dev_descriptor_allocator_destroy(allocator);
+
+	return start;
+}
+
+static void
+_bench_report(const struct _bench* bench, const char* name,
+	const uint64_t ns, const uint64_t baseline_ns)
+{
+	printf("%-10s %12.2f %10.2fx\n", name,
+		(double)bench->sets * bench->frames / (ns / 1e9) / 1e6,
+		(double)baseline_ns / ns);
+}
+
+int
+main(int argc, char** argv)
+{
+	uint64_t naive_ns, allocator_ns, cached_ns;
+	struct _bench bench;
+	struct vk_dev_context* context;
+	struct vk_dev_descriptor_stats stats;
+
+	memset(&bench, 0, sizeof(bench));
+	bench.sets = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 10000;
+	bench.frames = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 100;
+	if (bench.sets < 4 || bench.frames == 0) {
+		fprintf(stderr, "usage: %s [SETS [FRAMES]]\n", argv[0]);
+		return 1;
+	}
+	bench.variants = bench.sets / 4;
+
+	context = vk_dev_context_create(-1);
+	_bench_create(&bench, context);
+
+	naive_ns = _bench_naive(&bench);
+	allocator_ns = _bench_allocator(&bench, false, &stats);
+
+	printf("%u sets per frame, %u frames, %u distinct sets\n", bench.sets,
+		bench.frames, bench.variants);
+	printf("%-10s %12s %11s\n", "path", "Msets/s", "speedup");
+	_bench_report(&bench, "naive", naive_ns, naive_ns);
+	_bench_report(&bench, "allocator", allocator_ns, naive_ns);
+	printf("(%llu pools created, %llu resets)\n",
+		(unsigned long long)stats.pool_creations,
+		(unsigned long long)stats.pool_resets);
+
+	cached_ns = _bench_allocator(&bench, true, &stats);
+	_bench_report(&bench, "cached", cached_ns, naive_ns);
+	printf("(%llu hits, %llu misses)\n", (unsigned long long)stats.cache_hits,
+		(unsigned long long)stats.cache_misses);
+
+	_bench_destroy(&bench);
+	vk_dev_context_destroy(context);
+
+	return 0;
+}
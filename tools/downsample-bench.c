@@ -0,0 +1,330 @@
+/*
+ *	NOTE:	Mip generation benchmark: downsample-bench [SIZE [ITERATIONS]]
+ *
+ *			Builds the mip chain of a SIZE x SIZE RGBA8 image (2048 by
+ *			default) with the single pass compute downsampler and with the
+ *			vkCmdBlitImage chain, timing each submission from vkQueueSubmit
+ *			until its fence signals, then reads every level of both back and
+ *			reports the largest per-channel difference between them. Run
+ *			with VK_ICD_FILENAMES pointing at lavapipe to measure the
+ *			software path.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/buffer.h>
+#include <vulkan-dev/descriptor.h>
+#include <vulkan-dev/downsample.h>
+#include <vulkan-dev/image.h>
+#include <vulkan-dev/staging.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct _bench {
+	struct vk_dev_context* context;
+	VkCommandPool command_pool;
+	VkCommandBuffer command_buffer;
+	VkFence fence;
+};
+
+static uint64_t
+_bench_time_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+static void
+_bench_create(struct _bench* bench, struct vk_dev_context* context)
+{
+	VkFenceCreateInfo fence_info;
+	VkCommandPoolCreateInfo pool_info;
+	VkCommandBufferAllocateInfo allocate_info;
+
+	bench->context = context;
+
+	pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	pool_info.pNext = NULL;
+	pool_info.flags = 0;
+	pool_info.queueFamilyIndex = context->queue_family;
+
+	if (context->vk.CreateCommandPool(context->device, &pool_info, NULL,
+		&bench->command_pool) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create command pool.");
+	}
+
+	allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocate_info.pNext = NULL;
+	allocate_info.commandPool = bench->command_pool;
+	allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocate_info.commandBufferCount = 1;
+
+	if (context->vk.AllocateCommandBuffers(context->device, &allocate_info,
+		&bench->command_buffer) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to allocate command buffer.");
+	}
+
+	fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fence_info.pNext = NULL;
+	fence_info.flags = 0;
+
+	if (context->vk.CreateFence(context->device, &fence_info, NULL,
+		&bench->fence) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create fence.");
+	}
+}
+
+static void
+_bench_destroy(struct _bench* bench)
+{
+	bench->context->vk.DestroyFence(bench->context->device, bench->fence,
+		NULL);
+	bench->context->vk.DestroyCommandPool(bench->context->device,
+		bench->command_pool, NULL);
+}
+
+static VkCommandBuffer
+_bench_begin(struct _bench* bench)
+{
+	VkCommandBufferBeginInfo begin_info;
+
+	bench->context->vk.ResetCommandPool(bench->context->device,
+		bench->command_pool, 0);
+
+	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.pNext = NULL;
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	begin_info.pInheritanceInfo = NULL;
+
+	if (bench->context->vk.BeginCommandBuffer(bench->command_buffer,
+		&begin_info) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to begin command buffer.");
+	}
+
+	return bench->command_buffer;
+}
+
+// NOTE: Returns the time from submission until the GPU finished.
+static uint64_t
+_bench_submit(struct _bench* bench)
+{
+	uint64_t start;
+	VkSubmitInfo submit_info;
+	struct vk_dev_context* context;
+
+	context = bench->context;
+
+	if (context->vk.EndCommandBuffer(bench->command_buffer) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to record command buffer.");
+	}
+
+	memset(&submit_info, 0, sizeof(submit_info));
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &bench->command_buffer;
+
+	start = _bench_time_ns();
+
+	if (context->vk.QueueSubmit(context->queue, 1, &submit_info,
+		bench->fence) != VK_SUCCESS ||
+		context->vk.WaitForFences(context->device, 1, &bench->fence, VK_TRUE,
+		UINT64_MAX) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to run command buffer.");
+	}
+
+	start = _bench_time_ns() - start;
+
+	context->vk.ResetFences(context->device, 1, &bench->fence);
+
+	return start;
+}
+
+/*
+ *	NOTE:	Copies every level but the first into buffer, tightly packed one
+ *			after another.
+ */
+static void
+_bench_read_back(struct _bench* bench, const struct vk_dev_image* image,
+	const VkImageLayout layout, struct vk_dev_buffer* buffer)
+{
+	VkDeviceSize offset;
+	VkCommandBuffer command_buffer;
+	VkImageMemoryBarrier barrier;
+	VkBufferImageCopy region;
+
+	command_buffer = _bench_begin(bench);
+
+	memset(&barrier, 0, sizeof(barrier));
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	barrier.oldLayout = layout;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image->image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.levelCount = image->levels;
+	barrier.subresourceRange.layerCount = 1;
+
+	bench->context->vk.CmdPipelineBarrier(command_buffer,
+		VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+		0, NULL, 0, NULL, 1, &barrier);
+
+	memset(&region, 0, sizeof(region));
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent.depth = 1;
+
+	offset = 0;
+	for (uint32_t i = 1; i < image->levels; i++) {
+		region.bufferOffset = offset;
+		region.imageSubresource.mipLevel = i;
+		region.imageExtent.width = image->width >> i > 0 ?
+			image->width >> i : 1;
+		region.imageExtent.height = image->height >> i > 0 ?
+			image->height >> i : 1;
+
+		bench->context->vk.CmdCopyImageToBuffer(command_buffer, image->image,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer->buffer, 1, &region);
+
+		offset += (VkDeviceSize)region.imageExtent.width *
+			region.imageExtent.height * 4;
+	}
+
+	_bench_submit(bench);
+}
+
+int
+main(int argc, char** argv)
+{
+	uint8_t* texels;
+	uint32_t size, levels, iterations, difference;
+	uint64_t blit_ns, compute_ns;
+	VkDeviceSize level_size, chain_size;
+	VkCommandBuffer command_buffer;
+	struct _bench bench;
+	struct vk_dev_context* context;
+	struct vk_dev_staging* staging;
+	struct vk_dev_downsample* downsample;
+	struct vk_dev_descriptor_allocator* allocator;
+	struct vk_dev_image blit_image, compute_image;
+	struct vk_dev_buffer blit_levels, compute_levels;
+
+	size = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 2048;
+	iterations = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 20;
+	if (size == 0 || size > 4096 || iterations == 0) {
+		fprintf(stderr, "usage: %s [SIZE (1-4096) [ITERATIONS]]\n", argv[0]);
+		return 1;
+	}
+
+	levels = 1;
+	while (size >> levels > 0) {
+		levels++;
+	}
+
+	context = vk_dev_context_create(-1);
+	_bench_create(&bench, context);
+
+	level_size = (VkDeviceSize)size * size * 4;
+	staging = vk_dev_staging_create(context, level_size);
+	allocator = vk_dev_descriptor_allocator_create(context, 1);
+
+	vk_dev_image_create(context, size, size, levels,
+		VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_SAMPLED_BIT |
+		VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+		&blit_image);
+	vk_dev_image_create(context, size, size, levels,
+		VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_SAMPLED_BIT |
+		VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT, &compute_image);
+
+	// NOTE: A noisy pattern, so a misplaced texel shows as a difference.
+	texels = malloc(level_size);
+	if (texels == NULL) {
+		vk_dev_fatal_error("[BENCH] Out of memory.");
+	}
+
+	for (VkDeviceSize i = 0; i < level_size; i++) {
+		texels[i] = (uint8_t)((i * 2654435761u) >> 24);
+	}
+
+	vk_dev_staging_upload_image(staging, &blit_image, 0, texels, level_size);
+	vk_dev_staging_flush(staging);
+	vk_dev_staging_upload_image(staging, &compute_image, 0, texels,
+		level_size);
+	vk_dev_staging_flush(staging);
+
+	downsample = vk_dev_downsample_create(context, &compute_image);
+
+	blit_ns = 0;
+	compute_ns = 0;
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		command_buffer = _bench_begin(&bench);
+		vk_dev_downsample_blit(context, command_buffer, &blit_image,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		blit_ns += _bench_submit(&bench);
+
+		vk_dev_descriptor_allocator_begin_frame(allocator, 0);
+
+		command_buffer = _bench_begin(&bench);
+		vk_dev_downsample_record(downsample, command_buffer, allocator,
+			i == 0 ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL :
+			VK_IMAGE_LAYOUT_GENERAL);
+		compute_ns += _bench_submit(&bench);
+	}
+
+	chain_size = level_size / 3 + 4 * levels;
+
+	vk_dev_buffer_create(context, chain_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &blit_levels);
+	vk_dev_buffer_create(context, chain_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &compute_levels);
+
+	_bench_read_back(&bench, &blit_image,
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, &blit_levels);
+	_bench_read_back(&bench, &compute_image, VK_IMAGE_LAYOUT_GENERAL,
+		&compute_levels);
+
+	difference = 0;
+	for (VkDeviceSize i = 0; i < chain_size; i++) {
+		uint8_t a = ((const uint8_t*)blit_levels.mapped)[i];
+		uint8_t b = ((const uint8_t*)compute_levels.mapped)[i];
+
+		if ((uint32_t)abs(a - b) > difference) {
+			difference = (uint32_t)abs(a - b);
+		}
+	}
+
+	printf("%ux%u, %u levels, %u iterations\n", size, size, levels,
+		iterations);
+	printf("blit chain:   %8.3f ms\n", blit_ns / 1e6 / iterations);
+	printf("single pass:  %8.3f ms\n", compute_ns / 1e6 / iterations);
+	printf("speedup:      %8.2fx\n", (double)blit_ns / compute_ns);
+	printf("max channel difference: %u\n", difference);
+
+	vk_dev_buffer_destroy(context, &compute_levels);
+	vk_dev_buffer_destroy(context, &blit_levels);
+	vk_dev_downsample_destroy(downsample);
+	vk_dev_image_destroy(context, &compute_image);
+	vk_dev_image_destroy(context, &blit_image);
+	vk_dev_descriptor_allocator_destroy(allocator);
+	vk_dev_staging_destroy(staging);
+	_bench_destroy(&bench);
+	vk_dev_context_destroy(context);
+
+	free(texels);
+
+	return 0;
+}
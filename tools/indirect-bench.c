@@ -0,0 +1,931 @@
+/*
+ *	NOTE:	GPU-driven drawing benchmark:
+ *			indirect-bench [OBJECTS [FRAMES]]
+ *
+ *			Renders a flat field of OBJECTS spheres (100000 by default, 256
+ *			triangles each) at 512x512 from a camera turning once around
+ *			the middle of the field over FRAMES frames (30 by default),
+ *			three ways:
+ *
+ *				direct		frustum culling on the CPU and one
+ *							vkCmdDrawIndexed per visible object.
+ *				indirect	vk_dev_indirect_cull and a single
+ *							vk_dev_indirect_draw.
+ *				occlusion	as indirect, also culling against a Hi-Z
+ *							pyramid of the previous frame's depth, built
+ *							after the pass with vk_dev_hiz_build.
+ *
+ *			and reports the average CPU recording time, GPU time (from
+ *			vkQueueSubmit until the fence signals), draws and triangles per
+ *			frame. At eye level nearby spheres hide most of the field, so
+ *			occlusion culling removes most of the frustum's triangles. On a
+ *			machine with other drivers, point VK_ICD_FILENAMES at lavapipe's
+ *			ICD manifest to run it on the CPU rasterizer.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/buffer.h>
+#include <vulkan-dev/descriptor.h>
+#include <vulkan-dev/hiz.h>
+#include <vulkan-dev/image.h>
+#include <vulkan-dev/indirect.h>
+#include <vulkan-dev/shader.h>
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_SIZE 512
+
+#define BENCH_RINGS 8
+#define BENCH_SEGMENTS 16
+
+#define BENCH_SPACING 3.0f
+#define BENCH_EYE_HEIGHT 1.5f
+
+#define BENCH_COLOUR_FORMAT VK_FORMAT_R8G8B8A8_UNORM
+#define BENCH_DEPTH_FORMAT VK_FORMAT_D32_SFLOAT
+
+enum _bench_mode {
+	BENCH_DIRECT,
+	BENCH_INDIRECT,
+	BENCH_OCCLUSION,
+	BENCH_MODE_COUNT,
+};
+
+static const char* const _mode_names[BENCH_MODE_COUNT] = {
+	"direct",
+	"indirect",
+	"occlusion",
+};
+
+struct _bench_result {
+	uint64_t record_ns;
+	uint64_t gpu_ns;
+	uint64_t draws;
+	uint64_t triangles;
+};
+
+struct _bench {
+	struct vk_dev_context* context;
+	VkCommandPool command_pool;
+	VkCommandBuffer command_buffer;
+	VkFence fence;
+
+	struct vk_dev_image colour;
+	struct vk_dev_image depth;
+	VkImageView colour_view;
+	VkImageView depth_view;
+	VkRenderPass render_pass;
+	VkFramebuffer framebuffer;
+
+	VkDescriptorSetLayout set_layout;
+	VkDescriptorPool descriptor_pool;
+	VkDescriptorSet set;
+	VkPipelineLayout layout;
+	VkPipeline pipeline;
+
+	struct vk_dev_buffer vertices;
+	struct vk_dev_buffer indices;
+	uint32_t index_count;
+
+	struct vk_dev_indirect* indirect;
+	struct vk_dev_hiz* hiz;
+	struct vk_dev_descriptor_allocator* allocator;
+	uint32_t object_count;
+};
+
+static uint64_t
+_bench_time_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+/*
+ *	NOTE:	Matrices are column-major and map to Vulkan clip space: y down,
+ *			depth 0 at the near plane and 1 at the far plane.
+ */
+static void
+_bench_multiply(float* result, const float* a, const float* b)
+{
+	for (uint32_t column = 0; column < 4; column++) {
+		for (uint32_t row = 0; row < 4; row++) {
+			result[column * 4 + row] = 0.0f;
+			for (uint32_t k = 0; k < 4; k++) {
+				result[column * 4 + row] += a[k * 4 + row] * b[column * 4 + k];
+			}
+		}
+	}
+}
+
+static void
+_bench_normalize(float* v)
+{
+	const float length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+
+	v[0] /= length;
+	v[1] /= length;
+	v[2] /= length;
+}
+
+static void
+_bench_camera(const float eye[3], const float heading,
+	float view_projection[16])
+{
+	float f, near, far;
+	float forward[3], side[3], up[3];
+	float view[16], projection[16];
+
+	forward[0] = cosf(heading);
+	forward[1] = -0.05f;
+	forward[2] = sinf(heading);
+	_bench_normalize(forward);
+
+	// NOTE: side = forward x (0, 1, 0), up = side x forward.
+	side[0] = -forward[2];
+	side[1] = 0.0f;
+	side[2] = forward[0];
+	_bench_normalize(side);
+
+	up[0] = side[1] * forward[2] - side[2] * forward[1];
+	up[1] = side[2] * forward[0] - side[0] * forward[2];
+	up[2] = side[0] * forward[1] - side[1] * forward[0];
+
+	memset(view, 0, sizeof(view));
+	for (uint32_t i = 0; i < 3; i++) {
+		view[i * 4 + 0] = side[i];
+		view[i * 4 + 1] = up[i];
+		view[i * 4 + 2] = -forward[i];
+	}
+	view[12] = -(side[0] * eye[0] + side[1] * eye[1] + side[2] * eye[2]);
+	view[13] = -(up[0] * eye[0] + up[1] * eye[1] + up[2] * eye[2]);
+	view[14] = forward[0] * eye[0] + forward[1] * eye[1] +
+		forward[2] * eye[2];
+	view[15] = 1.0f;
+
+	f = 1.0f / tanf(30.0f * 3.14159265f / 180.0f);
+	near = 0.1f;
+	far = 1000.0f;
+
+	memset(projection, 0, sizeof(projection));
+	projection[0] = f;
+	projection[5] = -f;
+	projection[10] = far / (near - far);
+	projection[11] = -1.0f;
+	projection[14] = near * far / (near - far);
+
+	_bench_multiply(view_projection, projection, view);
+}
+
+// NOTE: Gribb-Hartmann, as in shaders/cull.glsl.
+static bool
+_bench_visible(const float m[16], const struct vk_dev_indirect_object* object)
+{
+	float rows[4][4], planes[6][4], length;
+
+	for (uint32_t row = 0; row < 4; row++) {
+		for (uint32_t column = 0; column < 4; column++) {
+			rows[row][column] = m[column * 4 + row];
+		}
+	}
+
+	for (uint32_t i = 0; i < 4; i++) {
+		planes[0][i] = rows[3][i] + rows[0][i];
+		planes[1][i] = rows[3][i] - rows[0][i];
+		planes[2][i] = rows[3][i] + rows[1][i];
+		planes[3][i] = rows[3][i] - rows[1][i];
+		planes[4][i] = rows[2][i];
+		planes[5][i] = rows[3][i] - rows[2][i];
+	}
+
+	for (uint32_t i = 0; i < 6; i++) {
+		length = sqrtf(planes[i][0] * planes[i][0] +
+			planes[i][1] * planes[i][1] + planes[i][2] * planes[i][2]);
+		if ((planes[i][0] * object->center[0] +
+			planes[i][1] * object->center[1] +
+			planes[i][2] * object->center[2] + planes[i][3]) / length <
+			-object->radius) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void
+_bench_create_targets(struct _bench* bench)
+{
+	VkAttachmentDescription attachments[2];
+	VkAttachmentReference references[2];
+	VkSubpassDescription subpass;
+	VkSubpassDependency dependencies[2];
+	VkRenderPassCreateInfo create_info;
+	VkImageView views[2];
+	VkImageViewCreateInfo view_info;
+	VkFramebufferCreateInfo framebuffer_info;
+	struct vk_dev_context* context;
+
+	context = bench->context;
+
+	memset(attachments, 0, sizeof(attachments));
+	attachments[0].format = BENCH_COLOUR_FORMAT;
+	attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+	attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	attachments[0].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	attachments[1] = attachments[0];
+	attachments[1].format = BENCH_DEPTH_FORMAT;
+	attachments[1].finalLayout =
+		VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+	references[0].attachment = 0;
+	references[0].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	references[1].attachment = 1;
+	references[1].layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	memset(&subpass, 0, sizeof(subpass));
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &references[0];
+	subpass.pDepthStencilAttachment = &references[1];
+
+	/*
+	 *	NOTE:	The previous frame's attachment writes and Hi-Z build come
+	 *			before the clears, and the depth is written before this
+	 *			frame's Hi-Z build reads it.
+	 */
+	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[0].dstSubpass = 0;
+	dependencies[0].srcStageMask =
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+		VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	dependencies[0].dstStageMask =
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+		VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	dependencies[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[0].dependencyFlags = 0;
+
+	dependencies[1].srcSubpass = 0;
+	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	dependencies[1].srcAccessMask =
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	dependencies[1].dependencyFlags = 0;
+
+	memset(&create_info, 0, sizeof(create_info));
+	create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	create_info.attachmentCount = 2;
+	create_info.pAttachments = attachments;
+	create_info.subpassCount = 1;
+	create_info.pSubpasses = &subpass;
+	create_info.dependencyCount = 2;
+	create_info.pDependencies = dependencies;
+
+	if (context->vk.CreateRenderPass(context->device, &create_info, NULL,
+		&bench->render_pass) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create render pass.");
+	}
+
+	vk_dev_image_create(context, BENCH_SIZE, BENCH_SIZE, 1,
+		BENCH_COLOUR_FORMAT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+		&bench->colour);
+	bench->colour_view = vk_dev_image_view_create(context, &bench->colour, 0,
+		1);
+
+	vk_dev_image_create(context, BENCH_SIZE, BENCH_SIZE, 1,
+		BENCH_DEPTH_FORMAT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+		VK_IMAGE_USAGE_SAMPLED_BIT, &bench->depth);
+
+	// NOTE: vk_dev_image_view_create only makes color views.
+	memset(&view_info, 0, sizeof(view_info));
+	view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	view_info.image = bench->depth.image;
+	view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	view_info.format = BENCH_DEPTH_FORMAT;
+	view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	view_info.subresourceRange.levelCount = 1;
+	view_info.subresourceRange.layerCount = 1;
+
+	if (context->vk.CreateImageView(context->device, &view_info, NULL,
+		&bench->depth_view) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create depth view.");
+	}
+
+	views[0] = bench->colour_view;
+	views[1] = bench->depth_view;
+
+	memset(&framebuffer_info, 0, sizeof(framebuffer_info));
+	framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebuffer_info.renderPass = bench->render_pass;
+	framebuffer_info.attachmentCount = 2;
+	framebuffer_info.pAttachments = views;
+	framebuffer_info.width = BENCH_SIZE;
+	framebuffer_info.height = BENCH_SIZE;
+	framebuffer_info.layers = 1;
+
+	if (context->vk.CreateFramebuffer(context->device, &framebuffer_info,
+		NULL, &bench->framebuffer) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create framebuffer.");
+	}
+}
+
+static void
+_bench_create_descriptors(struct _bench* bench)
+{
+	VkDescriptorSetLayoutBinding binding;
+	VkDescriptorSetLayoutCreateInfo layout_info;
+	VkDescriptorPoolSize pool_size;
+	VkDescriptorPoolCreateInfo pool_info;
+	VkDescriptorSetAllocateInfo allocate_info;
+	VkDescriptorBufferInfo buffer_info;
+	VkWriteDescriptorSet write;
+	struct vk_dev_context* context;
+
+	context = bench->context;
+
+	binding.binding = 0;
+	binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	binding.descriptorCount = 1;
+	binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	binding.pImmutableSamplers = NULL;
+
+	memset(&layout_info, 0, sizeof(layout_info));
+	layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layout_info.bindingCount = 1;
+	layout_info.pBindings = &binding;
+
+	if (context->vk.CreateDescriptorSetLayout(context->device, &layout_info,
+		NULL, &bench->set_layout) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create set layout.");
+	}
+
+	pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	pool_size.descriptorCount = 1;
+
+	memset(&pool_info, 0, sizeof(pool_info));
+	pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.maxSets = 1;
+	pool_info.poolSizeCount = 1;
+	pool_info.pPoolSizes = &pool_size;
+
+	if (context->vk.CreateDescriptorPool(context->device, &pool_info, NULL,
+		&bench->descriptor_pool) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create descriptor pool.");
+	}
+
+	allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocate_info.pNext = NULL;
+	allocate_info.descriptorPool = bench->descriptor_pool;
+	allocate_info.descriptorSetCount = 1;
+	allocate_info.pSetLayouts = &bench->set_layout;
+
+	if (context->vk.AllocateDescriptorSets(context->device, &allocate_info,
+		&bench->set) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to allocate descriptor set.");
+	}
+
+	buffer_info.buffer = vk_dev_indirect_get_object_buffer(bench->indirect);
+	buffer_info.offset = 0;
+	buffer_info.range = VK_WHOLE_SIZE;
+
+	memset(&write, 0, sizeof(write));
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = bench->set;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	write.pBufferInfo = &buffer_info;
+
+	context->vk.UpdateDescriptorSets(context->device, 1, &write, 0, NULL);
+}
+
+static void
+_bench_create_pipeline(struct _bench* bench)
+{
+	VkShaderModule vertex, fragment;
+	VkPushConstantRange range;
+	VkPipelineLayoutCreateInfo layout_info;
+	VkPipelineShaderStageCreateInfo stages[2];
+	VkVertexInputBindingDescription vertex_binding;
+	VkVertexInputAttributeDescription vertex_attribute;
+	VkPipelineVertexInputStateCreateInfo vertex_input;
+	VkPipelineInputAssemblyStateCreateInfo input_assembly;
+	VkViewport viewport;
+	VkRect2D scissor;
+	VkPipelineViewportStateCreateInfo viewport_state;
+	VkPipelineRasterizationStateCreateInfo rasterization;
+	VkPipelineMultisampleStateCreateInfo multisample;
+	VkPipelineDepthStencilStateCreateInfo depth_stencil;
+	VkPipelineColorBlendAttachmentState blend_attachment;
+	VkPipelineColorBlendStateCreateInfo blend;
+	VkGraphicsPipelineCreateInfo create_info;
+	struct vk_dev_context* context;
+
+	context = bench->context;
+
+	range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	range.offset = 0;
+	range.size = sizeof(float) * 16;
+
+	memset(&layout_info, 0, sizeof(layout_info));
+	layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layout_info.setLayoutCount = 1;
+	layout_info.pSetLayouts = &bench->set_layout;
+	layout_info.pushConstantRangeCount = 1;
+	layout_info.pPushConstantRanges = &range;
+
+	if (context->vk.CreatePipelineLayout(context->device, &layout_info, NULL,
+		&bench->layout) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create pipeline layout.");
+	}
+
+	vertex = vk_dev_shader_module_load(context,
+		VK_DEV_SHADER_DIR "/bench_scene.vert.spv");
+	fragment = vk_dev_shader_module_load(context,
+		VK_DEV_SHADER_DIR "/bench_scene.frag.spv");
+
+	memset(stages, 0, sizeof(stages));
+	stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	stages[0].module = vertex;
+	stages[0].pName = "main";
+	stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	stages[1].module = fragment;
+	stages[1].pName = "main";
+
+	vertex_binding.binding = 0;
+	vertex_binding.stride = sizeof(float) * 3;
+	vertex_binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+	vertex_attribute.location = 0;
+	vertex_attribute.binding = 0;
+	vertex_attribute.format = VK_FORMAT_R32G32B32_SFLOAT;
+	vertex_attribute.offset = 0;
+
+	memset(&vertex_input, 0, sizeof(vertex_input));
+	vertex_input.sType =
+		VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertex_input.vertexBindingDescriptionCount = 1;
+	vertex_input.pVertexBindingDescriptions = &vertex_binding;
+	vertex_input.vertexAttributeDescriptionCount = 1;
+	vertex_input.pVertexAttributeDescriptions = &vertex_attribute;
+
+	memset(&input_assembly, 0, sizeof(input_assembly));
+	input_assembly.sType =
+		VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = BENCH_SIZE;
+	viewport.height = BENCH_SIZE;
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	scissor.offset.x = 0;
+	scissor.offset.y = 0;
+	scissor.extent.width = BENCH_SIZE;
+	scissor.extent.height = BENCH_SIZE;
+
+	memset(&viewport_state, 0, sizeof(viewport_state));
+	viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewport_state.viewportCount = 1;
+	viewport_state.pViewports = &viewport;
+	viewport_state.scissorCount = 1;
+	viewport_state.pScissors = &scissor;
+
+	memset(&rasterization, 0, sizeof(rasterization));
+	rasterization.sType =
+		VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterization.cullMode = VK_CULL_MODE_NONE;
+	rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	rasterization.lineWidth = 1.0f;
+
+	memset(&multisample, 0, sizeof(multisample));
+	multisample.sType =
+		VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	memset(&depth_stencil, 0, sizeof(depth_stencil));
+	depth_stencil.sType =
+		VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depth_stencil.depthTestEnable = VK_TRUE;
+	depth_stencil.depthWriteEnable = VK_TRUE;
+	depth_stencil.depthCompareOp = VK_COMPARE_OP_LESS;
+
+	memset(&blend_attachment, 0, sizeof(blend_attachment));
+	blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT |
+		VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT |
+		VK_COLOR_COMPONENT_A_BIT;
+
+	memset(&blend, 0, sizeof(blend));
+	blend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	blend.attachmentCount = 1;
+	blend.pAttachments = &blend_attachment;
+
+	memset(&create_info, 0, sizeof(create_info));
+	create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	create_info.stageCount = 2;
+	create_info.pStages = stages;
+	create_info.pVertexInputState = &vertex_input;
+	create_info.pInputAssemblyState = &input_assembly;
+	create_info.pViewportState = &viewport_state;
+	create_info.pRasterizationState = &rasterization;
+	create_info.pMultisampleState = &multisample;
+	create_info.pDepthStencilState = &depth_stencil;
+	create_info.pColorBlendState = &blend;
+	create_info.layout = bench->layout;
+	create_info.renderPass = bench->render_pass;
+	create_info.subpass = 0;
+
+	if (context->vk.CreateGraphicsPipelines(context->device, VK_NULL_HANDLE,
+		1, &create_info, NULL, &bench->pipeline) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create pipeline.");
+	}
+
+	context->vk.DestroyShaderModule(context->device, fragment, NULL);
+	context->vk.DestroyShaderModule(context->device, vertex, NULL);
+}
+
+// NOTE: A unit UV sphere; the pole rings hold degenerate triangles.
+static void
+_bench_create_mesh(struct _bench* bench)
+{
+	float theta, phi;
+	float* vertices;
+	uint32_t* indices;
+	uint32_t vertex_count, a, b;
+	struct vk_dev_context* context;
+
+	context = bench->context;
+
+	vertex_count = (BENCH_RINGS + 1) * (BENCH_SEGMENTS + 1);
+	bench->index_count = BENCH_RINGS * BENCH_SEGMENTS * 6;
+
+	vk_dev_buffer_create(context, sizeof(float) * 3 * vertex_count,
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &bench->vertices);
+	vk_dev_buffer_create(context, sizeof(uint32_t) * bench->index_count,
+		VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &bench->indices);
+
+	vertices = bench->vertices.mapped;
+	for (uint32_t ring = 0; ring <= BENCH_RINGS; ring++) {
+		phi = 3.14159265f * ring / BENCH_RINGS;
+		for (uint32_t segment = 0; segment <= BENCH_SEGMENTS; segment++) {
+			theta = 2.0f * 3.14159265f * segment / BENCH_SEGMENTS;
+			*vertices++ = sinf(phi) * cosf(theta);
+			*vertices++ = cosf(phi);
+			*vertices++ = sinf(phi) * sinf(theta);
+		}
+	}
+
+	indices = bench->indices.mapped;
+	for (uint32_t ring = 0; ring < BENCH_RINGS; ring++) {
+		for (uint32_t segment = 0; segment < BENCH_SEGMENTS; segment++) {
+			a = ring * (BENCH_SEGMENTS + 1) + segment;
+			b = a + BENCH_SEGMENTS + 1;
+
+			*indices++ = a;
+			*indices++ = b;
+			*indices++ = a + 1;
+			*indices++ = a + 1;
+			*indices++ = b;
+			*indices++ = b + 1;
+		}
+	}
+}
+
+// NOTE: A square field of unit spheres on the ground around the origin.
+static void
+_bench_create_scene(struct _bench* bench)
+{
+	uint32_t side;
+	struct vk_dev_indirect_object* objects;
+	struct vk_dev_indirect_mesh* mesh;
+
+	bench->indirect = vk_dev_indirect_create(bench->context,
+		bench->object_count, 1);
+
+	mesh = vk_dev_indirect_get_meshes(bench->indirect);
+	mesh->index_count = bench->index_count;
+	mesh->first_index = 0;
+	mesh->vertex_offset = 0;
+	mesh->padding = 0;
+
+	side = (uint32_t)ceilf(sqrtf((float)bench->object_count));
+
+	objects = vk_dev_indirect_get_objects(bench->indirect);
+	for (uint32_t i = 0; i < bench->object_count; i++) {
+		memset(&objects[i], 0, sizeof(objects[i]));
+		objects[i].center[0] = ((float)(i % side) - side / 2.0f + 0.5f) *
+			BENCH_SPACING;
+		objects[i].center[1] = 0.0f;
+		objects[i].center[2] = ((float)(i / side) - side / 2.0f + 0.5f) *
+			BENCH_SPACING;
+		objects[i].radius = 1.0f;
+		objects[i].mesh = 0;
+	}
+
+	vk_dev_indirect_set_object_count(bench->indirect, bench->object_count);
+}
+
+static void
+_bench_create(struct _bench* bench, struct vk_dev_context* context)
+{
+	VkFenceCreateInfo fence_info;
+	VkCommandPoolCreateInfo pool_info;
+	VkCommandBufferAllocateInfo allocate_info;
+
+	bench->context = context;
+
+	pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	pool_info.pNext = NULL;
+	pool_info.flags = 0;
+	pool_info.queueFamilyIndex = context->queue_family;
+
+	if (context->vk.CreateCommandPool(context->device, &pool_info, NULL,
+		&bench->command_pool) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create command pool.");
+	}
+
+	allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocate_info.pNext = NULL;
+	allocate_info.commandPool = bench->command_pool;
+	allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocate_info.commandBufferCount = 1;
+
+	if (context->vk.AllocateCommandBuffers(context->device, &allocate_info,
+		&bench->command_buffer) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to allocate command buffer.");
+	}
+
+	fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fence_info.pNext = NULL;
+	fence_info.flags = 0;
+
+	if (context->vk.CreateFence(context->device, &fence_info, NULL,
+		&bench->fence) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create fence.");
+	}
+
+	bench->allocator = vk_dev_descriptor_allocator_create(context, 1);
+	bench->hiz = vk_dev_hiz_create(context, BENCH_SIZE, BENCH_SIZE);
+
+	_bench_create_targets(bench);
+	_bench_create_mesh(bench);
+	_bench_create_scene(bench);
+	_bench_create_descriptors(bench);
+	_bench_create_pipeline(bench);
+}
+
+static void
+_bench_destroy(struct _bench* bench)
+{
+	struct vk_dev_context* context;
+
+	context = bench->context;
+
+	context->vk.DestroyPipeline(context->device, bench->pipeline, NULL);
+	context->vk.DestroyPipelineLayout(context->device, bench->layout, NULL);
+	context->vk.DestroyDescriptorPool(context->device,
+		bench->descriptor_pool, NULL);
+	context->vk.DestroyDescriptorSetLayout(context->device,
+		bench->set_layout, NULL);
+	vk_dev_indirect_destroy(bench->indirect);
+	vk_dev_buffer_destroy(context, &bench->indices);
+	vk_dev_buffer_destroy(context, &bench->vertices);
+	context->vk.DestroyFramebuffer(context->device, bench->framebuffer, NULL);
+	context->vk.DestroyImageView(context->device, bench->depth_view, NULL);
+	vk_dev_image_destroy(context, &bench->depth);
+	context->vk.DestroyImageView(context->device, bench->colour_view, NULL);
+	vk_dev_image_destroy(context, &bench->colour);
+	context->vk.DestroyRenderPass(context->device, bench->render_pass, NULL);
+	vk_dev_hiz_destroy(bench->hiz);
+	vk_dev_descriptor_allocator_destroy(bench->allocator);
+	context->vk.DestroyFence(context->device, bench->fence, NULL);
+	context->vk.DestroyCommandPool(context->device, bench->command_pool,
+		NULL);
+}
+
+static void
+_bench_begin_pass(struct _bench* bench, const float view_projection[16])
+{
+	VkDeviceSize offset;
+	VkClearValue clears[2];
+	VkRenderPassBeginInfo pass_info;
+	struct vk_dev_context* context;
+
+	context = bench->context;
+
+	memset(clears, 0, sizeof(clears));
+	clears[1].depthStencil.depth = 1.0f;
+
+	memset(&pass_info, 0, sizeof(pass_info));
+	pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	pass_info.renderPass = bench->render_pass;
+	pass_info.framebuffer = bench->framebuffer;
+	pass_info.renderArea.extent.width = BENCH_SIZE;
+	pass_info.renderArea.extent.height = BENCH_SIZE;
+	pass_info.clearValueCount = 2;
+	pass_info.pClearValues = clears;
+
+	context->vk.CmdBeginRenderPass(bench->command_buffer, &pass_info,
+		VK_SUBPASS_CONTENTS_INLINE);
+
+	offset = 0;
+	context->vk.CmdBindPipeline(bench->command_buffer,
+		VK_PIPELINE_BIND_POINT_GRAPHICS, bench->pipeline);
+	context->vk.CmdBindDescriptorSets(bench->command_buffer,
+		VK_PIPELINE_BIND_POINT_GRAPHICS, bench->layout, 0, 1, &bench->set, 0,
+		NULL);
+	context->vk.CmdBindVertexBuffers(bench->command_buffer, 0, 1,
+		&bench->vertices.buffer, &offset);
+	context->vk.CmdBindIndexBuffer(bench->command_buffer,
+		bench->indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+	context->vk.CmdPushConstants(bench->command_buffer, bench->layout,
+		VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(float) * 16, view_projection);
+}
+
+static void
+_bench_frame(struct _bench* bench, const enum _bench_mode mode,
+	const float eye[3], const float view_projection[16],
+	struct _bench_result* result)
+{
+	uint64_t start;
+	uint32_t draws;
+	VkSubmitInfo submit_info;
+	VkCommandBufferBeginInfo begin_info;
+	struct vk_dev_context* context;
+	struct vk_dev_indirect_stats stats;
+	const struct vk_dev_indirect_object* objects;
+
+	context = bench->context;
+
+	start = _bench_time_ns();
+
+	vk_dev_descriptor_allocator_begin_frame(bench->allocator, 0);
+	context->vk.ResetCommandPool(context->device, bench->command_pool, 0);
+
+	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.pNext = NULL;
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	begin_info.pInheritanceInfo = NULL;
+
+	if (context->vk.BeginCommandBuffer(bench->command_buffer, &begin_info) !=
+		VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to begin command buffer.");
+	}
+
+	draws = 0;
+	if (mode == BENCH_DIRECT) {
+		_bench_begin_pass(bench, view_projection);
+
+		objects = vk_dev_indirect_get_objects(bench->indirect);
+		for (uint32_t i = 0; i < bench->object_count; i++) {
+			if (_bench_visible(view_projection, &objects[i])) {
+				context->vk.CmdDrawIndexed(bench->command_buffer,
+					bench->index_count, 1, 0, 0, i);
+				draws++;
+			}
+		}
+	} else {
+		vk_dev_indirect_cull(bench->indirect, bench->command_buffer,
+			bench->allocator, view_projection, eye,
+			mode == BENCH_OCCLUSION ? bench->hiz : NULL);
+
+		_bench_begin_pass(bench, view_projection);
+		vk_dev_indirect_draw(bench->indirect, bench->command_buffer);
+	}
+
+	context->vk.CmdEndRenderPass(bench->command_buffer);
+
+	// NOTE: The pyramid the next frame culls against.
+	if (mode == BENCH_OCCLUSION) {
+		vk_dev_hiz_build(bench->hiz, bench->command_buffer, bench->allocator,
+			bench->depth_view, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+	}
+
+	if (context->vk.EndCommandBuffer(bench->command_buffer) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to record command buffer.");
+	}
+
+	result->record_ns += _bench_time_ns() - start;
+
+	memset(&submit_info, 0, sizeof(submit_info));
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &bench->command_buffer;
+
+	start = _bench_time_ns();
+
+	if (context->vk.QueueSubmit(context->queue, 1, &submit_info,
+		bench->fence) != VK_SUCCESS ||
+		context->vk.WaitForFences(context->device, 1, &bench->fence, VK_TRUE,
+		UINT64_MAX) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to run command buffer.");
+	}
+
+	result->gpu_ns += _bench_time_ns() - start;
+
+	context->vk.ResetFences(context->device, 1, &bench->fence);
+
+	if (mode == BENCH_DIRECT) {
+		result->draws += draws;
+		result->triangles += (uint64_t)draws * (bench->index_count / 3);
+	} else {
+		vk_dev_indirect_get_stats(bench->indirect, &stats);
+		result->draws += stats.draw_count;
+		result->triangles += stats.triangle_count;
+	}
+}
+
+int
+main(int argc, char** argv)
+{
+	float heading;
+	float view_projection[16];
+	const float eye[3] = {0.0f, BENCH_EYE_HEIGHT, 0.0f};
+	uint32_t frames;
+	struct _bench bench;
+	struct _bench_result results[BENCH_MODE_COUNT];
+	struct _bench_result* result;
+	struct vk_dev_context* context;
+
+	memset(&bench, 0, sizeof(bench));
+	bench.object_count = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) :
+		100000;
+	frames = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 30;
+	if (bench.object_count == 0 || frames == 0) {
+		fprintf(stderr, "usage: %s [OBJECTS [FRAMES]]\n", argv[0]);
+		return 1;
+	}
+
+	context = vk_dev_context_create(-1);
+	_bench_create(&bench, context);
+
+	printf("%u objects, %u frames, %ux%u\n", bench.object_count, frames,
+		BENCH_SIZE, BENCH_SIZE);
+	printf("%-10s %10s %10s %10s %12s\n", "mode", "record ms", "gpu ms",
+		"draws", "triangles");
+
+	for (uint32_t mode = 0; mode < BENCH_MODE_COUNT; mode++) {
+		result = &results[mode];
+
+		/*
+		 *	NOTE:	An untimed frame first, so the occlusion run starts with
+		 *			a pyramid to cull against.
+		 */
+		_bench_camera(eye, 0.0f, view_projection);
+		_bench_frame(&bench, mode, eye, view_projection, result);
+		memset(result, 0, sizeof(*result));
+
+		for (uint32_t f = 0; f < frames; f++) {
+			heading = 2.0f * 3.14159265f * f / frames;
+			_bench_camera(eye, heading, view_projection);
+			_bench_frame(&bench, mode, eye, view_projection, result);
+		}
+
+		printf("%-10s %10.3f %10.3f %10llu %12llu\n", _mode_names[mode],
+			(double)result->record_ns / frames / 1e6,
+			(double)result->gpu_ns / frames / 1e6,
+			(unsigned long long)(result->draws / frames),
+			(unsigned long long)(result->triangles / frames));
+	}
+
+	if (results[BENCH_INDIRECT].triangles > 0) {
+		printf("occlusion drew %.1f%% of the triangles in %.1f%% of the GPU "
+			"time\n", 100.0 * results[BENCH_OCCLUSION].triangles /
+			results[BENCH_INDIRECT].triangles,
+			100.0 * results[BENCH_OCCLUSION].gpu_ns /
+			results[BENCH_INDIRECT].gpu_ns);
+	}
+
+	_bench_destroy(&bench);
+	vk_dev_context_destroy(context);
+
+	return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ *	NOTE:	Meshlet build benchmark:
+ *			meshlet-bench [SIZE [ITERATIONS]]
+ *
+ *			Builds meshlets for a SIZE x SIZE quad grid (1000 by default,
+ *			two million triangles) with a wavy height, on one thread and on
+ *			every CPU, and loads it back from the offline cache. Reports
+ *			triangles per second for each and checks that all three produce
+ *			identical meshlets. The cache file is written to the working
+ *			directory and removed afterwards. Needs no GPU.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/jobs.h>
+#include <vulkan-dev/meshlet.h>
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_CACHE "meshlet-bench.cache"
+
+static uint64_t
+_bench_time_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+static void
+_bench_fill(const uint32_t size, float* positions, uint32_t* indices)
+{
+	float* p;
+	uint32_t a, b, c, d;
+	uint32_t* index;
+
+	for (uint32_t y = 0; y <= size; y++) {
+		for (uint32_t x = 0; x <= size; x++) {
+			p = &positions[((size_t)y * (size + 1) + x) * 3];
+			p[0] = (float)x;
+			p[1] = 4.0f * sinf(x * 0.05f) * cosf(y * 0.07f);
+			p[2] = (float)y;
+		}
+	}
+
+	index = indices;
+	for (uint32_t y = 0; y < size; y++) {
+		for (uint32_t x = 0; x < size; x++) {
+			a = y * (size + 1) + x;
+			b = a + 1;
+			c = a + size + 1;
+			d = c + 1;
+
+			*index++ = a;
+			*index++ = c;
+			*index++ = b;
+			*index++ = b;
+			*index++ = c;
+			*index++ = d;
+		}
+	}
+}
+
+static bool
+_bench_equal(const struct vk_dev_meshlet_mesh* a,
+	const struct vk_dev_meshlet_mesh* b)
+{
+	return a->meshlet_count == b->meshlet_count &&
+		a->vertex_count == b->vertex_count &&
+		a->triangle_count == b->triangle_count &&
+		memcmp(a->meshlets, b->meshlets,
+		sizeof(*a->meshlets) * a->meshlet_count) == 0 &&
+		memcmp(a->vertices, b->vertices,
+		sizeof(*a->vertices) * a->vertex_count) == 0 &&
+		memcmp(a->triangles, b->triangles, a->triangle_count * 3) == 0;
+}
+
+static void
+_bench_report(const char* path, const uint32_t triangles, const uint64_t ns)
+{
+	printf("%-10s %12.2f %10.2f\n", path, triangles / (ns / 1e9) / 1e6,
+		ns / 1e6);
+}
+
+int
+main(int argc, char** argv)
+{
+	uint32_t size, iterations, vertex_count, index_count;
+	uint64_t single_ns, parallel_ns, cached_ns;
+	float* positions;
+	uint32_t* indices;
+	struct vk_dev_jobs* jobs;
+	struct vk_dev_meshlet_mesh reference, mesh;
+
+	size = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1000;
+	iterations = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 4;
+	if (size == 0 || size > 16384 || iterations == 0) {
+		fprintf(stderr, "usage: %s [SIZE [ITERATIONS]]\n", argv[0]);
+		return 1;
+	}
+
+	vertex_count = (size + 1) * (size + 1);
+	index_count = size * size * 6;
+
+	positions = malloc(sizeof(*positions) * vertex_count * 3);
+	indices = malloc(sizeof(*indices) * index_count);
+	if (positions == NULL || indices == NULL) {
+		vk_dev_fatal_error("[BENCH] Out of memory.");
+	}
+
+	_bench_fill(size, positions, indices);
+	jobs = vk_dev_jobs_create(0);
+
+	vk_dev_meshlet_build(NULL, indices, index_count, positions,
+		sizeof(float) * 3, vertex_count, &reference);
+
+	single_ns = _bench_time_ns();
+	for (uint32_t i = 0; i < iterations; i++) {
+		vk_dev_meshlet_mesh_free(&reference);
+		vk_dev_meshlet_build(NULL, indices, index_count, positions,
+			sizeof(float) * 3, vertex_count, &reference);
+	}
+	single_ns = (_bench_time_ns() - single_ns) / iterations;
+
+	parallel_ns = 0;
+	for (uint32_t i = 0; i < iterations; i++) {
+		parallel_ns -= _bench_time_ns();
+		vk_dev_meshlet_build(jobs, indices, index_count, positions,
+			sizeof(float) * 3, vertex_count, &mesh);
+		parallel_ns += _bench_time_ns();
+
+		if (!_bench_equal(&reference, &mesh)) {
+			vk_dev_fatal_error("[BENCH] Parallel build differs.");
+		}
+		vk_dev_meshlet_mesh_free(&mesh);
+	}
+	parallel_ns /= iterations;
+
+	// NOTE: The first cached build misses and writes the file.
+	remove(BENCH_CACHE);
+	vk_dev_meshlet_build_cached(jobs, BENCH_CACHE, indices, index_count,
+		positions, sizeof(float) * 3, vertex_count, &mesh);
+	vk_dev_meshlet_mesh_free(&mesh);
+
+	cached_ns = 0;
+	for (uint32_t i = 0; i < iterations; i++) {
+		cached_ns -= _bench_time_ns();
+		vk_dev_meshlet_build_cached(jobs, BENCH_CACHE, indices, index_count,
+			positions, sizeof(float) * 3, vertex_count, &mesh);
+		cached_ns += _bench_time_ns();
+
+		if (!_bench_equal(&reference, &mesh)) {
+			vk_dev_fatal_error("[BENCH] Cached meshlets differ.");
+		}
+		vk_dev_meshlet_mesh_free(&mesh);
+	}
+	cached_ns /= iterations;
+	remove(BENCH_CACHE);
+
+	printf("%ux%u grid, %u triangles, %u meshlets, %u iterations\n", size,
+		size, index_count / 3, reference.meshlet_count, iterations);
+	printf("%-10s %12s %10s\n", "path", "Mtri/s", "ms");
+	_bench_report("single", index_count / 3, single_ns);
+	_bench_report("jobs", index_count / 3, parallel_ns);
+	_bench_report("cached", index_count / 3, cached_ns);
+	printf("(jobs on %u threads, cached includes hashing the mesh)\n",
+		vk_dev_jobs_get_thread_count(jobs));
+
+	vk_dev_meshlet_mesh_free(&reference);
+	vk_dev_jobs_destroy(jobs);
+	free(indices);
+	free(positions);
+
+	return 0;
+}
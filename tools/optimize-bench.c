@@ -0,0 +1,198 @@
+/*
+ *	NOTE:	Mesh optimizer benchmark:
+ *			optimize-bench [SIZE [ITERATIONS]]
+ *
+ *			Builds a SIZE x SIZE quad grid (1000 by default, two million
+ *			triangles) with its triangles shuffled, runs each optimizer pass
+ *			on it in the usual order and then the whole vk_dev_optimize_mesh
+ *			pipeline, and reports triangles per second and the ACMR and ATVR
+ *			of the output under a FIFO cache of VK_DEV_OPTIMIZE_CACHE_SIZE.
+ *			Copying the input before each in place pass is not timed. Needs
+ *			no GPU.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/optimize.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct _bench_vertex {
+	float position[3];
+	float uv[2];
+};
+
+static uint64_t
+_bench_time_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+static void
+_bench_fill(const uint32_t size, struct _bench_vertex* vertices,
+	uint32_t* indices)
+{
+	uint32_t a, b, c, d, seed, other, swap;
+	uint32_t* index;
+	struct _bench_vertex* vertex;
+
+	for (uint32_t y = 0; y <= size; y++) {
+		for (uint32_t x = 0; x <= size; x++) {
+			vertex = &vertices[y * (size + 1) + x];
+			vertex->position[0] = (float)x;
+			vertex->position[1] = 4.0f * sinf(x * 0.05f) * cosf(y * 0.07f);
+			vertex->position[2] = (float)y;
+			vertex->uv[0] = (float)x / size;
+			vertex->uv[1] = (float)y / size;
+		}
+	}
+
+	index = indices;
+	for (uint32_t y = 0; y < size; y++) {
+		for (uint32_t x = 0; x < size; x++) {
+			a = y * (size + 1) + x;
+			b = a + 1;
+			c = a + size + 1;
+			d = c + 1;
+
+			*index++ = a;
+			*index++ = c;
+			*index++ = b;
+			*index++ = b;
+			*index++ = c;
+			*index++ = d;
+		}
+	}
+
+	// NOTE: Fisher-Yates over whole triangles, as an unoptimized export.
+	seed = 1;
+	for (uint32_t i = size * size * 2 - 1; i > 0; i--) {
+		seed = seed * 1664525u + 1013904223u;
+		other = (uint32_t)(((uint64_t)seed * (i + 1)) >> 32);
+
+		for (uint32_t j = 0; j < 3; j++) {
+			swap = indices[i * 3 + j];
+			indices[i * 3 + j] = indices[other * 3 + j];
+			indices[other * 3 + j] = swap;
+		}
+	}
+}
+
+static void
+_bench_report(const char* pass, const uint32_t* indices,
+	const uint32_t index_count, const uint32_t vertex_count,
+	const uint64_t ns)
+{
+	struct vk_dev_vertex_cache_stats stats;
+
+	vk_dev_optimize_analyze_vertex_cache(indices, index_count, vertex_count,
+		VK_DEV_OPTIMIZE_CACHE_SIZE, &stats);
+
+	// NOTE: ns is 0 for the unoptimized input, which has no timing.
+	if (ns == 0) {
+		printf("%-14s %10s %10s %8.3f %8.3f\n", pass, "-", "-", stats.acmr,
+			stats.atvr);
+	} else {
+		printf("%-14s %10.2f %10.2f %8.3f %8.3f\n", pass,
+			index_count / 3 / (ns / 1e9) / 1e6, ns / 1e6, stats.acmr,
+			stats.atvr);
+	}
+}
+
+int
+main(int argc, char** argv)
+{
+	uint32_t size, iterations, vertex_count, index_count, used;
+	uint64_t ns;
+	uint32_t* source, * ordered, * layered, * work;
+	struct _bench_vertex* vertices, * fetched;
+
+	size = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1000;
+	iterations = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 4;
+	if (size == 0 || size > 16384 || iterations == 0) {
+		fprintf(stderr, "usage: %s [SIZE [ITERATIONS]]\n", argv[0]);
+		return 1;
+	}
+
+	vertex_count = (size + 1) * (size + 1);
+	index_count = size * size * 6;
+
+	vertices = malloc(sizeof(*vertices) * vertex_count);
+	fetched = malloc(sizeof(*fetched) * vertex_count);
+	source = malloc(sizeof(*source) * index_count);
+	ordered = malloc(sizeof(*ordered) * index_count);
+	layered = malloc(sizeof(*layered) * index_count);
+	work = malloc(sizeof(*work) * index_count);
+	if (vertices == NULL || fetched == NULL || source == NULL ||
+		ordered == NULL || layered == NULL || work == NULL) {
+		vk_dev_fatal_error("[BENCH] Out of memory.");
+	}
+
+	_bench_fill(size, vertices, source);
+
+	printf("%ux%u grid, %u triangles, %u iterations\n", size, size,
+		index_count / 3, iterations);
+	printf("%-14s %10s %10s %8s %8s\n", "pass", "Mtri/s", "ms", "acmr",
+		"atvr");
+
+	ns = _bench_time_ns();
+	for (uint32_t i = 0; i < iterations; i++) {
+		vk_dev_optimize_vertex_cache(ordered, source, index_count,
+			vertex_count);
+	}
+	ns = (_bench_time_ns() - ns) / iterations;
+	_bench_report("input", source, index_count, vertex_count, 0);
+	_bench_report("vertex cache", ordered, index_count, vertex_count, ns);
+
+	ns = _bench_time_ns();
+	for (uint32_t i = 0; i < iterations; i++) {
+		vk_dev_optimize_overdraw(layered, ordered, index_count,
+			vertices[0].position, sizeof(*vertices), vertex_count);
+	}
+	ns = (_bench_time_ns() - ns) / iterations;
+	_bench_report("overdraw", layered, index_count, vertex_count, ns);
+
+	ns = 0;
+	used = 0;
+	for (uint32_t i = 0; i < iterations; i++) {
+		memcpy(work, layered, sizeof(*work) * index_count);
+
+		ns -= _bench_time_ns();
+		used = vk_dev_optimize_vertex_fetch(fetched, vertices, work,
+			index_count, vertex_count, sizeof(*vertices));
+		ns += _bench_time_ns();
+	}
+	ns /= iterations;
+	_bench_report("vertex fetch", work, index_count, used, ns);
+
+	ns = 0;
+	for (uint32_t i = 0; i < iterations; i++) {
+		memcpy(fetched, vertices, sizeof(*vertices) * vertex_count);
+		memcpy(work, source, sizeof(*work) * index_count);
+
+		ns -= _bench_time_ns();
+		used = vk_dev_optimize_mesh(fetched, work, index_count, vertex_count,
+			sizeof(*fetched), fetched[0].position, NULL);
+		ns += _bench_time_ns();
+	}
+	ns /= iterations;
+	_bench_report("optimize mesh", work, index_count, used, ns);
+
+	free(work);
+	free(layered);
+	free(ordered);
+	free(source);
+	free(fetched);
+	free(vertices);
+
+	return 0;
+}
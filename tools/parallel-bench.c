@@ -0,0 +1,460 @@
+/*
+ *	NOTE:	Parallel render pass recording benchmark:
+ *			parallel-bench [DRAWS [ITERATIONS]]
+ *
+ *			Records a render pass of DRAWS small triangles (256, 4096 and
+ *			65536 by default), each with its own push constants, through
+ *			vk_dev_parallel_pass on 1 thread and on 2, 4, ... up to the
+ *			number of online CPUs, and reports the split chosen and the CPU
+ *			time spent recording, averaged over ITERATIONS (50 by default).
+ *			Every recording is also submitted and waited on, outside the
+ *			timed part, so the command buffers are known to be valid.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/image.h>
+#include <vulkan-dev/jobs.h>
+#include <vulkan-dev/parallel.h>
+#include <vulkan-dev/shader.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BENCH_SIZE 256
+
+struct _bench_constants {
+	float placement[4];
+	float colour[4];
+};
+
+struct _bench {
+	struct vk_dev_context* context;
+	VkCommandPool command_pool;
+	VkCommandBuffer command_buffer;
+	VkFence fence;
+
+	struct vk_dev_image target;
+	VkImageView view;
+	VkRenderPass render_pass;
+	VkFramebuffer framebuffer;
+	VkPipelineLayout layout;
+	VkPipeline pipeline;
+};
+
+static void
+_bench_create_render_pass(struct _bench* bench)
+{
+	VkAttachmentDescription attachment;
+	VkAttachmentReference reference;
+	VkSubpassDescription subpass;
+	VkRenderPassCreateInfo create_info;
+	VkFramebufferCreateInfo framebuffer_info;
+	struct vk_dev_context* context;
+
+	context = bench->context;
+
+	memset(&attachment, 0, sizeof(attachment));
+	attachment.format = VK_FORMAT_R8G8B8A8_UNORM;
+	attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	reference.attachment = 0;
+	reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	memset(&subpass, 0, sizeof(subpass));
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &reference;
+
+	memset(&create_info, 0, sizeof(create_info));
+	create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	create_info.attachmentCount = 1;
+	create_info.pAttachments = &attachment;
+	create_info.subpassCount = 1;
+	create_info.pSubpasses = &subpass;
+
+	if (context->vk.CreateRenderPass(context->device, &create_info, NULL,
+		&bench->render_pass) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create render pass.");
+	}
+
+	vk_dev_image_create(context, BENCH_SIZE, BENCH_SIZE, 1,
+		VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+		&bench->target);
+	bench->view = vk_dev_image_view_create(context, &bench->target, 0, 1);
+
+	memset(&framebuffer_info, 0, sizeof(framebuffer_info));
+	framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebuffer_info.renderPass = bench->render_pass;
+	framebuffer_info.attachmentCount = 1;
+	framebuffer_info.pAttachments = &bench->view;
+	framebuffer_info.width = BENCH_SIZE;
+	framebuffer_info.height = BENCH_SIZE;
+	framebuffer_info.layers = 1;
+
+	if (context->vk.CreateFramebuffer(context->device, &framebuffer_info,
+		NULL, &bench->framebuffer) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create framebuffer.");
+	}
+}
+
+static void
+_bench_create_pipeline(struct _bench* bench)
+{
+	VkShaderModule vertex, fragment;
+	VkPushConstantRange range;
+	VkPipelineLayoutCreateInfo layout_info;
+	VkPipelineShaderStageCreateInfo stages[2];
+	VkPipelineVertexInputStateCreateInfo vertex_input;
+	VkPipelineInputAssemblyStateCreateInfo input_assembly;
+	VkViewport viewport;
+	VkRect2D scissor;
+	VkPipelineViewportStateCreateInfo viewport_state;
+	VkPipelineRasterizationStateCreateInfo rasterization;
+	VkPipelineMultisampleStateCreateInfo multisample;
+	VkPipelineColorBlendAttachmentState blend_attachment;
+	VkPipelineColorBlendStateCreateInfo blend;
+	VkGraphicsPipelineCreateInfo create_info;
+	struct vk_dev_context* context;
+
+	context = bench->context;
+
+	range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	range.offset = 0;
+	range.size = sizeof(struct _bench_constants);
+
+	memset(&layout_info, 0, sizeof(layout_info));
+	layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layout_info.pushConstantRangeCount = 1;
+	layout_info.pPushConstantRanges = &range;
+
+	if (context->vk.CreatePipelineLayout(context->device, &layout_info, NULL,
+		&bench->layout) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create pipeline layout.");
+	}
+
+	vertex = vk_dev_shader_module_load(context,
+		VK_DEV_SHADER_DIR "/bench_draw.vert.spv");
+	fragment = vk_dev_shader_module_load(context,
+		VK_DEV_SHADER_DIR "/bench_draw.frag.spv");
+
+	memset(stages, 0, sizeof(stages));
+	stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	stages[0].module = vertex;
+	stages[0].pName = "main";
+	stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	stages[1].module = fragment;
+	stages[1].pName = "main";
+
+	memset(&vertex_input, 0, sizeof(vertex_input));
+	vertex_input.sType =
+		VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+	memset(&input_assembly, 0, sizeof(input_assembly));
+	input_assembly.sType =
+		VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = BENCH_SIZE;
+	viewport.height = BENCH_SIZE;
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	scissor.offset.x = 0;
+	scissor.offset.y = 0;
+	scissor.extent.width = BENCH_SIZE;
+	scissor.extent.height = BENCH_SIZE;
+
+	memset(&viewport_state, 0, sizeof(viewport_state));
+	viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewport_state.viewportCount = 1;
+	viewport_state.pViewports = &viewport;
+	viewport_state.scissorCount = 1;
+	viewport_state.pScissors = &scissor;
+
+	memset(&rasterization, 0, sizeof(rasterization));
+	rasterization.sType =
+		VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterization.cullMode = VK_CULL_MODE_NONE;
+	rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	rasterization.lineWidth = 1.0f;
+
+	memset(&multisample, 0, sizeof(multisample));
+	multisample.sType =
+		VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	memset(&blend_attachment, 0, sizeof(blend_attachment));
+	blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT |
+		VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT |
+		VK_COLOR_COMPONENT_A_BIT;
+
+	memset(&blend, 0, sizeof(blend));
+	blend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	blend.attachmentCount = 1;
+	blend.pAttachments = &blend_attachment;
+
+	memset(&create_info, 0, sizeof(create_info));
+	create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	create_info.stageCount = 2;
+	create_info.pStages = stages;
+	create_info.pVertexInputState = &vertex_input;
+	create_info.pInputAssemblyState = &input_assembly;
+	create_info.pViewportState = &viewport_state;
+	create_info.pRasterizationState = &rasterization;
+	create_info.pMultisampleState = &multisample;
+	create_info.pColorBlendState = &blend;
+	create_info.layout = bench->layout;
+	create_info.renderPass = bench->render_pass;
+	create_info.subpass = 0;
+
+	if (context->vk.CreateGraphicsPipelines(context->device, VK_NULL_HANDLE,
+		1, &create_info, NULL, &bench->pipeline) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create pipeline.");
+	}
+
+	context->vk.DestroyShaderModule(context->device, fragment, NULL);
+	context->vk.DestroyShaderModule(context->device, vertex, NULL);
+}
+
+static void
+_bench_create(struct _bench* bench, struct vk_dev_context* context)
+{
+	VkFenceCreateInfo fence_info;
+	VkCommandPoolCreateInfo pool_info;
+	VkCommandBufferAllocateInfo allocate_info;
+
+	bench->context = context;
+
+	pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	pool_info.pNext = NULL;
+	pool_info.flags = 0;
+	pool_info.queueFamilyIndex = context->queue_family;
+
+	if (context->vk.CreateCommandPool(context->device, &pool_info, NULL,
+		&bench->command_pool) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create command pool.");
+	}
+
+	allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocate_info.pNext = NULL;
+	allocate_info.commandPool = bench->command_pool;
+	allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocate_info.commandBufferCount = 1;
+
+	if (context->vk.AllocateCommandBuffers(context->device, &allocate_info,
+		&bench->command_buffer) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to allocate command buffer.");
+	}
+
+	fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fence_info.pNext = NULL;
+	fence_info.flags = 0;
+
+	if (context->vk.CreateFence(context->device, &fence_info, NULL,
+		&bench->fence) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create fence.");
+	}
+
+	_bench_create_render_pass(bench);
+	_bench_create_pipeline(bench);
+}
+
+static void
+_bench_destroy(struct _bench* bench)
+{
+	struct vk_dev_context* context;
+
+	context = bench->context;
+
+	context->vk.DestroyPipeline(context->device, bench->pipeline, NULL);
+	context->vk.DestroyPipelineLayout(context->device, bench->layout, NULL);
+	context->vk.DestroyFramebuffer(context->device, bench->framebuffer, NULL);
+	context->vk.DestroyImageView(context->device, bench->view, NULL);
+	vk_dev_image_destroy(context, &bench->target);
+	context->vk.DestroyRenderPass(context->device, bench->render_pass, NULL);
+	context->vk.DestroyFence(context->device, bench->fence, NULL);
+	context->vk.DestroyCommandPool(context->device, bench->command_pool,
+		NULL);
+}
+
+static void
+_bench_record_draws(void* arg, VkCommandBuffer command_buffer,
+	const uint32_t first, const uint32_t count)
+{
+	uint32_t draw;
+	struct _bench* bench;
+	struct _bench_constants constants;
+	struct vk_dev_context* context;
+
+	bench = arg;
+	context = bench->context;
+
+	context->vk.CmdBindPipeline(command_buffer,
+		VK_PIPELINE_BIND_POINT_GRAPHICS, bench->pipeline);
+
+	for (uint32_t i = 0; i < count; i++) {
+		draw = first + i;
+
+		constants.placement[0] = (float)(draw % 64) / 32.0f - 1.0f;
+		constants.placement[1] = (float)(draw / 64 % 64) / 32.0f - 1.0f;
+		constants.placement[2] = 1.0f / 64.0f;
+		constants.placement[3] = 0.0f;
+		constants.colour[0] = (float)(draw & 0xff) / 255.0f;
+		constants.colour[1] = (float)(draw >> 8 & 0xff) / 255.0f;
+		constants.colour[2] = 0.5f;
+		constants.colour[3] = 1.0f;
+
+		context->vk.CmdPushConstants(command_buffer, bench->layout,
+			VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+		context->vk.CmdDraw(command_buffer, 3, 1, 0, 0);
+	}
+}
+
+/*
+ *	NOTE:	Returns the average recording time in nanoseconds and the split
+ *			of the last iteration.
+ */
+static uint64_t
+_bench_run(struct _bench* bench, struct vk_dev_parallel_pass* pass,
+	const uint32_t draws, const uint32_t iterations,
+	struct vk_dev_parallel_stats* stats)
+{
+	uint64_t total;
+	VkClearValue clear;
+	VkSubmitInfo submit_info;
+	VkRenderPassBeginInfo pass_info;
+	VkCommandBufferBeginInfo begin_info;
+	struct vk_dev_context* context;
+
+	context = bench->context;
+
+	memset(&clear, 0, sizeof(clear));
+
+	memset(&pass_info, 0, sizeof(pass_info));
+	pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	pass_info.renderPass = bench->render_pass;
+	pass_info.framebuffer = bench->framebuffer;
+	pass_info.renderArea.extent.width = BENCH_SIZE;
+	pass_info.renderArea.extent.height = BENCH_SIZE;
+	pass_info.clearValueCount = 1;
+	pass_info.pClearValues = &clear;
+
+	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.pNext = NULL;
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	begin_info.pInheritanceInfo = NULL;
+
+	memset(&submit_info, 0, sizeof(submit_info));
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &bench->command_buffer;
+
+	total = 0;
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		context->vk.ResetCommandPool(context->device, bench->command_pool, 0);
+
+		if (context->vk.BeginCommandBuffer(bench->command_buffer,
+			&begin_info) != VK_SUCCESS) {
+			vk_dev_fatal_error("[BENCH] Failed to begin command buffer.");
+		}
+
+		vk_dev_parallel_pass_record(pass, bench->command_buffer, &pass_info,
+			draws, _bench_record_draws, bench);
+		vk_dev_parallel_pass_get_stats(pass, stats);
+		total += stats->record_ns;
+
+		if (context->vk.EndCommandBuffer(bench->command_buffer) !=
+			VK_SUCCESS) {
+			vk_dev_fatal_error("[BENCH] Failed to record command buffer.");
+		}
+
+		if (context->vk.QueueSubmit(context->queue, 1, &submit_info,
+			bench->fence) != VK_SUCCESS ||
+			context->vk.WaitForFences(context->device, 1, &bench->fence,
+			VK_TRUE, UINT64_MAX) != VK_SUCCESS) {
+			vk_dev_fatal_error("[BENCH] Failed to run command buffer.");
+		}
+
+		context->vk.ResetFences(context->device, 1, &bench->fence);
+	}
+
+	return total / iterations;
+}
+
+int
+main(int argc, char** argv)
+{
+	long cpus;
+	uint64_t ns, single_ns;
+	uint32_t draws[3] = {256, 4096, 65536};
+	uint32_t draw_count, iterations, max_threads;
+	struct _bench bench;
+	struct vk_dev_jobs* jobs;
+	struct vk_dev_parallel_pass* pass;
+	struct vk_dev_parallel_stats stats;
+	struct vk_dev_context* context;
+
+	draw_count = 3;
+	if (argc > 1) {
+		draws[0] = (uint32_t)strtoul(argv[1], NULL, 10);
+		draw_count = 1;
+	}
+
+	iterations = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 50;
+	if (draws[0] == 0 || iterations == 0) {
+		fprintf(stderr, "usage: %s [DRAWS [ITERATIONS]]\n", argv[0]);
+		return 1;
+	}
+
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	max_threads = cpus > 1 ? (uint32_t)cpus : 1;
+
+	context = vk_dev_context_create(-1);
+	_bench_create(&bench, context);
+
+	printf("%u iterations, %u CPUs\n", iterations, max_threads);
+	printf("   draws  threads  chunks  chunk size  record ms  speedup\n");
+
+	for (uint32_t d = 0; d < draw_count; d++) {
+		single_ns = 0;
+
+		for (uint32_t threads = 1; threads <= max_threads; threads *= 2) {
+			jobs = vk_dev_jobs_create(threads);
+			pass = vk_dev_parallel_pass_create(context, jobs);
+
+			ns = _bench_run(&bench, pass, draws[d], iterations, &stats);
+			if (threads == 1) {
+				single_ns = ns;
+			}
+
+			printf("%8u  %7u  %6u  %10u  %9.3f  %6.2fx\n", draws[d],
+				threads, stats.chunk_count, stats.chunk_size, ns / 1e6,
+				(double)single_ns / ns);
+
+			vk_dev_parallel_pass_destroy(pass);
+			vk_dev_jobs_destroy(jobs);
+		}
+	}
+
+	_bench_destroy(&bench);
+	vk_dev_context_destroy(context);
+
+	return 0;
+}
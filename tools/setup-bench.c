@@ -0,0 +1,121 @@
+/*
+ *	NOTE:	Setup and terminate latency benchmark:
+ *			setup-bench [CYCLES]
+ *
+ *			Runs CYCLES (100 by default) vk_dev_setup / vk_dev_terminate
+ *			cycles in one process and reports the 50th, 90th and 99th
+ *			percentile and the worst time of each setup phase, of the whole
+ *			setup and of terminate. The first cycle pays for cold disk
+ *			caches and is reported on its own. To measure against lavapipe
+ *			on a machine with other drivers, point VK_ICD_FILENAMES at its
+ *			ICD manifest (lvp_icd.x86_64.json).
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <vulkan-dev/vulkan-dev.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_ROWS (VK_DEV_SETUP_PHASE_COUNT + 2)
+
+static uint64_t
+_bench_time_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+static int
+_bench_compare(const void* a, const void* b)
+{
+	const uint64_t x = *(const uint64_t*)a;
+	const uint64_t y = *(const uint64_t*)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static double
+_bench_percentile(const uint64_t* sorted, const uint32_t count,
+	const uint32_t percent)
+{
+	return (double)sorted[(uint64_t)(count - 1) * percent / 100] / 1e6;
+}
+
+// NOTE: samples[0] is the cold first cycle, left out of the percentiles.
+static void
+_bench_report(const char* name, uint64_t* samples, const uint32_t count)
+{
+	qsort(samples + 1, count - 1, sizeof(*samples), _bench_compare);
+
+	printf("%-24s %9.3f %9.3f %9.3f %9.3f %9.3f\n", name,
+		(double)samples[0] / 1e6,
+		_bench_percentile(samples + 1, count - 1, 50),
+		_bench_percentile(samples + 1, count - 1, 90),
+		_bench_percentile(samples + 1, count - 1, 99),
+		(double)samples[count - 1] / 1e6);
+}
+
+int
+main(int argc, char** argv)
+{
+	uint32_t cycles;
+	uint64_t start;
+	uint64_t* samples[BENCH_ROWS];
+	struct vk_dev_setup_timings timings;
+
+	cycles = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 100;
+	if (cycles < 2) {
+		fprintf(stderr, "usage: %s [CYCLES]\n", argv[0]);
+		return 1;
+	}
+
+	// NOTE: Rows are the setup phases, then the whole setup, then terminate.
+	for (uint32_t r = 0; r < BENCH_ROWS; r++) {
+		samples[r] = malloc(sizeof(*samples[r]) * cycles);
+		if (samples[r] == NULL) {
+			vk_dev_fatal_error("[BENCH] Out of memory.");
+		}
+	}
+
+	for (uint32_t c = 0; c < cycles; c++) {
+		start = _bench_time_ns();
+		vk_dev_setup();
+		start = _bench_time_ns() - start;
+
+		vk_dev_get_setup_timings(&timings);
+
+		for (uint32_t p = 0; p < VK_DEV_SETUP_PHASE_COUNT; p++) {
+			samples[p][c] = timings.phase_ns[p];
+		}
+		samples[VK_DEV_SETUP_PHASE_COUNT][c] = start;
+
+		start = _bench_time_ns();
+		vk_dev_terminate();
+		start = _bench_time_ns() - start;
+
+		samples[VK_DEV_SETUP_PHASE_COUNT + 1][c] = start;
+	}
+
+	printf("%u cycles, times in ms\n", cycles);
+	printf("%-24s %9s %9s %9s %9s %9s\n", "", "first", "p50", "p90", "p99",
+		"max");
+
+	for (uint32_t p = 0; p < VK_DEV_SETUP_PHASE_COUNT; p++) {
+		_bench_report(vk_dev_setup_phase_name(p), samples[p], cycles);
+	}
+	_bench_report("setup", samples[VK_DEV_SETUP_PHASE_COUNT], cycles);
+	_bench_report("terminate", samples[VK_DEV_SETUP_PHASE_COUNT + 1],
+		cycles);
+
+	for (uint32_t r = 0; r < BENCH_ROWS; r++) {
+		free(samples[r]);
+	}
+
+	return 0;
+}
@@ -0,0 +1,569 @@
+/*
+ *	NOTE:	Texture streaming feedback check:
+ *			streaming-bench [SIZE [FRAMES]]
+ *
+ *			Bakes a SIZE x SIZE texture with a full mip chain (2048 by
+ *			default, a power of two) and draws it across a 512x512 target
+ *			through shaders/streaming.glsl for up to FRAMES frames (60 by
+ *			default). Only the mip tail is resident at first and it is
+ *			magnified on screen, so the feedback has to ask for a level
+ *			finer than the resident one for anything to load. Fails if no
+ *			level is ever loaded, otherwise reports the frames and time it
+ *			took and the resident bytes. The asset file is written to the
+ *			working directory and removed afterwards. On a machine with other
+ *			drivers, point VK_ICD_FILENAMES at lavapipe's ICD manifest to run
+ *			it on the CPU rasterizer.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <vulkan-dev/vulkan-dev.h>
+#include <vulkan-dev/context.h>
+#include <vulkan-dev/asset.h>
+#include <vulkan-dev/baker.h>
+#include <vulkan-dev/bindless.h>
+#include <vulkan-dev/image.h>
+#include <vulkan-dev/shader.h>
+#include <vulkan-dev/staging.h>
+#include <vulkan-dev/streaming.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_SIZE 512
+#define BENCH_ASSET "streaming-bench.asset"
+
+#define BENCH_COLOUR_FORMAT VK_FORMAT_R8G8B8A8_UNORM
+
+#define BENCH_STAGING_SIZE (16ull << 20)
+#define BENCH_BUDGET (512ull << 20)
+
+struct _bench_constants {
+	uint32_t table;
+	uint32_t texture_index;
+	uint32_t sampler_handle;
+};
+
+struct _bench {
+	struct vk_dev_context* context;
+	VkCommandPool command_pool;
+	VkCommandBuffer command_buffer;
+	VkFence fence;
+
+	struct vk_dev_image colour;
+	VkImageView colour_view;
+	VkRenderPass render_pass;
+	VkFramebuffer framebuffer;
+
+	VkPipelineLayout layout;
+	VkPipeline pipeline;
+
+	VkSampler sampler;
+	struct vk_dev_bindless* bindless;
+	struct vk_dev_staging* staging;
+	struct vk_dev_streaming* streaming;
+	struct vk_dev_asset_file* file;
+	struct _bench_constants constants;
+};
+
+static uint64_t
+_bench_time_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+// NOTE: A checkerboard, tinted per level so loaded levels are visible.
+static void
+_bench_bake(const uint32_t size)
+{
+	uint8_t* texels;
+	uint8_t* texel;
+	uint32_t level_count, extent;
+	const void* levels[16];
+	uint64_t level_sizes[16];
+	size_t total;
+	struct vk_dev_baker* baker;
+
+	level_count = 0;
+	total = 0;
+	for (extent = size; extent > 0; extent >>= 1) {
+		level_sizes[level_count++] = (uint64_t)extent * extent * 4;
+		total += (size_t)extent * extent * 4;
+	}
+
+	texels = malloc(total);
+	if (texels == NULL) {
+		vk_dev_fatal_error("[BENCH] Out of memory.");
+	}
+
+	texel = texels;
+	for (uint32_t level = 0; level < level_count; level++) {
+		levels[level] = texel;
+
+		extent = size >> level;
+		for (uint32_t y = 0; y < extent; y++) {
+			for (uint32_t x = 0; x < extent; x++) {
+				*texel++ = (uint8_t)(level * 255 / level_count);
+				*texel++ = (((x * 16 / extent) ^ (y * 16 / extent)) & 1) ?
+					255 : 0;
+				*texel++ = 128;
+				*texel++ = 255;
+			}
+		}
+	}
+
+	baker = vk_dev_baker_create(BENCH_ASSET);
+	if (baker == NULL) {
+		vk_dev_fatal_error("[BENCH] Failed to create " BENCH_ASSET ".");
+	}
+
+	vk_dev_baker_add_texture(baker, "texture", BENCH_COLOUR_FORMAT, size,
+		size, level_count, levels, level_sizes);
+
+	if (!vk_dev_baker_finish(baker)) {
+		vk_dev_fatal_error("[BENCH] Failed to write " BENCH_ASSET ".");
+	}
+
+	free(texels);
+}
+
+static void
+_bench_create_targets(struct _bench* bench)
+{
+	VkAttachmentDescription attachment;
+	VkAttachmentReference reference;
+	VkSubpassDescription subpass;
+	VkRenderPassCreateInfo create_info;
+	VkFramebufferCreateInfo framebuffer_info;
+	struct vk_dev_context* context;
+
+	context = bench->context;
+
+	memset(&attachment, 0, sizeof(attachment));
+	attachment.format = BENCH_COLOUR_FORMAT;
+	attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	attachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	reference.attachment = 0;
+	reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	memset(&subpass, 0, sizeof(subpass));
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &reference;
+
+	memset(&create_info, 0, sizeof(create_info));
+	create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	create_info.attachmentCount = 1;
+	create_info.pAttachments = &attachment;
+	create_info.subpassCount = 1;
+	create_info.pSubpasses = &subpass;
+
+	if (context->vk.CreateRenderPass(context->device, &create_info, NULL,
+		&bench->render_pass) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create render pass.");
+	}
+
+	vk_dev_image_create(context, BENCH_SIZE, BENCH_SIZE, 1,
+		BENCH_COLOUR_FORMAT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+		&bench->colour);
+	bench->colour_view = vk_dev_image_view_create(context, &bench->colour, 0,
+		1);
+
+	memset(&framebuffer_info, 0, sizeof(framebuffer_info));
+	framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebuffer_info.renderPass = bench->render_pass;
+	framebuffer_info.attachmentCount = 1;
+	framebuffer_info.pAttachments = &bench->colour_view;
+	framebuffer_info.width = BENCH_SIZE;
+	framebuffer_info.height = BENCH_SIZE;
+	framebuffer_info.layers = 1;
+
+	if (context->vk.CreateFramebuffer(context->device, &framebuffer_info,
+		NULL, &bench->framebuffer) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create framebuffer.");
+	}
+}
+
+static void
+_bench_create_pipeline(struct _bench* bench)
+{
+	VkShaderModule vertex, fragment;
+	VkDescriptorSetLayout set_layout;
+	VkPushConstantRange range;
+	VkPipelineLayoutCreateInfo layout_info;
+	VkPipelineShaderStageCreateInfo stages[2];
+	VkPipelineVertexInputStateCreateInfo vertex_input;
+	VkPipelineInputAssemblyStateCreateInfo input_assembly;
+	VkViewport viewport;
+	VkRect2D scissor;
+	VkPipelineViewportStateCreateInfo viewport_state;
+	VkPipelineRasterizationStateCreateInfo rasterization;
+	VkPipelineMultisampleStateCreateInfo multisample;
+	VkPipelineColorBlendAttachmentState blend_attachment;
+	VkPipelineColorBlendStateCreateInfo blend;
+	VkGraphicsPipelineCreateInfo create_info;
+	struct vk_dev_context* context;
+
+	context = bench->context;
+
+	range.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	range.offset = 0;
+	range.size = sizeof(struct _bench_constants);
+
+	set_layout = vk_dev_bindless_get_layout(bench->bindless);
+
+	memset(&layout_info, 0, sizeof(layout_info));
+	layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layout_info.setLayoutCount = 1;
+	layout_info.pSetLayouts = &set_layout;
+	layout_info.pushConstantRangeCount = 1;
+	layout_info.pPushConstantRanges = &range;
+
+	if (context->vk.CreatePipelineLayout(context->device, &layout_info, NULL,
+		&bench->layout) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create pipeline layout.");
+	}
+
+	vertex = vk_dev_shader_module_load(context,
+		VK_DEV_SHADER_DIR "/bench_streaming.vert.spv");
+	fragment = vk_dev_shader_module_load(context,
+		VK_DEV_SHADER_DIR "/bench_streaming.frag.spv");
+
+	memset(stages, 0, sizeof(stages));
+	stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	stages[0].module = vertex;
+	stages[0].pName = "main";
+	stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	stages[1].module = fragment;
+	stages[1].pName = "main";
+
+	memset(&vertex_input, 0, sizeof(vertex_input));
+	vertex_input.sType =
+		VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+	memset(&input_assembly, 0, sizeof(input_assembly));
+	input_assembly.sType =
+		VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = BENCH_SIZE;
+	viewport.height = BENCH_SIZE;
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	scissor.offset.x = 0;
+	scissor.offset.y = 0;
+	scissor.extent.width = BENCH_SIZE;
+	scissor.extent.height = BENCH_SIZE;
+
+	memset(&viewport_state, 0, sizeof(viewport_state));
+	viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewport_state.viewportCount = 1;
+	viewport_state.pViewports = &viewport;
+	viewport_state.scissorCount = 1;
+	viewport_state.pScissors = &scissor;
+
+	memset(&rasterization, 0, sizeof(rasterization));
+	rasterization.sType =
+		VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterization.cullMode = VK_CULL_MODE_NONE;
+	rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	rasterization.lineWidth = 1.0f;
+
+	memset(&multisample, 0, sizeof(multisample));
+	multisample.sType =
+		VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	memset(&blend_attachment, 0, sizeof(blend_attachment));
+	blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT |
+		VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT |
+		VK_COLOR_COMPONENT_A_BIT;
+
+	memset(&blend, 0, sizeof(blend));
+	blend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	blend.attachmentCount = 1;
+	blend.pAttachments = &blend_attachment;
+
+	memset(&create_info, 0, sizeof(create_info));
+	create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	create_info.stageCount = 2;
+	create_info.pStages = stages;
+	create_info.pVertexInputState = &vertex_input;
+	create_info.pInputAssemblyState = &input_assembly;
+	create_info.pViewportState = &viewport_state;
+	create_info.pRasterizationState = &rasterization;
+	create_info.pMultisampleState = &multisample;
+	create_info.pColorBlendState = &blend;
+	create_info.layout = bench->layout;
+	create_info.renderPass = bench->render_pass;
+	create_info.subpass = 0;
+
+	if (context->vk.CreateGraphicsPipelines(context->device, VK_NULL_HANDLE,
+		1, &create_info, NULL, &bench->pipeline) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create pipeline.");
+	}
+
+	context->vk.DestroyShaderModule(context->device, fragment, NULL);
+	context->vk.DestroyShaderModule(context->device, vertex, NULL);
+}
+
+static void
+_bench_create_streaming(struct _bench* bench, const uint32_t size)
+{
+	VkSamplerCreateInfo sampler_info;
+	const struct vk_dev_asset_entry* entry;
+	struct vk_dev_context* context;
+
+	context = bench->context;
+
+	memset(&sampler_info, 0, sizeof(sampler_info));
+	sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	sampler_info.magFilter = VK_FILTER_LINEAR;
+	sampler_info.minFilter = VK_FILTER_LINEAR;
+	sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	sampler_info.maxAnisotropy = 1.0f;
+	sampler_info.compareOp = VK_COMPARE_OP_ALWAYS;
+	sampler_info.maxLod = VK_LOD_CLAMP_NONE;
+	sampler_info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+
+	if (context->vk.CreateSampler(context->device, &sampler_info, NULL,
+		&bench->sampler) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create sampler.");
+	}
+
+	_bench_bake(size);
+
+	bench->file = vk_dev_asset_open(BENCH_ASSET);
+	if (bench->file == NULL) {
+		vk_dev_fatal_error("[BENCH] Failed to open " BENCH_ASSET ".");
+	}
+	entry = vk_dev_asset_get_entry(bench->file, 0);
+
+	// NOTE: Room for the resident image and the ones waiting to retire.
+	bench->bindless = vk_dev_bindless_create(context, 4, 1, 1);
+	bench->staging = vk_dev_staging_create(context, BENCH_STAGING_SIZE);
+	bench->streaming = vk_dev_streaming_create(context, bench->bindless,
+		bench->staging, 1, 1, BENCH_BUDGET);
+
+	bench->constants.table = vk_dev_streaming_get_table(bench->streaming, 0);
+	bench->constants.texture_index = vk_dev_streaming_add_texture(
+		bench->streaming, bench->file, entry);
+	bench->constants.sampler_handle = vk_dev_bindless_add_sampler(
+		bench->bindless, bench->sampler);
+}
+
+static void
+_bench_create(struct _bench* bench, struct vk_dev_context* context,
+	const uint32_t size)
+{
+	VkFenceCreateInfo fence_info;
+	VkCommandPoolCreateInfo pool_info;
+	VkCommandBufferAllocateInfo allocate_info;
+
+	bench->context = context;
+
+	pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	pool_info.pNext = NULL;
+	pool_info.flags = 0;
+	pool_info.queueFamilyIndex = context->queue_family;
+
+	if (context->vk.CreateCommandPool(context->device, &pool_info, NULL,
+		&bench->command_pool) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create command pool.");
+	}
+
+	allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocate_info.pNext = NULL;
+	allocate_info.commandPool = bench->command_pool;
+	allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocate_info.commandBufferCount = 1;
+
+	if (context->vk.AllocateCommandBuffers(context->device, &allocate_info,
+		&bench->command_buffer) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to allocate command buffer.");
+	}
+
+	fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fence_info.pNext = NULL;
+	fence_info.flags = 0;
+
+	if (context->vk.CreateFence(context->device, &fence_info, NULL,
+		&bench->fence) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to create fence.");
+	}
+
+	_bench_create_streaming(bench, size);
+	_bench_create_targets(bench);
+	_bench_create_pipeline(bench);
+}
+
+static void
+_bench_destroy(struct _bench* bench)
+{
+	struct vk_dev_context* context;
+
+	context = bench->context;
+
+	context->vk.DestroyPipeline(context->device, bench->pipeline, NULL);
+	context->vk.DestroyPipelineLayout(context->device, bench->layout, NULL);
+	context->vk.DestroyFramebuffer(context->device, bench->framebuffer, NULL);
+	context->vk.DestroyImageView(context->device, bench->colour_view, NULL);
+	vk_dev_image_destroy(context, &bench->colour);
+	context->vk.DestroyRenderPass(context->device, bench->render_pass, NULL);
+	vk_dev_streaming_destroy(bench->streaming);
+	vk_dev_staging_destroy(bench->staging);
+	vk_dev_bindless_destroy(bench->bindless);
+	vk_dev_asset_close(bench->file);
+	context->vk.DestroySampler(context->device, bench->sampler, NULL);
+	context->vk.DestroyFence(context->device, bench->fence, NULL);
+	context->vk.DestroyCommandPool(context->device, bench->command_pool,
+		NULL);
+
+	remove(BENCH_ASSET);
+}
+
+static void
+_bench_frame(struct _bench* bench)
+{
+	VkSubmitInfo submit_info;
+	VkMemoryBarrier barrier;
+	VkRenderPassBeginInfo pass_info;
+	VkCommandBufferBeginInfo begin_info;
+	struct vk_dev_context* context;
+
+	context = bench->context;
+
+	vk_dev_streaming_begin_frame(bench->streaming, 0);
+	context->vk.ResetCommandPool(context->device, bench->command_pool, 0);
+
+	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.pNext = NULL;
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	begin_info.pInheritanceInfo = NULL;
+
+	if (context->vk.BeginCommandBuffer(bench->command_buffer, &begin_info) !=
+		VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to begin command buffer.");
+	}
+
+	memset(&pass_info, 0, sizeof(pass_info));
+	pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	pass_info.renderPass = bench->render_pass;
+	pass_info.framebuffer = bench->framebuffer;
+	pass_info.renderArea.extent.width = BENCH_SIZE;
+	pass_info.renderArea.extent.height = BENCH_SIZE;
+
+	context->vk.CmdBeginRenderPass(bench->command_buffer, &pass_info,
+		VK_SUBPASS_CONTENTS_INLINE);
+	context->vk.CmdBindPipeline(bench->command_buffer,
+		VK_PIPELINE_BIND_POINT_GRAPHICS, bench->pipeline);
+	vk_dev_bindless_bind(bench->bindless, bench->command_buffer,
+		VK_PIPELINE_BIND_POINT_GRAPHICS, bench->layout, 0);
+	context->vk.CmdPushConstants(bench->command_buffer, bench->layout,
+		VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(bench->constants),
+		&bench->constants);
+	context->vk.CmdDraw(bench->command_buffer, 3, 1, 0, 0);
+	context->vk.CmdEndRenderPass(bench->command_buffer);
+
+	// NOTE: The feedback is read back by the next vk_dev_streaming_begin_frame.
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.pNext = NULL;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+	context->vk.CmdPipelineBarrier(bench->command_buffer,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+		1, &barrier, 0, NULL, 0, NULL);
+
+	if (context->vk.EndCommandBuffer(bench->command_buffer) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to record command buffer.");
+	}
+
+	memset(&submit_info, 0, sizeof(submit_info));
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &bench->command_buffer;
+
+	if (context->vk.QueueSubmit(context->queue, 1, &submit_info,
+		bench->fence) != VK_SUCCESS ||
+		context->vk.WaitForFences(context->device, 1, &bench->fence, VK_TRUE,
+		UINT64_MAX) != VK_SUCCESS) {
+		vk_dev_fatal_error("[BENCH] Failed to run command buffer.");
+	}
+
+	context->vk.ResetFences(context->device, 1, &bench->fence);
+}
+
+int
+main(int argc, char** argv)
+{
+	uint32_t size, frames, frame;
+	uint64_t start, ns;
+	struct _bench bench;
+	struct vk_dev_streaming_stats stats;
+	struct vk_dev_context* context;
+
+	size = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 2048;
+	frames = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 60;
+	if (size <= VK_DEV_STREAMING_TAIL_SIZE || size > 16384 ||
+		(size & (size - 1)) != 0 || frames == 0) {
+		fprintf(stderr, "usage: %s [SIZE [FRAMES]]\n", argv[0]);
+		return 1;
+	}
+
+	memset(&bench, 0, sizeof(bench));
+	context = vk_dev_context_create(-1);
+	_bench_create(&bench, context, size);
+
+	/*
+	 *	NOTE:	Loads finish on the streaming thread, so a requested level
+	 *			can take a few frames to show up in the stats.
+	 */
+	start = _bench_time_ns();
+	for (frame = 1; frame <= frames; frame++) {
+		_bench_frame(&bench);
+
+		vk_dev_streaming_get_stats(bench.streaming, &stats);
+		if (stats.loads > 0) {
+			break;
+		}
+	}
+	ns = _bench_time_ns() - start;
+
+	if (stats.loads == 0) {
+		vk_dev_fatal_error("[BENCH] Feedback never requested a level finer "
+			"than the mip tail.");
+	}
+
+	printf("%ux%u texture at %ux%u\n", size, size, BENCH_SIZE, BENCH_SIZE);
+	printf("first load after %u frames, %.3f ms\n", frame, ns / 1e6);
+	printf("%.2f MB resident, %llu loads, %llu evictions\n",
+		stats.resident_bytes / 1048576.0, (unsigned long long)stats.loads,
+		(unsigned long long)stats.evictions);
+
+	_bench_destroy(&bench);
+	vk_dev_context_destroy(context);
+
+	return 0;
+}
@@ -0,0 +1,249 @@
+/*
+ *	NOTE:	Submission queue contention benchmark:
+ *			submit-bench [PUSHES]
+ *
+ *			1 to 64 producer threads each push PUSHES nodes (100000 by
+ *			default) while one consumer drains them, once through the
+ *			lock-free queue behind vk_dev_submitter_add and once through a
+ *			mutex-guarded list whose consumer takes everything queued in one
+ *			go. Reports pushes per second from the first push until the
+ *			consumer has seen them all, and checks that every producer's
+ *			nodes arrived in the order it pushed them. Needs no GPU.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <vulkan-dev/mpsc.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+
+#define BENCH_MAX_PRODUCERS 64
+
+struct _bench_node {
+	struct vk_dev_mpsc_node link;
+	uint32_t producer;
+	uint32_t sequence;
+};
+
+struct _bench_mutex_queue {
+	pthread_mutex_t lock;
+	struct vk_dev_mpsc_node* head;
+	struct vk_dev_mpsc_node* tail;
+};
+
+struct _bench {
+	bool lock_free;
+	struct vk_dev_mpsc mpsc;
+	struct _bench_mutex_queue mutex;
+
+	pthread_barrier_t start;
+	struct _bench_node* nodes;
+	uint32_t pushes;
+};
+
+struct _bench_producer {
+	struct _bench* bench;
+	uint32_t index;
+};
+
+static uint64_t
+_bench_time_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+static void
+_bench_mutex_push(struct _bench_mutex_queue* queue,
+	struct vk_dev_mpsc_node* node)
+{
+	node->next = NULL;
+
+	pthread_mutex_lock(&queue->lock);
+	if (queue->tail != NULL) {
+		queue->tail->next = node;
+	} else {
+		queue->head = node;
+	}
+	queue->tail = node;
+	pthread_mutex_unlock(&queue->lock);
+}
+
+static struct vk_dev_mpsc_node*
+_bench_mutex_take(struct _bench_mutex_queue* queue)
+{
+	struct vk_dev_mpsc_node* head;
+
+	pthread_mutex_lock(&queue->lock);
+	head = queue->head;
+	queue->head = NULL;
+	queue->tail = NULL;
+	pthread_mutex_unlock(&queue->lock);
+
+	return head;
+}
+
+static void*
+_bench_produce(void* arg)
+{
+	struct _bench_node* nodes;
+	struct _bench_producer* producer;
+	struct _bench* bench;
+
+	producer = arg;
+	bench = producer->bench;
+	nodes = bench->nodes + (size_t)producer->index * bench->pushes;
+
+	pthread_barrier_wait(&bench->start);
+
+	for (uint32_t i = 0; i < bench->pushes; i++) {
+		if (bench->lock_free) {
+			vk_dev_mpsc_push(&bench->mpsc, &nodes[i].link);
+		} else {
+			_bench_mutex_push(&bench->mutex, &nodes[i].link);
+		}
+	}
+
+	return NULL;
+}
+
+static bool
+_bench_consume(struct _bench_node* node, uint32_t* expected)
+{
+	if (node->sequence != expected[node->producer]) {
+		return false;
+	}
+
+	expected[node->producer]++;
+
+	return true;
+}
+
+/*
+ *	NOTE:	Returns nanoseconds from the start barrier until the last node
+ *			was consumed, or 0 if any arrived out of order.
+ */
+static uint64_t
+_bench_run(struct _bench* bench, const uint32_t producer_count)
+{
+	bool ordered;
+	uint64_t start, total, consumed;
+	uint32_t expected[BENCH_MAX_PRODUCERS] = {0};
+	pthread_t threads[BENCH_MAX_PRODUCERS];
+	struct _bench_producer producers[BENCH_MAX_PRODUCERS];
+	struct vk_dev_mpsc_node* node;
+
+	vk_dev_mpsc_init(&bench->mpsc);
+	bench->mutex.head = NULL;
+	bench->mutex.tail = NULL;
+
+	for (uint32_t p = 0; p < producer_count; p++) {
+		for (uint32_t i = 0; i < bench->pushes; i++) {
+			bench->nodes[(size_t)p * bench->pushes + i].producer = p;
+			bench->nodes[(size_t)p * bench->pushes + i].sequence = i;
+		}
+	}
+
+	pthread_barrier_init(&bench->start, NULL, producer_count + 1);
+
+	for (uint32_t p = 0; p < producer_count; p++) {
+		producers[p].bench = bench;
+		producers[p].index = p;
+		if (pthread_create(&threads[p], NULL, _bench_produce,
+			&producers[p]) != 0) {
+			fprintf(stderr, "Failed to create producer thread.\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	total = (uint64_t)producer_count * bench->pushes;
+	consumed = 0;
+	ordered = true;
+
+	pthread_barrier_wait(&bench->start);
+	start = _bench_time_ns();
+
+	while (consumed < total) {
+		if (bench->lock_free) {
+			node = vk_dev_mpsc_pop(&bench->mpsc);
+			if (node != NULL) {
+				ordered &= _bench_consume((struct _bench_node*)node,
+					expected);
+				consumed++;
+			}
+		} else {
+			for (node = _bench_mutex_take(&bench->mutex); node != NULL;
+				node = node->next) {
+				ordered &= _bench_consume((struct _bench_node*)node,
+					expected);
+				consumed++;
+			}
+		}
+	}
+
+	total = _bench_time_ns() - start;
+
+	for (uint32_t p = 0; p < producer_count; p++) {
+		pthread_join(threads[p], NULL);
+	}
+
+	pthread_barrier_destroy(&bench->start);
+
+	return ordered ? total : 0;
+}
+
+int
+main(int argc, char* argv[])
+{
+	uint64_t ns[2];
+	struct _bench bench;
+
+	bench.pushes = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 100000;
+	if (bench.pushes == 0) {
+		fprintf(stderr, "usage: %s [PUSHES]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	bench.nodes = malloc(sizeof(*bench.nodes) * BENCH_MAX_PRODUCERS *
+		bench.pushes);
+	if (bench.nodes == NULL) {
+		fprintf(stderr, "Failed to allocate nodes.\n");
+		return EXIT_FAILURE;
+	}
+
+	pthread_mutex_init(&bench.mutex.lock, NULL);
+
+	printf("%u pushes per producer\n", bench.pushes);
+	printf("producers  lock-free Mpush/s  mutex Mpush/s  speedup\n");
+
+	for (uint32_t producers = 1; producers <= BENCH_MAX_PRODUCERS;
+		producers *= 2) {
+		bench.lock_free = true;
+		ns[0] = _bench_run(&bench, producers);
+		bench.lock_free = false;
+		ns[1] = _bench_run(&bench, producers);
+
+		if (ns[0] == 0 || ns[1] == 0) {
+			fprintf(stderr, "Nodes arrived out of order.\n");
+			return EXIT_FAILURE;
+		}
+
+		printf("%9u  %17.2f  %13.2f  %6.2fx\n", producers,
+			(double)producers * bench.pushes * 1e3 / (double)ns[0],
+			(double)producers * bench.pushes * 1e3 / (double)ns[1],
+			(double)ns[1] / (double)ns[0]);
+	}
+
+	pthread_mutex_destroy(&bench.mutex.lock);
+	free(bench.nodes);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+"""Trim the glad generated Vulkan loader down to a manifest.
+
+Usage: trim-loader.py MANIFEST SOURCE OUTPUT
+
+Removes, for every core version and extension not named in MANIFEST:
+  - its glad_vk_has_extension() query in glad_vk_find_extensions_vulkan,
+  - its glad_vk_load_*() function and the call to it,
+  - the entry points it alone provided from DEVICE_FUNCTIONS, which glad
+    scans linearly for every symbol it resolves.
+
+The header is left untouched, so unlisted GLAD_VK_* flags simply stay 0
+and their function pointers stay NULL. A summary is printed to stderr.
+"""
+
+import re
+import sys
+
+LOAD_DEFINITION = re.compile(r"^static void glad_vk_load_(\w+)\(")
+LOAD_CALL = re.compile(r"^\s+glad_vk_load_(\w+)\(load, userptr\);")
+HAS_EXTENSION = re.compile(r"^\s+GLAD_(VK_\w+) = glad_vk_has_extension\(")
+RESOLVE = re.compile(r'load\(userptr, "(\w+)"\)')
+DEVICE_FUNCTION = re.compile(r'^\s+"(vk\w+)",$')
+
+
+def read_manifest(path):
+    names = set()
+    with open(path) as manifest:
+        for line in manifest:
+            line = line.split("#", 1)[0].strip()
+            if line:
+                names.add(line)
+    return names
+
+
+def trim(lines, keep):
+    output = []
+    kept_functions = set()
+    all_functions = set()
+    stats = {"resolves": [0, 0], "queries": [0, 0], "device": [0, 0]}
+
+    in_load = False
+    skipping = False
+    in_device_functions = False
+    for line in lines:
+        match = LOAD_DEFINITION.match(line)
+        if match:
+            in_load = True
+            skipping = match.group(1) not in keep
+
+        if in_load:
+            resolved = RESOLVE.findall(line)
+            stats["resolves"][0] += len(resolved)
+            all_functions.update(resolved)
+            if not skipping:
+                stats["resolves"][1] += len(resolved)
+                kept_functions.update(resolved)
+
+            if line.rstrip() == "}":
+                in_load = False
+
+        if skipping:
+            if not in_load:
+                skipping = False
+            continue
+
+        match = LOAD_CALL.match(line)
+        if match and match.group(1) not in keep:
+            continue
+
+        match = HAS_EXTENSION.match(line)
+        if match:
+            stats["queries"][0] += 1
+            if match.group(1) not in keep:
+                continue
+            stats["queries"][1] += 1
+
+        output.append(line)
+
+    # NOTE: DEVICE_FUNCTIONS comes after every load function in the file,
+    #       so the kept set is complete by the time it is filtered.
+    trimmed = []
+    for line in output:
+        if line.startswith("static const char* DEVICE_FUNCTIONS[]"):
+            in_device_functions = True
+        elif in_device_functions and line.startswith("};"):
+            in_device_functions = False
+
+        match = DEVICE_FUNCTION.match(line) if in_device_functions else None
+        if match:
+            stats["device"][0] += 1
+            name = match.group(1)
+            if name in all_functions and name not in kept_functions:
+                continue
+            stats["device"][1] += 1
+
+        trimmed.append(line)
+
+    return trimmed, stats
+
+
+def main(argv):
+    if len(argv) != 4:
+        sys.stderr.write(__doc__)
+        return 1
+
+    keep = read_manifest(argv[1])
+    with open(argv[2]) as source:
+        lines = source.readlines()
+
+    trimmed, stats = trim(lines, keep)
+
+    with open(argv[3], "w") as output:
+        output.write("/* Trimmed from %s by tools/trim-loader.py, do not edit. */\n"
+            % argv[2])
+        output.writelines(trimmed)
+
+    sys.stderr.write("trim-loader: %s\n" % argv[3])
+    sys.stderr.write("\tsymbol resolutions  %4d -> %4d\n" % tuple(stats["resolves"]))
+    sys.stderr.write("\textension queries   %4d -> %4d\n" % tuple(stats["queries"]))
+    sys.stderr.write("\tdevice function list%4d -> %4d\n" % tuple(stats["device"]))
+    sys.stderr.write("\tlines               %4d -> %4d\n" % (len(lines), len(trimmed)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))